@@ -2,6 +2,10 @@
 // Creates virtual audio output devices with loopback for passthrough
 // Phase 3: Multiple virtual devices (9 channels)
 
+#include "LoopbackBuffer.hpp"
+#include "engine/callback_timing.h"
+#include "engine/rt_scope.h"
+
 #include <aspl/Driver.hpp>
 #include <aspl/Plugin.hpp>
 #include <aspl/Device.hpp>
@@ -22,111 +26,34 @@
 
 namespace {
 
-// Lock-free ring buffer for audio loopback
-// Stores audio written to output for reading by input
-class LoopbackBuffer {
-public:
-    static constexpr size_t kBufferFrames = 48000 * 5; // 5 seconds at 48kHz (increased from 1s)
-    static constexpr size_t kChannels = 2;
-    static constexpr size_t kBufferSize = kBufferFrames * kChannels * sizeof(Float32);
-
-    LoopbackBuffer() : buffer_(kBufferSize, 0), writePos_(0), readPos_(0), underrunCount_(0), logCounter_(0) {}
-
-    void write(const void* data, size_t bytes) {
-        const uint8_t* src = static_cast<const uint8_t*>(data);
-        size_t wp = writePos_.load(std::memory_order_relaxed);
-        size_t rp = readPos_.load(std::memory_order_acquire);
-
-        // Calculate available space (using wrapped positions)
-        size_t used = wp - rp;  // This works due to unsigned wraparound
-        if (used > kBufferSize) {
-            // Read position is ahead - shouldn't happen but handle gracefully
-            used = 0;
-        }
-        size_t space = kBufferSize - used;
-
-        size_t toWrite = std::min(bytes, space);
-        if (toWrite == 0) {
-            return;  // Buffer full
-        }
-
-        size_t writeIdx = wp % kBufferSize;
-        size_t firstChunk = std::min(toWrite, kBufferSize - writeIdx);
-
-        std::memcpy(buffer_.data() + writeIdx, src, firstChunk);
-        if (toWrite > firstChunk) {
-            std::memcpy(buffer_.data(), src + firstChunk, toWrite - firstChunk);
-        }
+// Execution time of a device's I/O handlers. The I/O thread records; the
+// control handler reports when I/O stops.
+struct LoopbackTiming {
+    CallbackTiming write;
+    CallbackTiming read;
+    std::atomic<Float64> sampleRate{48000.0};   // For the deadline; set off the I/O thread
 
-        writePos_.store(wp + toWrite, std::memory_order_release);
+    size_t frames(UInt32 bytesCount) const {
+        return bytesCount / (LoopbackBuffer::kChannels * sizeof(Float32));
     }
 
-    size_t read(void* data, size_t bytes) {
-        uint8_t* dst = static_cast<uint8_t*>(data);
-        size_t wp = writePos_.load(std::memory_order_acquire);
-        size_t rp = readPos_.load(std::memory_order_relaxed);
-
-        size_t available = wp - rp;  // Works with unsigned wraparound
-        if (available > kBufferSize) {
-            // Write wrapped around - reset to avoid stale data
-            available = 0;
-        }
-
-        size_t toRead = std::min(bytes, available);
-
-        // Log periodically to diagnose timing issues
-        if (++logCounter_ % 500 == 0) {  // Every 500 reads (~10 seconds at typical callback rates)
-            size_t underruns = underrunCount_.load();
-            os_log(OS_LOG_DEFAULT, "PCPanel Loopback: available=%zu requested=%zu underruns=%zu",
-                   available, bytes, underruns);
-        }
-
-        if (toRead > 0) {
-            size_t readIdx = rp % kBufferSize;
-            size_t firstChunk = std::min(toRead, kBufferSize - readIdx);
-
-            std::memcpy(dst, buffer_.data() + readIdx, firstChunk);
-            if (toRead > firstChunk) {
-                std::memcpy(dst + firstChunk, buffer_.data(), toRead - firstChunk);
-            }
-
-            readPos_.store(rp + toRead, std::memory_order_release);
-        }
-
-        // Fill remaining with silence
-        if (toRead < bytes) {
-            std::memset(dst + toRead, 0, bytes - toRead);
-            if (toRead == 0) {
-                underrunCount_.fetch_add(1);
-                os_log(OS_LOG_DEFAULT, "PCPanel Loopback UNDERRUN: requested=%zu available=%zu total_underruns=%zu",
-                       bytes, available, underrunCount_.load() + 1);
-            }
+    void log(const char* name, const CallbackTiming& timing) const {
+        CallbackTiming::Snapshot snap = timing.snapshot();
+        if (snap.count == 0) {
+            return;
         }
-
-        return toRead;
-    }
-
-    void clear() {
-        writePos_.store(0, std::memory_order_relaxed);
-        readPos_.store(0, std::memory_order_relaxed);
-        underrunCount_.store(0, std::memory_order_relaxed);
-        // Zero out buffer to prevent stale audio playback
-        std::memset(buffer_.data(), 0, buffer_.size());
+        os_log(OS_LOG_DEFAULT, "PCPanel timing %{public}s: n=%llu p50=%lluus p99=%lluus max=%lluus period=%lluus misses=%llu",
+               name, snap.count, snap.p50Ns / 1000, snap.p99Ns / 1000, snap.maxNs / 1000,
+               snap.periodNs / 1000, snap.deadlineMisses);
     }
-
-private:
-    std::vector<uint8_t> buffer_;
-    std::atomic<size_t> writePos_;
-    std::atomic<size_t> readPos_;
-    std::atomic<size_t> underrunCount_;
-    mutable size_t logCounter_;
 };
 
 // I/O handler that implements loopback
 class LoopbackIOHandler : public aspl::IORequestHandler {
 public:
-    explicit LoopbackIOHandler(std::shared_ptr<LoopbackBuffer> buffer)
+    LoopbackIOHandler(std::shared_ptr<LoopbackBuffer> buffer, std::shared_ptr<LoopbackTiming> timing)
         : buffer_(std::move(buffer))
+        , timing_(std::move(timing))
     {}
 
     // Called when apps write audio to our output
@@ -135,11 +62,9 @@ public:
                            Float64 timestamp,
                            const void* bytes,
                            UInt32 bytesCount) override {
-        static int writeCount = 0;
-        if (writeCount++ < 20) {
-            // Log to system log (viewable via Console.app or `log stream`)
-            os_log(OS_LOG_DEFAULT, "PCPanel: OnWriteMixedOutput called, bytes=%u", bytesCount);
-        }
+        rtsan::Scope scope("LoopbackIOHandler::OnWriteMixedOutput");
+        CallbackTiming::Scope timing(timing_->write);
+        timing.setPeriod(timing_->frames(bytesCount), timing_->sampleRate.load(std::memory_order_relaxed));
         // Store the audio in our loopback buffer
         buffer_->write(bytes, bytesCount);
     }
@@ -151,23 +76,24 @@ public:
                           Float64 timestamp,
                           void* bytes,
                           UInt32 bytesCount) override {
-        static int readCount = 0;
-        if (readCount++ < 20) {
-            os_log(OS_LOG_DEFAULT, "PCPanel: OnReadClientInput called, bytes=%u", bytesCount);
-        }
+        rtsan::Scope scope("LoopbackIOHandler::OnReadClientInput");
+        CallbackTiming::Scope timing(timing_->read);
+        timing.setPeriod(timing_->frames(bytesCount), timing_->sampleRate.load(std::memory_order_relaxed));
         // Return audio from our loopback buffer
         buffer_->read(bytes, bytesCount);
     }
 
 private:
     std::shared_ptr<LoopbackBuffer> buffer_;
+    std::shared_ptr<LoopbackTiming> timing_;
 };
 
 // Control handler
 class LoopbackControlHandler : public aspl::ControlRequestHandler {
 public:
-    explicit LoopbackControlHandler(std::shared_ptr<LoopbackBuffer> buffer)
+    LoopbackControlHandler(std::shared_ptr<LoopbackBuffer> buffer, std::shared_ptr<LoopbackTiming> timing)
         : buffer_(std::move(buffer))
+        , timing_(std::move(timing))
     {}
 
     OSStatus OnStartIO() override {
@@ -176,12 +102,24 @@ public:
     }
 
     void OnStopIO() override {
+        // One summary per I/O session, logged here rather than on the I/O thread
+        timing_->log("write", timing_->write);
+        timing_->log("read", timing_->read);
+        timing_->write.reset();
+        timing_->read.reset();
+
+        RingStats::Snapshot xruns = buffer_->stats().read();
+        os_log(OS_LOG_DEFAULT, "PCPanel xruns: underruns=%llu silent=%llu overflows=%llu dropped=%llu fill=%llu..%llu/%llu frames",
+               xruns.underruns, xruns.silentFrames, xruns.overflows, xruns.droppedFrames,
+               xruns.fillMinFrames, xruns.fillMaxFrames, xruns.capacityFrames);
+
         // Clear buffer to prevent stale audio from being played back
         buffer_->clear();
     }
 
 private:
     std::shared_ptr<LoopbackBuffer> buffer_;
+    std::shared_ptr<LoopbackTiming> timing_;
 };
 
 // Custom device with loopback support
@@ -193,10 +131,13 @@ public:
         : aspl::Device(context, params)
         , channelIndex_(channelIndex)
         , loopbackBuffer_(std::make_shared<LoopbackBuffer>())
+        , timing_(std::make_shared<LoopbackTiming>())
     {
+        timing_->sampleRate.store(params.SampleRate);
+
         // Set up I/O and control handlers
-        auto ioHandler = std::make_shared<LoopbackIOHandler>(loopbackBuffer_);
-        auto controlHandler = std::make_shared<LoopbackControlHandler>(loopbackBuffer_);
+        auto ioHandler = std::make_shared<LoopbackIOHandler>(loopbackBuffer_, timing_);
+        auto controlHandler = std::make_shared<LoopbackControlHandler>(loopbackBuffer_, timing_);
 
         SetIOHandler(ioHandler);
         SetControlHandler(controlHandler);
@@ -226,6 +167,7 @@ public:
         if (status != kAudioHardwareNoError) {
             return status;
         }
+        timing_->sampleRate.store(rate);
 
         // Update all stream formats to match the new sample rate
         for (UInt32 i = 0; i < GetStreamCount(aspl::Direction::Output); i++) {
@@ -286,6 +228,7 @@ protected:
 private:
     int channelIndex_;
     std::shared_ptr<LoopbackBuffer> loopbackBuffer_;
+    std::shared_ptr<LoopbackTiming> timing_;
     std::shared_ptr<LoopbackIOHandler> ioHandler_;
     std::shared_ptr<LoopbackControlHandler> controlHandler_;
 };
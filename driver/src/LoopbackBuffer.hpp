@@ -0,0 +1,121 @@
+// PC Panel Pro Audio Driver - loopback ring buffer
+// Carries what apps play into a virtual device's output stream back out of its
+// input stream. Header-only so the host benchmarks can build it without the
+// CoreAudio SDK.
+
+#pragma once
+
+#include "engine/ring_stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Lock-free ring buffer for audio loopback
+// Stores audio written to output for reading by input. Positions only ever
+// grow; the writer owns writePos_ and the reader owns readPos_, including
+// when another thread asks for a clear().
+class LoopbackBuffer {
+public:
+    static constexpr size_t kBufferFrames = 48000 * 5; // 5 seconds at 48kHz (increased from 1s)
+    static constexpr size_t kChannels = 2;
+    static constexpr size_t kBufferSize = kBufferFrames * kChannels * sizeof(float);
+    static constexpr size_t kBytesPerFrame = kChannels * sizeof(float);
+    static constexpr size_t kNoClear = SIZE_MAX;
+
+    LoopbackBuffer() : buffer_(kBufferSize, 0), writePos_(0), readPos_(0), clearTo_(kNoClear) {
+        stats_.setCapacity(kBufferFrames);
+    }
+
+    void write(const void* data, size_t bytes) {
+        const uint8_t* src = static_cast<const uint8_t*>(data);
+        size_t wp = writePos_.load(std::memory_order_relaxed);
+        size_t rp = readPos_.load(std::memory_order_acquire);
+
+        // Calculate available space (using wrapped positions)
+        size_t used = wp - rp;  // This works due to unsigned wraparound
+        if (used > kBufferSize) {
+            // Read position is ahead - shouldn't happen but handle gracefully
+            used = 0;
+        }
+        size_t space = kBufferSize - used;
+        space -= space % kBytesPerFrame;
+
+        size_t toWrite = std::min(bytes, space);
+        stats_.recordWrite(bytes / kBytesPerFrame, toWrite / kBytesPerFrame);
+        if (toWrite == 0) {
+            return;  // Buffer full
+        }
+
+        size_t writeIdx = wp % kBufferSize;
+        size_t firstChunk = std::min(toWrite, kBufferSize - writeIdx);
+
+        std::memcpy(buffer_.data() + writeIdx, src, firstChunk);
+        if (toWrite > firstChunk) {
+            std::memcpy(buffer_.data(), src + firstChunk, toWrite - firstChunk);
+        }
+
+        writePos_.store(wp + toWrite, std::memory_order_release);
+    }
+
+    size_t read(void* data, size_t bytes) {
+        uint8_t* dst = static_cast<uint8_t*>(data);
+        size_t wp = writePos_.load(std::memory_order_acquire);
+        size_t rp = readPos_.load(std::memory_order_relaxed);
+
+        // Apply a pending clear(): skip what had been written by then
+        size_t clearTo = clearTo_.exchange(kNoClear, std::memory_order_acquire);
+        if (clearTo != kNoClear && clearTo - rp <= kBufferSize) {
+            rp = clearTo;
+            readPos_.store(rp, std::memory_order_release);
+        }
+
+        size_t available = wp - rp;  // Works with unsigned wraparound
+        if (available > kBufferSize) {
+            // Write wrapped around - reset to avoid stale data
+            available = 0;
+        }
+
+        size_t toRead = std::min(bytes, available);
+        stats_.recordRead(bytes / kBytesPerFrame, toRead / kBytesPerFrame, available / kBytesPerFrame);
+
+        if (toRead > 0) {
+            size_t readIdx = rp % kBufferSize;
+            size_t firstChunk = std::min(toRead, kBufferSize - readIdx);
+
+            std::memcpy(dst, buffer_.data() + readIdx, firstChunk);
+            if (toRead > firstChunk) {
+                std::memcpy(dst + firstChunk, buffer_.data(), toRead - firstChunk);
+            }
+
+            readPos_.store(rp + toRead, std::memory_order_release);
+        }
+
+        // Fill remaining with silence
+        if (toRead < bytes) {
+            std::memset(dst + toRead, 0, bytes - toRead);
+        }
+
+        return toRead;
+    }
+
+    // Cumulative over the buffer's life; clear() leaves them alone
+    RingStats& stats() { return stats_; }
+
+    // Drop everything buffered so far, from any thread while I/O may be
+    // running. The reader applies it on its next read, so neither position
+    // is ever written by another thread and stale audio is never read.
+    void clear() {
+        clearTo_.store(writePos_.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+private:
+    std::vector<uint8_t> buffer_;
+    std::atomic<size_t> writePos_;
+    std::atomic<size_t> readPos_;
+    std::atomic<size_t> clearTo_;       // Write position at the last clear(), until the reader applies it
+    RingStats stats_;
+};
@@ -25,7 +25,8 @@
         "libraries": [
           "-framework CoreAudio",
           "-framework AudioToolbox",
-          "-framework CoreFoundation"
+          "-framework CoreFoundation",
+          "-framework IOKit"
         ]
       },
       "defines": ["NAPI_DISABLE_CPP_EXCEPTIONS"]
@@ -5,177 +5,39 @@
 #include <CoreAudio/CoreAudio.h>
 #include <AudioToolbox/AudioToolbox.h>
 #include <AudioUnit/AudioUnit.h>
+#include <IOKit/hid/IOHIDManager.h>
+#include <dispatch/dispatch.h>
+#include <pthread.h>
 #include <vector>
 #include <mutex>
 #include <atomic>
 #include <cstring>
 #include <chrono>
+#include <condition_variable>
 #include <cmath>
-
-// =============================================================================
-// Simple Linear Interpolation Sample Rate Converter
-// =============================================================================
-class SampleRateConverter {
-public:
-    SampleRateConverter(double inputRate, double outputRate, int channels = 2)
-        : inputRate_(inputRate)
-        , outputRate_(outputRate)
-        , channels_(channels)
-        , ratio_(inputRate / outputRate)
-        , phase_(0.0)
-    {
-        // Pre-allocate for typical buffer sizes
-        lastSamples_.resize(channels, 0.0f);
-    }
-
-    // Convert input samples to output sample rate
-    // Returns the number of output frames produced
-    size_t convert(const float* input, size_t inputFrames, float* output, size_t maxOutputFrames) {
-        if (inputRate_ == outputRate_) {
-            // No conversion needed
-            size_t framesToCopy = std::min(inputFrames, maxOutputFrames);
-            memcpy(output, input, framesToCopy * channels_ * sizeof(float));
-            return framesToCopy;
-        }
-
-        size_t outputFrames = 0;
-        size_t inputIdx = 0;
-
-        while (outputFrames < maxOutputFrames && inputIdx < inputFrames) {
-            // Calculate which input samples we're interpolating between
-            double inputPos = phase_;
-            size_t idx0 = static_cast<size_t>(inputPos);
-            double frac = inputPos - idx0;
-
-            if (idx0 >= inputFrames) break;
-
-            size_t idx1 = idx0 + 1;
-            if (idx1 >= inputFrames) idx1 = idx0;  // Clamp at end
-
-            // Linear interpolation for each channel
-            for (int ch = 0; ch < channels_; ch++) {
-                float s0 = input[idx0 * channels_ + ch];
-                float s1 = input[idx1 * channels_ + ch];
-                output[outputFrames * channels_ + ch] = s0 + (s1 - s0) * static_cast<float>(frac);
-            }
-
-            outputFrames++;
-            phase_ += ratio_;
-
-            // Keep track of how far we've consumed the input
-            inputIdx = static_cast<size_t>(phase_);
-        }
-
-        // Adjust phase for next call (keep fractional part relative to remaining input)
-        phase_ -= inputFrames;
-        if (phase_ < 0) phase_ = 0;
-
-        return outputFrames;
-    }
-
-    // Reset state
-    void reset() {
-        phase_ = 0.0;
-        std::fill(lastSamples_.begin(), lastSamples_.end(), 0.0f);
-    }
-
-    // Calculate how many output frames we'd get for given input frames
-    size_t getOutputFrameCount(size_t inputFrames) const {
-        if (inputRate_ == outputRate_) return inputFrames;
-        return static_cast<size_t>(inputFrames * outputRate_ / inputRate_);
-    }
-
-    double getInputRate() const { return inputRate_; }
-    double getOutputRate() const { return outputRate_; }
-
-private:
-    double inputRate_;
-    double outputRate_;
-    int channels_;
-    double ratio_;
-    double phase_;
-    std::vector<float> lastSamples_;
-};
-
-// Simple lock-free ring buffer for audio passthrough
-// No drift compensation - relies on matched sample rates
-class RingBuffer {
-public:
-    RingBuffer(size_t sizeInFrames, UInt32 /* channelCount */, UInt32 bytesPerFrame)
-        : capacity_(sizeInFrames * bytesPerFrame)
-        , buffer_(capacity_)
-        , writePos_(0)
-        , readPos_(0)
-    {}
-
-    void write(const void* data, size_t bytes) {
-        const uint8_t* src = static_cast<const uint8_t*>(data);
-        size_t wp = writePos_.load(std::memory_order_relaxed);
-        size_t rp = readPos_.load(std::memory_order_acquire);
-
-        // Calculate available space (leave 1 byte to distinguish full from empty)
-        size_t used = (wp >= rp) ? (wp - rp) : (capacity_ - rp + wp);
-        size_t space = capacity_ - used - 1;
-
-        size_t toWrite = std::min(bytes, space);
-        if (toWrite == 0) return;  // Buffer full, drop samples
-
-        size_t writeIdx = wp % capacity_;
-        size_t firstChunk = std::min(toWrite, capacity_ - writeIdx);
-
-        memcpy(buffer_.data() + writeIdx, src, firstChunk);
-        if (toWrite > firstChunk) {
-            memcpy(buffer_.data(), src + firstChunk, toWrite - firstChunk);
-        }
-
-        writePos_.store((wp + toWrite) % capacity_, std::memory_order_release);
-    }
-
-    size_t read(void* data, size_t bytes) {
-        uint8_t* dst = static_cast<uint8_t*>(data);
-        size_t wp = writePos_.load(std::memory_order_acquire);
-        size_t rp = readPos_.load(std::memory_order_relaxed);
-
-        size_t available = (wp >= rp) ? (wp - rp) : (capacity_ - rp + wp);
-        size_t toRead = std::min(bytes, available);
-
-        if (toRead > 0) {
-            size_t readIdx = rp % capacity_;
-            size_t firstChunk = std::min(toRead, capacity_ - readIdx);
-
-            memcpy(dst, buffer_.data() + readIdx, firstChunk);
-            if (toRead > firstChunk) {
-                memcpy(dst + firstChunk, buffer_.data(), toRead - firstChunk);
-            }
-
-            readPos_.store((rp + toRead) % capacity_, std::memory_order_release);
-        }
-
-        // Fill remaining with silence
-        if (toRead < bytes) {
-            memset(dst + toRead, 0, bytes - toRead);
-        }
-
-        return toRead;
-    }
-
-    void reset() {
-        writePos_.store(0, std::memory_order_relaxed);
-        readPos_.store(0, std::memory_order_relaxed);
-    }
-
-    size_t getAvailable() const {
-        size_t wp = writePos_.load(std::memory_order_relaxed);
-        size_t rp = readPos_.load(std::memory_order_relaxed);
-        return (wp >= rp) ? (wp - rp) : (capacity_ - rp + wp);
-    }
-
-private:
-    size_t capacity_;
-    std::vector<uint8_t> buffer_;
-    std::atomic<size_t> writePos_;
-    std::atomic<size_t> readPos_;
-};
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "engine/bus_recorder.h"
+#include "engine/replay_buffer.h"
+#include "engine/stem_recorder.h"
+#include "engine/callback_timing.h"
+#include "engine/ring_stats.h"
+#include "engine/trace.h"
+#include "engine/hid_gain_map.h"
+#include "engine/hid_report.h"
+#include "engine/mix_engine.h"
+#include "engine/mixer_params.h"
+#include "engine/ring_buffer.h"
+#include "engine/rt_scope.h"
+#include "engine/sample_rate_converter.h"
+#include "engine/spsc_queue.h"
+#include "engine/taper.h"
 
 // Audio passthrough manager
 class AudioPassthrough {
@@ -189,7 +51,11 @@ public:
         , ringBuffer_(nullptr)
         , volume_(1.0f)
         , lastActivityTime_(0)
-    {}
+    {
+        int32_t traceId = trace::nextId();
+        ringStats_.setTraceId(traceId);
+        trace::label(traceId, "passthrough");
+    }
 
     ~AudioPassthrough() {
         stop();
@@ -259,10 +125,12 @@ public:
         ringBuffer_ = std::make_unique<RingBuffer>(
             static_cast<size_t>(outputSampleRate * 2),  // 2 seconds buffer
             inputFormat.mChannelsPerFrame,
-            bytesPerFrame
+            bytesPerFrame,
+            &ringStats_
         );
 
         format_ = inputFormat;
+        format_.mBytesPerFrame = bytesPerFrame;
 
         // Create input IOProc (reads from virtual device)
         status = AudioDeviceCreateIOProcID(inputDevice_, InputIOProc, this, &inputProcID_);
@@ -340,6 +208,18 @@ public:
         return volume_;
     }
 
+    const CallbackTiming& inputTiming() const { return inputTiming_; }
+    const CallbackTiming& outputTiming() const { return outputTiming_; }
+
+    void resetTiming() {
+        inputTiming_.reset();
+        outputTiming_.reset();
+    }
+
+    RingStats::Snapshot readRingStats() {
+        return ringStats_.read();
+    }
+
     bool hasAudioActivity() const {
         // Consider audio active if we've seen non-silent audio in the last 500ms
         auto now = std::chrono::steady_clock::now().time_since_epoch().count();
@@ -356,7 +236,10 @@ private:
                                  AudioBufferList* /* outputData */,
                                  const AudioTimeStamp* /* outputTime */,
                                  void* clientData) {
+        rtsan::Scope scope("AudioPassthrough::InputIOProc");
+        trace::Scope traceScope("passthrough input IOProc");
         auto* self = static_cast<AudioPassthrough*>(clientData);
+        CallbackTiming::Scope timing(self->inputTiming_);
 
         // Read from the INPUT side of the virtual device
         // The driver's loopback puts output audio into the input stream
@@ -364,6 +247,7 @@ private:
             for (UInt32 i = 0; i < inputData->mNumberBuffers; i++) {
                 const AudioBuffer& buf = inputData->mBuffers[i];
                 if (buf.mData && buf.mDataByteSize > 0) {
+                    timing.setPeriod(buf.mDataByteSize / self->format_.mBytesPerFrame, self->format_.mSampleRate);
                     self->ringBuffer_->write(buf.mData, buf.mDataByteSize);
 
                     // Check for non-silent audio (any sample above -60dB threshold)
@@ -391,12 +275,16 @@ private:
                                   AudioBufferList* outputData,
                                   const AudioTimeStamp* /* outputTime */,
                                   void* clientData) {
+        rtsan::Scope scope("AudioPassthrough::OutputIOProc");
+        trace::Scope traceScope("passthrough output IOProc");
         auto* self = static_cast<AudioPassthrough*>(clientData);
+        CallbackTiming::Scope timing(self->outputTiming_);
 
         if (outputData && outputData->mNumberBuffers > 0) {
             for (UInt32 i = 0; i < outputData->mNumberBuffers; i++) {
                 AudioBuffer& buf = outputData->mBuffers[i];
                 if (buf.mData && buf.mDataByteSize > 0) {
+                    timing.setPeriod(buf.mDataByteSize / self->format_.mBytesPerFrame, self->format_.mSampleRate);
                     self->ringBuffer_->read(buf.mData, buf.mDataByteSize);
 
                     // Apply volume
@@ -424,6 +312,9 @@ private:
     AudioStreamBasicDescription format_;
     std::atomic<float> volume_;
     std::atomic<int64_t> lastActivityTime_;
+    CallbackTiming inputTiming_;
+    CallbackTiming outputTiming_;
+    RingStats ringStats_;
 };
 
 // Store passthrough instances with their device names for activity lookup
@@ -436,1043 +327,3515 @@ struct PassthroughInfo {
 // Global passthrough instances (one per channel)
 std::vector<PassthroughInfo> g_passthroughs;
 std::mutex g_mutex;
+// Bumped by stopAllPassthrough(); a start that began under an older value
+// is cancelled instead of registered
+std::atomic<uint64_t> g_passthroughGeneration{0};
 
-// Helper function to find device by name
-AudioDeviceID findDeviceByName(const std::string& name, bool isOutput) {
-    AudioObjectPropertyAddress propAddr = {
-        kAudioHardwarePropertyDevices,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
+// =============================================================================
+// DeviceRegistry - cached view of the HAL device list
+// Built once on first use, then kept current from HAL property listeners so
+// lookups never have to re-enumerate kAudioHardwarePropertyDevices
+// =============================================================================
 
-    UInt32 propSize = 0;
-    OSStatus status = AudioObjectGetPropertyDataSize(kAudioObjectSystemObject, &propAddr,
-                                                      0, nullptr, &propSize);
-    if (status != noErr) {
-        return kAudioObjectUnknown;
-    }
+struct DeviceInfo {
+    AudioDeviceID id = kAudioObjectUnknown;
+    std::string name;
+    std::string uid;
+    bool hasInput = false;
+    bool hasOutput = false;
+    UInt32 inputChannels = 0;
+    UInt32 outputChannels = 0;
+    Float64 sampleRate = 0;
+};
 
-    UInt32 deviceCount = propSize / sizeof(AudioDeviceID);
-    std::vector<AudioDeviceID> devices(deviceCount);
+// Change notification delivered to JS
+struct DeviceChangeEvent {
+    std::string type;      // "added", "removed", "changed", "default-output"
+    AudioDeviceID deviceId;
+    std::string name;
+    std::string uid;
+};
 
-    status = AudioObjectGetPropertyData(kAudioObjectSystemObject, &propAddr,
-                                        0, nullptr, &propSize, devices.data());
-    if (status != noErr) {
-        return kAudioObjectUnknown;
+static std::string cfStringToStdString(CFStringRef str) {
+    if (!str) {
+        return std::string();
     }
-
-    for (AudioDeviceID deviceID : devices) {
-        // Check if device has the right direction
-        propAddr.mSelector = kAudioDevicePropertyStreams;
-        propAddr.mScope = isOutput ? kAudioDevicePropertyScopeOutput : kAudioDevicePropertyScopeInput;
-
-        status = AudioObjectGetPropertyDataSize(deviceID, &propAddr, 0, nullptr, &propSize);
-        if (status != noErr || propSize == 0) {
-            continue;
-        }
-
-        // Get device name
-        propAddr.mSelector = kAudioObjectPropertyName;
-        propAddr.mScope = kAudioObjectPropertyScopeGlobal;
-
-        CFStringRef deviceName = nullptr;
-        propSize = sizeof(deviceName);
-        status = AudioObjectGetPropertyData(deviceID, &propAddr, 0, nullptr, &propSize, &deviceName);
-        if (status != noErr || !deviceName) {
-            continue;
-        }
-
-        char nameBuf[256];
-        if (CFStringGetCString(deviceName, nameBuf, sizeof(nameBuf), kCFStringEncodingUTF8)) {
-            if (name == nameBuf) {
-                CFRelease(deviceName);
-                return deviceID;
-            }
-        }
-        CFRelease(deviceName);
+    char buf[256];
+    if (CFStringGetCString(str, buf, sizeof(buf), kCFStringEncodingUTF8)) {
+        return std::string(buf);
     }
-
-    return kAudioObjectUnknown;
+    return std::string();
 }
 
-// Get default output device
-AudioDeviceID getDefaultOutputDevice() {
-    AudioDeviceID deviceID = kAudioObjectUnknown;
-    UInt32 propSize = sizeof(deviceID);
-    AudioObjectPropertyAddress propAddr = {
-        kAudioHardwarePropertyDefaultOutputDevice,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
+class DeviceRegistry {
+public:
+    using ChangeCallback = std::function<void(const DeviceChangeEvent&)>;
 
-    AudioObjectGetPropertyData(kAudioObjectSystemObject, &propAddr, 0, nullptr, &propSize, &deviceID);
-    return deviceID;
-}
+    static DeviceRegistry& instance() {
+        // Intentionally leaked: HAL listeners may fire during process teardown
+        static DeviceRegistry* registry = new DeviceRegistry();
+        return *registry;
+    }
 
-// NOTE: App name detection for audio clients is not currently implemented.
-// CoreAudio's kAudioDevicePropertyClientList and kAudioHardwarePropertyProcessObjectList
-// are not accessible from HAL plugin context. A future phase will implement this
-// using a privileged helper daemon with access to private AudioHardwareService APIs.
+    // Build the initial snapshot and install listeners (once)
+    void ensureStarted() {
+        std::call_once(startOnce_, [this]() {
+            AudioObjectPropertyAddress addr = {
+                kAudioHardwarePropertyDevices,
+                kAudioObjectPropertyScopeGlobal,
+                kAudioObjectPropertyElementMain
+            };
+            AudioObjectAddPropertyListener(kAudioObjectSystemObject, &addr, SystemListener, this);
+            addr.mSelector = kAudioHardwarePropertyDefaultOutputDevice;
+            AudioObjectAddPropertyListener(kAudioObjectSystemObject, &addr, SystemListener, this);
 
-// ============================================================================
-// AudioMixer - BEACN-style multi-input mixer
-// Reads from multiple PCPanel devices and mixes to a single output
-// ============================================================================
+            refreshDeviceList(false);
+            refreshDefaultOutput(false);
+        });
+    }
 
-class AudioMixer {
-public:
-    struct InputChannel {
-        AudioDeviceID deviceId;
-        std::string name;
-        AudioDeviceIOProcID inputProcID;
-        std::unique_ptr<RingBuffer> ringBuffer;
-        std::unique_ptr<SampleRateConverter> converter;  // For sample rate conversion
-        Float64 inputSampleRate;                         // Actual input device sample rate
-        std::atomic<float> gain;
-        std::atomic<bool> enabled;
-        std::atomic<int64_t> lastActivityTime;
-        std::atomic<float> peakLevel;      // Peak level (0.0-1.0)
-        std::atomic<float> rmsLevel;       // RMS level (0.0-1.0)
-
-        InputChannel()
-            : deviceId(kAudioObjectUnknown)
-            , inputProcID(nullptr)
-            , inputSampleRate(48000.0)
-            , gain(1.0f)
-            , enabled(true)
-            , lastActivityTime(0)
-            , peakLevel(0.0f)
-            , rmsLevel(0.0f)
-        {}
-
-        // Move constructor
-        InputChannel(InputChannel&& other) noexcept
-            : deviceId(other.deviceId)
-            , name(std::move(other.name))
-            , inputProcID(other.inputProcID)
-            , ringBuffer(std::move(other.ringBuffer))
-            , converter(std::move(other.converter))
-            , inputSampleRate(other.inputSampleRate)
-            , gain(other.gain.load())
-            , enabled(other.enabled.load())
-            , lastActivityTime(other.lastActivityTime.load())
-            , peakLevel(other.peakLevel.load())
-            , rmsLevel(other.rmsLevel.load())
-        {
-            other.deviceId = kAudioObjectUnknown;
-            other.inputProcID = nullptr;
-        }
-
-        // Move assignment
-        InputChannel& operator=(InputChannel&& other) noexcept {
-            if (this != &other) {
-                deviceId = other.deviceId;
-                name = std::move(other.name);
-                inputProcID = other.inputProcID;
-                ringBuffer = std::move(other.ringBuffer);
-                converter = std::move(other.converter);
-                inputSampleRate = other.inputSampleRate;
-                gain.store(other.gain.load());
-                enabled.store(other.enabled.load());
-                lastActivityTime.store(other.lastActivityTime.load());
-                peakLevel.store(other.peakLevel.load());
-                rmsLevel.store(other.rmsLevel.load());
-                other.deviceId = kAudioObjectUnknown;
-                other.inputProcID = nullptr;
+    AudioDeviceID findByName(const std::string& name, bool isOutput) {
+        ensureStarted();
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = byName_.find(name);
+        if (it == byName_.end()) {
+            return kAudioObjectUnknown;
+        }
+        // Names are not unique, but the list behind a name is almost always one entry
+        for (AudioDeviceID id : it->second) {
+            const DeviceInfo& dev = devices_.at(id);
+            if (isOutput ? dev.hasOutput : dev.hasInput) {
+                return id;
             }
-            return *this;
         }
-    };
-
-    AudioMixer(const std::string& name)
-        : name_(name)
-        , outputDevice_(kAudioObjectUnknown)
-        , outputProcID_(nullptr)
-        , running_(false)
-        , masterVolume_(1.0f)
-        , outputSampleRate_(48000.0)
-    {}
+        return kAudioObjectUnknown;
+    }
 
-    ~AudioMixer() {
-        stop();
+    AudioDeviceID findByUID(const std::string& uid) {
+        ensureStarted();
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = byUid_.find(uid);
+        return it != byUid_.end() ? it->second : kAudioObjectUnknown;
     }
 
-    bool addInput(const std::string& deviceName) {
-        AudioDeviceID deviceId = findDeviceByName(deviceName, false);
-        if (deviceId == kAudioObjectUnknown) {
-            deviceId = findDeviceByName(deviceName, true);
-        }
-        if (deviceId == kAudioObjectUnknown) {
-            fprintf(stderr, "[AudioMixer] Device not found: %s\n", deviceName.c_str());
+    bool getInfo(AudioDeviceID id, DeviceInfo& out) {
+        ensureStarted();
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = devices_.find(id);
+        if (it == devices_.end()) {
             return false;
         }
+        out = it->second;
+        return true;
+    }
 
+    std::vector<DeviceInfo> snapshot() {
+        ensureStarted();
         std::lock_guard<std::mutex> lock(mutex_);
-
-        // Check if already added
-        for (const auto& ch : inputs_) {
-            if (ch.name == deviceName) {
-                return true;  // Already exists
-            }
+        std::vector<DeviceInfo> result;
+        result.reserve(order_.size());
+        for (AudioDeviceID id : order_) {
+            result.push_back(devices_.at(id));
         }
+        return result;
+    }
 
-        InputChannel channel;
-        channel.deviceId = deviceId;
-        channel.name = deviceName;
-        channel.gain.store(1.0f);
-        channel.enabled.store(true);
-
-        inputs_.push_back(std::move(channel));
-        fprintf(stderr, "[AudioMixer] Added input: %s (device %u)\n", deviceName.c_str(), deviceId);
-        return true;
+    AudioDeviceID defaultOutput() {
+        ensureStarted();
+        return defaultOutput_.load();
     }
 
-    bool setInputGain(const std::string& deviceName, float gain) {
+    // Resolve a persistent device UID into a compact handle (1-based, 0 is
+    // invalid). Handles are never reused, survive the device disappearing and
+    // reappearing under a new AudioDeviceID, and can be resolved before the
+    // device exists.
+    uint32_t resolveUID(const std::string& uid) {
+        if (uid.empty()) {
+            return kInvalidDeviceHandle;
+        }
+        ensureStarted();
         std::lock_guard<std::mutex> lock(mutex_);
-        for (auto& ch : inputs_) {
-            if (ch.name == deviceName) {
-                ch.gain.store(std::max(0.0f, std::min(1.0f, gain)));
-                return true;
-            }
+        auto it = handleByUid_.find(uid);
+        if (it != handleByUid_.end()) {
+            return it->second;
         }
-        return false;
+        HandleEntry entry;
+        entry.uid = uid;
+        auto devIt = byUid_.find(uid);
+        entry.deviceId = devIt != byUid_.end() ? devIt->second : kAudioObjectUnknown;
+        handles_.push_back(std::move(entry));
+        uint32_t handle = static_cast<uint32_t>(handles_.size());
+        handleByUid_[uid] = handle;
+        return handle;
+    }
+
+    // Current AudioDeviceID behind a handle (kAudioObjectUnknown while absent)
+    AudioDeviceID deviceForHandle(uint32_t handle) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (handle == kInvalidDeviceHandle || handle > handles_.size()) {
+            return kAudioObjectUnknown;
+        }
+        return handles_[handle - 1].deviceId;
     }
 
-    bool setInputEnabled(const std::string& deviceName, bool enabled) {
+    bool uidForHandle(uint32_t handle, std::string& uid) {
         std::lock_guard<std::mutex> lock(mutex_);
-        for (auto& ch : inputs_) {
-            if (ch.name == deviceName) {
-                ch.enabled.store(enabled);
-                return true;
-            }
+        if (handle == kInvalidDeviceHandle || handle > handles_.size()) {
+            return false;
         }
-        return false;
+        uid = handles_[handle - 1].uid;
+        return true;
     }
 
-    void setMasterVolume(float volume) {
-        masterVolume_.store(std::max(0.0f, std::min(1.0f, volume)));
+    static constexpr uint32_t kInvalidDeviceHandle = 0;
+
+    void setChangeCallback(ChangeCallback callback) {
+        std::lock_guard<std::mutex> lock(callbackMutex_);
+        callback_ = std::move(callback);
     }
 
-    bool setOutput(AudioDeviceID outputDevice) {
-        if (running_) {
-            fprintf(stderr, "[AudioMixer] Cannot change output while running\n");
+private:
+    DeviceRegistry() : defaultOutput_(kAudioObjectUnknown) {}
+
+    struct HandleEntry {
+        std::string uid;
+        AudioDeviceID deviceId = kAudioObjectUnknown;
+    };
+
+    // Query everything we cache about a device. Runs without mutex_ held since
+    // HAL property reads can block.
+    static bool queryDevice(AudioDeviceID id, DeviceInfo& info) {
+        info.id = id;
+
+        AudioObjectPropertyAddress addr = {
+            kAudioObjectPropertyName,
+            kAudioObjectPropertyScopeGlobal,
+            kAudioObjectPropertyElementMain
+        };
+
+        CFStringRef cfName = nullptr;
+        UInt32 propSize = sizeof(cfName);
+        OSStatus status = AudioObjectGetPropertyData(id, &addr, 0, nullptr, &propSize, &cfName);
+        if (status != noErr || !cfName) {
             return false;
         }
-        outputDevice_ = outputDevice;
+        info.name = cfStringToStdString(cfName);
+        CFRelease(cfName);
+
+        addr.mSelector = kAudioDevicePropertyDeviceUID;
+        CFStringRef cfUid = nullptr;
+        propSize = sizeof(cfUid);
+        status = AudioObjectGetPropertyData(id, &addr, 0, nullptr, &propSize, &cfUid);
+        if (status == noErr && cfUid) {
+            info.uid = cfStringToStdString(cfUid);
+            CFRelease(cfUid);
+        }
+
+        addr.mSelector = kAudioDevicePropertyNominalSampleRate;
+        propSize = sizeof(info.sampleRate);
+        AudioObjectGetPropertyData(id, &addr, 0, nullptr, &propSize, &info.sampleRate);
+
+        // Direction is determined by the presence of streams, channel counts by
+        // the stream configuration
+        addr.mSelector = kAudioDevicePropertyStreams;
+        addr.mScope = kAudioDevicePropertyScopeOutput;
+        status = AudioObjectGetPropertyDataSize(id, &addr, 0, nullptr, &propSize);
+        info.hasOutput = (status == noErr && propSize > 0);
+
+        addr.mScope = kAudioDevicePropertyScopeInput;
+        status = AudioObjectGetPropertyDataSize(id, &addr, 0, nullptr, &propSize);
+        info.hasInput = (status == noErr && propSize > 0);
+
+        info.outputChannels = queryChannelCount(id, kAudioDevicePropertyScopeOutput);
+        info.inputChannels = queryChannelCount(id, kAudioDevicePropertyScopeInput);
         return true;
     }
 
-    bool start() {
-        if (running_) {
-            return true;
+    static UInt32 queryChannelCount(AudioDeviceID id, AudioObjectPropertyScope scope) {
+        AudioObjectPropertyAddress addr = {
+            kAudioDevicePropertyStreamConfiguration,
+            scope,
+            kAudioObjectPropertyElementMain
+        };
+
+        UInt32 propSize = 0;
+        if (AudioObjectGetPropertyDataSize(id, &addr, 0, nullptr, &propSize) != noErr || propSize == 0) {
+            return 0;
         }
 
-        // Use default output if not set
-        if (outputDevice_ == kAudioObjectUnknown) {
-            outputDevice_ = getDefaultOutputDevice();
+        std::vector<uint8_t> storage(propSize);
+        auto* bufferList = reinterpret_cast<AudioBufferList*>(storage.data());
+        if (AudioObjectGetPropertyData(id, &addr, 0, nullptr, &propSize, bufferList) != noErr) {
+            return 0;
         }
-        if (outputDevice_ == kAudioObjectUnknown) {
-            fprintf(stderr, "[AudioMixer] No output device\n");
-            return false;
+
+        UInt32 channels = 0;
+        for (UInt32 i = 0; i < bufferList->mNumberBuffers; i++) {
+            channels += bufferList->mBuffers[i].mNumberChannels;
         }
+        return channels;
+    }
 
-        // Get output device's actual sample rate - we'll use this as our target
-        AudioObjectPropertyAddress propAddr = {
-            kAudioDevicePropertyNominalSampleRate,
+    void refreshDeviceList(bool notify) {
+        // Initial build and listener callbacks can overlap
+        std::lock_guard<std::mutex> refreshLock(refreshMutex_);
+
+        AudioObjectPropertyAddress addr = {
+            kAudioHardwarePropertyDevices,
             kAudioObjectPropertyScopeGlobal,
             kAudioObjectPropertyElementMain
         };
-        Float64 outputSampleRate = 48000.0;
-        UInt32 propSize = sizeof(outputSampleRate);
-        AudioObjectGetPropertyData(outputDevice_, &propAddr, 0, nullptr, &propSize, &outputSampleRate);
 
-        fprintf(stderr, "[AudioMixer] Output device %u sample rate: %.0f Hz\n",
-                outputDevice_, outputSampleRate);
-
-        // Store output sample rate for use in OutputIOProc
-        outputSampleRate_ = outputSampleRate;
+        UInt32 propSize = 0;
+        if (AudioObjectGetPropertyDataSize(kAudioObjectSystemObject, &addr, 0, nullptr, &propSize) != noErr) {
+            return;
+        }
 
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<AudioDeviceID> ids(propSize / sizeof(AudioDeviceID));
+        if (AudioObjectGetPropertyData(kAudioObjectSystemObject, &addr, 0, nullptr,
+                                       &propSize, ids.data()) != noErr) {
+            return;
+        }
+        ids.resize(propSize / sizeof(AudioDeviceID));
 
-        // Set up each input channel
-        for (auto& ch : inputs_) {
-            // Get the input device's actual sample rate
-            Float64 inputSampleRate = 48000.0;
-            UInt32 rateSize = sizeof(inputSampleRate);
-            AudioObjectGetPropertyData(ch.deviceId, &propAddr, 0, nullptr, &rateSize, &inputSampleRate);
-
-            // Store the input sample rate for this channel
-            ch.inputSampleRate = inputSampleRate;
-
-            fprintf(stderr, "[AudioMixer] Input %s sample rate: %.0f Hz\n",
-                    ch.name.c_str(), inputSampleRate);
-
-            // Create sample rate converter if rates don't match
-            if (inputSampleRate != outputSampleRate) {
-                fprintf(stderr, "[AudioMixer] Creating sample rate converter for %s: %.0f -> %.0f Hz\n",
-                        ch.name.c_str(), inputSampleRate, outputSampleRate);
-                ch.converter = std::make_unique<SampleRateConverter>(inputSampleRate, outputSampleRate, 2);
-            } else {
-                ch.converter.reset();  // No conversion needed
-                fprintf(stderr, "[AudioMixer] No sample rate conversion needed for %s\n", ch.name.c_str());
+        // Only newly appeared devices need a full query
+        std::vector<AudioDeviceID> added;
+        std::vector<DeviceInfo> removed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (AudioDeviceID id : ids) {
+                if (devices_.find(id) == devices_.end()) {
+                    added.push_back(id);
+                }
             }
-
-            // Create ring buffer (10 seconds at stereo Float32)
-            // Large buffer to absorb any timing variations between IOProcs
-            ch.ringBuffer = std::make_unique<RingBuffer>(
-                static_cast<size_t>(inputSampleRate * 10),
-                2,  // stereo
-                sizeof(Float32) * 2
-            );
-
-            // Create input IOProc
-            OSStatus status = AudioDeviceCreateIOProcID(ch.deviceId, InputIOProc, this, &ch.inputProcID);
-            if (status != noErr) {
-                fprintf(stderr, "[AudioMixer] Failed to create input IOProc for %s: %d\n",
-                        ch.name.c_str(), status);
-                continue;
+            for (AudioDeviceID id : order_) {
+                if (std::find(ids.begin(), ids.end(), id) == ids.end()) {
+                    removed.push_back(devices_.at(id));
+                }
             }
+        }
 
-            // Start input
-            status = AudioDeviceStart(ch.deviceId, ch.inputProcID);
-            if (status != noErr) {
-                fprintf(stderr, "[AudioMixer] Failed to start input for %s: %d\n",
-                        ch.name.c_str(), status);
-                AudioDeviceDestroyIOProcID(ch.deviceId, ch.inputProcID);
-                ch.inputProcID = nullptr;
-                continue;
+        std::vector<DeviceInfo> addedInfo;
+        for (AudioDeviceID id : added) {
+            DeviceInfo info;
+            if (queryDevice(id, info)) {
+                addedInfo.push_back(std::move(info));
             }
-
-            fprintf(stderr, "[AudioMixer] Started input: %s\n", ch.name.c_str());
         }
 
-        // Create output IOProc
-        OSStatus status = AudioDeviceCreateIOProcID(outputDevice_, OutputIOProc, this, &outputProcID_);
-        if (status != noErr) {
-            fprintf(stderr, "[AudioMixer] Failed to create output IOProc: %d\n", status);
-            stopInputs();
-            return false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const DeviceInfo& info : removed) {
+                eraseLocked(info.id);
+            }
+            for (const DeviceInfo& info : addedInfo) {
+                insertLocked(info);
+            }
+            // Keep HAL enumeration order for listings
+            std::vector<AudioDeviceID> order;
+            for (AudioDeviceID id : ids) {
+                if (devices_.find(id) != devices_.end()) {
+                    order.push_back(id);
+                }
+            }
+            order_ = std::move(order);
         }
 
-        // Start output
-        status = AudioDeviceStart(outputDevice_, outputProcID_);
-        if (status != noErr) {
-            fprintf(stderr, "[AudioMixer] Failed to start output: %d\n", status);
-            AudioDeviceDestroyIOProcID(outputDevice_, outputProcID_);
-            outputProcID_ = nullptr;
-            stopInputs();
-            return false;
+        for (const DeviceInfo& info : removed) {
+            setDeviceListeners(info.id, false);
+            if (notify) emit({"removed", info.id, info.name, info.uid});
+        }
+        for (const DeviceInfo& info : addedInfo) {
+            setDeviceListeners(info.id, true);
+            if (notify) emit({"added", info.id, info.name, info.uid});
         }
-
-        running_ = true;
-        fprintf(stderr, "[AudioMixer] Started successfully\n");
-        return true;
     }
 
-    void stop() {
-        if (!running_) {
+    void refreshDevice(AudioDeviceID id) {
+        DeviceInfo info;
+        if (!queryDevice(id, info)) {
             return;
         }
-
-        running_ = false;
-
-        std::lock_guard<std::mutex> lock(mutex_);
-
-        // Stop output
-        if (outputProcID_) {
-            AudioDeviceStop(outputDevice_, outputProcID_);
-            AudioDeviceDestroyIOProcID(outputDevice_, outputProcID_);
-            outputProcID_ = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (devices_.find(id) == devices_.end()) {
+                return;  // Removed while we were querying
+            }
+            insertLocked(info);
         }
-
-        stopInputs();
-        fprintf(stderr, "[AudioMixer] Stopped\n");
+        emit({"changed", info.id, info.name, info.uid});
+    }
+
+    void refreshDefaultOutput(bool notify) {
+        AudioDeviceID deviceID = kAudioObjectUnknown;
+        UInt32 propSize = sizeof(deviceID);
+        AudioObjectPropertyAddress addr = {
+            kAudioHardwarePropertyDefaultOutputDevice,
+            kAudioObjectPropertyScopeGlobal,
+            kAudioObjectPropertyElementMain
+        };
+        AudioObjectGetPropertyData(kAudioObjectSystemObject, &addr, 0, nullptr, &propSize, &deviceID);
+        defaultOutput_.store(deviceID);
+
+        if (notify) {
+            DeviceChangeEvent event{"default-output", deviceID, "", ""};
+            DeviceInfo info;
+            if (getInfo(deviceID, info)) {
+                event.name = info.name;
+                event.uid = info.uid;
+            }
+            emit(event);
+        }
+    }
+
+    // Caller holds mutex_ (order_ is maintained by refreshDeviceList)
+    void insertLocked(const DeviceInfo& info) {
+        eraseLocked(info.id);
+        devices_[info.id] = info;
+        byName_[info.name].push_back(info.id);
+        if (!info.uid.empty()) {
+            byUid_[info.uid] = info.id;
+            auto handleIt = handleByUid_.find(info.uid);
+            if (handleIt != handleByUid_.end()) {
+                handles_[handleIt->second - 1].deviceId = info.id;
+            }
+        }
+    }
+
+    void eraseLocked(AudioDeviceID id) {
+        auto it = devices_.find(id);
+        if (it == devices_.end()) {
+            return;
+        }
+        auto nameIt = byName_.find(it->second.name);
+        if (nameIt != byName_.end()) {
+            auto& ids = nameIt->second;
+            ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+            if (ids.empty()) {
+                byName_.erase(nameIt);
+            }
+        }
+        auto uidIt = byUid_.find(it->second.uid);
+        if (uidIt != byUid_.end() && uidIt->second == id) {
+            byUid_.erase(uidIt);
+            auto handleIt = handleByUid_.find(it->second.uid);
+            if (handleIt != handleByUid_.end()) {
+                handles_[handleIt->second - 1].deviceId = kAudioObjectUnknown;
+            }
+        }
+        devices_.erase(it);
+    }
+
+    void setDeviceListeners(AudioDeviceID id, bool add) {
+        static const AudioObjectPropertySelector kSelectors[] = {
+            kAudioObjectPropertyName,
+            kAudioDevicePropertyNominalSampleRate,
+            kAudioDevicePropertyStreams,
+            kAudioDevicePropertyStreamConfiguration,
+        };
+        for (AudioObjectPropertySelector selector : kSelectors) {
+            AudioObjectPropertyAddress addr = {
+                selector,
+                kAudioObjectPropertyScopeWildcard,
+                kAudioObjectPropertyElementWildcard
+            };
+            if (add) {
+                AudioObjectAddPropertyListener(id, &addr, DeviceListener, this);
+            } else {
+                AudioObjectRemovePropertyListener(id, &addr, DeviceListener, this);
+            }
+        }
+    }
+
+    void emit(const DeviceChangeEvent& event) {
+        std::lock_guard<std::mutex> lock(callbackMutex_);
+        if (callback_) {
+            callback_(event);
+        }
+    }
+
+    // HAL listeners run on a CoreAudio notification thread, never the IO thread
+    static OSStatus SystemListener(AudioObjectID /* object */,
+                                   UInt32 numAddresses,
+                                   const AudioObjectPropertyAddress* addresses,
+                                   void* clientData) {
+        auto* self = static_cast<DeviceRegistry*>(clientData);
+        for (UInt32 i = 0; i < numAddresses; i++) {
+            if (addresses[i].mSelector == kAudioHardwarePropertyDevices) {
+                self->refreshDeviceList(true);
+            } else if (addresses[i].mSelector == kAudioHardwarePropertyDefaultOutputDevice) {
+                self->refreshDefaultOutput(true);
+            }
+        }
+        return noErr;
+    }
+
+    static OSStatus DeviceListener(AudioObjectID object,
+                                   UInt32 /* numAddresses */,
+                                   const AudioObjectPropertyAddress* /* addresses */,
+                                   void* clientData) {
+        // Any cached property changed - requery this one device
+        static_cast<DeviceRegistry*>(clientData)->refreshDevice(object);
+        return noErr;
+    }
+
+    std::once_flag startOnce_;
+    std::mutex refreshMutex_;
+    std::mutex mutex_;
+    std::unordered_map<AudioDeviceID, DeviceInfo> devices_;
+    std::unordered_map<std::string, std::vector<AudioDeviceID>> byName_;
+    std::unordered_map<std::string, AudioDeviceID> byUid_;
+    std::vector<AudioDeviceID> order_;
+    std::vector<HandleEntry> handles_;                       // index = handle - 1
+    std::unordered_map<std::string, uint32_t> handleByUid_;
+    std::atomic<AudioDeviceID> defaultOutput_;
+    std::mutex callbackMutex_;
+    ChangeCallback callback_;
+};
+
+// Helper function to find device by name
+AudioDeviceID findDeviceByName(const std::string& name, bool isOutput) {
+    return DeviceRegistry::instance().findByName(name, isOutput);
+}
+
+// Get default output device
+AudioDeviceID getDefaultOutputDevice() {
+    return DeviceRegistry::instance().defaultOutput();
+}
+
+// Resolve a UID or (legacy) display name into a device handle, or 0 if
+// unknown. Safe on worker threads.
+uint32_t deviceHandleFromRef(const std::string& ref) {
+    DeviceRegistry& registry = DeviceRegistry::instance();
+    if (registry.findByUID(ref) != kAudioObjectUnknown) {
+        return registry.resolveUID(ref);
+    }
+
+    // Display name: prefer the input side (loopback), then output
+    AudioDeviceID deviceId = registry.findByName(ref, false);
+    if (deviceId == kAudioObjectUnknown) {
+        deviceId = registry.findByName(ref, true);
+    }
+    DeviceInfo dev;
+    if (deviceId == kAudioObjectUnknown || !registry.getInfo(deviceId, dev)) {
+        return DeviceRegistry::kInvalidDeviceHandle;
+    }
+    return registry.resolveUID(dev.uid);
+}
+
+// Resolve a device reference from JS: a handle from resolveDevice(), a UID,
+// or (legacy) a display name. Returns the device handle, or 0 if unknown.
+uint32_t deviceHandleFromValue(const Napi::Value& value) {
+    if (value.IsNumber()) {
+        return value.As<Napi::Number>().Uint32Value();
+    }
+    if (!value.IsString()) {
+        return DeviceRegistry::kInvalidDeviceHandle;
+    }
+    return deviceHandleFromRef(value.As<Napi::String>().Utf8Value());
+}
+
+// NOTE: App name detection for audio clients is not currently implemented.
+// CoreAudio's kAudioDevicePropertyClientList and kAudioHardwarePropertyProcessObjectList
+// are not accessible from HAL plugin context. A future phase will implement this
+// using a privileged helper daemon with access to private AudioHardwareService APIs.
+
+// ============================================================================
+// AudioMixer - BEACN-style multi-input mixer
+// Reads from multiple PCPanel devices and mixes to a single output
+// ============================================================================
+
+class AudioMixer {
+public:
+    // Device side of one input; its audio state lives in engine_.input(slot)
+    struct InputChannel {
+        AudioDeviceID deviceId = kAudioObjectUnknown;
+        uint32_t deviceHandle = DeviceRegistry::kInvalidDeviceHandle;  // Registry handle (persistent UID)
+        std::string name;
+        std::string uid;
+        int slot = -1;
+        AudioDeviceIOProcID inputProcID = nullptr;
+    };
+
+    // inputs_ never reallocates, so IOProcs can hold pointers into it
+    static constexpr size_t kMaxInputs = MixerParams::kMaxInputs;
+    static constexpr uint32_t kMaxDeviceHandles = MixerParams::kMaxDeviceHandles;
+
+    using ParamUpdate = MixerParams::ParamUpdate;
+
+    AudioMixer(const std::string& name)
+        : name_(name)
+        , params_(engine_.params())
+        , outputDevice_(kAudioObjectUnknown)
+        , outputProcID_(nullptr)
+        , running_(false)
+    {
+        inputs_.reserve(kMaxInputs);
+        engine_.setStemRecorder(&stems_);
+    }
+
+    ~AudioMixer() {
+        stop();
+    }
+
+    bool addInput(uint32_t deviceHandle) {
+        DeviceRegistry& registry = DeviceRegistry::instance();
+        AudioDeviceID deviceId = registry.deviceForHandle(deviceHandle);
+        DeviceInfo dev;
+        if (deviceId == kAudioObjectUnknown || !registry.getInfo(deviceId, dev)) {
+            fprintf(stderr, "[AudioMixer] Device not found for handle %u\n", deviceHandle);
+            return false;
+        }
+
+        // Topology changes serialize with start/stop
+        std::lock_guard<std::mutex> lifecycle(lifecycleMutex_);
+
+        // Check if already added
+        if (params_.findInput(deviceHandle) >= 0) {
+            return true;  // Already exists
+        }
+        if (deviceHandle >= kMaxDeviceHandles || inputs_.size() >= kMaxInputs) {
+            fprintf(stderr, "[AudioMixer] Too many inputs, can't add %s\n", dev.name.c_str());
+            return false;
+        }
+
+        InputChannel channel;
+        channel.deviceId = deviceId;
+        channel.deviceHandle = deviceHandle;
+        channel.name = dev.name;
+        channel.uid = dev.uid;
+
+        int slot = static_cast<int>(inputs_.size());
+        channel.slot = slot;
+        trace::label(engine_.input(slot).traceId, dev.name + " -> " + name_);
+        inputs_.push_back(std::move(channel));
+        if (running_) {
+            // Bring the device up before the render side learns about it
+            startInput(inputs_[slot]);
+        }
+        params_.bindInput(deviceHandle, slot);
+
+        MixerParams::Command command = MixerParams::makeAddInput(slot);
+        if (!running_) {
+            // We already own the lifecycle lock, so consume directly
+            params_.drain();
+        }
+        if (!params_.push(&command, 1)) {
+            fprintf(stderr, "[AudioMixer] Command queue full, %s won't be mixed\n", dev.name.c_str());
+        } else if (!running_) {
+            params_.drain();
+        }
+
+        fprintf(stderr, "[AudioMixer] Added input: %s [%s] (device %u)\n",
+                dev.name.c_str(), dev.uid.c_str(), deviceId);
+        return true;
+    }
+
+    // Parameter setters never touch render state directly: they queue a
+    // command that the output IOProc applies at the start of its next cycle.
+    // Gain changes ramp across that cycle instead of stepping mid-buffer.
+    bool setInputGain(uint32_t deviceHandle, float gain) {
+        MixerParams::Command command;
+        if (!params_.makeSetGain(deviceHandle, gain, command)) {
+            return false;
+        }
+        return enqueue(&command, 1);
+    }
+
+    bool setInputEnabled(uint32_t deviceHandle, bool enabled) {
+        MixerParams::Command command;
+        if (!params_.makeSetEnabled(deviceHandle, enabled, command)) {
+            return false;
+        }
+        return enqueue(&command, 1);
+    }
+
+    // Queue a whole batch of parameter changes as one scene. The batch is
+    // published to the command queue atomically, so the output IOProc applies
+    // all of it in the same cycle and a scene recall or state restore never
+    // renders half-applied. Returns the number of updates that matched an input.
+    size_t applyUpdates(const std::vector<ParamUpdate>& updates) {
+        std::vector<MixerParams::Command> scene;
+        size_t matched = params_.makeScene(updates, scene);
+
+        if (!scene.empty() && !enqueue(scene.data(), scene.size())) {
+            return 0;
+        }
+        return matched;
+    }
+
+    // One input's compressor, switched and configured in a single batch
+    bool setInputCompressor(uint32_t deviceHandle, const CompressorSettings& settings) {
+        std::vector<MixerParams::Command> commands;
+        if (!params_.makeCompressor(deviceHandle, settings, commands)) {
+            return false;
+        }
+        return enqueue(commands.data(), commands.size());
+    }
+
+    // Replace the sidechain setup (key handle 0 turns it off). Key, targets
+    // and settings go out as one batch, so the output IOProc never renders a
+    // half-changed duck. False if the key isn't one of this mixer's inputs.
+    bool setDucking(const MixerParams::DuckingConfig& config) {
+        std::vector<MixerParams::Command> commands;
+        if (!params_.makeDucking(config, commands) || !enqueue(commands.data(), commands.size())) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(duckingMutex_);
+        ducking_ = config;
+        ducking_.settings = clampDuckSettings(config.settings);
+        return true;
+    }
+
+    MixerParams::DuckingConfig getDucking() const {
+        std::lock_guard<std::mutex> lock(duckingMutex_);
+        return ducking_;
+    }
+
+    float getDuckReductionDb() const { return engine_.duckReductionDb(); }
+
+    void setMasterVolume(float volume) {
+        MixerParams::Command command = MixerParams::makeSetMasterGain(volume);
+        enqueue(&command, 1);
+    }
+
+    bool setOutput(AudioDeviceID outputDevice) {
+        if (running_) {
+            fprintf(stderr, "[AudioMixer] Cannot change output while running\n");
+            return false;
+        }
+        outputDevice_ = outputDevice;
+        return true;
+    }
+
+    enum class StartResult { Started, Failed, Cancelled };
+
+    // start()/stop() may run on worker threads. Every lifecycle request from
+    // JS takes a ticket; a newer ticket cancels a start that is still in
+    // progress and supersedes an older stop that hasn't run yet.
+    uint64_t requestLifecycleChange() {
+        return generation_.fetch_add(1) + 1;
+    }
+
+    bool isSuperseded(uint64_t ticket) const {
+        return generation_.load() != ticket;
+    }
+
+    StartResult start() {
+        return start(requestLifecycleChange());
+    }
+
+    StartResult start(uint64_t ticket) {
+        std::lock_guard<std::mutex> lifecycle(lifecycleMutex_);
+
+        if (isSuperseded(ticket)) {
+            return StartResult::Cancelled;
+        }
+        if (running_) {
+            return StartResult::Started;
+        }
+
+        // Use default output if not set
+        if (outputDevice_ == kAudioObjectUnknown) {
+            outputDevice_ = getDefaultOutputDevice();
+        }
+        if (outputDevice_ == kAudioObjectUnknown) {
+            fprintf(stderr, "[AudioMixer] No output device\n");
+            return StartResult::Failed;
+        }
+
+        // Get output device's actual sample rate - we'll use this as our target
+        AudioObjectPropertyAddress propAddr = {
+            kAudioDevicePropertyNominalSampleRate,
+            kAudioObjectPropertyScopeGlobal,
+            kAudioObjectPropertyElementMain
+        };
+        Float64 outputSampleRate = 48000.0;
+        UInt32 propSize = sizeof(outputSampleRate);
+        AudioObjectGetPropertyData(outputDevice_, &propAddr, 0, nullptr, &propSize, &outputSampleRate);
+
+        fprintf(stderr, "[AudioMixer] Output device %u sample rate: %.0f Hz\n",
+                outputDevice_, outputSampleRate);
+
+        // Inputs convert to the output rate
+        engine_.setOutputSampleRate(outputSampleRate);
+
+        // Set up and start every input in parallel - AudioDeviceStart can take
+        // tens of milliseconds per device
+        StartInputsContext context = { this, ticket };
+        dispatch_apply_f(inputs_.size(),
+                         dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0),
+                         &context, StartInputTrampoline);
+
+        if (isSuperseded(ticket)) {
+            stopInputs();
+            fprintf(stderr, "[AudioMixer] Start cancelled\n");
+            return StartResult::Cancelled;
+        }
+
+        // Nothing is rendering yet, so this thread is the queue's consumer;
+        // settle the ramps so the first cycle starts at the configured levels
+        params_.drain();
+        params_.settle();
+
+        // Create output IOProc
+        OSStatus status = AudioDeviceCreateIOProcID(outputDevice_, OutputIOProc, this, &outputProcID_);
+        if (status != noErr) {
+            fprintf(stderr, "[AudioMixer] Failed to create output IOProc: %d\n", status);
+            stopInputs();
+            return StartResult::Failed;
+        }
+
+        // Start output
+        status = AudioDeviceStart(outputDevice_, outputProcID_);
+        if (status != noErr) {
+            fprintf(stderr, "[AudioMixer] Failed to start output: %d\n", status);
+            AudioDeviceDestroyIOProcID(outputDevice_, outputProcID_);
+            outputProcID_ = nullptr;
+            stopInputs();
+            return StartResult::Failed;
+        }
+
+        running_ = true;
+        fprintf(stderr, "[AudioMixer] Started successfully\n");
+        return StartResult::Started;
+    }
+
+    // Unconditional stop (destroy/shutdown)
+    void stop() {
+        std::lock_guard<std::mutex> lifecycle(lifecycleMutex_);
+        stopLocked();
+    }
+
+    // Stop on behalf of a JS request; returns false if a newer request
+    // superseded it before it ran
+    bool stop(uint64_t ticket) {
+        std::lock_guard<std::mutex> lifecycle(lifecycleMutex_);
+        if (isSuperseded(ticket)) {
+            return false;
+        }
+        stopLocked();
+        return true;
     }
 
     bool isRunning() const { return running_; }
     const std::string& getName() const { return name_; }
 
-    // Get input channel activity info
-    bool getInputActivity(const std::string& deviceName) const {
-        for (const auto& ch : inputs_) {
-            if (ch.name == deviceName) {
-                auto now = std::chrono::steady_clock::now().time_since_epoch().count();
-                auto elapsed = now - ch.lastActivityTime.load();
-                return elapsed < 500000000LL;  // 500ms
+    // Get input channel activity info
+    bool getInputActivity(uint32_t deviceHandle) const {
+        int slot = params_.findInput(deviceHandle);
+        if (slot < 0) {
+            return false;
+        }
+        auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+        auto elapsed = now - engine_.input(slot).lastActivityTime.load();
+        return elapsed < 500000000LL;  // 500ms
+    }
+
+    // Get all input levels for UI metering
+    struct LevelInfo {
+        std::string name;
+        std::string uid;
+        uint32_t deviceHandle;
+        float peak;
+        float rms;
+        float gainReductionDb;      // Compressor, 0 while it's off
+    };
+
+    std::vector<LevelInfo> getLevels() const {
+        std::vector<LevelInfo> levels;
+        for (const auto& ch : inputs_) {
+            LevelInfo info;
+            info.name = ch.name;
+            info.uid = ch.uid;
+            info.deviceHandle = ch.deviceHandle;
+            info.peak = engine_.input(ch.slot).peakLevel.load(std::memory_order_relaxed);
+            info.rms = engine_.input(ch.slot).rmsLevel.load(std::memory_order_relaxed);
+            info.gainReductionDb = engine_.input(ch.slot).gainReductionDb.load(std::memory_order_relaxed);
+            levels.push_back(info);
+        }
+        return levels;
+    }
+
+    // Callback timing for the diagnostics panel
+    struct InputTimingInfo {
+        std::string name;
+        std::string uid;
+        uint32_t deviceHandle;
+        CallbackTiming::Snapshot timing;
+    };
+
+    CallbackTiming::Snapshot getOutputTiming() const {
+        return outputTiming_.snapshot();
+    }
+
+    std::vector<InputTimingInfo> getInputTimings() const {
+        std::vector<InputTimingInfo> timings;
+        for (const auto& ch : inputs_) {
+            timings.push_back({ch.name, ch.uid, ch.deviceHandle, engine_.input(ch.slot).timing.snapshot()});
+        }
+        return timings;
+    }
+
+    void resetTiming() {
+        outputTiming_.reset();
+        for (const auto& ch : inputs_) {
+            engine_.input(ch.slot).timing.reset();
+        }
+    }
+
+    // Capture ring xruns per input; starts a new fill window for each
+    struct InputRingInfo {
+        std::string name;
+        std::string uid;
+        uint32_t deviceHandle;
+        RingStats::Snapshot stats;
+    };
+
+    std::vector<InputRingInfo> readRingStats() {
+        std::vector<InputRingInfo> rings;
+        for (const auto& ch : inputs_) {
+            rings.push_back({ch.name, ch.uid, ch.deviceHandle, engine_.input(ch.slot).ringStats.read()});
+        }
+        return rings;
+    }
+
+    // Record what the output IOProc renders. Only while running, so the file
+    // gets the rate the bus actually runs at; stopping the mixer ends the take.
+    bool startRecording(const std::string& path, BusRecorder::Format format, std::string& error) {
+        std::lock_guard<std::mutex> lifecycle(lifecycleMutex_);
+        if (!running_) {
+            error = name_ + " is not running";
+            return false;
+        }
+        if (!recorder_.start(path, format, engine_.outputSampleRate(), error)) {
+            return false;
+        }
+        fprintf(stderr, "[AudioMixer] %s recording to %s\n", name_.c_str(), path.c_str());
+        return true;
+    }
+
+    bool stopRecording(std::string& error) {
+        return recorder_.stop(&error);
+    }
+
+    BusRecorder::Stats getRecordingStats() const { return recorder_.stats(); }
+    std::string getRecordingPath() const { return recorder_.path(); }
+
+    // Keep the last windowSeconds of output in memory for saveReplay().
+    // Like recording, it only runs while the output does.
+    bool startReplay(double windowSeconds, size_t maxBytes, std::string& error) {
+        std::lock_guard<std::mutex> lifecycle(lifecycleMutex_);
+        if (!running_) {
+            error = name_ + " is not running";
+            return false;
+        }
+        return replay_.start(engine_.outputSampleRate(), windowSeconds, maxBytes, error);
+    }
+
+    bool saveReplay(const std::string& path, double seconds, double& savedSeconds, std::string& error) {
+        uint64_t frames = 0;
+        bool saved = replay_.save(path, seconds, frames, error);
+        double rate = replay_.stats().sampleRate;
+        savedSeconds = rate > 0 ? frames / rate : 0;
+        return saved;
+    }
+
+    // Record every input, after its gain, as aligned stems in directory.
+    // Inputs added after the start are not in the take.
+    bool startStems(const std::string& directory, StemRecorder::Layout layout, BusRecorder::Format format,
+                    std::string& error) {
+        std::lock_guard<std::mutex> lifecycle(lifecycleMutex_);
+        if (!running_) {
+            error = name_ + " is not running";
+            return false;
+        }
+        std::vector<StemRecorder::Stem> stems;
+        for (const InputChannel& ch : inputs_) {
+            if (ch.slot >= 0) {
+                stems.push_back({ch.slot, ch.name});
+            }
+        }
+        if (!stems_.start(directory, stems, layout, format, engine_.outputSampleRate(), error)) {
+            return false;
+        }
+        fprintf(stderr, "[AudioMixer] %s recording %zu stem(s) to %s\n", name_.c_str(), stems.size(),
+                directory.c_str());
+        return true;
+    }
+
+    bool stopStems(std::string& error) {
+        return stems_.stop(&error);
+    }
+
+    StemRecorder::Stats getStemStats() const { return stems_.stats(); }
+    std::vector<std::string> getStemPaths() const { return stems_.paths(); }
+
+    void stopReplay() { replay_.stop(); }
+    ReplayBuffer::Stats getReplayStats() const { return replay_.stats(); }
+
+private:
+    // Caller must not hold lifecycleMutex_
+    bool enqueue(const MixerParams::Command* commands, size_t count) {
+        bool queued = params_.push(commands, count);
+        if (!queued) {
+            // Nothing is draining while stopped - flush and retry once
+            flushIfIdle();
+            queued = params_.push(commands, count);
+        }
+        if (!queued) {
+            fprintf(stderr, "[AudioMixer] Command queue full, dropped %zu command(s)\n", count);
+            return false;
+        }
+        flushIfIdle();
+        return true;
+    }
+
+    // While stopped there is no IOProc to consume commands, so whoever can
+    // take the lifecycle lock without waiting applies them instead
+    void flushIfIdle() {
+        std::unique_lock<std::mutex> lifecycle(lifecycleMutex_, std::try_to_lock);
+        if (lifecycle.owns_lock() && !running_) {
+            params_.drain();
+        }
+    }
+
+    // Caller holds lifecycleMutex_
+    void stopLocked() {
+        if (!running_) {
+            return;
+        }
+
+        // Stop output
+        if (outputProcID_) {
+            AudioDeviceStop(outputDevice_, outputProcID_);
+            AudioDeviceDestroyIOProcID(outputDevice_, outputProcID_);
+            outputProcID_ = nullptr;
+        }
+
+        running_ = false;
+
+        // The file is finished before the output can come back at another rate
+        std::string recordError;
+        if (recorder_.isRecording() && !recorder_.stop(&recordError)) {
+            fprintf(stderr, "[AudioMixer] %s recording failed: %s\n", name_.c_str(), recordError.c_str());
+        }
+        replay_.stop();
+        if (stems_.isRecording() && !stems_.stop(&recordError)) {
+            fprintf(stderr, "[AudioMixer] %s stem recording failed: %s\n", name_.c_str(), recordError.c_str());
+        }
+
+        stopInputs();
+
+        // The IOProc is gone - apply anything it didn't get to
+        params_.drain();
+        fprintf(stderr, "[AudioMixer] Stopped\n");
+    }
+
+    struct StartInputsContext {
+        AudioMixer* mixer;
+        uint64_t ticket;
+    };
+
+    static void StartInputTrampoline(void* context, size_t index) {
+        auto* ctx = static_cast<StartInputsContext*>(context);
+        if (ctx->mixer->isSuperseded(ctx->ticket)) {
+            return;  // Cancelled - don't start any more devices
+        }
+        ctx->mixer->startInput(ctx->mixer->inputs_[index]);
+    }
+
+    // Set up one input channel. Runs concurrently for different channels
+    // (caller holds lifecycleMutex_); touches only this channel's state.
+    void startInput(InputChannel& ch) {
+        AudioObjectPropertyAddress propAddr = {
+            kAudioDevicePropertyNominalSampleRate,
+            kAudioObjectPropertyScopeGlobal,
+            kAudioObjectPropertyElementMain
+        };
+        Float64 outputSampleRate = engine_.outputSampleRate();
+
+        // Get the input device's actual sample rate
+        Float64 inputSampleRate = 48000.0;
+        UInt32 rateSize = sizeof(inputSampleRate);
+        AudioObjectGetPropertyData(ch.deviceId, &propAddr, 0, nullptr, &rateSize, &inputSampleRate);
+
+        fprintf(stderr, "[AudioMixer] Input %s sample rate: %.0f Hz\n",
+                ch.name.c_str(), inputSampleRate);
+
+        if (inputSampleRate != outputSampleRate) {
+            fprintf(stderr, "[AudioMixer] Creating sample rate converter for %s: %.0f -> %.0f Hz\n",
+                    ch.name.c_str(), inputSampleRate, outputSampleRate);
+        } else {
+            fprintf(stderr, "[AudioMixer] No sample rate conversion needed for %s\n", ch.name.c_str());
+        }
+
+        // Ring buffer and converter (if rates don't match) for this slot
+        engine_.prepareInput(ch.slot, inputSampleRate);
+
+        // Create input IOProc
+        OSStatus status = AudioDeviceCreateIOProcID(ch.deviceId, InputIOProc, &engine_.input(ch.slot),
+                                                    &ch.inputProcID);
+        if (status != noErr) {
+            fprintf(stderr, "[AudioMixer] Failed to create input IOProc for %s: %d\n",
+                    ch.name.c_str(), status);
+            return;
+        }
+
+        // Start input
+        status = AudioDeviceStart(ch.deviceId, ch.inputProcID);
+        if (status != noErr) {
+            fprintf(stderr, "[AudioMixer] Failed to start input for %s: %d\n",
+                    ch.name.c_str(), status);
+            AudioDeviceDestroyIOProcID(ch.deviceId, ch.inputProcID);
+            ch.inputProcID = nullptr;
+            return;
+        }
+
+        fprintf(stderr, "[AudioMixer] Started input: %s\n", ch.name.c_str());
+    }
+
+    void stopInputs() {
+        for (auto& ch : inputs_) {
+            if (ch.inputProcID) {
+                AudioDeviceStop(ch.deviceId, ch.inputProcID);
+                AudioDeviceDestroyIOProcID(ch.deviceId, ch.inputProcID);
+                ch.inputProcID = nullptr;
+            }
+            engine_.releaseInput(ch.slot);
+        }
+    }
+
+    // Input IOProc - called for each input device with its own engine input
+    static OSStatus InputIOProc(AudioObjectID /* device */,
+                                 const AudioTimeStamp* /* now */,
+                                 const AudioBufferList* inputData,
+                                 const AudioTimeStamp* /* inputTime */,
+                                 AudioBufferList* /* outputData */,
+                                 const AudioTimeStamp* /* outputTime */,
+                                 void* clientData) {
+        rtsan::Scope scope("AudioMixer::InputIOProc");
+        auto* input = static_cast<MixEngine::Input*>(clientData);
+        trace::Scope traceScope("mixer input IOProc", input->traceId);
+        CallbackTiming::Scope timing(input->timing);
+
+        if (!input->isActive() || !inputData) {
+            return noErr;
+        }
+
+        for (UInt32 i = 0; i < inputData->mNumberBuffers; i++) {
+            const AudioBuffer& buf = inputData->mBuffers[i];
+            if (buf.mData && buf.mDataByteSize > 0) {
+                timing.setPeriod(buf.mDataByteSize / sizeof(Float32) / MixEngine::kChannels, input->sampleRate);
+                input->write(static_cast<const Float32*>(buf.mData), buf.mDataByteSize / sizeof(Float32));
+            }
+        }
+
+        return noErr;
+    }
+
+    // Output IOProc - mixes all inputs and writes to output
+    static OSStatus OutputIOProc(AudioObjectID /* device */,
+                                  const AudioTimeStamp* /* now */,
+                                  const AudioBufferList* /* inputData */,
+                                  const AudioTimeStamp* /* inputTime */,
+                                  AudioBufferList* outputData,
+                                  const AudioTimeStamp* /* outputTime */,
+                                  void* clientData) {
+        rtsan::Scope scope("AudioMixer::OutputIOProc");
+        auto* mixer = static_cast<AudioMixer*>(clientData);
+        trace::Scope traceScope("mixer output IOProc");
+        CallbackTiming::Scope timing(mixer->outputTiming_);
+        MixEngine& engine = mixer->engine_;
+
+        engine.beginCycle();
+
+        if (!outputData || outputData->mNumberBuffers == 0) {
+            return noErr;
+        }
+
+        for (UInt32 bufIdx = 0; bufIdx < outputData->mNumberBuffers; bufIdx++) {
+            AudioBuffer& outBuf = outputData->mBuffers[bufIdx];
+            if (!outBuf.mData || outBuf.mDataByteSize == 0) {
+                continue;
+            }
+            UInt32 outputFrameCount = outBuf.mDataByteSize / sizeof(Float32) / 2;  // stereo frames
+            timing.setPeriod(outputFrameCount, engine.outputSampleRate());
+            engine.mix(static_cast<Float32*>(outBuf.mData), outputFrameCount);
+            mixer->recorder_.push(static_cast<const Float32*>(outBuf.mData), outputFrameCount);
+            mixer->replay_.push(static_cast<const Float32*>(outBuf.mData), outputFrameCount);
+        }
+
+        engine.endCycle();
+
+        return noErr;
+    }
+
+    std::string name_;
+    std::vector<InputChannel> inputs_;                 // Reserved to kMaxInputs, append-only
+    MixEngine engine_;                                 // Rings, conversion, mix - everything the IOProcs run
+    MixerParams& params_;                              // engine_'s handle lookup, command queue, render gains
+    AudioDeviceID outputDevice_;
+    AudioDeviceIOProcID outputProcID_;
+    std::atomic<bool> running_;
+    std::mutex lifecycleMutex_;                 // Serializes start/stop/topology across threads
+    std::atomic<uint64_t> generation_{0};       // Latest lifecycle ticket
+    CallbackTiming outputTiming_;               // Output IOProc execution time
+    BusRecorder recorder_;                      // Fed by the output IOProc while recording
+    ReplayBuffer replay_;                       // Fed by the output IOProc while replay is on
+    StemRecorder stems_;                        // Fed by engine_'s input taps while recording stems
+    mutable std::mutex duckingMutex_;           // Guards ducking_
+    MixerParams::DuckingConfig ducking_;        // Last sidechain setup, for mixerGetDucking
+};
+
+// ============================================================================
+// Handle slot map
+// ============================================================================
+
+// Generational slot map handing out 32-bit handles: the low kIndexBits select
+// a slot, the high bits carry that slot's generation. Freed slots go on a free
+// list and bump their generation, so storage stays bounded and a stale handle
+// never resolves to a newer object. Values are packed densely for iteration.
+template <typename T>
+class SlotMap {
+public:
+    static constexpr uint32_t kIndexBits = 16;
+    static constexpr uint32_t kIndexMask = (1u << kIndexBits) - 1;
+    static constexpr uint32_t kMaxSlots = kIndexMask;    // kIndexMask itself marks "no slot"
+    static constexpr uint32_t kInvalidHandle = 0;         // generation 0 is never issued
+
+    // Returns kInvalidHandle if every slot is in use
+    uint32_t insert(std::shared_ptr<T> value) {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+
+        uint32_t index;
+        if (freeHead_ != kIndexMask) {
+            index = freeHead_;
+            freeHead_ = slots_[index].nextFree;
+        } else {
+            if (slots_.size() >= kMaxSlots) {
+                return kInvalidHandle;
+            }
+            index = static_cast<uint32_t>(slots_.size());
+            slots_.push_back(Slot());
+        }
+
+        Slot& slot = slots_[index];
+        slot.dense = static_cast<uint32_t>(values_.size());
+        slot.nextFree = kIndexMask;
+        values_.push_back(std::move(value));
+        denseToSlot_.push_back(index);
+        return (slot.generation << kIndexBits) | index;
+    }
+
+    // O(1); the lock is only held long enough to copy the pointer out
+    std::shared_ptr<T> get(uint32_t handle) const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return isLiveLocked(handle) ? values_[slots_[handle & kIndexMask].dense] : nullptr;
+    }
+
+    // Removes and returns the value; null if the handle is stale
+    std::shared_ptr<T> erase(uint32_t handle) {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (!isLiveLocked(handle)) {
+            return nullptr;
+        }
+
+        uint32_t index = handle & kIndexMask;
+        Slot& slot = slots_[index];
+
+        // Swap-remove keeps values_ dense
+        uint32_t dense = slot.dense;
+        std::shared_ptr<T> removed = std::move(values_[dense]);
+        uint32_t last = static_cast<uint32_t>(values_.size() - 1);
+        if (dense != last) {
+            values_[dense] = std::move(values_[last]);
+            denseToSlot_[dense] = denseToSlot_[last];
+            slots_[denseToSlot_[dense]].dense = dense;
+        }
+        values_.pop_back();
+        denseToSlot_.pop_back();
+
+        slot.dense = kIndexMask;
+        slot.generation = nextGeneration(slot.generation);
+        slot.nextFree = freeHead_;
+        freeHead_ = index;
+        return removed;
+    }
+
+    // Visits every live value under the shared lock; fn must not modify the map
+    template <typename F>
+    void forEach(F&& fn) const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        for (const std::shared_ptr<T>& value : values_) {
+            fn(*value);
+        }
+    }
+
+    // Removes everything, returning the values so callers can tear them down unlocked
+    std::vector<std::shared_ptr<T>> clear() {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        std::vector<std::shared_ptr<T>> removed;
+        removed.swap(values_);
+        for (uint32_t index : denseToSlot_) {
+            Slot& slot = slots_[index];
+            slot.dense = kIndexMask;
+            slot.generation = nextGeneration(slot.generation);
+            slot.nextFree = freeHead_;
+            freeHead_ = index;
+        }
+        denseToSlot_.clear();
+        return removed;
+    }
+
+private:
+    static constexpr uint32_t kMaxGeneration = (1u << (32 - kIndexBits)) - 1;
+
+    struct Slot {
+        uint32_t generation = 1;
+        uint32_t dense = kIndexMask;      // index into values_, kIndexMask when free
+        uint32_t nextFree = kIndexMask;
+    };
+
+    static uint32_t nextGeneration(uint32_t generation) {
+        return generation == kMaxGeneration ? 1 : generation + 1;
+    }
+
+    bool isLiveLocked(uint32_t handle) const {
+        uint32_t index = handle & kIndexMask;
+        if (index >= slots_.size()) {
+            return false;
+        }
+        const Slot& slot = slots_[index];
+        return slot.dense != kIndexMask && slot.generation == (handle >> kIndexBits);
+    }
+
+    mutable std::shared_mutex mutex_;
+    std::vector<Slot> slots_;
+    std::vector<std::shared_ptr<T>> values_;
+    std::vector<uint32_t> denseToSlot_;
+    uint32_t freeHead_ = kIndexMask;
+};
+
+// Global mixer instances
+// shared_ptr so async start/stop workers keep a mixer alive past destroyMixer
+SlotMap<AudioMixer> g_mixers;
+
+// ============================================================================
+// Native HID reader - PC Panel reports parsed off the JS thread
+// ============================================================================
+
+// Opens the PC Panel with IOHIDManager on a dedicated run-loop thread.
+// Analog controls mapped to a mixer input are applied straight into every
+// mixer's command queue from that thread; JS gets a coalesced view (latest
+// value per control, every button edge) for the UI and for persistence.
+static_assert(HidGainMap::kNoDevice == DeviceRegistry::kInvalidDeviceHandle, "Unmapped control handle");
+
+class HidReader {
+public:
+    struct ButtonEvent {
+        uint8_t index;
+        bool pressed;
+        uint32_t order;                         // Arrival order within the drain
+    };
+
+    using GainMapping = HidGainMap::GainMapping;
+
+    // Everything that changed since the last drain. The order fields rank
+    // each entry's latest change so the drain can be replayed in arrival order.
+    struct Pending {
+        bool connectionChanged = false;
+        bool connected = false;
+        bool stateResponse = false;
+        uint32_t dirtyAnalog = 0;                // Bit per control
+        uint32_t appliedAnalog = 0;              // Subset whose gain was applied natively
+        uint8_t analogValues[kHidAnalogCount] = {};
+        bool buttonStates[kHidButtonCount] = {};
+        std::vector<ButtonEvent> buttons;
+        uint32_t nextOrder = 0;
+        uint32_t connectionOrder = 0;
+        uint32_t stateOrder = 0;
+        uint32_t analogOrder[kHidAnalogCount] = {};
+    };
+
+    static HidReader& instance() {
+        static HidReader* reader = new HidReader();  // Never destroyed: the thread may outlive statics
+        return *reader;
+    }
+
+    // notify is called from the reader thread whenever a drain is due; it is
+    // not called again until takePending() has run
+    bool start(uint16_t vendorId, uint16_t productId, std::function<void()> notify) {
+        std::lock_guard<std::mutex> lock(lifecycleMutex_);
+        if (thread_.joinable()) {
+            return true;
+        }
+
+        vendorId_ = vendorId;
+        productId_ = productId;
+        {
+            std::lock_guard<std::mutex> eventLock(eventMutex_);
+            notify_ = std::move(notify);
+        }
+        notifyPending_.store(false);
+        stopRequested_.store(false);
+
+        std::unique_lock<std::mutex> readyLock(readyMutex_);
+        runLoop_ = nullptr;
+        ready_ = false;
+        thread_ = std::thread([this]() { run(); });
+        readyCv_.wait(readyLock, [this]() { return ready_; });
+
+        if (!runLoop_) {
+            thread_.join();
+            return false;
+        }
+        return true;
+    }
+
+    void stop() {
+        std::lock_guard<std::mutex> lock(lifecycleMutex_);
+        if (!thread_.joinable()) {
+            return;
+        }
+        // The flag covers a stop that lands before run() has entered the
+        // loop, where CFRunLoopStop alone would be lost
+        stopRequested_.store(true);
+        CFRunLoopStop(runLoop_);
+        CFRunLoopWakeUp(runLoop_);
+        thread_.join();
+        runLoop_ = nullptr;
+
+        std::lock_guard<std::mutex> eventLock(eventMutex_);
+        notify_ = nullptr;
+    }
+
+    // Control index -> mixer input device handle and taper
+    void setGainMapping(const std::vector<GainMapping>& mappings) {
+        gainMap_.set(mappings);
+    }
+
+    // Custom taper tables by device handle; the reader and taperGain() share them
+    void setCustomTaper(uint32_t deviceHandle, const std::vector<float>& points) {
+        gainMap_.setCustomTaper(deviceHandle, points);
+    }
+
+    float customTaperGain(uint32_t deviceHandle, uint8_t value) {
+        return gainMap_.customGain(deviceHandle, value);
+    }
+
+    bool requestState() {
+        std::lock_guard<std::mutex> lock(deviceMutex_);
+        if (!device_) {
+            return false;
+        }
+        uint8_t packet[kHidReportSize] = {};
+        packet[0] = kHidCodeRequestState;
+        return IOHIDDeviceSetReport(device_, kIOHIDReportTypeOutput, 0, packet, sizeof(packet)) == kIOReturnSuccess;
+    }
+
+    bool isConnected() const {
+        std::lock_guard<std::mutex> lock(deviceMutex_);
+        return device_ != nullptr;
+    }
+
+    Pending takePending() {
+        // Clear first: anything arriving after this point schedules a new drain
+        notifyPending_.store(false, std::memory_order_release);
+
+        std::lock_guard<std::mutex> lock(eventMutex_);
+        Pending taken = std::move(pending_);
+        pending_ = Pending();
+        pending_.buttons.reserve(16);
+        return taken;
+    }
+
+private:
+    HidReader() {
+        pending_.buttons.reserve(16);
+    }
+
+    void run() {
+        pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0);
+
+        IOHIDManagerRef manager = IOHIDManagerCreate(kCFAllocatorDefault, kIOHIDOptionsTypeNone);
+        if (manager) {
+            CFMutableDictionaryRef matching = CFDictionaryCreateMutable(
+                kCFAllocatorDefault, 2, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+            int vendorId = vendorId_;
+            int productId = productId_;
+            CFNumberRef vendor = CFNumberCreate(kCFAllocatorDefault, kCFNumberIntType, &vendorId);
+            CFNumberRef product = CFNumberCreate(kCFAllocatorDefault, kCFNumberIntType, &productId);
+            CFDictionarySetValue(matching, CFSTR(kIOHIDVendorIDKey), vendor);
+            CFDictionarySetValue(matching, CFSTR(kIOHIDProductIDKey), product);
+            CFRelease(vendor);
+            CFRelease(product);
+            IOHIDManagerSetDeviceMatching(manager, matching);
+            CFRelease(matching);
+
+            IOHIDManagerRegisterDeviceMatchingCallback(manager, DeviceMatched, this);
+            IOHIDManagerRegisterDeviceRemovalCallback(manager, DeviceRemoved, this);
+            IOHIDManagerScheduleWithRunLoop(manager, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode);
+
+            IOReturn status = IOHIDManagerOpen(manager, kIOHIDOptionsTypeNone);
+            if (status != kIOReturnSuccess) {
+                fprintf(stderr, "[HidReader] Failed to open HID manager: 0x%x\n", status);
+                IOHIDManagerUnscheduleFromRunLoop(manager, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode);
+                CFRelease(manager);
+                manager = nullptr;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> readyLock(readyMutex_);
+            runLoop_ = manager ? CFRunLoopGetCurrent() : nullptr;
+            ready_ = true;
+        }
+        readyCv_.notify_one();
+        if (!manager) {
+            return;
+        }
+
+        while (!stopRequested_.load()) {
+            CFRunLoopRunInMode(kCFRunLoopDefaultMode, 0.25, false);
+        }
+
+        IOHIDManagerUnscheduleFromRunLoop(manager, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode);
+        IOHIDManagerClose(manager, kIOHIDOptionsTypeNone);
+        CFRelease(manager);
+        setDevice(nullptr);
+    }
+
+    // Holds a reference to the current device so it stays valid for
+    // requestState() even while the manager is releasing it
+    void setDevice(IOHIDDeviceRef device) {
+        IOHIDDeviceRef previous;
+        {
+            std::lock_guard<std::mutex> lock(deviceMutex_);
+            if (device_ == device) {
+                return;
+            }
+            if (device) {
+                CFRetain(device);
+            }
+            previous = device_;
+            device_ = device;
+        }
+        if (previous) {
+            CFRelease(previous);
+        }
+        {
+            std::lock_guard<std::mutex> lock(eventMutex_);
+            pending_.connectionChanged = true;
+            pending_.connected = device != nullptr;
+            pending_.connectionOrder = pending_.nextOrder++;
+        }
+        scheduleNotify();
+    }
+
+    static void DeviceMatched(void* context, IOReturn /* result */, void* /* sender */, IOHIDDeviceRef device) {
+        auto* self = static_cast<HidReader*>(context);
+        if (self->isConnected()) {
+            return;  // Only one panel at a time
+        }
+
+        IOHIDDeviceRegisterInputReportCallback(device, self->reportBuffer_, sizeof(self->reportBuffer_),
+                                               InputReport, self);
+        self->setDevice(device);
+        fprintf(stderr, "[HidReader] PC Panel connected\n");
+
+        // Initial volumes come from the device's state response
+        self->requestState();
+    }
+
+    static void DeviceRemoved(void* context, IOReturn /* result */, void* /* sender */, IOHIDDeviceRef device) {
+        auto* self = static_cast<HidReader*>(context);
+        {
+            std::lock_guard<std::mutex> lock(self->deviceMutex_);
+            if (self->device_ != device) {
+                return;
+            }
+        }
+        self->setDevice(nullptr);
+        fprintf(stderr, "[HidReader] PC Panel disconnected\n");
+    }
+
+    static void InputReport(void* context, IOReturn result, void* /* sender */, IOHIDReportType /* type */,
+                            uint32_t /* reportID */, uint8_t* report, CFIndex reportLength) {
+        if (result != kIOReturnSuccess) {
+            return;
+        }
+        HidReport parsed;
+        if (parseHidReport(report, static_cast<size_t>(reportLength), parsed)) {
+            static_cast<HidReader*>(context)->handleReport(parsed);
+        }
+    }
+
+    // Reader thread: apply first, then publish for JS
+    void handleReport(const HidReport& report) {
+        switch (report.type) {
+            case HidReport::Type::KnobChange: {
+                bool applied = applyGain(report.index, report.value);
+                std::lock_guard<std::mutex> lock(eventMutex_);
+                pending_.analogValues[report.index] = report.value;
+                pending_.dirtyAnalog |= 1u << report.index;
+                pending_.analogOrder[report.index] = pending_.nextOrder++;
+                if (applied) {
+                    pending_.appliedAnalog |= 1u << report.index;
+                } else {
+                    pending_.appliedAnalog &= ~(1u << report.index);
+                }
+                break;
+            }
+            case HidReport::Type::ButtonChange: {
+                std::lock_guard<std::mutex> lock(eventMutex_);
+                pending_.buttonStates[report.index] = report.value != 0;
+                pending_.buttons.push_back({report.index, report.value != 0, pending_.nextOrder++});
+                break;
+            }
+            case HidReport::Type::StateResponse: {
+                uint32_t applied = 0;
+                for (size_t i = 0; i < kHidAnalogCount; i++) {
+                    if (applyGain(i, report.analogValues[i])) {
+                        applied |= 1u << i;
+                    }
+                }
+                std::lock_guard<std::mutex> lock(eventMutex_);
+                std::copy(report.analogValues, report.analogValues + kHidAnalogCount, pending_.analogValues);
+                std::copy(report.buttonStates, report.buttonStates + kHidButtonCount, pending_.buttonStates);
+                pending_.stateResponse = true;
+                pending_.stateOrder = pending_.nextOrder++;
+                pending_.dirtyAnalog = 0;  // Superseded by the full snapshot
+                pending_.appliedAnalog = applied;
+                break;
+            }
+        }
+        scheduleNotify();
+    }
+
+    // Push the control's gain into every mixer that has the mapped input
+    bool applyGain(size_t control, uint8_t value) {
+        uint32_t deviceHandle;
+        float gain;
+        if (!gainMap_.lookup(control, value, deviceHandle, gain)) {
+            return false;
+        }
+        g_mixers.forEach([deviceHandle, gain](AudioMixer& mixer) {
+            mixer.setInputGain(deviceHandle, gain);
+        });
+        return true;
+    }
+
+    // At most one JS callback is in flight; it drains everything since
+    void scheduleNotify() {
+        if (notifyPending_.exchange(true, std::memory_order_acq_rel)) {
+            return;
+        }
+        // Called unlocked: the callback may drain (takePending) synchronously
+        std::function<void()> notify;
+        {
+            std::lock_guard<std::mutex> lock(eventMutex_);
+            notify = notify_;
+        }
+        if (notify) {
+            notify();
+        }
+    }
+
+    std::mutex lifecycleMutex_;
+    std::thread thread_;
+    uint16_t vendorId_ = 0;
+    uint16_t productId_ = 0;
+
+    std::mutex readyMutex_;
+    std::condition_variable readyCv_;
+    bool ready_ = false;
+    CFRunLoopRef runLoop_ = nullptr;
+    std::atomic<bool> stopRequested_{false};
+
+    mutable std::mutex deviceMutex_;
+    IOHIDDeviceRef device_ = nullptr;
+    uint8_t reportBuffer_[kHidReportSize];
+
+    HidGainMap gainMap_;
+
+    std::mutex eventMutex_;                     // Guards pending_ and notify_
+    Pending pending_;
+    std::function<void()> notify_;
+    std::atomic<bool> notifyPending_{false};
+};
+
+// ============================================================================
+// N-API wrapper functions
+// ============================================================================
+
+Napi::Array devicesToArray(Napi::Env env, const std::vector<DeviceInfo>& devices) {
+    Napi::Array result = Napi::Array::New(env, devices.size());
+    uint32_t index = 0;
+
+    for (const DeviceInfo& dev : devices) {
+        Napi::Object device = Napi::Object::New(env);
+        device.Set("id", Napi::Number::New(env, dev.id));
+        device.Set("name", Napi::String::New(env, dev.name));
+        device.Set("uid", Napi::String::New(env, dev.uid));
+        device.Set("hasOutput", Napi::Boolean::New(env, dev.hasOutput));
+        device.Set("hasInput", Napi::Boolean::New(env, dev.hasInput));
+        device.Set("inputChannels", Napi::Number::New(env, dev.inputChannels));
+        device.Set("outputChannels", Napi::Number::New(env, dev.outputChannels));
+        device.Set("sampleRate", Napi::Number::New(env, dev.sampleRate));
+
+        result[index++] = device;
+    }
+
+    return result;
+}
+
+// Enumerates off the JS thread: the first snapshot installs the HAL listeners
+// and queries every device, which can block for a while on cold start
+class ListAudioDevicesWorker : public Napi::AsyncWorker {
+public:
+    explicit ListAudioDevicesWorker(Napi::Env env)
+        : Napi::AsyncWorker(env), deferred_(Napi::Promise::Deferred::New(env)) {}
+
+    Napi::Promise promise() const { return deferred_.Promise(); }
+
+protected:
+    void Execute() override {
+        devices_ = DeviceRegistry::instance().snapshot();
+    }
+
+    void OnOK() override {
+        deferred_.Resolve(devicesToArray(Env(), devices_));
+    }
+
+    void OnError(const Napi::Error& error) override {
+        deferred_.Reject(error.Value());
+    }
+
+private:
+    Napi::Promise::Deferred deferred_;
+    std::vector<DeviceInfo> devices_;
+};
+
+// N-API wrapper functions
+Napi::Value ListAudioDevices(const Napi::CallbackInfo& info) {
+    auto* worker = new ListAudioDevicesWorker(info.Env());
+    Napi::Promise promise = worker->promise();
+    worker->Queue();
+    return promise;
+}
+
+// Synchronous listing served from the registry cache, for callers that can't await
+Napi::Value GetCachedAudioDevices(const Napi::CallbackInfo& info) {
+    return devicesToArray(info.Env(), DeviceRegistry::instance().snapshot());
+}
+
+// Resolves the input device and creates and starts the IOProcs on a worker
+// thread; resolves with the passthrough index (or true when input and output
+// are the same device). The ticket is taken on the JS thread, so a
+// stopAllPassthrough() made while the start is in flight wins and the start
+// rejects with code ECANCELED.
+class StartPassthroughWorker : public Napi::AsyncWorker {
+public:
+    StartPassthroughWorker(Napi::Env env, uint32_t deviceHandle, const std::string& deviceRef)
+        : Napi::AsyncWorker(env),
+          deferred_(Napi::Promise::Deferred::New(env)),
+          deviceHandle_(deviceHandle),
+          deviceRef_(deviceRef),
+          ticket_(g_passthroughGeneration.load()),
+          sameDevice_(false),
+          cancelled_(false),
+          index_(0) {}
+
+    Napi::Promise promise() const { return deferred_.Promise(); }
+
+protected:
+    void Execute() override {
+        // Accepts a device handle, UID, or display name; the first lookup may
+        // build the registry, which is why it happens here
+        DeviceRegistry& registry = DeviceRegistry::instance();
+        uint32_t handle = deviceRef_.empty() ? deviceHandle_ : deviceHandleFromRef(deviceRef_);
+        AudioDeviceID inputDevice = registry.deviceForHandle(handle);
+        DeviceInfo inputInfo;
+        if (inputDevice == kAudioObjectUnknown || !registry.getInfo(inputDevice, inputInfo)) {
+            SetError("Input device not found: " + (deviceRef_.empty() ? std::to_string(handle) : deviceRef_));
+            return;
+        }
+
+        AudioDeviceID outputDevice = getDefaultOutputDevice();
+        if (outputDevice == kAudioObjectUnknown) {
+            SetError("No default output device");
+            return;
+        }
+
+        // Don't passthrough to itself
+        if (inputDevice == outputDevice) {
+            sameDevice_ = true;
+            return;
+        }
+
+        auto passthrough = std::make_unique<AudioPassthrough>();
+        if (!passthrough->start(inputDevice, outputDevice)) {
+            SetError("Failed to start passthrough");
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            if (g_passthroughGeneration.load() == ticket_) {
+                PassthroughInfo ptInfo;
+                ptInfo.passthrough = std::move(passthrough);
+                ptInfo.deviceName = inputInfo.name;
+                ptInfo.inputDeviceId = inputDevice;
+                g_passthroughs.push_back(std::move(ptInfo));
+                index_ = g_passthroughs.size() - 1;
+                return;
+            }
+        }
+
+        // Stopped while starting: nobody would own this instance
+        passthrough->stop();
+        cancelled_ = true;
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        if (cancelled_) {
+            Napi::Error error = Napi::Error::New(env, "Passthrough start cancelled");
+            error.Set("code", Napi::String::New(env, "ECANCELED"));
+            deferred_.Reject(error.Value());
+        } else if (sameDevice_) {
+            deferred_.Resolve(Napi::Boolean::New(env, true));
+        } else {
+            deferred_.Resolve(Napi::Number::New(env, static_cast<double>(index_)));
+        }
+    }
+
+    void OnError(const Napi::Error& error) override {
+        deferred_.Reject(error.Value());
+    }
+
+private:
+    Napi::Promise::Deferred deferred_;
+    uint32_t deviceHandle_;
+    std::string deviceRef_;         // UID or name; empty when called with a handle
+    uint64_t ticket_;
+    bool sameDevice_;
+    bool cancelled_;
+    size_t index_;
+};
+
+Napi::Value StartPassthrough(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !(info[0].IsString() || info[0].IsNumber())) {
+        Napi::TypeError::New(env, "Input device handle, UID or name required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    uint32_t deviceHandle = info[0].IsNumber() ? info[0].As<Napi::Number>().Uint32Value()
+                                               : DeviceRegistry::kInvalidDeviceHandle;
+    std::string deviceRef = info[0].IsString() ? info[0].As<Napi::String>().Utf8Value() : std::string();
+
+    auto* worker = new StartPassthroughWorker(env, deviceHandle, deviceRef);
+    Napi::Promise promise = worker->promise();
+    worker->Queue();
+    return promise;
+}
+
+Napi::Value StopPassthrough(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Passthrough index required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    size_t index = static_cast<size_t>(info[0].As<Napi::Number>().Int32Value());
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+
+    if (index >= g_passthroughs.size() || !g_passthroughs[index].passthrough) {
+        return Napi::Boolean::New(env, false);
+    }
+
+    g_passthroughs[index].passthrough->stop();
+    g_passthroughs[index].passthrough.reset();
+
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value StopAllPassthrough(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    // Cancels starts still in flight
+    g_passthroughGeneration.fetch_add(1);
+
+    for (auto& pt : g_passthroughs) {
+        if (pt.passthrough) {
+            pt.passthrough->stop();
+        }
+    }
+    g_passthroughs.clear();
+
+    return Napi::Boolean::New(env, true);
+}
+
+// { count, deadlineMisses, minUs, maxUs, meanUs, p50Us, p99Us, periodUs,
+//   histogram: [[upperBoundUs, count], ...] } - empty buckets left out
+Napi::Object timingToJs(Napi::Env env, const CallbackTiming::Snapshot& snap) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("count", Napi::Number::New(env, static_cast<double>(snap.count)));
+    obj.Set("deadlineMisses", Napi::Number::New(env, static_cast<double>(snap.deadlineMisses)));
+    obj.Set("minUs", Napi::Number::New(env, snap.minNs / 1000.0));
+    obj.Set("maxUs", Napi::Number::New(env, snap.maxNs / 1000.0));
+    obj.Set("meanUs", Napi::Number::New(env, snap.meanNs / 1000.0));
+    obj.Set("p50Us", Napi::Number::New(env, snap.p50Ns / 1000.0));
+    obj.Set("p99Us", Napi::Number::New(env, snap.p99Ns / 1000.0));
+    obj.Set("periodUs", Napi::Number::New(env, snap.periodNs / 1000.0));
+
+    Napi::Array histogram = Napi::Array::New(env);
+    uint32_t used = 0;
+    for (size_t i = 0; i < CallbackTiming::kBucketCount; i++) {
+        if (snap.buckets[i] == 0) {
+            continue;
+        }
+        uint64_t limit = CallbackTiming::bucketLimit(i);
+        Napi::Array bucket = Napi::Array::New(env, 2);
+        bucket.Set(0u, limit == UINT64_MAX ? Napi::Number::New(env, INFINITY) : Napi::Number::New(env, limit / 1000.0));
+        bucket.Set(1u, Napi::Number::New(env, static_cast<double>(snap.buckets[i])));
+        histogram.Set(used++, bucket);
+    }
+    obj.Set("histogram", histogram);
+    return obj;
+}
+
+// { input: timing, output: timing } for one passthrough, or null
+Napi::Value GetPassthroughTiming(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Index required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    size_t index = static_cast<size_t>(info[0].As<Napi::Number>().Int32Value());
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+
+    if (index >= g_passthroughs.size() || !g_passthroughs[index].passthrough) {
+        return env.Null();
+    }
+
+    const AudioPassthrough& passthrough = *g_passthroughs[index].passthrough;
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("input", timingToJs(env, passthrough.inputTiming().snapshot()));
+    result.Set("output", timingToJs(env, passthrough.outputTiming().snapshot()));
+    return result;
+}
+
+Napi::Value ResetPassthroughTiming(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Index required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    size_t index = static_cast<size_t>(info[0].As<Napi::Number>().Int32Value());
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+
+    if (index >= g_passthroughs.size() || !g_passthroughs[index].passthrough) {
+        return Napi::Boolean::New(env, false);
+    }
+
+    g_passthroughs[index].passthrough->resetTiming();
+    return Napi::Boolean::New(env, true);
+}
+
+// { underruns, silentFrames, overflows, droppedFrames, fillMinFrames,
+//   fillMaxFrames, capacityFrames } - counters are cumulative
+Napi::Object ringStatsToJs(Napi::Env env, const RingStats::Snapshot& snap) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("underruns", Napi::Number::New(env, static_cast<double>(snap.underruns)));
+    obj.Set("silentFrames", Napi::Number::New(env, static_cast<double>(snap.silentFrames)));
+    obj.Set("overflows", Napi::Number::New(env, static_cast<double>(snap.overflows)));
+    obj.Set("droppedFrames", Napi::Number::New(env, static_cast<double>(snap.droppedFrames)));
+    obj.Set("fillMinFrames", Napi::Number::New(env, static_cast<double>(snap.fillMinFrames)));
+    obj.Set("fillMaxFrames", Napi::Number::New(env, static_cast<double>(snap.fillMaxFrames)));
+    obj.Set("capacityFrames", Napi::Number::New(env, static_cast<double>(snap.capacityFrames)));
+    return obj;
+}
+
+// Ring stats for one passthrough, or null
+Napi::Value GetPassthroughRingStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Index required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    size_t index = static_cast<size_t>(info[0].As<Napi::Number>().Int32Value());
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+
+    if (index >= g_passthroughs.size() || !g_passthroughs[index].passthrough) {
+        return env.Null();
+    }
+
+    return ringStatsToJs(env, g_passthroughs[index].passthrough->readRingStats());
+}
+
+Napi::Value SetPassthroughVolume(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Index and volume required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    size_t index = static_cast<size_t>(info[0].As<Napi::Number>().Int32Value());
+    float volume = info[1].As<Napi::Number>().FloatValue();
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+
+    if (index >= g_passthroughs.size() || !g_passthroughs[index].passthrough) {
+        return Napi::Boolean::New(env, false);
+    }
+
+    g_passthroughs[index].passthrough->setVolume(volume);
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value GetDefaultOutputDevice(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    AudioDeviceID deviceID = getDefaultOutputDevice();
+    if (deviceID == kAudioObjectUnknown) {
+        return env.Null();
+    }
+
+    DeviceInfo dev;
+    if (!DeviceRegistry::instance().getInfo(deviceID, dev)) {
+        return env.Null();
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("id", Napi::Number::New(env, deviceID));
+    result.Set("name", Napi::String::New(env, dev.name));
+    result.Set("uid", Napi::String::New(env, dev.uid));
+
+    return result;
+}
+
+// Resolve a persistent device UID into a compact handle for the hot-path setters
+Napi::Value ResolveDevice(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Device UID required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    uint32_t handle = DeviceRegistry::instance().resolveUID(info[0].As<Napi::String>().Utf8Value());
+    if (handle == DeviceRegistry::kInvalidDeviceHandle) {
+        return env.Null();
+    }
+    return Napi::Number::New(env, handle);
+}
+
+// Look up the current device behind a UID (null while it is not present)
+Napi::Value GetDeviceByUID(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Device UID required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    DeviceRegistry& registry = DeviceRegistry::instance();
+    AudioDeviceID deviceId = registry.findByUID(info[0].As<Napi::String>().Utf8Value());
+    DeviceInfo dev;
+    if (deviceId == kAudioObjectUnknown || !registry.getInfo(deviceId, dev)) {
+        return env.Null();
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("id", Napi::Number::New(env, dev.id));
+    result.Set("name", Napi::String::New(env, dev.name));
+    result.Set("uid", Napi::String::New(env, dev.uid));
+    result.Set("hasOutput", Napi::Boolean::New(env, dev.hasOutput));
+    result.Set("hasInput", Napi::Boolean::New(env, dev.hasInput));
+    return result;
+}
+
+// Device change events pushed from the registry's HAL listeners
+Napi::ThreadSafeFunction g_deviceChangeTsfn;
+std::mutex g_deviceChangeMutex;
+
+// Register a JS callback for device list / default output / format changes
+Napi::Value OnDeviceChange(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !(info[0].IsFunction() || info[0].IsNull())) {
+        Napi::TypeError::New(env, "Callback function or null required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::lock_guard<std::mutex> lock(g_deviceChangeMutex);
+
+    if (g_deviceChangeTsfn) {
+        g_deviceChangeTsfn.Release();
+        g_deviceChangeTsfn = Napi::ThreadSafeFunction();
+    }
+
+    if (info[0].IsFunction()) {
+        g_deviceChangeTsfn = Napi::ThreadSafeFunction::New(
+            env, info[0].As<Napi::Function>(), "PCPanelDeviceChange", 0, 1);
+        // Don't keep the event loop alive just for device notifications
+        g_deviceChangeTsfn.Unref(env);
+    }
+
+    DeviceRegistry::instance().setChangeCallback([](const DeviceChangeEvent& event) {
+        std::lock_guard<std::mutex> lock(g_deviceChangeMutex);
+        if (!g_deviceChangeTsfn) {
+            return;
+        }
+        auto* data = new DeviceChangeEvent(event);
+        napi_status status = g_deviceChangeTsfn.NonBlockingCall(data,
+            [](Napi::Env env, Napi::Function callback, DeviceChangeEvent* event) {
+                // env/callback are null when the function is torn down with calls queued
+                if (env != nullptr && callback != nullptr) {
+                    Napi::Object obj = Napi::Object::New(env);
+                    obj.Set("type", Napi::String::New(env, event->type));
+                    obj.Set("id", Napi::Number::New(env, event->deviceId));
+                    obj.Set("name", Napi::String::New(env, event->name));
+                    obj.Set("uid", Napi::String::New(env, event->uid));
+                    callback.Call({obj});
+                }
+                delete event;
+            });
+        if (status != napi_ok) {
+            delete data;
+        }
+    });
+
+    // Listeners are installed by the registry's first (off-thread) listing;
+    // events raised from then on reach this callback
+    return Napi::Boolean::New(env, true);
+}
+
+// Get whether a device is currently running (has active audio)
+Napi::Value GetDeviceIsRunning(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Device ID required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    AudioDeviceID deviceID = static_cast<AudioDeviceID>(info[0].As<Napi::Number>().Uint32Value());
+
+    AudioObjectPropertyAddress propAddr = {
+        kAudioDevicePropertyDeviceIsRunningSomewhere,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+
+    UInt32 isRunning = 0;
+    UInt32 propSize = sizeof(isRunning);
+    OSStatus status = AudioObjectGetPropertyData(deviceID, &propAddr, 0, nullptr, &propSize, &isRunning);
+
+    if (status != noErr) {
+        return Napi::Boolean::New(env, false);
+    }
+
+    return Napi::Boolean::New(env, isRunning != 0);
+}
+
+// Get activity status for all PCPanel devices based on actual audio data
+Napi::Value GetDeviceActivity(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+
+    Napi::Object result = Napi::Object::New(env);
+
+    // Check each passthrough for audio activity
+    for (const auto& pt : g_passthroughs) {
+        if (pt.passthrough && !pt.deviceName.empty()) {
+            Napi::Object deviceInfo = Napi::Object::New(env);
+            deviceInfo.Set("id", Napi::Number::New(env, static_cast<double>(pt.inputDeviceId)));
+            deviceInfo.Set("name", Napi::String::New(env, pt.deviceName));
+            deviceInfo.Set("isActive", Napi::Boolean::New(env, pt.passthrough->hasAudioActivity()));
+
+            // App names not yet implemented - requires privileged helper daemon
+            Napi::Array appsArray = Napi::Array::New(env, 0);
+            deviceInfo.Set("apps", appsArray);
+
+            result.Set(pt.deviceName, deviceInfo);
+        }
+    }
+
+    return result;
+}
+
+// ============================================================================
+// Mixer N-API Functions
+// ============================================================================
+
+Napi::Value CreateMixer(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    std::string name = "Mixer";
+    if (info.Length() >= 1 && info[0].IsString()) {
+        name = info[0].As<Napi::String>().Utf8Value();
+    }
+
+    uint32_t handle = g_mixers.insert(std::make_shared<AudioMixer>(name));
+    if (handle == SlotMap<AudioMixer>::kInvalidHandle) {
+        Napi::Error::New(env, "Too many mixers").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    return Napi::Number::New(env, handle);
+}
+
+Napi::Value MixerAddInput(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsNumber() || !(info[1].IsNumber() || info[1].IsString())) {
+        Napi::TypeError::New(env, "Mixer handle and device handle required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
+    uint32_t deviceHandle = deviceHandleFromValue(info[1]);
+
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        return Napi::Boolean::New(env, false);
+    }
+
+    return Napi::Boolean::New(env, mixer->addInput(deviceHandle));
+}
+
+Napi::Value MixerSetInputGain(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 3 || !info[0].IsNumber() || !(info[1].IsNumber() || info[1].IsString()) ||
+        !info[2].IsNumber()) {
+        Napi::TypeError::New(env, "Mixer handle, device handle, and gain required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
+    uint32_t deviceHandle = deviceHandleFromValue(info[1]);
+    float gain = info[2].As<Napi::Number>().FloatValue();
+
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        return Napi::Boolean::New(env, false);
+    }
+
+    return Napi::Boolean::New(env, mixer->setInputGain(deviceHandle, gain));
+}
+
+Napi::Value MixerSetInputEnabled(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 3 || !info[0].IsNumber() || !(info[1].IsNumber() || info[1].IsString()) ||
+        !info[2].IsBoolean()) {
+        Napi::TypeError::New(env, "Mixer handle, device handle, and enabled required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
+    uint32_t deviceHandle = deviceHandleFromValue(info[1]);
+    bool enabled = info[2].As<Napi::Boolean>().Value();
+
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        return Napi::Boolean::New(env, false);
+    }
+
+    return Napi::Boolean::New(env, mixer->setInputEnabled(deviceHandle, enabled));
+}
+
+// Apply a batch of { channel, gain?, enabled? } updates atomically at one
+// render-cycle boundary: mixerApplyUpdates(handle, updates) -> number applied
+Napi::Value MixerApplyUpdates(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsArray()) {
+        Napi::TypeError::New(env, "Mixer handle and update array required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
+    Napi::Array array = info[1].As<Napi::Array>();
+
+    std::vector<AudioMixer::ParamUpdate> updates;
+    updates.reserve(array.Length());
+    for (uint32_t i = 0; i < array.Length(); i++) {
+        Napi::Value item = array.Get(i);
+        if (!item.IsObject()) {
+            Napi::TypeError::New(env, "Each update must be an object").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        Napi::Object obj = item.As<Napi::Object>();
+
+        AudioMixer::ParamUpdate update = {};
+        update.deviceHandle = deviceHandleFromValue(obj.Get("channel"));
+
+        Napi::Value gain = obj.Get("gain");
+        if (gain.IsNumber()) {
+            update.hasGain = true;
+            update.gain = gain.As<Napi::Number>().FloatValue();
+        }
+        Napi::Value enabled = obj.Get("enabled");
+        if (enabled.IsBoolean()) {
+            update.hasEnabled = true;
+            update.enabled = enabled.As<Napi::Boolean>().Value();
+        }
+        updates.push_back(update);
+    }
+
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        return Napi::Number::New(env, 0);
+    }
+
+    return Napi::Number::New(env, static_cast<double>(mixer->applyUpdates(updates)));
+}
+
+// mixerSetInputCompressor(handle, device, { enabled?, detector?: 'peak' | 'rms',
+// thresholdDb?, ratio?, kneeDb?, attackMs?, releaseMs?, makeupDb? } | null) -
+// missing fields keep their defaults; null turns the compressor off
+Napi::Value MixerSetInputCompressor(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 3 || !info[0].IsNumber() || !(info[1].IsNumber() || info[1].IsString()) ||
+        !(info[2].IsObject() || info[2].IsNull())) {
+        Napi::TypeError::New(env, "Mixer handle, device handle, and compressor settings (or null) required")
+            .ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
+    uint32_t deviceHandle = deviceHandleFromValue(info[1]);
+
+    CompressorSettings settings;
+    if (info[2].IsObject()) {
+        Napi::Object obj = info[2].As<Napi::Object>();
+        Napi::Value enabled = obj.Get("enabled");
+        settings.enabled = enabled.IsBoolean() ? enabled.As<Napi::Boolean>().Value() : true;
+        Napi::Value detector = obj.Get("detector");
+        if (detector.IsString()) {
+            settings.detector = compressorDetectorFromName(detector.As<Napi::String>().Utf8Value());
+        }
+        const std::pair<const char*, float*> fields[] = {
+            {"thresholdDb", &settings.thresholdDb},
+            {"ratio", &settings.ratio},
+            {"kneeDb", &settings.kneeDb},
+            {"attackMs", &settings.attackMs},
+            {"releaseMs", &settings.releaseMs},
+            {"makeupDb", &settings.makeupDb},
+        };
+        for (const auto& field : fields) {
+            Napi::Value value = obj.Get(field.first);
+            if (value.IsNumber()) {
+                *field.second = value.As<Napi::Number>().FloatValue();
+            }
+        }
+    }
+
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        return Napi::Boolean::New(env, false);
+    }
+
+    return Napi::Boolean::New(env, mixer->setInputCompressor(deviceHandle, settings));
+}
+
+// mixerSetDucking(handle, { key, targets, thresholdDb?, ratio?, attackMs?,
+// releaseMs? } | null) - key and targets are device handles of this mixer's
+// inputs; null or key 0 turns ducking off
+Napi::Value MixerSetDucking(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsNumber() || !(info[1].IsObject() || info[1].IsNull())) {
+        Napi::TypeError::New(env, "Mixer handle and ducking config (or null) required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
+
+    MixerParams::DuckingConfig config;
+    if (info[1].IsObject()) {
+        Napi::Object obj = info[1].As<Napi::Object>();
+        Napi::Value key = obj.Get("key");
+        config.keyHandle = deviceHandleFromValue(key);
+        if (key.IsString() && config.keyHandle == DeviceRegistry::kInvalidDeviceHandle) {
+            return Napi::Boolean::New(env, false);  // Unknown device, not "off"
+        }
+        Napi::Value targets = obj.Get("targets");
+        if (targets.IsArray()) {
+            Napi::Array array = targets.As<Napi::Array>();
+            for (uint32_t i = 0; i < array.Length(); i++) {
+                config.targetHandles.push_back(deviceHandleFromValue(array.Get(i)));
+            }
+        }
+        const std::pair<const char*, float*> fields[] = {
+            {"thresholdDb", &config.settings.thresholdDb},
+            {"ratio", &config.settings.ratio},
+            {"attackMs", &config.settings.attackMs},
+            {"releaseMs", &config.settings.releaseMs},
+        };
+        for (const auto& field : fields) {
+            Napi::Value value = obj.Get(field.first);
+            if (value.IsNumber()) {
+                *field.second = value.As<Napi::Number>().FloatValue();
             }
         }
-        return false;
     }
 
-    // Get all input levels for UI metering
-    struct LevelInfo {
-        std::string name;
-        float peak;
-        float rms;
-    };
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        return Napi::Boolean::New(env, false);
+    }
 
-    std::vector<LevelInfo> getLevels() const {
-        std::vector<LevelInfo> levels;
-        for (const auto& ch : inputs_) {
-            LevelInfo info;
-            info.name = ch.name;
-            info.peak = ch.peakLevel.load(std::memory_order_relaxed);
-            info.rms = ch.rmsLevel.load(std::memory_order_relaxed);
-            levels.push_back(info);
-        }
-        return levels;
+    return Napi::Boolean::New(env, mixer->setDucking(config));
+}
+
+// Sidechain setup of a mixer plus its current gain reduction, or null
+Napi::Value MixerGetDucking(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Mixer handle required").ThrowAsJavaScriptException();
+        return env.Null();
     }
 
-private:
-    void stopInputs() {
-        for (auto& ch : inputs_) {
-            if (ch.inputProcID) {
-                AudioDeviceStop(ch.deviceId, ch.inputProcID);
-                AudioDeviceDestroyIOProcID(ch.deviceId, ch.inputProcID);
-                ch.inputProcID = nullptr;
-            }
-            ch.ringBuffer.reset();
-        }
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
+
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        return env.Null();
     }
 
-    // Input IOProc - called for each input device
-    static OSStatus InputIOProc(AudioObjectID device,
-                                 const AudioTimeStamp* /* now */,
-                                 const AudioBufferList* inputData,
-                                 const AudioTimeStamp* /* inputTime */,
-                                 AudioBufferList* /* outputData */,
-                                 const AudioTimeStamp* /* outputTime */,
-                                 void* clientData) {
-        auto* self = static_cast<AudioMixer*>(clientData);
+    MixerParams::DuckingConfig config = mixer->getDucking();
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("enabled", Napi::Boolean::New(env, config.keyHandle != 0));
+    obj.Set("key", Napi::Number::New(env, config.keyHandle));
+    Napi::Array targets = Napi::Array::New(env, config.targetHandles.size());
+    for (uint32_t i = 0; i < config.targetHandles.size(); i++) {
+        targets.Set(i, Napi::Number::New(env, config.targetHandles[i]));
+    }
+    obj.Set("targets", targets);
+    obj.Set("thresholdDb", Napi::Number::New(env, config.settings.thresholdDb));
+    obj.Set("ratio", Napi::Number::New(env, config.settings.ratio));
+    obj.Set("attackMs", Napi::Number::New(env, config.settings.attackMs));
+    obj.Set("releaseMs", Napi::Number::New(env, config.settings.releaseMs));
+    obj.Set("reductionDb", Napi::Number::New(env, mixer->getDuckReductionDb()));
+    return obj;
+}
 
-        // Find the channel for this device
-        InputChannel* channel = nullptr;
-        for (auto& ch : self->inputs_) {
-            if (ch.deviceId == device) {
-                channel = &ch;
-                break;
-            }
+Napi::Value MixerSetOutput(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Mixer handle and device ID required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
+    AudioDeviceID deviceId = static_cast<AudioDeviceID>(info[1].As<Napi::Number>().Uint32Value());
+
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        return Napi::Boolean::New(env, false);
+    }
+
+    return Napi::Boolean::New(env, mixer->setOutput(deviceId));
+}
+
+// Runs a lifecycle transition on a worker thread. The ticket is taken on the
+// JS thread when the call is made, so call order decides which request wins;
+// a superseded start rejects with code ECANCELED.
+class MixerLifecycleWorker : public Napi::AsyncWorker {
+public:
+    MixerLifecycleWorker(Napi::Env env, std::shared_ptr<AudioMixer> mixer, bool starting)
+        : Napi::AsyncWorker(env),
+          deferred_(Napi::Promise::Deferred::New(env)),
+          mixer_(std::move(mixer)),
+          ticket_(mixer_->requestLifecycleChange()),
+          starting_(starting),
+          result_(false),
+          cancelled_(false) {}
+
+    Napi::Promise promise() const { return deferred_.Promise(); }
+
+protected:
+    void Execute() override {
+        if (starting_) {
+            AudioMixer::StartResult status = mixer_->start(ticket_);
+            result_ = status == AudioMixer::StartResult::Started;
+            cancelled_ = status == AudioMixer::StartResult::Cancelled;
+        } else {
+            result_ = mixer_->stop(ticket_);
         }
+    }
 
-        if (!channel || !channel->ringBuffer || !channel->enabled.load()) {
-            return noErr;
+    void OnOK() override {
+        Napi::Env env = Env();
+        if (cancelled_) {
+            Napi::Error error = Napi::Error::New(env, "Mixer start cancelled");
+            error.Set("code", Napi::String::New(env, "ECANCELED"));
+            deferred_.Reject(error.Value());
+            return;
         }
+        deferred_.Resolve(Napi::Boolean::New(env, result_));
+    }
 
-        if (inputData && inputData->mNumberBuffers > 0) {
-            for (UInt32 i = 0; i < inputData->mNumberBuffers; i++) {
-                const AudioBuffer& buf = inputData->mBuffers[i];
-                if (buf.mData && buf.mDataByteSize > 0) {
-                    channel->ringBuffer->write(buf.mData, buf.mDataByteSize);
+    void OnError(const Napi::Error& error) override {
+        deferred_.Reject(error.Value());
+    }
 
-                    // Calculate peak and RMS levels
-                    const Float32* samples = static_cast<const Float32*>(buf.mData);
-                    UInt32 sampleCount = buf.mDataByteSize / sizeof(Float32);
+private:
+    Napi::Promise::Deferred deferred_;
+    std::shared_ptr<AudioMixer> mixer_;
+    uint64_t ticket_;
+    bool starting_;
+    bool result_;
+    bool cancelled_;
+};
 
-                    float peak = 0.0f;
-                    float sumSquares = 0.0f;
-                    bool hasAudio = false;
+Napi::Value queueMixerLifecycle(const Napi::CallbackInfo& info, bool starting) {
+    Napi::Env env = info.Env();
 
-                    for (UInt32 j = 0; j < sampleCount; j++) {
-                        float absVal = std::fabs(samples[j]);
-                        if (absVal > peak) {
-                            peak = absVal;
-                        }
-                        sumSquares += samples[j] * samples[j];
-                        if (absVal > 0.001f) {
-                            hasAudio = true;
-                        }
-                    }
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Mixer handle required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
 
-                    // Calculate RMS
-                    float rms = sampleCount > 0 ? std::sqrt(sumSquares / sampleCount) : 0.0f;
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
 
-                    // Store levels (atomic, lock-free)
-                    channel->peakLevel.store(peak, std::memory_order_relaxed);
-                    channel->rmsLevel.store(rms, std::memory_order_relaxed);
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        deferred.Resolve(Napi::Boolean::New(env, false));
+        return deferred.Promise();
+    }
 
-                    // Update activity time if audio detected
-                    if (hasAudio) {
-                        channel->lastActivityTime.store(
-                            std::chrono::steady_clock::now().time_since_epoch().count()
-                        );
-                    }
-                }
-            }
-        }
+    auto* worker = new MixerLifecycleWorker(env, std::move(mixer), starting);
+    Napi::Promise promise = worker->promise();
+    worker->Queue();
+    return promise;
+}
 
-        return noErr;
+Napi::Value MixerStart(const Napi::CallbackInfo& info) {
+    return queueMixerLifecycle(info, true);
+}
+
+Napi::Value MixerStop(const Napi::CallbackInfo& info) {
+    return queueMixerLifecycle(info, false);
+}
+
+Napi::Value MixerGetLevels(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Mixer handle required").ThrowAsJavaScriptException();
+        return env.Null();
     }
 
-    // Output IOProc - mixes all inputs and writes to output
-    static OSStatus OutputIOProc(AudioObjectID /* device */,
-                                  const AudioTimeStamp* /* now */,
-                                  const AudioBufferList* /* inputData */,
-                                  const AudioTimeStamp* /* inputTime */,
-                                  AudioBufferList* outputData,
-                                  const AudioTimeStamp* /* outputTime */,
-                                  void* clientData) {
-        auto* self = static_cast<AudioMixer*>(clientData);
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
 
-        if (!outputData || outputData->mNumberBuffers == 0) {
-            return noErr;
-        }
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        return Napi::Object::New(env);  // Return empty object
+    }
 
-        for (UInt32 bufIdx = 0; bufIdx < outputData->mNumberBuffers; bufIdx++) {
-            AudioBuffer& outBuf = outputData->mBuffers[bufIdx];
-            if (!outBuf.mData || outBuf.mDataByteSize == 0) {
-                continue;
-            }
+    auto levels = mixer->getLevels();
 
-            // Clear output buffer
-            memset(outBuf.mData, 0, outBuf.mDataByteSize);
+    // Create result object: { deviceUid: { name, handle, peak, rms, gainReductionDb } }
+    Napi::Object result = Napi::Object::New(env);
+    for (const auto& level : levels) {
+        Napi::Object channelObj = Napi::Object::New(env);
+        channelObj.Set("name", Napi::String::New(env, level.name));
+        channelObj.Set("handle", Napi::Number::New(env, level.deviceHandle));
+        channelObj.Set("peak", Napi::Number::New(env, level.peak));
+        channelObj.Set("rms", Napi::Number::New(env, level.rms));
+        channelObj.Set("gainReductionDb", Napi::Number::New(env, level.gainReductionDb));
+        result.Set(level.uid.empty() ? level.name : level.uid, channelObj);
+    }
 
-            Float32* outSamples = static_cast<Float32*>(outBuf.mData);
-            UInt32 outputFrameCount = outBuf.mDataByteSize / sizeof(Float32) / 2;  // stereo frames
-            UInt32 outputSampleCount = outputFrameCount * 2;  // total samples
+    return result;
+}
 
-            // Mix all enabled inputs
-            for (auto& ch : self->inputs_) {
-                if (!ch.enabled.load() || !ch.ringBuffer) {
-                    continue;
-                }
+Napi::Value MixerGetTiming(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
 
-                float gain = ch.gain.load();
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Mixer handle required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
 
-                if (ch.converter) {
-                    // Sample rate conversion needed
-                    // Calculate how many input frames we need based on the conversion ratio
-                    double ratio = ch.inputSampleRate / self->outputSampleRate_;
-                    size_t inputFramesNeeded = static_cast<size_t>(outputFrameCount * ratio) + 2;  // +2 for interpolation safety
-                    size_t inputBytesNeeded = inputFramesNeeded * 2 * sizeof(Float32);
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
 
-                    // Read input samples at the input sample rate
-                    std::vector<Float32> inputBuffer(inputFramesNeeded * 2);
-                    size_t bytesRead = ch.ringBuffer->read(inputBuffer.data(), inputBytesNeeded);
-                    if (bytesRead == 0) {
-                        continue;
-                    }
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        return env.Null();
+    }
 
-                    size_t inputFramesRead = bytesRead / (2 * sizeof(Float32));
+    // { output: timing, inputs: { deviceUid: { name, handle, ...timing } } }
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("output", timingToJs(env, mixer->getOutputTiming()));
 
-                    // Convert to output sample rate
-                    std::vector<Float32> convertedBuffer(outputFrameCount * 2);
-                    size_t convertedFrames = ch.converter->convert(
-                        inputBuffer.data(), inputFramesRead,
-                        convertedBuffer.data(), outputFrameCount
-                    );
+    Napi::Object inputs = Napi::Object::New(env);
+    for (const auto& input : mixer->getInputTimings()) {
+        Napi::Object inputObj = timingToJs(env, input.timing);
+        inputObj.Set("name", Napi::String::New(env, input.name));
+        inputObj.Set("handle", Napi::Number::New(env, input.deviceHandle));
+        inputs.Set(input.uid.empty() ? input.name : input.uid, inputObj);
+    }
+    result.Set("inputs", inputs);
 
-                    // Mix converted samples into output with gain
-                    size_t samplesToMix = convertedFrames * 2;
-                    for (size_t i = 0; i < samplesToMix && i < outputSampleCount; i++) {
-                        outSamples[i] += convertedBuffer[i] * gain;
-                    }
-                } else {
-                    // No sample rate conversion needed - direct read
-                    std::vector<Float32> tempBuffer(outputSampleCount);
-                    size_t bytesRead = ch.ringBuffer->read(tempBuffer.data(), outBuf.mDataByteSize);
-                    if (bytesRead == 0) {
-                        continue;
-                    }
+    return result;
+}
 
-                    UInt32 samplesRead = bytesRead / sizeof(Float32);
+Napi::Value MixerResetTiming(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
 
-                    // Mix into output with gain
-                    for (UInt32 i = 0; i < samplesRead && i < outputSampleCount; i++) {
-                        outSamples[i] += tempBuffer[i] * gain;
-                    }
-                }
-            }
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Mixer handle required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
+
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        return Napi::Boolean::New(env, false);
+    }
+
+    mixer->resetTiming();
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value MixerGetRingStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Mixer handle required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
 
-            // Apply master volume and clipping protection
-            float masterVol = self->masterVolume_.load();
-            for (UInt32 i = 0; i < outputSampleCount; i++) {
-                outSamples[i] *= masterVol;
-                // Soft clipping
-                if (outSamples[i] > 1.0f) outSamples[i] = 1.0f;
-                else if (outSamples[i] < -1.0f) outSamples[i] = -1.0f;
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        return env.Null();
+    }
+
+    // { total: stats, inputs: { deviceUid: { name, handle, ...stats } } }
+    Napi::Object inputs = Napi::Object::New(env);
+    RingStats::Snapshot total = {};
+    for (const auto& input : mixer->readRingStats()) {
+        total += input.stats;
+        Napi::Object inputObj = ringStatsToJs(env, input.stats);
+        inputObj.Set("name", Napi::String::New(env, input.name));
+        inputObj.Set("handle", Napi::Number::New(env, input.deviceHandle));
+        inputs.Set(input.uid.empty() ? input.name : input.uid, inputObj);
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("total", ringStatsToJs(env, total));
+    result.Set("inputs", inputs);
+    return result;
+}
+
+Napi::Object recordingStatsToJs(Napi::Env env, const BusRecorder::Stats& stats, const std::string& path) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("recording", Napi::Boolean::New(env, stats.recording));
+    obj.Set("path", Napi::String::New(env, path));
+    obj.Set("framesWritten", Napi::Number::New(env, static_cast<double>(stats.framesWritten)));
+    obj.Set("droppedFrames", Napi::Number::New(env, static_cast<double>(stats.droppedFrames)));
+    obj.Set("bytesWritten", Napi::Number::New(env, static_cast<double>(stats.bytesWritten)));
+    obj.Set("seconds", Napi::Number::New(env, stats.seconds));
+    obj.Set("writeSeconds", Napi::Number::New(env, stats.writeSeconds));
+    obj.Set("maxWriteMs", Napi::Number::New(env, stats.maxWriteNs / 1e6));
+    obj.Set("backlogMaxFrames", Napi::Number::New(env, static_cast<double>(stats.backlogMaxFrames)));
+    obj.Set("ringCapacityFrames", Napi::Number::New(env, static_cast<double>(stats.ringCapacityFrames)));
+    return obj;
+}
+
+// Starts or stops a mixer's recording on a worker thread; starting creates the
+// file and stopping drains the writer and finalizes the header, and either can
+// block on the disk
+class MixerRecordingWorker : public Napi::AsyncWorker {
+public:
+    // Start a take at path
+    MixerRecordingWorker(Napi::Env env, std::shared_ptr<AudioMixer> mixer, const std::string& path,
+                         BusRecorder::Format format)
+        : Napi::AsyncWorker(env),
+          deferred_(Napi::Promise::Deferred::New(env)),
+          mixer_(std::move(mixer)),
+          starting_(true),
+          path_(path),
+          format_(format) {}
+
+    // Finish the current take
+    MixerRecordingWorker(Napi::Env env, std::shared_ptr<AudioMixer> mixer)
+        : Napi::AsyncWorker(env),
+          deferred_(Napi::Promise::Deferred::New(env)),
+          mixer_(std::move(mixer)),
+          starting_(false),
+          format_(BusRecorder::Format::Wav) {}
+
+    Napi::Promise promise() const { return deferred_.Promise(); }
+
+protected:
+    void Execute() override {
+        std::string error;
+        if (starting_) {
+            if (!mixer_->startRecording(path_, format_, error)) {
+                SetError(error);
             }
+            return;
+        }
+        if (!mixer_->stopRecording(error)) {
+            SetError(error);
+            return;
+        }
+        stats_ = mixer_->getRecordingStats();
+        path_ = mixer_->getRecordingPath();
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        if (starting_) {
+            deferred_.Resolve(Napi::Boolean::New(env, true));
+        } else {
+            deferred_.Resolve(recordingStatsToJs(env, stats_, path_));
         }
+    }
 
-        return noErr;
+    void OnError(const Napi::Error& error) override {
+        deferred_.Reject(error.Value());
     }
 
-    std::string name_;
-    std::vector<InputChannel> inputs_;
-    AudioDeviceID outputDevice_;
-    AudioDeviceIOProcID outputProcID_;
-    std::atomic<bool> running_;
-    std::atomic<float> masterVolume_;
-    Float64 outputSampleRate_;  // Output device sample rate
-    std::mutex mutex_;
+private:
+    Napi::Promise::Deferred deferred_;
+    std::shared_ptr<AudioMixer> mixer_;
+    bool starting_;
+    std::string path_;
+    BusRecorder::Format format_;
+    BusRecorder::Stats stats_;
 };
 
-// Global mixer instances
-std::vector<std::unique_ptr<AudioMixer>> g_mixers;
-std::mutex g_mixerMutex;
+// mixerStartRecording(handle, path, format = 'wav') - resolves true once the
+// file is open (false for an unknown handle) and rejects if it can't be started
+Napi::Value MixerStartRecording(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
 
-// ============================================================================
-// N-API wrapper functions
-// ============================================================================
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Mixer handle and path required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
 
-// N-API wrapper functions
-Napi::Value ListAudioDevices(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
+    std::string path = info[1].As<Napi::String>().Utf8Value();
+    BusRecorder::Format format = BusRecorder::Format::Wav;
+    if (info.Length() >= 3 && info[2].IsString()
+        && !BusRecorder::parseFormat(info[2].As<Napi::String>().Utf8Value(), format)) {
+        Napi::TypeError::New(env, "Format must be 'wav' or 'caf'").ThrowAsJavaScriptException();
+        return env.Null();
+    }
 
-    AudioObjectPropertyAddress propAddr = {
-        kAudioHardwarePropertyDevices,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        deferred.Resolve(Napi::Boolean::New(env, false));
+        return deferred.Promise();
+    }
 
-    UInt32 propSize = 0;
-    OSStatus status = AudioObjectGetPropertyDataSize(kAudioObjectSystemObject, &propAddr,
-                                                      0, nullptr, &propSize);
-    if (status != noErr) {
+    auto* worker = new MixerRecordingWorker(env, std::move(mixer), path, format);
+    Napi::Promise promise = worker->promise();
+    worker->Queue();
+    return promise;
+}
+
+// mixerStopRecording(handle) - flushes and closes the file; resolves with its
+// final stats (null for an unknown handle)
+Napi::Value MixerStopRecording(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Mixer handle required").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    UInt32 deviceCount = propSize / sizeof(AudioDeviceID);
-    std::vector<AudioDeviceID> devices(deviceCount);
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
 
-    status = AudioObjectGetPropertyData(kAudioObjectSystemObject, &propAddr,
-                                        0, nullptr, &propSize, devices.data());
-    if (status != noErr) {
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        deferred.Resolve(env.Null());
+        return deferred.Promise();
+    }
+
+    auto* worker = new MixerRecordingWorker(env, std::move(mixer));
+    Napi::Promise promise = worker->promise();
+    worker->Queue();
+    return promise;
+}
+
+// Current or last recording of a mixer, or null
+Napi::Value MixerGetRecordingStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Mixer handle required").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Array result = Napi::Array::New(env);
-    uint32_t index = 0;
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
 
-    for (AudioDeviceID deviceID : devices) {
-        // Get device name
-        propAddr.mSelector = kAudioObjectPropertyName;
-        CFStringRef deviceName = nullptr;
-        propSize = sizeof(deviceName);
-        status = AudioObjectGetPropertyData(deviceID, &propAddr, 0, nullptr, &propSize, &deviceName);
-        if (status != noErr || !deviceName) {
-            continue;
-        }
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        return env.Null();
+    }
 
-        char nameBuf[256];
-        if (!CFStringGetCString(deviceName, nameBuf, sizeof(nameBuf), kCFStringEncodingUTF8)) {
-            CFRelease(deviceName);
-            continue;
-        }
-        CFRelease(deviceName);
+    return recordingStatsToJs(env, mixer->getRecordingStats(), mixer->getRecordingPath());
+}
 
-        // Check if has output
-        propAddr.mSelector = kAudioDevicePropertyStreams;
-        propAddr.mScope = kAudioDevicePropertyScopeOutput;
-        status = AudioObjectGetPropertyDataSize(deviceID, &propAddr, 0, nullptr, &propSize);
-        bool hasOutput = (status == noErr && propSize > 0);
+Napi::Object stemStatsToJs(Napi::Env env, const StemRecorder::Stats& stats, const std::vector<std::string>& paths) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("recording", Napi::Boolean::New(env, stats.recording));
+    Napi::Array files = Napi::Array::New(env, paths.size());
+    for (size_t i = 0; i < paths.size(); i++) {
+        files.Set(static_cast<uint32_t>(i), Napi::String::New(env, paths[i]));
+    }
+    obj.Set("paths", files);
+    obj.Set("stems", Napi::Number::New(env, static_cast<double>(stats.stems)));
+    obj.Set("framesWritten", Napi::Number::New(env, static_cast<double>(stats.framesWritten)));
+    obj.Set("droppedFrames", Napi::Number::New(env, static_cast<double>(stats.droppedFrames)));
+    obj.Set("bytesWritten", Napi::Number::New(env, static_cast<double>(stats.bytesWritten)));
+    obj.Set("seconds", Napi::Number::New(env, stats.seconds));
+    obj.Set("writeSeconds", Napi::Number::New(env, stats.writeSeconds));
+    obj.Set("maxWriteMs", Napi::Number::New(env, stats.maxWriteNs / 1e6));
+    obj.Set("backlogMaxFrames", Napi::Number::New(env, static_cast<double>(stats.backlogMaxFrames)));
+    return obj;
+}
 
-        // Check if has input
-        propAddr.mScope = kAudioDevicePropertyScopeInput;
-        status = AudioObjectGetPropertyDataSize(deviceID, &propAddr, 0, nullptr, &propSize);
-        bool hasInput = (status == noErr && propSize > 0);
+// Starts or stops a mixer's stem take on a worker thread; starting creates one
+// file per input (or one interleaved file) and stopping drains the writer and
+// finalizes them, and either can block on the disk
+class MixerStemsWorker : public Napi::AsyncWorker {
+public:
+    // Start a take in directory
+    MixerStemsWorker(Napi::Env env, std::shared_ptr<AudioMixer> mixer, const std::string& directory,
+                     StemRecorder::Layout layout, BusRecorder::Format format)
+        : Napi::AsyncWorker(env),
+          deferred_(Napi::Promise::Deferred::New(env)),
+          mixer_(std::move(mixer)),
+          starting_(true),
+          directory_(directory),
+          layout_(layout),
+          format_(format) {}
+
+    // Finish the current take
+    MixerStemsWorker(Napi::Env env, std::shared_ptr<AudioMixer> mixer)
+        : Napi::AsyncWorker(env),
+          deferred_(Napi::Promise::Deferred::New(env)),
+          mixer_(std::move(mixer)),
+          starting_(false),
+          layout_(StemRecorder::Layout::PerFile),
+          format_(BusRecorder::Format::Wav) {}
+
+    Napi::Promise promise() const { return deferred_.Promise(); }
+
+protected:
+    void Execute() override {
+        std::string error;
+        if (starting_) {
+            if (!mixer_->startStems(directory_, layout_, format_, error)) {
+                SetError(error);
+            }
+            return;
+        }
+        if (!mixer_->stopStems(error)) {
+            SetError(error);
+            return;
+        }
+        stats_ = mixer_->getStemStats();
+        paths_ = mixer_->getStemPaths();
+    }
 
-        Napi::Object device = Napi::Object::New(env);
-        device.Set("id", Napi::Number::New(env, deviceID));
-        device.Set("name", Napi::String::New(env, nameBuf));
-        device.Set("hasOutput", Napi::Boolean::New(env, hasOutput));
-        device.Set("hasInput", Napi::Boolean::New(env, hasInput));
+    void OnOK() override {
+        Napi::Env env = Env();
+        if (starting_) {
+            deferred_.Resolve(Napi::Boolean::New(env, true));
+        } else {
+            deferred_.Resolve(stemStatsToJs(env, stats_, paths_));
+        }
+    }
 
-        result[index++] = device;
+    void OnError(const Napi::Error& error) override {
+        deferred_.Reject(error.Value());
     }
 
-    return result;
-}
+private:
+    Napi::Promise::Deferred deferred_;
+    std::shared_ptr<AudioMixer> mixer_;
+    bool starting_;
+    std::string directory_;
+    StemRecorder::Layout layout_;
+    BusRecorder::Format format_;
+    StemRecorder::Stats stats_;
+    std::vector<std::string> paths_;
+};
 
-Napi::Value StartPassthrough(const Napi::CallbackInfo& info) {
+// mixerStartStems(handle, directory, layout = 'files', format = 'wav') - resolves
+// true once the files are open (false for an unknown handle) and rejects if they
+// can't be started
+Napi::Value MixerStartStems(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 1 || !info[0].IsString()) {
-        Napi::TypeError::New(env, "Input device name required").ThrowAsJavaScriptException();
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Mixer handle and directory required").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    std::string inputName = info[0].As<Napi::String>().Utf8Value();
-
-    // Find device that has INPUT streams (for reading loopback audio)
-    AudioDeviceID inputDevice = findDeviceByName(inputName, false);  // false = look for input capability
-    if (inputDevice == kAudioObjectUnknown) {
-        // Fallback: try finding by output capability (older approach)
-        inputDevice = findDeviceByName(inputName, true);
-    }
-    if (inputDevice == kAudioObjectUnknown) {
-        Napi::Error::New(env, "Input device not found: " + inputName).ThrowAsJavaScriptException();
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
+    std::string directory = info[1].As<Napi::String>().Utf8Value();
+    StemRecorder::Layout layout = StemRecorder::Layout::PerFile;
+    if (info.Length() >= 3 && info[2].IsString()
+        && !StemRecorder::parseLayout(info[2].As<Napi::String>().Utf8Value(), layout)) {
+        Napi::TypeError::New(env, "Layout must be 'files' or 'interleaved'").ThrowAsJavaScriptException();
         return env.Null();
     }
-
-    AudioDeviceID outputDevice = getDefaultOutputDevice();
-    if (outputDevice == kAudioObjectUnknown) {
-        Napi::Error::New(env, "No default output device").ThrowAsJavaScriptException();
+    BusRecorder::Format format = BusRecorder::Format::Wav;
+    if (info.Length() >= 4 && info[3].IsString()
+        && !BusRecorder::parseFormat(info[3].As<Napi::String>().Utf8Value(), format)) {
+        Napi::TypeError::New(env, "Format must be 'wav' or 'caf'").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    // Don't passthrough to itself
-    if (inputDevice == outputDevice) {
-        return Napi::Boolean::New(env, true);
-    }
-
-    std::lock_guard<std::mutex> lock(g_mutex);
-
-    auto passthrough = std::make_unique<AudioPassthrough>();
-    if (!passthrough->start(inputDevice, outputDevice)) {
-        Napi::Error::New(env, "Failed to start passthrough").ThrowAsJavaScriptException();
-        return env.Null();
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        deferred.Resolve(Napi::Boolean::New(env, false));
+        return deferred.Promise();
     }
 
-    PassthroughInfo ptInfo;
-    ptInfo.passthrough = std::move(passthrough);
-    ptInfo.deviceName = inputName;
-    ptInfo.inputDeviceId = inputDevice;
-    g_passthroughs.push_back(std::move(ptInfo));
-    return Napi::Number::New(env, static_cast<double>(g_passthroughs.size() - 1));
+    auto* worker = new MixerStemsWorker(env, std::move(mixer), directory, layout, format);
+    Napi::Promise promise = worker->promise();
+    worker->Queue();
+    return promise;
 }
 
-Napi::Value StopPassthrough(const Napi::CallbackInfo& info) {
+// mixerStopStems(handle) - flushes and closes the files; resolves with their
+// final stats (null for an unknown handle)
+Napi::Value MixerStopStems(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 1 || !info[0].IsNumber()) {
-        Napi::TypeError::New(env, "Passthrough index required").ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, "Mixer handle required").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    size_t index = static_cast<size_t>(info[0].As<Napi::Number>().Int32Value());
-
-    std::lock_guard<std::mutex> lock(g_mutex);
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
 
-    if (index >= g_passthroughs.size() || !g_passthroughs[index].passthrough) {
-        return Napi::Boolean::New(env, false);
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        deferred.Resolve(env.Null());
+        return deferred.Promise();
     }
 
-    g_passthroughs[index].passthrough->stop();
-    g_passthroughs[index].passthrough.reset();
-
-    return Napi::Boolean::New(env, true);
+    auto* worker = new MixerStemsWorker(env, std::move(mixer));
+    Napi::Promise promise = worker->promise();
+    worker->Queue();
+    return promise;
 }
 
-Napi::Value StopAllPassthrough(const Napi::CallbackInfo& info) {
+// Current or last stem take of a mixer, or null
+Napi::Value MixerGetStemStats(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    std::lock_guard<std::mutex> lock(g_mutex);
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Mixer handle required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
 
-    for (auto& pt : g_passthroughs) {
-        if (pt.passthrough) {
-            pt.passthrough->stop();
-        }
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
+
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        return env.Null();
     }
-    g_passthroughs.clear();
 
-    return Napi::Boolean::New(env, true);
+    return stemStatsToJs(env, mixer->getStemStats(), mixer->getStemPaths());
 }
 
-Napi::Value SetPassthroughVolume(const Napi::CallbackInfo& info) {
+Napi::Object replayStatsToJs(Napi::Env env, const ReplayBuffer::Stats& stats) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("running", Napi::Boolean::New(env, stats.running));
+    obj.Set("sampleRate", Napi::Number::New(env, stats.sampleRate));
+    obj.Set("windowSeconds", Napi::Number::New(env, stats.windowSeconds));
+    obj.Set("heldSeconds", Napi::Number::New(env, stats.heldSeconds));
+    obj.Set("compressedBytes", Napi::Number::New(env, static_cast<double>(stats.compressedBytes)));
+    obj.Set("arenaBytes", Napi::Number::New(env, static_cast<double>(stats.arenaBytes)));
+    obj.Set("bytesPerMinute", Napi::Number::New(env, stats.bytesPerMinute));
+    obj.Set("compressionRatio", Napi::Number::New(env, stats.compressionRatio));
+    obj.Set("droppedFrames", Napi::Number::New(env, static_cast<double>(stats.droppedFrames)));
+    obj.Set("evictedFrames", Napi::Number::New(env, static_cast<double>(stats.evictedFrames)));
+    obj.Set("encodeSeconds", Napi::Number::New(env, stats.encodeSeconds));
+    obj.Set("maxEncodeMs", Napi::Number::New(env, stats.maxEncodeNs / 1e6));
+    return obj;
+}
+
+// mixerStartReplay(handle, seconds, maxBytes = 0) - throws if the mixer isn't running
+Napi::Value MixerStartReplay(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber()) {
-        Napi::TypeError::New(env, "Index and volume required").ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, "Mixer handle and seconds required").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    size_t index = static_cast<size_t>(info[0].As<Napi::Number>().Int32Value());
-    float volume = info[1].As<Napi::Number>().FloatValue();
-
-    std::lock_guard<std::mutex> lock(g_mutex);
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
+    double seconds = info[1].As<Napi::Number>().DoubleValue();
+    size_t maxBytes = 0;
+    if (info.Length() >= 3 && info[2].IsNumber()) {
+        maxBytes = static_cast<size_t>(std::max(0.0, info[2].As<Napi::Number>().DoubleValue()));
+    }
 
-    if (index >= g_passthroughs.size() || !g_passthroughs[index].passthrough) {
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
         return Napi::Boolean::New(env, false);
     }
 
-    g_passthroughs[index].passthrough->setVolume(volume);
+    std::string error;
+    if (!mixer->startReplay(seconds, maxBytes, error)) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
     return Napi::Boolean::New(env, true);
 }
 
-Napi::Value GetDefaultOutputDevice(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
+// Decodes the replay window and writes the WAV on a worker thread; a window
+// of minutes is tens of MB and would stall the JS thread for a noticeable time
+class SaveReplayWorker : public Napi::AsyncWorker {
+public:
+    SaveReplayWorker(Napi::Env env, std::shared_ptr<AudioMixer> mixer, const std::string& path, double seconds)
+        : Napi::AsyncWorker(env),
+          deferred_(Napi::Promise::Deferred::New(env)),
+          mixer_(std::move(mixer)),
+          path_(path),
+          seconds_(seconds),
+          savedSeconds_(0) {}
+
+    Napi::Promise promise() const { return deferred_.Promise(); }
+
+protected:
+    void Execute() override {
+        std::string error;
+        if (!mixer_->saveReplay(path_, seconds_, savedSeconds_, error)) {
+            SetError(error);
+        }
+    }
 
-    AudioDeviceID deviceID = getDefaultOutputDevice();
-    if (deviceID == kAudioObjectUnknown) {
-        return env.Null();
+    void OnOK() override {
+        deferred_.Resolve(Napi::Number::New(Env(), savedSeconds_));
     }
 
-    // Get device name
-    AudioObjectPropertyAddress propAddr = {
-        kAudioObjectPropertyName,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
+    void OnError(const Napi::Error& error) override {
+        deferred_.Reject(error.Value());
+    }
 
-    CFStringRef deviceName = nullptr;
-    UInt32 propSize = sizeof(deviceName);
-    OSStatus status = AudioObjectGetPropertyData(deviceID, &propAddr, 0, nullptr, &propSize, &deviceName);
+private:
+    Napi::Promise::Deferred deferred_;
+    std::shared_ptr<AudioMixer> mixer_;
+    std::string path_;
+    double seconds_;
+    double savedSeconds_;
+};
+
+// mixerSaveReplay(handle, path, seconds = 0) - writes the newest seconds (0: all
+// held) as 24-bit WAV; resolves with the seconds saved (null for an unknown
+// handle) and rejects if the file can't be written
+Napi::Value MixerSaveReplay(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
 
-    if (status != noErr || !deviceName) {
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Mixer handle and path required").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    char nameBuf[256];
-    CFStringGetCString(deviceName, nameBuf, sizeof(nameBuf), kCFStringEncodingUTF8);
-    CFRelease(deviceName);
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
+    std::string path = info[1].As<Napi::String>().Utf8Value();
+    double seconds = 0;
+    if (info.Length() >= 3 && info[2].IsNumber()) {
+        seconds = info[2].As<Napi::Number>().DoubleValue();
+    }
 
-    Napi::Object result = Napi::Object::New(env);
-    result.Set("id", Napi::Number::New(env, deviceID));
-    result.Set("name", Napi::String::New(env, nameBuf));
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        deferred.Resolve(env.Null());
+        return deferred.Promise();
+    }
 
-    return result;
+    auto* worker = new SaveReplayWorker(env, std::move(mixer), path, seconds);
+    Napi::Promise promise = worker->promise();
+    worker->Queue();
+    return promise;
 }
 
-// Get whether a device is currently running (has active audio)
-Napi::Value GetDeviceIsRunning(const Napi::CallbackInfo& info) {
+Napi::Value MixerStopReplay(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 1 || !info[0].IsNumber()) {
-        Napi::TypeError::New(env, "Device ID required").ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, "Mixer handle required").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    AudioDeviceID deviceID = static_cast<AudioDeviceID>(info[0].As<Napi::Number>().Uint32Value());
-
-    AudioObjectPropertyAddress propAddr = {
-        kAudioDevicePropertyDeviceIsRunningSomewhere,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
-
-    UInt32 isRunning = 0;
-    UInt32 propSize = sizeof(isRunning);
-    OSStatus status = AudioObjectGetPropertyData(deviceID, &propAddr, 0, nullptr, &propSize, &isRunning);
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
 
-    if (status != noErr) {
-        return Napi::Boolean::New(env, false);
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (mixer) {
+        mixer->stopReplay();
     }
-
-    return Napi::Boolean::New(env, isRunning != 0);
+    return env.Undefined();
 }
 
-// Get activity status for all PCPanel devices based on actual audio data
-Napi::Value GetDeviceActivity(const Napi::CallbackInfo& info) {
+Napi::Value MixerGetReplayStats(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    std::lock_guard<std::mutex> lock(g_mutex);
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Mixer handle required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
 
-    Napi::Object result = Napi::Object::New(env);
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
 
-    // Check each passthrough for audio activity
-    for (const auto& pt : g_passthroughs) {
-        if (pt.passthrough && !pt.deviceName.empty()) {
-            Napi::Object deviceInfo = Napi::Object::New(env);
-            deviceInfo.Set("id", Napi::Number::New(env, static_cast<double>(pt.inputDeviceId)));
-            deviceInfo.Set("name", Napi::String::New(env, pt.deviceName));
-            deviceInfo.Set("isActive", Napi::Boolean::New(env, pt.passthrough->hasAudioActivity()));
+    std::shared_ptr<AudioMixer> mixer = g_mixers.get(handle);
+    if (!mixer) {
+        return env.Null();
+    }
 
-            // App names not yet implemented - requires privileged helper daemon
-            Napi::Array appsArray = Napi::Array::New(env, 0);
-            deviceInfo.Set("apps", appsArray);
+    return replayStatsToJs(env, mixer->getReplayStats());
+}
 
-            result.Set(pt.deviceName, deviceInfo);
+// Stops mixers that are already unpublished on a worker thread. Stopping ends
+// any recording or stem take, which drains the writers and finalizes the files.
+class MixerTeardownWorker : public Napi::AsyncWorker {
+public:
+    MixerTeardownWorker(Napi::Env env, std::vector<std::shared_ptr<AudioMixer>> mixers)
+        : Napi::AsyncWorker(env),
+          deferred_(Napi::Promise::Deferred::New(env)),
+          mixers_(std::move(mixers)) {
+        // Supersede any queued start so a worker holding a mixer doesn't restart it
+        for (auto& mixer : mixers_) {
+            mixer->requestLifecycleChange();
         }
     }
 
-    return result;
-}
-
-// ============================================================================
-// Mixer N-API Functions
-// ============================================================================
+    Napi::Promise promise() const { return deferred_.Promise(); }
 
-Napi::Value CreateMixer(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
+protected:
+    void Execute() override {
+        for (auto& mixer : mixers_) {
+            mixer->stop();
+        }
+        // Drop the references here so a last owner is destroyed off the JS thread
+        mixers_.clear();
+    }
 
-    std::string name = "Mixer";
-    if (info.Length() >= 1 && info[0].IsString()) {
-        name = info[0].As<Napi::String>().Utf8Value();
+    void OnOK() override {
+        deferred_.Resolve(Napi::Boolean::New(Env(), true));
     }
 
-    std::lock_guard<std::mutex> lock(g_mixerMutex);
-    auto mixer = std::make_unique<AudioMixer>(name);
-    g_mixers.push_back(std::move(mixer));
+    void OnError(const Napi::Error& error) override {
+        deferred_.Reject(error.Value());
+    }
 
-    return Napi::Number::New(env, static_cast<double>(g_mixers.size() - 1));
-}
+private:
+    Napi::Promise::Deferred deferred_;
+    std::vector<std::shared_ptr<AudioMixer>> mixers_;
+};
 
-Napi::Value MixerAddInput(const Napi::CallbackInfo& info) {
+// destroyMixer(handle) - resolves true once the mixer is stopped (false for an
+// unknown handle); the handle is stale as soon as the call returns
+Napi::Value DestroyMixer(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsString()) {
-        Napi::TypeError::New(env, "Mixer handle and device name required").ThrowAsJavaScriptException();
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Mixer handle required").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    size_t handle = static_cast<size_t>(info[0].As<Napi::Number>().Int32Value());
-    std::string deviceName = info[1].As<Napi::String>().Utf8Value();
+    uint32_t handle = info[0].As<Napi::Number>().Uint32Value();
 
-    std::lock_guard<std::mutex> lock(g_mixerMutex);
-    if (handle >= g_mixers.size() || !g_mixers[handle]) {
-        return Napi::Boolean::New(env, false);
+    // Unpublish first so the handle goes stale before teardown begins
+    std::shared_ptr<AudioMixer> mixer = g_mixers.erase(handle);
+    if (!mixer) {
+        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        deferred.Resolve(Napi::Boolean::New(env, false));
+        return deferred.Promise();
     }
 
-    return Napi::Boolean::New(env, g_mixers[handle]->addInput(deviceName));
+    std::vector<std::shared_ptr<AudioMixer>> mixers;
+    mixers.push_back(std::move(mixer));
+    auto* worker = new MixerTeardownWorker(env, std::move(mixers));
+    Napi::Promise promise = worker->promise();
+    worker->Queue();
+    return promise;
 }
 
-Napi::Value MixerSetInputGain(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
-
-    if (info.Length() < 3 || !info[0].IsNumber() || !info[1].IsString() || !info[2].IsNumber()) {
-        Napi::TypeError::New(env, "Mixer handle, device name, and gain required").ThrowAsJavaScriptException();
-        return env.Null();
-    }
+// stopAllMixers() - resolves true once every mixer is stopped
+Napi::Value StopAllMixers(const Napi::CallbackInfo& info) {
+    auto* worker = new MixerTeardownWorker(info.Env(), g_mixers.clear());
+    Napi::Promise promise = worker->promise();
+    worker->Queue();
+    return promise;
+}
 
-    size_t handle = static_cast<size_t>(info[0].As<Napi::Number>().Int32Value());
-    std::string deviceName = info[1].As<Napi::String>().Utf8Value();
-    float gain = info[2].As<Napi::Number>().FloatValue();
+// ============================================================================
+// Trace N-API Functions
+// ============================================================================
 
-    std::lock_guard<std::mutex> lock(g_mixerMutex);
-    if (handle >= g_mixers.size() || !g_mixers[handle]) {
-        return Napi::Boolean::New(env, false);
+// traceStart([eventsPerThread]) - starts recording, discarding any previous trace
+Napi::Value TraceStart(const Napi::CallbackInfo& info) {
+    size_t eventsPerThread = trace::kDefaultEventsPerThread;
+    if (info.Length() >= 1 && info[0].IsNumber()) {
+        eventsPerThread = std::max<size_t>(1024, info[0].As<Napi::Number>().Uint32Value());
     }
-
-    return Napi::Boolean::New(env, g_mixers[handle]->setInputGain(deviceName, gain));
+    trace::start(eventsPerThread);
+    return Napi::Boolean::New(info.Env(), true);
 }
 
-Napi::Value MixerSetInputEnabled(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
+Napi::Value TraceStop(const Napi::CallbackInfo& info) {
+    trace::stop();
+    return Napi::Boolean::New(info.Env(), true);
+}
 
-    if (info.Length() < 3 || !info[0].IsNumber() || !info[1].IsString() || !info[2].IsBoolean()) {
-        Napi::TypeError::New(env, "Mixer handle, device name, and enabled required").ThrowAsJavaScriptException();
-        return env.Null();
+// Writes the trace on a worker thread; a full pool is hundreds of thousands
+// of events and several MB of JSON
+class TraceWriteWorker : public Napi::AsyncWorker {
+public:
+    TraceWriteWorker(Napi::Env env, const std::string& path)
+        : Napi::AsyncWorker(env),
+          deferred_(Napi::Promise::Deferred::New(env)),
+          path_(path),
+          events_(0),
+          overflow_{0, 0} {}
+
+    Napi::Promise promise() const { return deferred_.Promise(); }
+
+protected:
+    void Execute() override {
+        std::string error;
+        if (!trace::writeChromeJson(path_, events_, error)) {
+            SetError(error);
+            return;
+        }
+        overflow_ = trace::overflow();
     }
 
-    size_t handle = static_cast<size_t>(info[0].As<Napi::Number>().Int32Value());
-    std::string deviceName = info[1].As<Napi::String>().Utf8Value();
-    bool enabled = info[2].As<Napi::Boolean>().Value();
+    void OnOK() override {
+        Napi::Env env = Env();
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("events", Napi::Number::New(env, static_cast<double>(events_)));
+        result.Set("droppedThreads", Napi::Number::New(env, static_cast<double>(overflow_.threads)));
+        result.Set("droppedEvents", Napi::Number::New(env, static_cast<double>(overflow_.events)));
+        deferred_.Resolve(result);
+    }
 
-    std::lock_guard<std::mutex> lock(g_mixerMutex);
-    if (handle >= g_mixers.size() || !g_mixers[handle]) {
-        return Napi::Boolean::New(env, false);
+    void OnError(const Napi::Error& error) override {
+        deferred_.Reject(error.Value());
     }
 
-    return Napi::Boolean::New(env, g_mixers[handle]->setInputEnabled(deviceName, enabled));
-}
+private:
+    Napi::Promise::Deferred deferred_;
+    std::string path_;
+    size_t events_;
+    trace::Overflow overflow_;
+};
 
-Napi::Value MixerSetOutput(const Napi::CallbackInfo& info) {
+// traceWrite(path) - Chrome trace JSON of the last recording; resolves with
+// { events, droppedThreads, droppedEvents }, the last two counting threads
+// that found every trace slot taken
+Napi::Value TraceWrite(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber()) {
-        Napi::TypeError::New(env, "Mixer handle and device ID required").ThrowAsJavaScriptException();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Path required").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    size_t handle = static_cast<size_t>(info[0].As<Napi::Number>().Int32Value());
-    AudioDeviceID deviceId = static_cast<AudioDeviceID>(info[1].As<Napi::Number>().Uint32Value());
+    auto* worker = new TraceWriteWorker(env, info[0].As<Napi::String>().Utf8Value());
+    Napi::Promise promise = worker->promise();
+    worker->Queue();
+    return promise;
+}
 
-    std::lock_guard<std::mutex> lock(g_mixerMutex);
-    if (handle >= g_mixers.size() || !g_mixers[handle]) {
-        return Napi::Boolean::New(env, false);
+// ============================================================================
+// HID N-API Functions
+// ============================================================================
+
+Napi::ThreadSafeFunction g_hidTsfn;
+std::mutex g_hidMutex;
+
+// Turn everything the reader collected since the last drain into the same
+// event shapes parseInputPacket produces (plus connection events), in the
+// order the changes arrived. Knobs are coalesced to their latest value, which
+// is placed where that value arrived.
+Napi::Array hidPendingToEvents(Napi::Env env, const HidReader::Pending& pending) {
+    enum class Kind { Connection, State, Knob, Button };
+    struct Entry {
+        uint32_t order;
+        Kind kind;
+        uint32_t index;             // Control or pending.buttons index
+    };
+    std::vector<Entry> entries;
+    if (pending.connectionChanged) {
+        entries.push_back({pending.connectionOrder, Kind::Connection, 0});
+    }
+    if (pending.stateResponse) {
+        entries.push_back({pending.stateOrder, Kind::State, 0});
+    }
+    for (uint32_t i = 0; i < kHidAnalogCount; i++) {
+        if (pending.dirtyAnalog & (1u << i)) {
+            entries.push_back({pending.analogOrder[i], Kind::Knob, i});
+        }
+    }
+    for (uint32_t i = 0; i < pending.buttons.size(); i++) {
+        entries.push_back({pending.buttons[i].order, Kind::Button, i});
     }
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.order < b.order; });
 
-    return Napi::Boolean::New(env, g_mixers[handle]->setOutput(deviceId));
+    Napi::Array events = Napi::Array::New(env, entries.size());
+    uint32_t count = 0;
+    for (const Entry& entry : entries) {
+        Napi::Object event = Napi::Object::New(env);
+        switch (entry.kind) {
+            case Kind::Connection:
+                event.Set("type", Napi::String::New(env, pending.connected ? "connected" : "disconnected"));
+                break;
+            case Kind::State: {
+                Napi::Array analogValues = Napi::Array::New(env, kHidAnalogCount);
+                Napi::Array applied = Napi::Array::New(env, kHidAnalogCount);
+                for (uint32_t i = 0; i < kHidAnalogCount; i++) {
+                    analogValues[i] = Napi::Number::New(env, pending.analogValues[i]);
+                    applied[i] = Napi::Boolean::New(env, (pending.appliedAnalog & (1u << i)) != 0);
+                }
+                Napi::Array buttonStates = Napi::Array::New(env, kHidButtonCount);
+                for (uint32_t i = 0; i < kHidButtonCount; i++) {
+                    buttonStates[i] = Napi::Boolean::New(env, pending.buttonStates[i]);
+                }
+                event.Set("type", Napi::String::New(env, "state-response"));
+                event.Set("analogValues", analogValues);
+                event.Set("buttonStates", buttonStates);
+                event.Set("applied", applied);
+                break;
+            }
+            case Kind::Knob:
+                // Latest value per control - intermediate knob positions are coalesced
+                event.Set("type", Napi::String::New(env, "knob-change"));
+                event.Set("index", Napi::Number::New(env, entry.index));
+                event.Set("value", Napi::Number::New(env, pending.analogValues[entry.index]));
+                event.Set("applied", Napi::Boolean::New(env, (pending.appliedAnalog & (1u << entry.index)) != 0));
+                break;
+            case Kind::Button: {
+                // Every button edge is delivered
+                const HidReader::ButtonEvent& button = pending.buttons[entry.index];
+                event.Set("type", Napi::String::New(env, "button-change"));
+                event.Set("index", Napi::Number::New(env, button.index));
+                event.Set("pressed", Napi::Boolean::New(env, button.pressed));
+                break;
+            }
+        }
+        events[count++] = event;
+    }
+    return events;
 }
 
-Napi::Value MixerStart(const Napi::CallbackInfo& info) {
+// hidStart(vendorId, productId, callback(events[])) -> boolean
+Napi::Value HidStart(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 1 || !info[0].IsNumber()) {
-        Napi::TypeError::New(env, "Mixer handle required").ThrowAsJavaScriptException();
+    if (info.Length() < 3 || !info[0].IsNumber() || !info[1].IsNumber() || !info[2].IsFunction()) {
+        Napi::TypeError::New(env, "Vendor ID, product ID and callback required").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    size_t handle = static_cast<size_t>(info[0].As<Napi::Number>().Int32Value());
+    uint16_t vendorId = static_cast<uint16_t>(info[0].As<Napi::Number>().Uint32Value());
+    uint16_t productId = static_cast<uint16_t>(info[1].As<Napi::Number>().Uint32Value());
 
-    std::lock_guard<std::mutex> lock(g_mixerMutex);
-    if (handle >= g_mixers.size() || !g_mixers[handle]) {
-        return Napi::Boolean::New(env, false);
+    std::lock_guard<std::mutex> lock(g_hidMutex);
+
+    HidReader::instance().stop();
+    if (g_hidTsfn) {
+        g_hidTsfn.Release();
+        g_hidTsfn = Napi::ThreadSafeFunction();
     }
 
-    return Napi::Boolean::New(env, g_mixers[handle]->start());
-}
+    g_hidTsfn = Napi::ThreadSafeFunction::New(env, info[2].As<Napi::Function>(), "PCPanelHid", 0, 1);
+    g_hidTsfn.Unref(env);
 
-Napi::Value MixerStop(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
+    Napi::ThreadSafeFunction tsfn = g_hidTsfn;
+    bool started = HidReader::instance().start(vendorId, productId, [tsfn]() {
+        tsfn.NonBlockingCall([](Napi::Env env, Napi::Function callback) {
+            // hidStart resets the pending flag if this never runs after teardown
+            HidReader::Pending pending = HidReader::instance().takePending();
+            if (env != nullptr && callback != nullptr) {
+                callback.Call({hidPendingToEvents(env, pending)});
+            }
+        });
+    });
 
-    if (info.Length() < 1 || !info[0].IsNumber()) {
-        Napi::TypeError::New(env, "Mixer handle required").ThrowAsJavaScriptException();
-        return env.Null();
+    if (!started) {
+        g_hidTsfn.Release();
+        g_hidTsfn = Napi::ThreadSafeFunction();
     }
+    return Napi::Boolean::New(env, started);
+}
 
-    size_t handle = static_cast<size_t>(info[0].As<Napi::Number>().Int32Value());
+Napi::Value HidStop(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
 
-    std::lock_guard<std::mutex> lock(g_mixerMutex);
-    if (handle >= g_mixers.size() || !g_mixers[handle]) {
-        return Napi::Boolean::New(env, false);
+    std::lock_guard<std::mutex> lock(g_hidMutex);
+    HidReader::instance().stop();
+    if (g_hidTsfn) {
+        g_hidTsfn.Release();
+        g_hidTsfn = Napi::ThreadSafeFunction();
     }
-
-    g_mixers[handle]->stop();
     return Napi::Boolean::New(env, true);
 }
 
-Napi::Value MixerGetLevels(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
-
-    if (info.Length() < 1 || !info[0].IsNumber()) {
-        Napi::TypeError::New(env, "Mixer handle required").ThrowAsJavaScriptException();
-        return env.Null();
+// A custom curve from JS: an array of numbers, or undefined/null for none.
+// Throws a TypeError and returns false for anything else.
+bool taperPointsFromValue(Napi::Env env, const Napi::Value& value, std::vector<float>& points) {
+    points.clear();
+    if (value.IsUndefined() || value.IsNull()) {
+        return true;
+    }
+    if (!value.IsArray()) {
+        Napi::TypeError::New(env, "Taper curve must be an array of numbers").ThrowAsJavaScriptException();
+        return false;
+    }
+    Napi::Array array = value.As<Napi::Array>();
+    if (array.Length() < 2) {
+        Napi::TypeError::New(env, "Taper curve needs at least two points").ThrowAsJavaScriptException();
+        return false;
+    }
+    points.reserve(array.Length());
+    for (uint32_t i = 0; i < array.Length(); i++) {
+        Napi::Value point = array.Get(i);
+        if (!point.IsNumber()) {
+            Napi::TypeError::New(env, "Taper curve point " + std::to_string(i) + " is not a number")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+        points.push_back(point.As<Napi::Number>().FloatValue());
     }
+    return true;
+}
 
-    size_t handle = static_cast<size_t>(info[0].As<Napi::Number>().Int32Value());
+// hidSetGainMapping([{ channel, taper? } | deviceHandle | null, ...])
+// Index is the analog control; a bare handle uses the linear taper. 'custom'
+// uses the channel's table from setCustomTaper().
+Napi::Value HidSetGainMapping(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
 
-    std::lock_guard<std::mutex> lock(g_mixerMutex);
-    if (handle >= g_mixers.size() || !g_mixers[handle]) {
-        return Napi::Object::New(env);  // Return empty object
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Mapping array required").ThrowAsJavaScriptException();
+        return env.Null();
     }
 
-    auto levels = g_mixers[handle]->getLevels();
-
-    // Create result object: { deviceName: { peak, rms } }
-    Napi::Object result = Napi::Object::New(env);
-    for (const auto& level : levels) {
-        Napi::Object channelObj = Napi::Object::New(env);
-        channelObj.Set("peak", Napi::Number::New(env, level.peak));
-        channelObj.Set("rms", Napi::Number::New(env, level.rms));
-        result.Set(level.name, channelObj);
+    Napi::Array array = info[0].As<Napi::Array>();
+    std::vector<HidReader::GainMapping> mappings(kHidAnalogCount);
+    for (uint32_t i = 0; i < array.Length() && i < kHidAnalogCount; i++) {
+        Napi::Value entry = array.Get(i);
+        if (entry.IsNumber()) {
+            mappings[i].deviceHandle = entry.As<Napi::Number>().Uint32Value();
+        } else if (entry.IsObject()) {
+            Napi::Object obj = entry.As<Napi::Object>();
+            Napi::Value channel = obj.Get("channel");
+            if (!channel.IsNumber()) {
+                continue;
+            }
+            mappings[i].deviceHandle = channel.As<Napi::Number>().Uint32Value();
+            Napi::Value taper = obj.Get("taper");
+            if (taper.IsString()) {
+                mappings[i].curve = taperCurveFromName(taper.As<Napi::String>().Utf8Value());
+            }
+        }
     }
 
-    return result;
+    HidReader::instance().setGainMapping(mappings);
+    return Napi::Boolean::New(env, true);
 }
 
-Napi::Value DestroyMixer(const Napi::CallbackInfo& info) {
+// setCustomTaper(channel, curve | null) - builds the channel's custom table,
+// or drops it for null. The HID reader owns the tables; a curve needs at
+// least two points (TypeError otherwise).
+Napi::Value SetCustomTaper(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 1 || !info[0].IsNumber()) {
-        Napi::TypeError::New(env, "Mixer handle required").ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, "Channel handle required").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    size_t handle = static_cast<size_t>(info[0].As<Napi::Number>().Int32Value());
-
-    std::lock_guard<std::mutex> lock(g_mixerMutex);
-    if (handle >= g_mixers.size() || !g_mixers[handle]) {
-        return Napi::Boolean::New(env, false);
+    uint32_t channel = info[0].As<Napi::Number>().Uint32Value();
+    std::vector<float> points;
+    if (!taperPointsFromValue(env, info.Length() >= 2 ? info[1] : env.Undefined(), points)) {
+        return env.Null();
     }
 
-    g_mixers[handle]->stop();
-    g_mixers[handle].reset();
+    HidReader::instance().setCustomTaper(channel, points);
     return Napi::Boolean::New(env, true);
 }
 
-Napi::Value StopAllMixers(const Napi::CallbackInfo& info) {
+// taperGain(taper, value, channel?) -> gain. The same tables the native reader
+// uses, for controls that still go through JS (UI sliders, node-hid fallback).
+// 'custom' reads the channel's table from setCustomTaper() (linear if none).
+Napi::Value TaperGain(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    std::lock_guard<std::mutex> lock(g_mixerMutex);
-    for (auto& mixer : g_mixers) {
-        if (mixer) {
-            mixer->stop();
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Taper name and value required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    TaperCurve curve = taperCurveFromName(info[0].As<Napi::String>().Utf8Value());
+    uint32_t value = std::min(info[1].As<Napi::Number>().Uint32Value(), static_cast<uint32_t>(kTaperSize - 1));
+
+    if (curve == TaperCurve::Custom) {
+        if (info.Length() >= 3 && info[2].IsNumber()) {
+            uint32_t channel = info[2].As<Napi::Number>().Uint32Value();
+            return Napi::Number::New(env, HidReader::instance().customTaperGain(channel, static_cast<uint8_t>(value)));
         }
+        return Napi::Number::New(env, kLinearTaper[value]);
     }
-    g_mixers.clear();
+    return Napi::Number::New(env, taperTable(curve)[value]);
+}
 
-    return Napi::Boolean::New(env, true);
+Napi::Value HidRequestState(const Napi::CallbackInfo& info) {
+    return Napi::Boolean::New(info.Env(), HidReader::instance().requestState());
+}
+
+Napi::Value HidIsConnected(const Napi::CallbackInfo& info) {
+    return Napi::Boolean::New(info.Env(), HidReader::instance().isConnected());
 }
 
 // ============================================================================
@@ -1482,26 +3845,64 @@ Napi::Value StopAllMixers(const Napi::CallbackInfo& info) {
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
     // Passthrough functions
     exports.Set("listAudioDevices", Napi::Function::New(env, ListAudioDevices));
+    exports.Set("getCachedAudioDevices", Napi::Function::New(env, GetCachedAudioDevices));
     exports.Set("startPassthrough", Napi::Function::New(env, StartPassthrough));
     exports.Set("stopPassthrough", Napi::Function::New(env, StopPassthrough));
     exports.Set("stopAllPassthrough", Napi::Function::New(env, StopAllPassthrough));
     exports.Set("setPassthroughVolume", Napi::Function::New(env, SetPassthroughVolume));
+    exports.Set("getPassthroughTiming", Napi::Function::New(env, GetPassthroughTiming));
+    exports.Set("resetPassthroughTiming", Napi::Function::New(env, ResetPassthroughTiming));
+    exports.Set("getPassthroughRingStats", Napi::Function::New(env, GetPassthroughRingStats));
     exports.Set("getDefaultOutputDevice", Napi::Function::New(env, GetDefaultOutputDevice));
     exports.Set("getDeviceIsRunning", Napi::Function::New(env, GetDeviceIsRunning));
     exports.Set("getDeviceActivity", Napi::Function::New(env, GetDeviceActivity));
+    exports.Set("onDeviceChange", Napi::Function::New(env, OnDeviceChange));
+    exports.Set("resolveDevice", Napi::Function::New(env, ResolveDevice));
+    exports.Set("getDeviceByUID", Napi::Function::New(env, GetDeviceByUID));
 
     // Mixer functions
     exports.Set("createMixer", Napi::Function::New(env, CreateMixer));
     exports.Set("mixerAddInput", Napi::Function::New(env, MixerAddInput));
     exports.Set("mixerSetInputGain", Napi::Function::New(env, MixerSetInputGain));
     exports.Set("mixerSetInputEnabled", Napi::Function::New(env, MixerSetInputEnabled));
+    exports.Set("mixerApplyUpdates", Napi::Function::New(env, MixerApplyUpdates));
+    exports.Set("mixerSetInputCompressor", Napi::Function::New(env, MixerSetInputCompressor));
+    exports.Set("mixerSetDucking", Napi::Function::New(env, MixerSetDucking));
+    exports.Set("mixerGetDucking", Napi::Function::New(env, MixerGetDucking));
     exports.Set("mixerSetOutput", Napi::Function::New(env, MixerSetOutput));
     exports.Set("mixerStart", Napi::Function::New(env, MixerStart));
     exports.Set("mixerStop", Napi::Function::New(env, MixerStop));
     exports.Set("mixerGetLevels", Napi::Function::New(env, MixerGetLevels));
+    exports.Set("mixerGetTiming", Napi::Function::New(env, MixerGetTiming));
+    exports.Set("mixerResetTiming", Napi::Function::New(env, MixerResetTiming));
+    exports.Set("mixerGetRingStats", Napi::Function::New(env, MixerGetRingStats));
+    exports.Set("mixerStartRecording", Napi::Function::New(env, MixerStartRecording));
+    exports.Set("mixerStopRecording", Napi::Function::New(env, MixerStopRecording));
+    exports.Set("mixerGetRecordingStats", Napi::Function::New(env, MixerGetRecordingStats));
+    exports.Set("mixerStartStems", Napi::Function::New(env, MixerStartStems));
+    exports.Set("mixerStopStems", Napi::Function::New(env, MixerStopStems));
+    exports.Set("mixerGetStemStats", Napi::Function::New(env, MixerGetStemStats));
+    exports.Set("mixerStartReplay", Napi::Function::New(env, MixerStartReplay));
+    exports.Set("mixerSaveReplay", Napi::Function::New(env, MixerSaveReplay));
+    exports.Set("mixerStopReplay", Napi::Function::New(env, MixerStopReplay));
+    exports.Set("mixerGetReplayStats", Napi::Function::New(env, MixerGetReplayStats));
     exports.Set("destroyMixer", Napi::Function::New(env, DestroyMixer));
     exports.Set("stopAllMixers", Napi::Function::New(env, StopAllMixers));
 
+    // Trace functions
+    exports.Set("traceStart", Napi::Function::New(env, TraceStart));
+    exports.Set("traceStop", Napi::Function::New(env, TraceStop));
+    exports.Set("traceWrite", Napi::Function::New(env, TraceWrite));
+
+    // HID functions
+    exports.Set("hidStart", Napi::Function::New(env, HidStart));
+    exports.Set("hidStop", Napi::Function::New(env, HidStop));
+    exports.Set("hidSetGainMapping", Napi::Function::New(env, HidSetGainMapping));
+    exports.Set("hidRequestState", Napi::Function::New(env, HidRequestState));
+    exports.Set("hidIsConnected", Napi::Function::New(env, HidIsConnected));
+    exports.Set("setCustomTaper", Napi::Function::New(env, SetCustomTaper));
+    exports.Set("taperGain", Napi::Function::New(env, TaperGain));
+
     return exports;
 }
 
@@ -0,0 +1,458 @@
+// PC Panel Pro - streaming recorder for one mix bus
+// Shared by the addon and the Linux tools; POSIX file I/O, no other
+// platform dependencies.
+//
+// The output callback hands each rendered buffer to push(), which only
+// copies it into a ring sized for a few seconds of audio. A writer thread
+// drains the ring into the file in large blocks from an aligned staging
+// buffer. The header is padded so the audio starts 4 KiB into the file and
+// every full block lands on an aligned offset, and file space is reserved
+// ahead of the writes in big steps. If the disk falls behind for longer than
+// the ring lasts, the frames that don't fit are dropped and counted.
+//
+// Formats are Float32 WAV (limited to 4 GiB of audio) and CAF (no limit;
+// its data size reads as "unknown" until stop(), so a take cut short by a
+// crash still opens).
+
+#pragma once
+
+#include "callback_timing.h"
+#include "ring_buffer.h"
+#include "ring_stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+class BusRecorder {
+public:
+    enum class Format { Wav, Caf };
+
+    static constexpr size_t kChannels = 2;                     // Interleaved stereo Float32, like the bus
+    static constexpr size_t kBytesPerFrame = kChannels * sizeof(float);
+    static constexpr double kRingSeconds = 4.0;                // Disk stalls this long lose nothing
+    static constexpr size_t kBlockBytes = 256 * 1024;          // One pwrite() per block
+    static constexpr size_t kAlignment = 4096;                 // Staging buffer and audio data offset
+    static constexpr off_t kPreallocateBytes = 32 << 20;       // File space reserved per step
+    static constexpr int kPollMs = 20;                         // Writer wake-up interval
+
+    struct Stats {
+        bool recording;
+        uint64_t framesWritten;         // On disk
+        uint64_t droppedFrames;         // Didn't fit in the ring, or lost to a write error
+        uint64_t bytesWritten;          // Audio bytes
+        double seconds;                 // Since start(), or the whole recording once stopped
+        double writeSeconds;            // Spent inside pwrite() calls
+        uint64_t maxWriteNs;            // Slowest single pwrite()
+        uint64_t backlogMaxFrames;      // Most the ring held when the writer drained it
+        uint64_t ringCapacityFrames;
+    };
+
+    BusRecorder() = default;
+    ~BusRecorder() { stop(); }
+    BusRecorder(const BusRecorder&) = delete;
+    BusRecorder& operator=(const BusRecorder&) = delete;
+
+    static bool parseFormat(const std::string& name, Format& format) {
+        if (name == "wav") {
+            format = Format::Wav;
+        } else if (name == "caf") {
+            format = Format::Caf;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // ---- File helpers, shared with StemRecorder ----
+
+    // WAV sizes are 32-bit
+    static constexpr uint64_t kMaxWavDataBytes = 0xFFFFFFFFull - kAlignment;
+
+    static void putLE(uint8_t* p, uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++) {
+            p[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+
+    static void putBE(uint8_t* p, uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++) {
+            p[i] = static_cast<uint8_t>(value >> (8 * (bytes - 1 - i)));
+        }
+    }
+
+    // The kAlignment bytes before the audio of a Float32 file with this
+    // many interleaved channels. Until final, WAV sizes read 0 and the CAF
+    // data size -1 (unknown, allowed for the last chunk).
+    static void buildHeader(uint8_t* header, Format format, double sampleRate, size_t channels,
+                            uint64_t dataBytes, bool final) {
+        memset(header, 0, kAlignment);
+        size_t bytesPerFrame = channels * sizeof(float);
+        uint32_t rate = static_cast<uint32_t>(sampleRate);
+        if (format == Format::Wav) {
+            // RIFF, fmt (IEEE float), fact, JUNK padding, data
+            memcpy(header, "RIFF", 4);
+            putLE(header + 4, kAlignment - 8 + dataBytes, 4);
+            memcpy(header + 8, "WAVE", 4);
+            memcpy(header + 12, "fmt ", 4);
+            putLE(header + 16, 16, 4);
+            putLE(header + 20, 3, 2);                               // WAVE_FORMAT_IEEE_FLOAT
+            putLE(header + 22, channels, 2);
+            putLE(header + 24, rate, 4);
+            putLE(header + 28, rate * bytesPerFrame, 4);
+            putLE(header + 32, bytesPerFrame, 2);
+            putLE(header + 34, 32, 2);
+            memcpy(header + 36, "fact", 4);
+            putLE(header + 40, 4, 4);
+            putLE(header + 44, dataBytes / bytesPerFrame, 4);
+            memcpy(header + 48, "JUNK", 4);
+            putLE(header + 52, kAlignment - 8 - 56, 4);
+            memcpy(header + kAlignment - 8, "data", 4);
+            putLE(header + kAlignment - 4, dataBytes, 4);
+        } else {
+            // caff file header, desc (LE float LPCM), free padding, data
+            memcpy(header, "caff", 4);
+            putBE(header + 4, 1, 2);
+            memcpy(header + 8, "desc", 4);
+            putBE(header + 12, 32, 8);
+            double rateValue = sampleRate;
+            uint64_t rateBits;
+            memcpy(&rateBits, &rateValue, sizeof(rateBits));
+            putBE(header + 20, rateBits, 8);
+            memcpy(header + 28, "lpcm", 4);
+            putBE(header + 32, 1 | 2, 4);                           // Float, little-endian
+            putBE(header + 36, bytesPerFrame, 4);
+            putBE(header + 40, 1, 4);
+            putBE(header + 44, channels, 4);
+            putBE(header + 48, 32, 4);
+            memcpy(header + 52, "free", 4);
+            putBE(header + 56, kAlignment - 16 - 64, 8);
+            // data chunk: header, then a 4-byte edit count before the audio
+            memcpy(header + kAlignment - 16, "data", 4);
+            putBE(header + kAlignment - 12, final ? dataBytes + 4 : UINT64_MAX, 8);
+        }
+    }
+
+    // Best effort: a filesystem that can't reserve space just grows as written
+    static void preallocate(int fd, off_t offset, off_t length) {
+#if defined(__APPLE__)
+        (void)offset;
+        fstore_t store = {F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, length, 0};
+        if (fcntl(fd, F_PREALLOCATE, &store) != 0) {
+            store.fst_flags = F_ALLOCATEALL;
+            fcntl(fd, F_PREALLOCATE, &store);
+        }
+#elif defined(__linux__)
+        fallocate(fd, FALLOC_FL_KEEP_SIZE, offset, length);
+#else
+        (void)offset;
+        (void)length;
+#endif
+    }
+
+    // ---- Render thread ----
+
+    // Queue one rendered buffer; drops what doesn't fit
+    void push(const float* samples, size_t frames) {
+        if (!active_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        // stop() waits for pushing_ to clear after turning active_ off, so
+        // the ring is never torn down under this write
+        pushing_.store(true, std::memory_order_seq_cst);
+        if (active_.load(std::memory_order_seq_cst)) {
+            ring_->write(samples, frames * kBytesPerFrame);
+        }
+        pushing_.store(false, std::memory_order_release);
+    }
+
+    // ---- Control thread ----
+
+    // Creates path and starts the writer; fails if already recording
+    bool start(const std::string& path, Format format, double sampleRate, std::string& error) {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        if (writer_.joinable()) {
+            error = "already recording to " + path_;
+            return false;
+        }
+
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            error = "can't create " + path + ": " + strerror(errno);
+            return false;
+        }
+        if (!staging_) {
+            void* memory = nullptr;
+            if (posix_memalign(&memory, kAlignment, kBlockBytes) != 0) {
+                ::close(fd);
+                error = "out of memory";
+                return false;
+            }
+            staging_.reset(static_cast<uint8_t*>(memory));
+        }
+
+        // Neither side is running, so the ring and counters can be replaced
+        size_t ringFrames = static_cast<size_t>(sampleRate * kRingSeconds);
+        ringStats_ = std::make_unique<RingStats>();
+        ring_ = std::make_unique<RingBuffer>(ringFrames, kChannels, kBytesPerFrame, ringStats_.get());
+        capacityFrames_.store(ringStats_->read().capacityFrames, std::memory_order_relaxed);
+
+        fd_ = fd;
+        format_ = format;
+        sampleRate_ = sampleRate;
+        path_ = path;
+        {
+            std::lock_guard<std::mutex> status(statusMutex_);
+            writeError_.clear();
+        }
+        framesWritten_.store(0, std::memory_order_relaxed);
+        writeErrorFrames_.store(0, std::memory_order_relaxed);
+        ringDropped_.store(0, std::memory_order_relaxed);
+        writeNs_.store(0, std::memory_order_relaxed);
+        maxWriteNs_.store(0, std::memory_order_relaxed);
+        backlogMaxFrames_.store(0, std::memory_order_relaxed);
+        preallocatedEnd_ = 0;
+        dataEnd_ = kAlignment;
+        failed_ = false;
+        startNs_.store(CallbackTiming::now(), std::memory_order_relaxed);
+        stopNs_.store(0, std::memory_order_relaxed);
+
+        if (!writeHeader(false)) {
+            ::close(fd_);
+            fd_ = -1;
+            error = "can't write " + path + ": " + strerror(errno);
+            return false;
+        }
+
+        stopRequested_ = false;
+        writer_ = std::thread([this] { run(); });
+        active_.store(true, std::memory_order_seq_cst);
+        return true;
+    }
+
+    // Flushes what's queued, finalizes the header and closes the file.
+    // Returns false with the reason if any write failed.
+    bool stop(std::string* error = nullptr) {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        if (!writer_.joinable()) {
+            return true;
+        }
+        active_.store(false, std::memory_order_seq_cst);
+        while (pushing_.load(std::memory_order_seq_cst)) {
+            std::this_thread::yield();
+        }
+        {
+            std::lock_guard<std::mutex> wake(wakeMutex_);
+            stopRequested_ = true;
+        }
+        wakeCondition_.notify_one();
+        writer_.join();
+        stopNs_.store(CallbackTiming::now(), std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> status(statusMutex_);
+        if (!writeError_.empty() && error) {
+            *error = writeError_;
+        }
+        return writeError_.empty();
+    }
+
+    bool isRecording() const { return active_.load(std::memory_order_relaxed); }
+
+    // The current recording, or the last one once stopped
+    std::string path() const {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        return path_;
+    }
+
+    // Any thread
+    Stats stats() const {
+        Stats stats = {};
+        stats.recording = active_.load(std::memory_order_relaxed);
+        uint64_t start = startNs_.load(std::memory_order_relaxed);
+        uint64_t stop = stopNs_.load(std::memory_order_relaxed);
+        if (start == 0) {
+            return stats;
+        }
+        stats.framesWritten = framesWritten_.load(std::memory_order_relaxed);
+        stats.bytesWritten = stats.framesWritten * kBytesPerFrame;
+        stats.seconds = ((stop != 0 ? stop : CallbackTiming::now()) - start) / 1e9;
+        stats.writeSeconds = writeNs_.load(std::memory_order_relaxed) / 1e9;
+        stats.maxWriteNs = maxWriteNs_.load(std::memory_order_relaxed);
+        stats.backlogMaxFrames = backlogMaxFrames_.load(std::memory_order_relaxed);
+        stats.ringCapacityFrames = capacityFrames_.load(std::memory_order_relaxed);
+        stats.droppedFrames = writeErrorFrames_.load(std::memory_order_relaxed) + ringDropped_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    std::string error() const {
+        std::lock_guard<std::mutex> lock(statusMutex_);
+        return writeError_;
+    }
+
+private:
+    // ---- Writer thread ----
+
+    void run() {
+        for (;;) {
+            bool stopping;
+            {
+                std::unique_lock<std::mutex> wake(wakeMutex_);
+                wakeCondition_.wait_for(wake, std::chrono::milliseconds(kPollMs), [this] { return stopRequested_; });
+                stopping = stopRequested_;
+            }
+            // Only whole blocks while running; the remainder once stopping
+            drain(stopping);
+            if (stopping) {
+                break;
+            }
+        }
+        finish();
+    }
+
+    void drain(bool all) {
+        // read() below acquires the writer's position, so a relaxed count is enough
+        size_t available = ring_->getAvailable();
+        uint64_t backlog = available / kBytesPerFrame;
+        if (backlog > backlogMaxFrames_.load(std::memory_order_relaxed)) {
+            backlogMaxFrames_.store(backlog, std::memory_order_relaxed);
+        }
+        ringDropped_.store(ringStats_->read().droppedFrames, std::memory_order_relaxed);
+
+        while (available >= kBlockBytes || (all && available > 0)) {
+            size_t bytes = std::min(available, kBlockBytes);
+            bytes -= bytes % kBytesPerFrame;
+            ring_->read(staging_.get(), bytes);
+            available -= bytes;
+            writeBlock(bytes);
+        }
+    }
+
+    void writeBlock(size_t bytes) {
+        uint64_t frames = bytes / kBytesPerFrame;
+        if (failed_ || (format_ == Format::Wav && dataEnd_ - kAlignment + bytes > kMaxWavDataBytes)) {
+            if (!failed_) {
+                setError("WAV size limit reached; record to CAF for longer takes");
+                failed_ = true;
+            }
+            writeErrorFrames_.store(writeErrorFrames_.load(std::memory_order_relaxed) + frames,
+                                    std::memory_order_relaxed);
+            return;
+        }
+
+        if (dataEnd_ + static_cast<off_t>(bytes) > preallocatedEnd_) {
+            preallocate(fd_, dataEnd_, kPreallocateBytes);
+            preallocatedEnd_ = dataEnd_ + kPreallocateBytes;
+        }
+
+        uint64_t start = CallbackTiming::now();
+        bool ok = writeAll(staging_.get(), bytes, dataEnd_);
+        uint64_t elapsed = CallbackTiming::now() - start;
+        writeNs_.store(writeNs_.load(std::memory_order_relaxed) + elapsed, std::memory_order_relaxed);
+        if (elapsed > maxWriteNs_.load(std::memory_order_relaxed)) {
+            maxWriteNs_.store(elapsed, std::memory_order_relaxed);
+        }
+
+        if (!ok) {
+            setError(std::string("write failed: ") + strerror(errno));
+            failed_ = true;
+            writeErrorFrames_.store(writeErrorFrames_.load(std::memory_order_relaxed) + frames,
+                                    std::memory_order_relaxed);
+            return;
+        }
+        dataEnd_ += static_cast<off_t>(bytes);
+        framesWritten_.store(framesWritten_.load(std::memory_order_relaxed) + frames, std::memory_order_relaxed);
+    }
+
+    // Final sizes into the header, give back the unused reservation, close
+    void finish() {
+        ringDropped_.store(ringStats_->read().droppedFrames, std::memory_order_relaxed);
+        if (!writeHeader(true) || ftruncate(fd_, dataEnd_) != 0) {
+            setError(std::string("can't finalize file: ") + strerror(errno));
+        }
+        if (::close(fd_) != 0) {
+            setError(std::string("close failed: ") + strerror(errno));
+        }
+        fd_ = -1;
+    }
+
+    bool writeAll(const uint8_t* data, size_t bytes, off_t offset) {
+        while (bytes > 0) {
+            ssize_t written = pwrite(fd_, data, bytes, offset);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data += written;
+            bytes -= static_cast<size_t>(written);
+            offset += written;
+        }
+        return true;
+    }
+
+    void setError(const std::string& message) {
+        std::lock_guard<std::mutex> lock(statusMutex_);
+        if (writeError_.empty()) {
+            writeError_ = message;
+        }
+    }
+
+    bool writeHeader(bool final) {
+        uint64_t dataBytes = final ? static_cast<uint64_t>(dataEnd_ - kAlignment) : 0;
+        uint8_t header[kAlignment];
+        buildHeader(header, format_, sampleRate_, kChannels, dataBytes, final);
+        return pwrite(fd_, header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+    }
+
+    struct FreeDeleter {
+        void operator()(uint8_t* p) const { free(p); }
+    };
+
+    // Render thread and control thread
+    std::atomic<bool> active_{false};
+    std::atomic<bool> pushing_{false};
+    std::unique_ptr<RingBuffer> ring_;
+    std::unique_ptr<RingStats> ringStats_;
+
+    // Writer thread, set up by start()
+    int fd_ = -1;
+    Format format_ = Format::Wav;
+    double sampleRate_ = 48000.0;
+    std::unique_ptr<uint8_t, FreeDeleter> staging_;
+    off_t dataEnd_ = 0;
+    off_t preallocatedEnd_ = 0;
+    bool failed_ = false;
+
+    // Published by the writer for stats()
+    std::atomic<uint64_t> framesWritten_{0};
+    std::atomic<uint64_t> writeErrorFrames_{0};
+    std::atomic<uint64_t> ringDropped_{0};
+    std::atomic<uint64_t> writeNs_{0};
+    std::atomic<uint64_t> maxWriteNs_{0};
+    std::atomic<uint64_t> backlogMaxFrames_{0};
+    std::atomic<uint64_t> startNs_{0};
+    std::atomic<uint64_t> stopNs_{0};
+    std::atomic<uint64_t> capacityFrames_{0};
+
+    std::thread writer_;
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCondition_;
+    bool stopRequested_ = false;
+
+    mutable std::mutex controlMutex_;       // start/stop and path_
+    mutable std::mutex statusMutex_;        // writeError_
+    std::string path_;
+    std::string writeError_;
+};
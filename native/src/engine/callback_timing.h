@@ -0,0 +1,189 @@
+// PC Panel Pro - audio callback execution-time histograms
+// Shared by the addon, the driver and the Linux tools; no platform
+// dependencies beyond the monotonic clock.
+//
+// One CallbackTiming per callback. The callback's own thread is the only
+// writer, so recording is a handful of relaxed loads and stores - no locks,
+// no read-modify-write. Any thread may take a snapshot or request a reset.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <time.h>
+
+class CallbackTiming {
+public:
+    // Log-spaced buckets: four per octave from 64 ns to ~1 s, plus one each
+    // for anything faster or slower
+    static constexpr int kBucketsPerOctave = 4;
+    static constexpr int kMinOctave = 6;
+    static constexpr int kMaxOctave = 30;
+    static constexpr size_t kBucketCount = (kMaxOctave - kMinOctave) * kBucketsPerOctave + 2;
+
+    struct Snapshot {
+        uint64_t count;
+        uint64_t deadlineMisses;        // Callbacks that took longer than their buffer period
+        uint64_t minNs;
+        uint64_t maxNs;
+        uint64_t meanNs;
+        uint64_t p50Ns;                 // Bucket upper bounds, clamped to [min, max]
+        uint64_t p99Ns;
+        uint64_t periodNs;              // Buffer period of the latest callback
+        uint64_t buckets[kBucketCount];
+    };
+
+    // Monotonic nanoseconds; vDSO / commpage reads, no syscall
+    static uint64_t now() {
+#ifdef __APPLE__
+        return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+#else
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+#endif
+    }
+
+    static uint64_t periodNs(size_t frames, double sampleRate) {
+        return sampleRate > 0 ? static_cast<uint64_t>(frames * 1e9 / sampleRate) : 0;
+    }
+
+    static size_t bucketIndex(uint64_t ns) {
+        if (ns < (1ull << kMinOctave)) {
+            return 0;
+        }
+        int octave = 63 - __builtin_clzll(ns);
+        if (octave >= kMaxOctave) {
+            return kBucketCount - 1;
+        }
+        // The two bits after the leading one pick the quarter-octave
+        size_t quarter = static_cast<size_t>(ns >> (octave - 2)) & 3;
+        return 1 + static_cast<size_t>(octave - kMinOctave) * kBucketsPerOctave + quarter;
+    }
+
+    // Exclusive upper bound of a bucket in ns (UINT64_MAX for the last)
+    static uint64_t bucketLimit(size_t index) {
+        if (index == 0) {
+            return 1ull << kMinOctave;
+        }
+        if (index >= kBucketCount - 1) {
+            return UINT64_MAX;
+        }
+        size_t octave = kMinOctave + (index - 1) / kBucketsPerOctave;
+        size_t quarter = (index - 1) % kBucketsPerOctave;
+        return (1ull << octave) + (quarter + 1) * (1ull << (octave - 2));
+    }
+
+    // ---- Callback thread ----
+
+    void record(uint64_t durationNs, uint64_t periodNs) {
+        if (resetRequested_.load(std::memory_order_relaxed)
+            && resetRequested_.exchange(false, std::memory_order_acquire)) {
+            clear();
+        }
+
+        size_t index = bucketIndex(durationNs);
+        bump(buckets_[index]);
+        sumNs_.store(sumNs_.load(std::memory_order_relaxed) + durationNs, std::memory_order_relaxed);
+        if (durationNs < minNs_.load(std::memory_order_relaxed)) {
+            minNs_.store(durationNs, std::memory_order_relaxed);
+        }
+        if (durationNs > maxNs_.load(std::memory_order_relaxed)) {
+            maxNs_.store(durationNs, std::memory_order_relaxed);
+        }
+        periodNs_.store(periodNs, std::memory_order_relaxed);
+        if (periodNs > 0 && durationNs > periodNs) {
+            bump(deadlineMisses_);
+        }
+    }
+
+    // Times the enclosing block; call setPeriod once the buffer size is known
+    class Scope {
+    public:
+        explicit Scope(CallbackTiming& timing) : timing_(timing), start_(now()), periodNs_(0) {}
+        ~Scope() { timing_.record(now() - start_, periodNs_); }
+
+        void setPeriod(size_t frames, double sampleRate) {
+            periodNs_ = periodNs(frames, sampleRate);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        CallbackTiming& timing_;
+        uint64_t start_;
+        uint64_t periodNs_;
+    };
+
+    // ---- Any thread ----
+
+    // Applied by the next record(); a pending reset reads as empty
+    void reset() {
+        resetRequested_.store(true, std::memory_order_release);
+    }
+
+    Snapshot snapshot() const {
+        Snapshot snap = {};
+        if (resetRequested_.load(std::memory_order_acquire)) {
+            return snap;
+        }
+
+        uint64_t total = 0;
+        for (size_t i = 0; i < kBucketCount; i++) {
+            snap.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+            total += snap.buckets[i];
+        }
+        snap.count = total;
+        snap.deadlineMisses = deadlineMisses_.load(std::memory_order_relaxed);
+        snap.minNs = total > 0 ? minNs_.load(std::memory_order_relaxed) : 0;
+        snap.maxNs = maxNs_.load(std::memory_order_relaxed);
+        snap.meanNs = total > 0 ? sumNs_.load(std::memory_order_relaxed) / total : 0;
+        snap.periodNs = periodNs_.load(std::memory_order_relaxed);
+        snap.p50Ns = percentile(snap, 0.50);
+        snap.p99Ns = percentile(snap, 0.99);
+        return snap;
+    }
+
+private:
+    static void bump(std::atomic<uint64_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    static uint64_t percentile(const Snapshot& snap, double fraction) {
+        if (snap.count == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(snap.count - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBucketCount; i++) {
+            seen += snap.buckets[i];
+            if (seen >= rank) {
+                uint64_t limit = bucketLimit(i);
+                if (limit > snap.maxNs) return snap.maxNs;
+                if (limit < snap.minNs) return snap.minNs;
+                return limit;
+            }
+        }
+        return snap.maxNs;
+    }
+
+    void clear() {
+        for (auto& bucket : buckets_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        sumNs_.store(0, std::memory_order_relaxed);
+        minNs_.store(UINT64_MAX, std::memory_order_relaxed);
+        maxNs_.store(0, std::memory_order_relaxed);
+        deadlineMisses_.store(0, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> buckets_[kBucketCount] = {};
+    std::atomic<uint64_t> sumNs_{0};
+    std::atomic<uint64_t> minNs_{UINT64_MAX};
+    std::atomic<uint64_t> maxNs_{0};
+    std::atomic<uint64_t> deadlineMisses_{0};
+    std::atomic<uint64_t> periodNs_{0};
+    std::atomic<bool> resetRequested_{false};
+};
@@ -0,0 +1,167 @@
+// PC Panel Pro - per-input compressor/limiter
+// Feed-forward dynamics for one mixer input, applied in place before the
+// input is mixed. Shared by the addon and the Linux tools; no platform
+// dependencies. Level is detected per block of kCompressorBlock frames
+// (blockPeak / blockMeanSquare), the gain computer and smoothing run in the
+// log domain on fastLog2 / fastExp2, and each block ramps from the previous
+// block's gain to its own. A buffer is processed in passes over up to
+// kCompressorGroup blocks so that everything but the one-pole smoother runs
+// as independent, vectorizable loops instead of one long dependency chain.
+
+#pragma once
+
+#include "mix_kernels.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum class CompressorDetector : uint8_t { Peak, Rms };
+
+struct CompressorSettings {
+    bool enabled = false;
+    CompressorDetector detector = CompressorDetector::Peak;
+    float thresholdDb = -18.0f;
+    float ratio = 3.0f;             // kCompressorMaxRatio with peak detection limits
+    float kneeDb = 6.0f;            // Soft-knee width centred on the threshold
+    float attackMs = 5.0f;
+    float releaseMs = 120.0f;
+    float makeupDb = 0.0f;
+};
+
+constexpr size_t kCompressorBlock = 32;             // 0.67 ms at 48 kHz, 0.33 ms at 96 kHz
+constexpr size_t kCompressorGroup = 32;             // Blocks per pass; 1024 frames
+constexpr float kCompressorMaxRatio = 100.0f;
+constexpr float kCompressorMaxTimeMs = 5000.0f;
+
+inline CompressorSettings clampCompressorSettings(CompressorSettings settings) {
+    settings.thresholdDb = std::max(-60.0f, std::min(0.0f, settings.thresholdDb));
+    settings.ratio = std::max(1.0f, std::min(kCompressorMaxRatio, settings.ratio));
+    settings.kneeDb = std::max(0.0f, std::min(24.0f, settings.kneeDb));
+    settings.attackMs = std::max(0.0f, std::min(kCompressorMaxTimeMs, settings.attackMs));
+    settings.releaseMs = std::max(0.0f, std::min(kCompressorMaxTimeMs, settings.releaseMs));
+    settings.makeupDb = std::max(0.0f, std::min(24.0f, settings.makeupDb));
+    return settings;
+}
+
+// 'peak' | 'rms'; unknown names fall back to peak
+inline CompressorDetector compressorDetectorFromName(const std::string& name) {
+    return name == "rms" ? CompressorDetector::Rms : CompressorDetector::Peak;
+}
+
+class Compressor {
+public:
+    static constexpr float kDbPerLog2 = 6.0205999f;     // 20 * log10(2)
+
+    // Coefficients for settings at sampleRate. The envelope is kept, so a
+    // settings change mid-stream doesn't click.
+    void configure(const CompressorSettings& settings, double sampleRate) {
+        rms_ = settings.detector == CompressorDetector::Rms;
+        thresholdDb_ = settings.thresholdDb;
+        slope_ = 1.0f - 1.0f / std::max(1.0f, settings.ratio);
+        halfKneeDb_ = 0.5f * settings.kneeDb;
+        kneeScale_ = settings.kneeDb > 0.0f ? slope_ / (2.0f * settings.kneeDb) : 0.0f;
+        makeupLog2_ = settings.makeupDb / kDbPerLog2;
+        // One-pole coefficient over n frames is 2^(n * perFrame)
+        attackLog2PerFrame_ = timeToLog2PerFrame(settings.attackMs, sampleRate);
+        releaseLog2PerFrame_ = timeToLog2PerFrame(settings.releaseMs, sampleRate);
+        attackCoeff_ = fastExp2(attackLog2PerFrame_ * kCompressorBlock);
+        releaseCoeff_ = fastExp2(releaseLog2PerFrame_ * kCompressorBlock);
+    }
+
+    // Back to no reduction, e.g. when the compressor is switched on again
+    void reset() {
+        reductionDb_ = 0.0f;
+        gain_ = fastExp2(makeupLog2_);
+    }
+
+    // In place over interleaved frames
+    void process(float* samples, size_t frames, size_t channels) {
+        const size_t groupFrames = kCompressorBlock * kCompressorGroup;
+        for (size_t offset = 0; offset < frames; offset += groupFrames) {
+            processGroup(samples + offset * channels, std::min(groupFrames, frames - offset), channels);
+        }
+    }
+
+    float reductionDb() const { return reductionDb_; }
+
+private:
+    void processGroup(float* samples, size_t frames, size_t channels) {
+        float level[kCompressorGroup];
+        float gain[kCompressorGroup];
+        size_t blocks = (frames + kCompressorBlock - 1) / kCompressorBlock;
+        size_t lastFrames = frames - (blocks - 1) * kCompressorBlock;
+
+        // Detect: mean square or peak of each block
+        for (size_t b = 0; b < blocks; b++) {
+            size_t count = (b + 1 < blocks ? kCompressorBlock : lastFrames) * channels;
+            const float* block = samples + b * kCompressorBlock * channels;
+            level[b] = rms_ ? blockMeanSquare(block, count) : blockPeak(block, count);
+        }
+
+        // Static curve in dB; the RMS path never takes the square root
+        float scale = rms_ ? 0.5f * kDbPerLog2 : kDbPerLog2;
+        for (size_t b = 0; b < blocks; b++) {
+            level[b] = gainComputer(fastLog2(level[b] + 1e-30f) * scale);
+        }
+
+        // Attack/release smoothing: the only serial part
+        float reduction = reductionDb_;
+        for (size_t b = 0; b < blocks; b++) {
+            float target = level[b];
+            float coeff = target > reduction ? attackCoeff_ : releaseCoeff_;
+            if (b + 1 == blocks && lastFrames != kCompressorBlock) {
+                float perFrame = target > reduction ? attackLog2PerFrame_ : releaseLog2PerFrame_;
+                coeff = fastExp2(perFrame * static_cast<float>(lastFrames));
+            }
+            reduction = target + (reduction - target) * coeff;
+            gain[b] = makeupLog2_ - reduction * (1.0f / kDbPerLog2);
+        }
+        reductionDb_ = reduction;
+
+        for (size_t b = 0; b < blocks; b++) {
+            gain[b] = fastExp2(gain[b]);
+        }
+
+        // Ramp each block from the previous block's gain to its own
+        float previous = gain_;
+        for (size_t b = 0; b < blocks; b++) {
+            size_t blockFrames = b + 1 < blocks ? kCompressorBlock : lastFrames;
+            applyGainRamp(samples + b * kCompressorBlock * channels, blockFrames, channels, previous,
+                          (gain[b] - previous) / static_cast<float>(blockFrames));
+            previous = gain[b];
+        }
+        gain_ = previous;
+    }
+
+    static float timeToLog2PerFrame(float timeMs, double sampleRate) {
+        double frames = timeMs * 0.001 * sampleRate;
+        // Zero time: a coefficient of 2^-126, i.e. no smoothing at all
+        return frames > 0.0 ? static_cast<float>(-1.4426950408889634 / frames) : -126.0f;
+    }
+
+    // Static curve: reduction in dB (>= 0) for an input level, with a
+    // quadratic soft knee around the threshold. Selects, not branches, so
+    // the pass over a group vectorizes.
+    float gainComputer(float levelDb) const {
+        float over = levelDb - thresholdDb_;
+        float into = over + halfKneeDb_;
+        into = into > 0.0f ? into : 0.0f;
+        float knee = kneeScale_ * into * into;
+        return over >= halfKneeDb_ ? slope_ * over : knee;
+    }
+
+    bool rms_ = false;
+    float thresholdDb_ = -18.0f;
+    float slope_ = 0.0f;                    // 1 - 1 / ratio
+    float halfKneeDb_ = 0.0f;
+    float kneeScale_ = 0.0f;                // slope / (2 * knee); 0 for a hard knee
+    float makeupLog2_ = 0.0f;
+    float attackLog2PerFrame_ = -126.0f;
+    float releaseLog2PerFrame_ = -126.0f;
+    float attackCoeff_ = 0.0f;              // Per full block
+    float releaseCoeff_ = 0.0f;
+    float reductionDb_ = 0.0f;              // Smoothed, >= 0
+    float gain_ = 1.0f;                     // Linear gain reached at the end of the last block
+};
@@ -0,0 +1,81 @@
+// PC Panel Pro - analog control -> mixer input gain mapping
+// Written from the JS thread, read per report on the HID thread. Also the one
+// owner of the channels' custom taper tables, which UI-driven gains read too.
+
+#pragma once
+
+#include "hid_report.h"
+#include "taper.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class HidGainMap {
+public:
+    static constexpr uint32_t kNoDevice = 0;   // Same as DeviceRegistry::kInvalidDeviceHandle
+
+    // What one analog control drives
+    struct GainMapping {
+        uint32_t deviceHandle = kNoDevice;
+        TaperCurve curve = TaperCurve::Linear;  // Custom reads the device's setCustomTaper() table
+    };
+
+    HidGainMap() {
+        for (auto& mapping : mapping_) {
+            mapping.store(kNoDevice, std::memory_order_relaxed);
+        }
+    }
+
+    // Control index -> mixer input device handle (kNoDevice = not applied
+    // natively) and taper. Handle and curve are packed into one atomic so the
+    // reader thread sees them change together.
+    void set(const std::vector<GainMapping>& mappings) {
+        for (size_t i = 0; i < kHidAnalogCount; i++) {
+            GainMapping mapping = i < mappings.size() ? mappings[i] : GainMapping();
+            uint64_t packed = static_cast<uint64_t>(mapping.deviceHandle)
+                | (static_cast<uint64_t>(mapping.curve) << 32);
+            mapping_[i].store(packed, std::memory_order_release);
+        }
+    }
+
+    // The raw value indexes the control's taper table directly. Returns false
+    // when the control isn't mapped to an input.
+    bool lookup(size_t control, uint8_t value, uint32_t& deviceHandle, float& gain) {
+        uint64_t packed = mapping_[control].load(std::memory_order_acquire);
+        deviceHandle = static_cast<uint32_t>(packed);
+        if (deviceHandle == kNoDevice) {
+            return false;
+        }
+        TaperCurve curve = static_cast<TaperCurve>(packed >> 32);
+        gain = curve == TaperCurve::Custom ? customGain(deviceHandle, value) : taperTable(curve)[value];
+        return true;
+    }
+
+    // Builds a device's custom table once per curve change so lookups stay a
+    // table read; empty points drop it
+    void setCustomTaper(uint32_t deviceHandle, const std::vector<float>& points) {
+        if (points.empty()) {
+            std::lock_guard<std::mutex> lock(customMutex_);
+            customTapers_.erase(deviceHandle);
+            return;
+        }
+        TaperTable table = buildCustomTaper(points);
+        std::lock_guard<std::mutex> lock(customMutex_);
+        customTapers_[deviceHandle] = table;
+    }
+
+    // The device's custom table, or linear if it has none
+    float customGain(uint32_t deviceHandle, uint8_t value) {
+        std::lock_guard<std::mutex> lock(customMutex_);
+        auto it = customTapers_.find(deviceHandle);
+        return it != customTapers_.end() ? it->second[value] : kLinearTaper[value];
+    }
+
+private:
+    std::atomic<uint64_t> mapping_[kHidAnalogCount];
+    std::mutex customMutex_;                    // Guards customTapers_
+    std::unordered_map<uint32_t, TaperTable> customTapers_;    // By device handle
+};
@@ -0,0 +1,59 @@
+// PC Panel Pro - HID input report parsing
+// Shared by the addon's HID reader and the Linux replay tool.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Report layout (64 bytes, device -> host). Mirrors parseInputPacket in
+// src/main/hid/protocol.ts.
+constexpr uint8_t kHidCodeKnobChange = 0x01;
+constexpr uint8_t kHidCodeButtonChange = 0x02;
+constexpr uint8_t kHidCodeStateResponse = 0x03;
+constexpr uint8_t kHidCodeRequestState = 0x01;   // host -> device
+constexpr size_t kHidReportSize = 64;
+constexpr size_t kHidAnalogCount = 9;
+constexpr size_t kHidButtonCount = 5;
+
+struct HidReport {
+    enum class Type { KnobChange, ButtonChange, StateResponse };
+    Type type;
+    uint8_t index;
+    uint8_t value;
+    uint8_t analogValues[kHidAnalogCount];
+    bool buttonStates[kHidButtonCount];
+};
+
+inline bool parseHidReport(const uint8_t* data, size_t length, HidReport& report) {
+    if (length < 3) {
+        return false;
+    }
+
+    switch (data[0]) {
+        case kHidCodeKnobChange:
+            report.type = HidReport::Type::KnobChange;
+            report.index = data[1];
+            report.value = data[2];
+            return report.index < kHidAnalogCount;
+        case kHidCodeButtonChange:
+            report.type = HidReport::Type::ButtonChange;
+            report.index = data[1];
+            report.value = data[2] == 0x01 ? 1 : 0;
+            return report.index < kHidButtonCount;
+        case kHidCodeStateResponse:
+            if (length < 1 + kHidAnalogCount + kHidButtonCount) {
+                return false;
+            }
+            report.type = HidReport::Type::StateResponse;
+            for (size_t i = 0; i < kHidAnalogCount; i++) {
+                report.analogValues[i] = data[1 + i];
+            }
+            for (size_t i = 0; i < kHidButtonCount; i++) {
+                report.buttonStates[i] = data[1 + kHidAnalogCount + i] == 0x01;
+            }
+            return true;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,346 @@
+// PC Panel Pro - mixer render graph
+// The DSP half of AudioMixer with no device code in it: per-input capture
+// rings, sample rate conversion, metering, per-input compression, sidechain
+// ducking and the gain-ramped mix. The
+// addon calls it from CoreAudio IOProcs; the offline harness calls it from
+// a loop over WAV files. Callbacks are plain interleaved stereo Float32.
+
+#pragma once
+
+#include "callback_timing.h"
+#include "compressor.h"
+#include "mix_kernels.h"
+#include "mixer_params.h"
+#include "ring_buffer.h"
+#include "ring_stats.h"
+#include "rt_scope.h"
+#include "sample_rate_converter.h"
+#include "sidechain.h"
+#include "stem_recorder.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+class MixEngine {
+public:
+    static constexpr size_t kMaxInputs = MixerParams::kMaxInputs;
+    static constexpr size_t kChannels = 2;                // Stereo, interleaved
+    static constexpr double kRingSeconds = 10.0;          // Absorbs timing variations between callbacks
+    static constexpr size_t kMaxCycleFrames = 4096;       // Scratch size; longer buffers are mixed in chunks
+    static_assert(kMaxInputs <= StemRecorder::kMaxSlots, "StemRecorder must cover every slot");
+
+    // Capture side of one input slot
+    struct Input {
+        std::unique_ptr<RingBuffer> ringBuffer;
+        std::unique_ptr<SampleRateConverter> converter;  // Only when rates differ
+        bool converterPrimed = false;                     // Cushion built since the last underrun
+        std::vector<float> scratch;                       // One chunk read from the ring
+        double sampleRate = 48000.0;
+        MixerParams::Channel* params = nullptr;
+        std::atomic<int64_t> lastActivityTime{0};
+        std::atomic<float> peakLevel{0.0f};               // Peak level (0.0-1.0)
+        std::atomic<float> rmsLevel{0.0f};                // RMS level (0.0-1.0)
+        CallbackTiming timing;                            // Recorded by whatever drives write()
+        RingStats ringStats;                              // Kept across ring reallocations
+        int32_t traceId = trace::nextId();                // Tags this input's events in a trace
+        Compressor compressor;                            // Render side only
+        uint32_t compressorVersion = 0;                   // Channel settings it was configured from
+        bool compressing = false;                         // Configured at the current output rate
+        std::atomic<float> gainReductionDb{0.0f};         // Compressor reduction, for meters
+
+        bool isActive() const {
+            return ringBuffer && params->enabled.load(std::memory_order_relaxed);
+        }
+
+        // Input callback: queue one buffer for the render side and meter it
+        void write(const float* samples, size_t sampleCount) {
+            rtsan::Scope scope("MixEngine::Input::write");
+            trace::Scope traceScope("input write", traceId);
+
+            ringBuffer->write(samples, sampleCount * sizeof(float));
+
+            Levels levels = measureLevels(samples, sampleCount);
+
+            // Store levels (atomic, lock-free)
+            peakLevel.store(levels.peak, std::memory_order_relaxed);
+            rmsLevel.store(levels.rms, std::memory_order_relaxed);
+
+            // Update activity time if audio detected
+            if (levels.hasAudio) {
+                lastActivityTime.store(std::chrono::steady_clock::now().time_since_epoch().count());
+            }
+        }
+    };
+
+    MixEngine() : converted_(kMaxCycleFrames * kChannels), outputSampleRate_(48000.0) {
+        for (size_t i = 0; i < kMaxInputs; i++) {
+            inputs_[i].params = &params_.channel(static_cast<int>(i));
+            inputs_[i].ringStats.setTraceId(inputs_[i].traceId);
+        }
+    }
+
+    MixerParams& params() { return params_; }
+    Input& input(int slot) { return inputs_[slot]; }
+    const Input& input(int slot) const { return inputs_[slot]; }
+
+    double outputSampleRate() const { return outputSampleRate_; }
+
+    // Set while no render callback is running
+    void setOutputSampleRate(double sampleRate) {
+        outputSampleRate_ = sampleRate;
+        for (Input& in : inputs_) {
+            in.compressing = false;  // Time constants are in frames
+        }
+        trace::instant("output rate", sampleRate);
+    }
+
+    // Inputs are tapped into stems while it records. Set before the first
+    // render callback.
+    void setStemRecorder(StemRecorder* stems) {
+        stems_ = stems;
+    }
+
+    // Allocate a slot's ring and converter before its input callback starts.
+    // Touches only this slot, so different slots can be prepared concurrently.
+    void prepareInput(int slot, double inputSampleRate, double ringSeconds = kRingSeconds) {
+        Input& in = inputs_[slot];
+        in.sampleRate = inputSampleRate;
+        trace::instant("src ratio", inputSampleRate / outputSampleRate_, in.traceId);
+        if (inputSampleRate != outputSampleRate_) {
+            in.converter = std::make_unique<SampleRateConverter>(inputSampleRate, outputSampleRate_, kChannels);
+            in.converterPrimed = false;
+        } else {
+            in.converter.reset();  // No conversion needed
+        }
+        // Allocated here so the render callback never has to
+        double ratio = inputSampleRate / outputSampleRate_;
+        size_t scratchFrames = in.converter ? static_cast<size_t>(kMaxCycleFrames * ratio) + 2 : kMaxCycleFrames;
+        in.scratch.assign(scratchFrames * kChannels, 0.0f);
+        in.ringBuffer = std::make_unique<RingBuffer>(
+            static_cast<size_t>(inputSampleRate * ringSeconds),
+            kChannels,
+            sizeof(float) * kChannels,
+            &in.ringStats
+        );
+    }
+
+    // After the slot's input callback has stopped
+    void releaseInput(int slot) {
+        inputs_[slot].ringBuffer.reset();
+    }
+
+    // ---- Render callback ----
+
+    // Cycle boundary: everything queued so far takes effect from sample 0
+    void beginCycle() {
+        rtsan::Scope scope("MixEngine::beginCycle");
+        size_t applied = 0;
+        params_.drain([&applied](const MixerParams::Command&) { applied++; });
+        if (applied > 0) {
+            trace::instant("commands drained", static_cast<double>(applied));
+        }
+    }
+
+    // Mix every enabled input into one output buffer, ramping each from last
+    // cycle's gain to its target, then apply master gain and clip. With a
+    // duck key set, the key is mixed first so its level this cycle sets the
+    // gain reduction ramped into the targets mixed after it.
+    void mix(float* outSamples, size_t outputFrameCount) {
+        rtsan::Scope scope("MixEngine::mix");
+        trace::Scope traceScope("mix");
+
+        size_t outputSampleCount = outputFrameCount * kChannels;
+        memset(outSamples, 0, outputSampleCount * sizeof(float));
+        if (stems_) {
+            stems_->beginCycle();
+        }
+
+        int duckKey = params_.duckKey();
+        float duckGain = 1.0f;
+        if (duckKey >= 0) {
+            float keyPeak = 0.0f;
+            if (inputs_[duckKey].isActive()) {
+                mixSlot(duckKey, outSamples, outputFrameCount, 1.0f, &keyPeak);
+            }
+            duckGain = ducker_.process(params_.duckSettings(), keyPeak, outputFrameCount, outputSampleRate_);
+        } else {
+            ducker_.reset();
+        }
+        duckReductionDb_.store(ducker_.reductionDb(), std::memory_order_relaxed);
+
+        for (size_t r = 0; r < params_.renderCount(); r++) {
+            int slot = params_.renderSlot(r);
+            if (slot == duckKey || !inputs_[slot].isActive()) {
+                continue;
+            }
+            mixSlot(slot, outSamples, outputFrameCount, inputs_[slot].params->duckTarget ? duckGain : 1.0f, nullptr);
+        }
+
+        if (stems_) {
+            stems_->endCycle(outputFrameCount);
+        }
+
+        // Apply master volume and clipping protection
+        float masterVol = params_.masterGain();
+        float masterStep = outputFrameCount > 0
+            ? (params_.masterTarget() - masterVol) / static_cast<float>(outputFrameCount) : 0.0f;
+        applyGainAndClip(outSamples, outputFrameCount, kChannels, masterVol, masterStep);
+    }
+
+    void endCycle() {
+        rtsan::Scope scope("MixEngine::endCycle");
+        params_.finishCycle();
+    }
+
+    // Current sidechain gain reduction in dB (>= 0); any thread
+    float duckReductionDb() const {
+        return duckReductionDb_.load(std::memory_order_relaxed);
+    }
+
+    // One whole cycle into a single buffer
+    void render(float* outSamples, size_t outputFrameCount) {
+        beginCycle();
+        mix(outSamples, outputFrameCount);
+        endCycle();
+    }
+
+private:
+    // One enabled input for the whole cycle. Its compressor, if on, runs
+    // first; its fader ramp is scaled by the duck gain ramp from last
+    // cycle's to duckEnd; keyPeak, if given, collects the input's pre-fader
+    // peak.
+    void mixSlot(int slot, float* outSamples, size_t outputFrameCount, float duckEnd, float* keyPeak) {
+        Input& in = inputs_[slot];
+        Compressor* compressor = nullptr;
+        if (in.params->compressor.enabled) {
+            compressor = prepareCompressor(in);
+        } else if (in.compressing) {
+            in.compressing = false;
+            in.gainReductionDb.store(0.0f, std::memory_order_relaxed);
+        }
+
+        float gain = in.params->renderGain * in.params->duckGain;
+        float gainStep = outputFrameCount > 0
+            ? (in.params->targetGain * duckEnd - gain) / static_cast<float>(outputFrameCount) : 0.0f;
+        in.params->duckGain = duckEnd;
+
+        // Scratch is sized for kMaxCycleFrames; bigger buffers go in pieces
+        for (size_t offset = 0; offset < outputFrameCount; offset += kMaxCycleFrames) {
+            size_t frames = std::min(kMaxCycleFrames, outputFrameCount - offset);
+            float chunkGain = gain + gainStep * static_cast<float>(offset);
+            if (!mixInput(slot, in, outSamples + offset * kChannels, offset, frames, chunkGain, gainStep,
+                          compressor, keyPeak)) {
+                break;  // Ring ran dry
+            }
+        }
+        if (compressor) {
+            in.gainReductionDb.store(compressor->reductionDb(), std::memory_order_relaxed);
+        }
+    }
+
+    // Reconfigure after a settings or rate change; a compressor switched
+    // back on starts from no reduction
+    Compressor* prepareCompressor(Input& in) {
+        if (!in.compressing || in.compressorVersion != in.params->compressorVersion) {
+            in.compressor.configure(in.params->compressor, outputSampleRate_);
+            if (!in.compressing) {
+                in.compressor.reset();
+            }
+            in.compressorVersion = in.params->compressorVersion;
+            in.compressing = true;
+        }
+        return &in.compressor;
+    }
+
+    // Add up to kMaxCycleFrames of one input into out, offset frames into the
+    // cycle; false if its ring was empty
+    bool mixInput(int slot, Input& in, float* out, size_t offset, size_t frames, float gain, float gainStep,
+                  Compressor* compressor, float* keyPeak) {
+        if (in.converter) {
+            // Sample rate conversion needed
+            // Exactly the input frames this cycle's output needs from the
+            // converter's current phase; the rest stay in the ring
+            size_t inputFramesNeeded = in.converter->inputFramesFor(frames);
+            size_t inputBytesNeeded = inputFramesNeeded * kChannels * sizeof(float);
+
+            // Input buffers arrive in chunks that don't line up with output
+            // cycles, so a converted input only starts (and restarts after an
+            // underrun) once the ring holds more than this cycle needs, i.e.
+            // one more input chunk. Without that cushion every cycle that
+            // straddles a chunk comes up a frame short and the input slips.
+            if (!in.converterPrimed) {
+                if (in.ringBuffer->getAvailable() <= inputBytesNeeded) {
+                    return false;
+                }
+                in.converterPrimed = true;
+            }
+
+            // Read input samples at the input sample rate
+            size_t bytesRead = in.ringBuffer->read(in.scratch.data(), inputBytesNeeded);
+            if (bytesRead < inputBytesNeeded) {
+                in.converterPrimed = false;
+            }
+            if (bytesRead == 0 && inputFramesNeeded > 0) {
+                return false;
+            }
+
+            size_t inputFramesRead = bytesRead / (kChannels * sizeof(float));
+
+            // Convert to output sample rate
+            size_t convertedFrames = in.converter->convert(
+                in.scratch.data(), inputFramesRead,
+                converted_.data(), frames
+            );
+
+            // Mix converted samples into output with gain
+            size_t mixed = std::min(convertedFrames, frames);
+            if (compressor) {
+                compressor->process(converted_.data(), mixed, kChannels);
+            }
+            if (keyPeak) {
+                *keyPeak = std::max(*keyPeak, measureLevels(converted_.data(), mixed * kChannels).peak);
+            }
+            mixAccumulate(out, converted_.data(), mixed, kChannels, gain, gainStep);
+            if (stems_) {
+                stems_->tap(slot, offset, converted_.data(), mixed, gain, gainStep);
+            }
+        } else {
+            // No sample rate conversion needed - direct read
+            size_t bytesRead = in.ringBuffer->read(in.scratch.data(), frames * kChannels * sizeof(float));
+            if (bytesRead == 0) {
+                return false;
+            }
+
+            size_t framesRead = bytesRead / (kChannels * sizeof(float));
+
+            // Mix into output with gain
+            if (compressor) {
+                compressor->process(in.scratch.data(), framesRead, kChannels);
+            }
+            if (keyPeak) {
+                *keyPeak = std::max(*keyPeak, measureLevels(in.scratch.data(), framesRead * kChannels).peak);
+            }
+            mixAccumulate(out, in.scratch.data(), framesRead, kChannels, gain, gainStep);
+            if (stems_) {
+                stems_->tap(slot, offset, in.scratch.data(), framesRead, gain, gainStep);
+            }
+        }
+        return true;
+    }
+
+    MixerParams params_;
+    Input inputs_[kMaxInputs];
+    std::vector<float> converted_;                        // One chunk of resampled input
+    StemRecorder* stems_ = nullptr;                       // Optional input taps
+    Ducker ducker_;                                       // Render side only
+    std::atomic<float> duckReductionDb_{0.0f};
+    double outputSampleRate_;
+};
@@ -0,0 +1,148 @@
+// PC Panel Pro - inner loops of the render callback
+// Shared by the addon and the Linux tools; no platform dependencies.
+// Kept as free functions so the benchmarks time exactly what MixEngine runs.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Signal levels of one buffer
+struct Levels {
+    float peak;         // 0.0-1.0
+    float rms;          // 0.0-1.0
+    bool hasAudio;      // Any sample above the activity threshold
+};
+
+constexpr float kActivityThreshold = 0.001f;
+
+// out += in * gain, with gain ramping linearly by gainStep per frame
+inline void mixAccumulate(float* out, const float* in, size_t frames, size_t channels,
+                          float gain, float gainStep) {
+    for (size_t frame = 0; frame < frames; frame++) {
+        float frameGain = gain + gainStep * static_cast<float>(frame);
+        for (size_t ch = 0; ch < channels; ch++) {
+            out[frame * channels + ch] += in[frame * channels + ch] * frameGain;
+        }
+    }
+}
+
+// samples *= gain (ramping per frame), then hard clip to [-1, 1]
+inline void applyGainAndClip(float* samples, size_t frames, size_t channels,
+                             float gain, float gainStep) {
+    for (size_t frame = 0; frame < frames; frame++) {
+        float frameGain = gain + gainStep * static_cast<float>(frame);
+        for (size_t ch = 0; ch < channels; ch++) {
+            float& sample = samples[frame * channels + ch];
+            sample *= frameGain;
+            if (sample > 1.0f) sample = 1.0f;
+            else if (sample < -1.0f) sample = -1.0f;
+        }
+    }
+}
+
+// Peak and RMS over all samples regardless of channel
+inline Levels measureLevels(const float* samples, size_t sampleCount) {
+    float peak = 0.0f;
+    float sumSquares = 0.0f;
+    bool hasAudio = false;
+
+    for (size_t i = 0; i < sampleCount; i++) {
+        float absVal = std::fabs(samples[i]);
+        if (absVal > peak) {
+            peak = absVal;
+        }
+        sumSquares += samples[i] * samples[i];
+        if (absVal > kActivityThreshold) {
+            hasAudio = true;
+        }
+    }
+
+    float rms = sampleCount > 0 ? std::sqrt(sumSquares / sampleCount) : 0.0f;
+    return {peak, rms, hasAudio};
+}
+
+// Detection kernels for the per-input compressor. Eight independent lanes
+// with no cross-lane dependency, so -O2/-O3 keeps them in vector registers
+// (SSE/AVX or NEON) without needing -ffast-math to reassociate.
+constexpr size_t kDetectLanes = 8;
+
+// Largest |sample| over count samples
+inline float blockPeak(const float* samples, size_t count) {
+    float lanes[kDetectLanes] = {};
+    size_t i = 0;
+    for (; i + kDetectLanes <= count; i += kDetectLanes) {
+        for (size_t lane = 0; lane < kDetectLanes; lane++) {
+            float value = std::fabs(samples[i + lane]);
+            lanes[lane] = lanes[lane] > value ? lanes[lane] : value;
+        }
+    }
+    float peak = 0.0f;
+    for (size_t lane = 0; lane < kDetectLanes; lane++) {
+        peak = peak > lanes[lane] ? peak : lanes[lane];
+    }
+    for (; i < count; i++) {
+        float value = std::fabs(samples[i]);
+        peak = peak > value ? peak : value;
+    }
+    return peak;
+}
+
+// Mean of sample^2 over count samples (RMS without the square root)
+inline float blockMeanSquare(const float* samples, size_t count) {
+    float lanes[kDetectLanes] = {};
+    size_t i = 0;
+    for (; i + kDetectLanes <= count; i += kDetectLanes) {
+        for (size_t lane = 0; lane < kDetectLanes; lane++) {
+            lanes[lane] += samples[i + lane] * samples[i + lane];
+        }
+    }
+    float sum = 0.0f;
+    for (size_t lane = 0; lane < kDetectLanes; lane++) {
+        sum += lanes[lane];
+    }
+    for (; i < count; i++) {
+        sum += samples[i] * samples[i];
+    }
+    return count > 0 ? sum / static_cast<float>(count) : 0.0f;
+}
+
+// samples *= gain, ramping per frame (no clip)
+inline void applyGainRamp(float* samples, size_t frames, size_t channels, float gain, float gainStep) {
+    for (size_t frame = 0; frame < frames; frame++) {
+        float frameGain = gain + gainStep * static_cast<float>(frame);
+        for (size_t ch = 0; ch < channels; ch++) {
+            samples[frame * channels + ch] *= frameGain;
+        }
+    }
+}
+
+// log2(x) for x > 0 to within 1e-4 (6e-4 dB): exponent bits plus a quartic
+// on the mantissa. Denormals and zero come out near -127.
+inline float fastLog2(float x) {
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    float exponent = static_cast<float>(static_cast<int>((bits >> 23) & 0xFF) - 127);
+    bits = (bits & 0x007FFFFF) | 0x3F800000;
+    float mantissa;
+    memcpy(&mantissa, &bits, sizeof(mantissa));
+    float t = mantissa - 1.0f;
+    return exponent + 1.0001890e-4f
+        + t * (1.4373022f + t * (-0.67293419f + t * (0.31546761f + t * -0.080010877f)));
+}
+
+// 2^x to a relative 5e-6 for x in [-126, 126]: integer part into the
+// exponent bits, a quartic for the fraction. Branch-free and without
+// std::floor, so loops over arrays of it vectorize on baseline SSE2/NEON.
+inline float fastExp2(float x) {
+    x = x < -126.0f ? -126.0f : (x > 126.0f ? 126.0f : x);
+    int whole = static_cast<int>(x) - (x < 0.0f ? 1 : 0);  // Exact negative integers land on t = 1
+    float t = x - static_cast<float>(whole);
+    float fraction = 1.0000036f + t * (0.69296955f + t * (0.24162132f + t * (0.051717735f + t * 0.013683983f)));
+    uint32_t bits = static_cast<uint32_t>(whole + 127) << 23;
+    float scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return fraction * scale;
+}
@@ -0,0 +1,370 @@
+// PC Panel Pro - mixer parameter path
+// Control -> render half of AudioMixer with no device code in it: the
+// device handle -> input slot table, the command queue, and the gain state
+// the render side ramps through. Shared by the addon and the Linux tools.
+
+#pragma once
+
+#include "compressor.h"
+#include "sidechain.h"
+#include "spsc_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+class MixerParams {
+public:
+    static constexpr size_t kMaxInputs = 32;
+    static constexpr uint32_t kMaxDeviceHandles = 256;
+    static constexpr size_t kCommandQueueSize = 1024;
+
+    enum class CommandType : uint8_t {
+        SetGain, SetEnabled, AddInput, SetMasterGain,
+        SetDuckKey, SetDuckTarget, SetDuckThreshold, SetDuckRatio, SetDuckAttack, SetDuckRelease,
+        SetCompEnabled, SetCompDetector, SetCompThreshold, SetCompRatio, SetCompKnee,
+        SetCompAttack, SetCompRelease, SetCompMakeup
+    };
+
+    // Control -> render message; slot indexes the mixer's inputs
+    struct Command {
+        CommandType type;
+        bool flag;
+        int slot;
+        float value;
+    };
+
+    // One entry of a parameter batch (mixerApplyUpdates)
+    struct ParamUpdate {
+        uint32_t deviceHandle;
+        bool hasGain;
+        float gain;
+        bool hasEnabled;
+        bool enabled;
+    };
+
+    // Sidechain ducking for one mix (mixerSetDucking); key 0 = off
+    struct DuckingConfig {
+        uint32_t keyHandle = 0;
+        std::vector<uint32_t> targetHandles;
+        DuckSettings settings;
+    };
+
+    // Render-side parameters of one input slot
+    struct Channel {
+        float targetGain = 1.0f;            // Command consumer only
+        float renderGain = 1.0f;            // Gain reached at the end of the last cycle
+        bool duckTarget = false;            // Pulled down by the duck key
+        float duckGain = 1.0f;              // Duck gain reached at the end of the last cycle
+        CompressorSettings compressor;      // Command consumer only
+        uint32_t compressorVersion = 0;     // Bumped on every compressor command
+        std::atomic<bool> enabled{true};    // Written by the consumer, read by the input IOProc
+    };
+
+    MixerParams()
+        : inputSlots_(new std::atomic<int>[kMaxDeviceHandles])
+        , renderCount_(0)
+        , masterTarget_(1.0f)
+        , masterGain_(1.0f)
+    {
+        for (uint32_t i = 0; i < kMaxDeviceHandles; i++) {
+            inputSlots_[i].store(-1, std::memory_order_relaxed);
+        }
+    }
+
+    // ---- Control side (any thread) ----
+
+    // O(1): device handles are small dense integers
+    int findInput(uint32_t deviceHandle) const {
+        if (deviceHandle >= kMaxDeviceHandles) {
+            return -1;
+        }
+        return inputSlots_[deviceHandle].load(std::memory_order_acquire);
+    }
+
+    // Publish handle -> slot once the slot's input is ready to be looked up
+    void bindInput(uint32_t deviceHandle, int slot) {
+        inputSlots_[deviceHandle].store(slot, std::memory_order_release);
+    }
+
+    bool makeSetGain(uint32_t deviceHandle, float gain, Command& command) const {
+        int slot = findInput(deviceHandle);
+        if (slot < 0) {
+            return false;
+        }
+        command = {};
+        command.type = CommandType::SetGain;
+        command.slot = slot;
+        command.value = std::max(0.0f, std::min(1.0f, gain));
+        return true;
+    }
+
+    bool makeSetEnabled(uint32_t deviceHandle, bool enabled, Command& command) const {
+        int slot = findInput(deviceHandle);
+        if (slot < 0) {
+            return false;
+        }
+        command = {};
+        command.type = CommandType::SetEnabled;
+        command.slot = slot;
+        command.flag = enabled;
+        return true;
+    }
+
+    static Command makeSetMasterGain(float gain) {
+        Command command = {};
+        command.type = CommandType::SetMasterGain;
+        command.value = std::max(0.0f, std::min(1.0f, gain));
+        return command;
+    }
+
+    static Command makeAddInput(int slot) {
+        Command command = {};
+        command.type = CommandType::AddInput;
+        command.slot = slot;
+        return command;
+    }
+
+    // Replace the ducking setup with one batch: the key command clears every
+    // target first, so targets dropped from the config stop ducking. False
+    // if the key isn't an input of this mix; unknown targets and the key
+    // itself are skipped.
+    bool makeDucking(const DuckingConfig& config, std::vector<Command>& commands) const {
+        int key = config.keyHandle == 0 ? -1 : findInput(config.keyHandle);
+        if (config.keyHandle != 0 && key < 0) {
+            return false;
+        }
+        DuckSettings settings = clampDuckSettings(config.settings);
+        Command command = {};
+        command.type = CommandType::SetDuckKey;
+        command.slot = key;
+        commands.push_back(command);
+        if (key < 0) {
+            return true;
+        }
+        for (uint32_t handle : config.targetHandles) {
+            int slot = findInput(handle);
+            if (slot < 0 || slot == key) {
+                continue;
+            }
+            command = {};
+            command.type = CommandType::SetDuckTarget;
+            command.slot = slot;
+            command.flag = true;
+            commands.push_back(command);
+        }
+        const std::pair<CommandType, float> values[] = {
+            {CommandType::SetDuckThreshold, settings.thresholdDb},
+            {CommandType::SetDuckRatio, settings.ratio},
+            {CommandType::SetDuckAttack, settings.attackMs},
+            {CommandType::SetDuckRelease, settings.releaseMs},
+        };
+        for (const auto& value : values) {
+            command = {};
+            command.type = value.first;
+            command.value = value.second;
+            commands.push_back(command);
+        }
+        return true;
+    }
+
+    // One input's whole compressor setup as a batch; false if the handle
+    // isn't an input of this mix
+    bool makeCompressor(uint32_t deviceHandle, const CompressorSettings& config,
+                        std::vector<Command>& commands) const {
+        int slot = findInput(deviceHandle);
+        if (slot < 0) {
+            return false;
+        }
+        CompressorSettings settings = clampCompressorSettings(config);
+        Command command = {};
+        command.slot = slot;
+        command.type = CommandType::SetCompEnabled;
+        command.flag = settings.enabled;
+        commands.push_back(command);
+        command.flag = false;
+        const std::pair<CommandType, float> values[] = {
+            {CommandType::SetCompDetector, static_cast<float>(settings.detector)},
+            {CommandType::SetCompThreshold, settings.thresholdDb},
+            {CommandType::SetCompRatio, settings.ratio},
+            {CommandType::SetCompKnee, settings.kneeDb},
+            {CommandType::SetCompAttack, settings.attackMs},
+            {CommandType::SetCompRelease, settings.releaseMs},
+            {CommandType::SetCompMakeup, settings.makeupDb},
+        };
+        for (const auto& value : values) {
+            command.type = value.first;
+            command.value = value.second;
+            commands.push_back(command);
+        }
+        return true;
+    }
+
+    // Turn a batch into one scene of commands; returns the number of
+    // updates that matched an input
+    size_t makeScene(const std::vector<ParamUpdate>& updates, std::vector<Command>& scene) const {
+        scene.reserve(scene.size() + updates.size() * 2);
+        size_t matched = 0;
+        for (const ParamUpdate& update : updates) {
+            int slot = findInput(update.deviceHandle);
+            if (slot < 0) {
+                continue;
+            }
+            matched++;
+            Command command = {};
+            command.slot = slot;
+            if (update.hasGain) {
+                command.type = CommandType::SetGain;
+                command.value = std::max(0.0f, std::min(1.0f, update.gain));
+                scene.push_back(command);
+            }
+            if (update.hasEnabled) {
+                command.type = CommandType::SetEnabled;
+                command.flag = update.enabled;
+                scene.push_back(command);
+            }
+        }
+        return matched;
+    }
+
+    // Producers (JS thread, workers, HID thread) only serialize among
+    // themselves; the render side never takes producerMutex_. A batch is
+    // published atomically or not at all.
+    bool push(const Command* commands, size_t count) {
+        std::lock_guard<std::mutex> lock(producerMutex_);
+        return commands_.pushBatch(commands, count);
+    }
+
+    // ---- Render side (single consumer) ----
+
+    // Apply everything queued so far; onApplied sees each command after it
+    // took effect
+    template <typename F>
+    void drain(F&& onApplied) {
+        Command command;
+        while (commands_.pop(command)) {
+            switch (command.type) {
+                case CommandType::SetGain:
+                    channels_[command.slot].targetGain = command.value;
+                    break;
+                case CommandType::SetEnabled:
+                    channels_[command.slot].enabled.store(command.flag, std::memory_order_relaxed);
+                    if (!command.flag) {
+                        // Come back in from silence rather than from the old level
+                        channels_[command.slot].renderGain = 0.0f;
+                    }
+                    break;
+                case CommandType::AddInput:
+                    if (renderCount_ < kMaxInputs) {
+                        renderSlots_[renderCount_++] = command.slot;
+                    }
+                    break;
+                case CommandType::SetMasterGain:
+                    masterTarget_ = command.value;
+                    break;
+                case CommandType::SetDuckKey:
+                    duckKey_ = command.slot;
+                    for (Channel& ch : channels_) {
+                        ch.duckTarget = false;   // duckGain ramps back to 1 next cycle
+                    }
+                    break;
+                case CommandType::SetDuckTarget:
+                    channels_[command.slot].duckTarget = command.flag;
+                    break;
+                case CommandType::SetDuckThreshold:
+                    duckSettings_.thresholdDb = command.value;
+                    break;
+                case CommandType::SetDuckRatio:
+                    duckSettings_.ratio = command.value;
+                    break;
+                case CommandType::SetDuckAttack:
+                    duckSettings_.attackMs = command.value;
+                    break;
+                case CommandType::SetDuckRelease:
+                    duckSettings_.releaseMs = command.value;
+                    break;
+                case CommandType::SetCompEnabled:
+                case CommandType::SetCompDetector:
+                case CommandType::SetCompThreshold:
+                case CommandType::SetCompRatio:
+                case CommandType::SetCompKnee:
+                case CommandType::SetCompAttack:
+                case CommandType::SetCompRelease:
+                case CommandType::SetCompMakeup:
+                    applyCompressor(command);
+                    break;
+            }
+            onApplied(command);
+        }
+    }
+
+    void drain() {
+        drain([](const Command&) {});
+    }
+
+    // Jump every ramp to its target (before the first cycle)
+    void settle() {
+        for (size_t r = 0; r < renderCount_; r++) {
+            Channel& ch = channels_[renderSlots_[r]];
+            ch.renderGain = ch.enabled.load(std::memory_order_relaxed) ? ch.targetGain : 0.0f;
+        }
+        masterGain_ = masterTarget_;
+    }
+
+    // Ramps are complete - the next cycle starts from the targets
+    void finishCycle() {
+        for (size_t r = 0; r < renderCount_; r++) {
+            Channel& ch = channels_[renderSlots_[r]];
+            if (ch.enabled.load(std::memory_order_relaxed)) {
+                ch.renderGain = ch.targetGain;
+            }
+        }
+        masterGain_ = masterTarget_;
+    }
+
+    size_t renderCount() const { return renderCount_; }
+    int renderSlot(size_t index) const { return renderSlots_[index]; }
+    Channel& channel(int slot) { return channels_[slot]; }
+    float masterGain() const { return masterGain_; }
+    float masterTarget() const { return masterTarget_; }
+    int duckKey() const { return duckKey_; }             // -1 = no ducking
+    const DuckSettings& duckSettings() const { return duckSettings_; }
+
+private:
+    void applyCompressor(const Command& command) {
+        Channel& ch = channels_[command.slot];
+        CompressorSettings& settings = ch.compressor;
+        switch (command.type) {
+            case CommandType::SetCompEnabled: settings.enabled = command.flag; break;
+            case CommandType::SetCompDetector:
+                settings.detector = static_cast<CompressorDetector>(static_cast<int>(command.value));
+                break;
+            case CommandType::SetCompThreshold: settings.thresholdDb = command.value; break;
+            case CommandType::SetCompRatio: settings.ratio = command.value; break;
+            case CommandType::SetCompKnee: settings.kneeDb = command.value; break;
+            case CommandType::SetCompAttack: settings.attackMs = command.value; break;
+            case CommandType::SetCompRelease: settings.releaseMs = command.value; break;
+            case CommandType::SetCompMakeup: settings.makeupDb = command.value; break;
+            default: return;
+        }
+        ch.compressorVersion++;
+    }
+
+    std::unique_ptr<std::atomic<int>[]> inputSlots_;   // device handle -> slot (-1 = absent)
+    std::mutex producerMutex_;                         // Serializes command producers only
+    SpscQueue<Command, kCommandQueueSize> commands_;
+
+    // Render state - only touched by the command consumer
+    Channel channels_[kMaxInputs];
+    int renderSlots_[kMaxInputs];                      // Inputs being mixed, in add order
+    size_t renderCount_;
+    float masterTarget_;
+    float masterGain_;
+    int duckKey_ = -1;
+    DuckSettings duckSettings_;
+};
@@ -0,0 +1,732 @@
+// PC Panel Pro - instant-replay buffer for one mix bus
+// Shared by the addon and the Linux tools; POSIX file I/O, no other
+// platform dependencies.
+//
+// Keeps the last few minutes of a bus in memory so they can be saved after
+// the fact. The output callback hands each rendered buffer to push(), which
+// only copies it into a short ring. An encoder thread compresses the ring in
+// blocks into a fixed arena of segments; the oldest blocks are dropped as
+// they fall out of the window, and whole segments are recycled if the arena
+// fills first. Memory never grows past the arena allocated by start().
+//
+// The codec is lossless at 24 bits: samples are quantized to 24-bit
+// integers, each block and channel picks the fixed polynomial predictor
+// (order 0-2) with the smallest residuals, and the residuals are Rice coded.
+// Silent blocks cost a few bytes; blocks that don't compress are stored
+// verbatim. Blocks decode on their own, so any suffix of the window can be
+// saved. save() writes a 24-bit PCM WAV.
+
+#pragma once
+
+#include "callback_timing.h"
+#include "ring_buffer.h"
+#include "ring_stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+class ReplayBuffer {
+public:
+    static constexpr size_t kChannels = 2;                      // Interleaved stereo Float32, like the bus
+    static constexpr size_t kBytesPerFrame = kChannels * sizeof(float);
+    static constexpr size_t kBlockFrames = 4096;                // One packet per channel pair
+    static constexpr double kRingSeconds = 2.0;                 // Encoder stalls this long lose nothing
+    static constexpr size_t kSegmentBytes = 256 * 1024;         // Arena recycling unit
+    static constexpr double kBudgetBytesPerSample = 2.0;        // Default arena: 16 bits per sample
+    static constexpr int kPollMs = 20;                          // Encoder wake-up interval
+
+    struct Stats {
+        bool running;
+        double sampleRate;
+        double windowSeconds;           // Asked for in start()
+        double heldSeconds;             // Encoded and saveable now
+        uint64_t compressedBytes;       // Held packets
+        uint64_t arenaBytes;            // Allocated; the memory bound
+        double bytesPerMinute;          // compressedBytes over heldSeconds
+        double compressionRatio;        // Float32 size over compressed size
+        uint64_t droppedFrames;         // Didn't fit in the ring
+        uint64_t evictedFrames;         // Pushed out by a full arena before leaving the window
+        double encodeSeconds;           // Encoder CPU time
+        uint64_t maxEncodeNs;           // Slowest block
+    };
+
+    ReplayBuffer() = default;
+    ~ReplayBuffer() { stop(); }
+    ReplayBuffer(const ReplayBuffer&) = delete;
+    ReplayBuffer& operator=(const ReplayBuffer&) = delete;
+
+    // ---- Render thread ----
+
+    // Queue one rendered buffer; drops what doesn't fit
+    void push(const float* samples, size_t frames) {
+        if (!active_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        // Same handshake as BusRecorder::push: stop() waits for pushing_
+        pushing_.store(true, std::memory_order_seq_cst);
+        if (active_.load(std::memory_order_seq_cst)) {
+            ring_->write(samples, frames * kBytesPerFrame);
+        }
+        pushing_.store(false, std::memory_order_release);
+    }
+
+    // ---- Control thread ----
+
+    // Keeps the last windowSeconds in at most maxBytes of arena (0 sizes it
+    // for kBudgetBytesPerSample). Discards anything held from a previous start().
+    bool start(double sampleRate, double windowSeconds, size_t maxBytes, std::string& error) {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        if (encoder_.joinable()) {
+            error = "replay buffer already running";
+            return false;
+        }
+        if (!(windowSeconds > 0) || !(sampleRate > 0)) {
+            error = "replay window and sample rate must be positive";
+            return false;
+        }
+        size_t segments;
+        if (maxBytes == 0) {
+            // One spare segment: the newest is part-filled, the oldest part-expired
+            size_t budget = static_cast<size_t>(windowSeconds * sampleRate * kChannels * kBudgetBytesPerSample);
+            segments = (budget + kSegmentBytes - 1) / kSegmentBytes + 1;
+        } else {
+            segments = maxBytes / kSegmentBytes;
+        }
+        segments = std::max<size_t>(2, segments);
+
+        // Neither side is running, so everything can be replaced
+        size_t ringFrames = static_cast<size_t>(sampleRate * kRingSeconds);
+        ringStats_ = std::make_unique<RingStats>();
+        ring_ = std::make_unique<RingBuffer>(ringFrames, kChannels, kBytesPerFrame, ringStats_.get());
+        block_.assign(kBlockFrames * kChannels, 0.0f);
+        quantized_.assign(kBlockFrames, 0);
+        packet_.assign(kMaxPacketBytes, 0);
+        {
+            std::lock_guard<std::mutex> arena(arenaMutex_);
+            arena_.assign(segments * kSegmentBytes, 0);
+            segmentCount_ = segments;
+            packets_.clear();
+            oldestSegment_ = 0;
+            currentSegment_ = 0;
+            segmentsUsed_ = 1;
+            segmentOffset_ = 0;
+            heldFrames_ = 0;
+            compressedBytes_ = 0;
+        }
+
+        sampleRate_ = sampleRate;
+        windowFrames_ = static_cast<uint64_t>(windowSeconds * sampleRate);
+        windowSeconds_.store(windowSeconds, std::memory_order_relaxed);
+        publishedRate_.store(sampleRate, std::memory_order_relaxed);
+        arenaBytes_.store(segments * kSegmentBytes, std::memory_order_relaxed);
+        publishedFrames_.store(0, std::memory_order_relaxed);
+        publishedSeconds_.store(0.0, std::memory_order_relaxed);
+        publishedBytes_.store(0, std::memory_order_relaxed);
+        evictedFrames_.store(0, std::memory_order_relaxed);
+        ringDropped_.store(0, std::memory_order_relaxed);
+        encodeNs_.store(0, std::memory_order_relaxed);
+        maxEncodeNs_.store(0, std::memory_order_relaxed);
+
+        stopRequested_ = false;
+        flushRequested_ = 0;
+        flushDone_ = 0;
+        encoder_ = std::thread([this] { run(); });
+        active_.store(true, std::memory_order_seq_cst);
+        return true;
+    }
+
+    // Stops the encoder and frees the arena
+    void stop() {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        if (!encoder_.joinable()) {
+            return;
+        }
+        active_.store(false, std::memory_order_seq_cst);
+        while (pushing_.load(std::memory_order_seq_cst)) {
+            std::this_thread::yield();
+        }
+        {
+            std::lock_guard<std::mutex> wake(wakeMutex_);
+            stopRequested_ = true;
+        }
+        wakeCondition_.notify_one();
+        encoder_.join();
+
+        std::lock_guard<std::mutex> arena(arenaMutex_);
+        std::vector<uint8_t>().swap(arena_);
+        packets_.clear();
+        heldFrames_ = 0;
+        compressedBytes_ = 0;
+        publishedFrames_.store(0, std::memory_order_relaxed);
+        publishedSeconds_.store(0.0, std::memory_order_relaxed);
+        publishedBytes_.store(0, std::memory_order_relaxed);
+        arenaBytes_.store(0, std::memory_order_relaxed);
+    }
+
+    // Waits until everything pushed so far is encoded. For callers that push
+    // faster than real time (offline rendering) and would otherwise overrun
+    // the ring.
+    void flush() {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        if (encoder_.joinable()) {
+            flushLocked();
+        }
+    }
+
+    bool isRunning() const { return active_.load(std::memory_order_relaxed); }
+
+    // Writes the newest `seconds` (0 or more than is held: everything held)
+    // to path as 24-bit PCM WAV. Encodes what's still queued first, so the
+    // file ends at most one output buffer before the call. Decoding and the
+    // write run after the control lock is released, so stop() isn't held up,
+    // and go one packet at a time through a block-sized scratch buffer, so
+    // only the compressed window is ever held in memory.
+    bool save(const std::string& path, double seconds, uint64_t& framesSaved, std::string& error) {
+        std::unique_lock<std::mutex> lock(controlMutex_);
+        framesSaved = 0;
+        if (!encoder_.joinable()) {
+            error = "replay buffer is not running";
+            return false;
+        }
+        flushLocked();
+
+        // Copy the packets out so the encoder is only held up for a memcpy
+        uint64_t wanted = seconds > 0 ? static_cast<uint64_t>(seconds * sampleRate_) : UINT64_MAX;
+        std::vector<uint8_t> data;
+        std::vector<Packet> packets;
+        {
+            std::lock_guard<std::mutex> arena(arenaMutex_);
+            uint64_t frames = 0;
+            size_t first = packets_.size();
+            while (first > 0 && frames < wanted) {
+                first--;
+                frames += packets_[first].frames;
+            }
+            size_t bytes = 0;
+            for (size_t i = first; i < packets_.size(); i++) {
+                bytes += packets_[i].bytes;
+            }
+            data.reserve(bytes);
+            for (size_t i = first; i < packets_.size(); i++) {
+                Packet packet = packets_[i];
+                const uint8_t* source = arena_.data() + packet.segment * kSegmentBytes + packet.offset;
+                packet.offset = static_cast<uint32_t>(data.size());
+                data.insert(data.end(), source, source + packet.bytes);
+                packets.push_back(packet);
+            }
+        }
+        double rate = sampleRate_;
+        lock.unlock();
+
+        uint64_t frames = 0;
+        for (const Packet& packet : packets) {
+            frames += packet.frames;
+        }
+        uint64_t skip = frames > wanted ? frames - wanted : 0;     // Oldest frames past the request
+        uint64_t saved = frames - skip;
+
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            error = "can't create " + path + ": " + strerror(errno);
+            return false;
+        }
+        uint8_t header[kWavHeaderBytes];
+        writeWavHeader(header, rate, saved);
+        bool ok = writeAll(fd, header, sizeof(header), error);
+
+        std::vector<int32_t> samples(kBlockFrames * kChannels);
+        std::vector<uint8_t> pcm(kBlockFrames * kChannels * 3);
+        for (size_t i = 0; ok && i < packets.size(); i++) {
+            const Packet& packet = packets[i];
+            if (!decodePacket(data.data() + packet.offset, packet.bytes, packet.frames, samples.data())) {
+                error = "replay buffer is corrupt";
+                ok = false;
+                break;
+            }
+            size_t from = static_cast<size_t>(std::min<uint64_t>(skip, packet.frames));
+            skip -= from;
+            size_t count = (packet.frames - from) * kChannels;
+            for (size_t j = 0; j < count; j++) {
+                putLE(pcm.data() + j * 3, static_cast<uint32_t>(samples[from * kChannels + j]), 3);
+            }
+            ok = writeAll(fd, pcm.data(), count * 3, error);
+        }
+
+        if (::close(fd) != 0 && ok) {
+            error = std::string("close failed: ") + strerror(errno);
+            ok = false;
+        }
+        if (!ok) {
+            ::unlink(path.c_str());
+            return false;
+        }
+        framesSaved = saved;
+        return true;
+    }
+
+    // Any thread
+    Stats stats() const {
+        Stats stats = {};
+        stats.running = active_.load(std::memory_order_relaxed);
+        stats.sampleRate = publishedRate_.load(std::memory_order_relaxed);
+        stats.windowSeconds = windowSeconds_.load(std::memory_order_relaxed);
+        uint64_t frames = publishedFrames_.load(std::memory_order_relaxed);
+        stats.heldSeconds = publishedSeconds_.load(std::memory_order_relaxed);
+        stats.compressedBytes = publishedBytes_.load(std::memory_order_relaxed);
+        stats.arenaBytes = arenaBytes_.load(std::memory_order_relaxed);
+        if (stats.heldSeconds > 0) {
+            stats.bytesPerMinute = stats.compressedBytes / stats.heldSeconds * 60.0;
+        }
+        if (stats.compressedBytes > 0) {
+            stats.compressionRatio = static_cast<double>(frames * kBytesPerFrame) / stats.compressedBytes;
+        }
+        stats.droppedFrames = ringDropped_.load(std::memory_order_relaxed);
+        stats.evictedFrames = evictedFrames_.load(std::memory_order_relaxed);
+        stats.encodeSeconds = encodeNs_.load(std::memory_order_relaxed) / 1e9;
+        stats.maxEncodeNs = maxEncodeNs_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    struct Packet {
+        uint32_t segment;
+        uint32_t offset;
+        uint32_t bytes;
+        uint32_t frames;
+    };
+
+    // Channel modes; 0-2 are the predictor orders
+    enum Mode : uint32_t { kVerbatim = 3, kConstant = 4 };
+    static constexpr int kModeBits = 3;
+    static constexpr int kRiceBits = 5;
+    static constexpr int kSampleBits = 24;
+    static constexpr int32_t kSampleMax = (1 << 23) - 1;
+    static constexpr int32_t kSampleMin = -(1 << 23);
+    // Frame count, then per channel a mode and at worst every sample verbatim
+    static constexpr size_t kMaxPacketBytes = 2 + kChannels * (kBlockFrames * 3 + 1) + 8;
+
+    // Caller holds controlMutex_ with the encoder running
+    void flushLocked() {
+        std::unique_lock<std::mutex> wake(wakeMutex_);
+        uint64_t request = ++flushRequested_;
+        wakeCondition_.notify_one();
+        flushedCondition_.wait(wake, [this, request] { return flushDone_ >= request; });
+    }
+
+    // ---- Encoder thread ----
+
+    void run() {
+        uint64_t flushed = 0;
+        for (;;) {
+            bool stopping;
+            uint64_t request;
+            {
+                std::unique_lock<std::mutex> wake(wakeMutex_);
+                wakeCondition_.wait_for(wake, std::chrono::milliseconds(kPollMs),
+                                        [this, flushed] { return stopRequested_ || flushRequested_ > flushed; });
+                stopping = stopRequested_;
+                request = flushRequested_;
+            }
+            if (stopping) {
+                break;
+            }
+            // Whole blocks while running; a save() also takes the partial one
+            drain(request > flushed);
+            if (request > flushed) {
+                flushed = request;
+                {
+                    std::lock_guard<std::mutex> wake(wakeMutex_);
+                    flushDone_ = flushed;
+                }
+                flushedCondition_.notify_all();
+            }
+        }
+    }
+
+    void drain(bool all) {
+        size_t blockBytes = kBlockFrames * kBytesPerFrame;
+        size_t available = ring_->getAvailable();
+        ringDropped_.store(ringStats_->read().droppedFrames, std::memory_order_relaxed);
+        while (available >= blockBytes || (all && available > 0)) {
+            size_t bytes = std::min(available, blockBytes);
+            bytes -= bytes % kBytesPerFrame;
+            ring_->read(block_.data(), bytes);
+            available -= bytes;
+
+            uint64_t start = CallbackTiming::now();
+            size_t frames = bytes / kBytesPerFrame;
+            size_t packetBytes = encodePacket(block_.data(), frames, packet_.data());
+            append(packet_.data(), packetBytes, frames);
+            uint64_t elapsed = CallbackTiming::now() - start;
+            encodeNs_.store(encodeNs_.load(std::memory_order_relaxed) + elapsed, std::memory_order_relaxed);
+            if (elapsed > maxEncodeNs_.load(std::memory_order_relaxed)) {
+                maxEncodeNs_.store(elapsed, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Stores one packet, recycling the oldest segment if the arena is full,
+    // then drops packets that have left the window
+    void append(const uint8_t* data, size_t bytes, size_t frames) {
+        std::lock_guard<std::mutex> arena(arenaMutex_);
+        if (segmentOffset_ + bytes > kSegmentBytes) {
+            if (segmentsUsed_ == segmentCount_) {
+                uint64_t evicted = 0;
+                while (!packets_.empty() && packets_.front().segment == oldestSegment_) {
+                    evicted += packets_.front().frames;
+                    popFront();
+                }
+                evictedFrames_.store(evictedFrames_.load(std::memory_order_relaxed) + evicted,
+                                     std::memory_order_relaxed);
+                oldestSegment_ = (oldestSegment_ + 1) % segmentCount_;
+                segmentsUsed_--;
+            }
+            currentSegment_ = (currentSegment_ + 1) % segmentCount_;
+            segmentsUsed_++;
+            segmentOffset_ = 0;
+        }
+
+        memcpy(arena_.data() + currentSegment_ * kSegmentBytes + segmentOffset_, data, bytes);
+        packets_.push_back({static_cast<uint32_t>(currentSegment_), static_cast<uint32_t>(segmentOffset_),
+                            static_cast<uint32_t>(bytes), static_cast<uint32_t>(frames)});
+        segmentOffset_ += bytes;
+        heldFrames_ += frames;
+        compressedBytes_ += bytes;
+
+        while (!packets_.empty() && heldFrames_ - packets_.front().frames >= windowFrames_) {
+            popFront();
+        }
+        // Segments before the oldest held packet are free again
+        while (segmentsUsed_ > 1 && (packets_.empty() || packets_.front().segment != oldestSegment_)) {
+            oldestSegment_ = (oldestSegment_ + 1) % segmentCount_;
+            segmentsUsed_--;
+        }
+        publishedFrames_.store(heldFrames_, std::memory_order_relaxed);
+        publishedSeconds_.store(heldFrames_ / sampleRate_, std::memory_order_relaxed);
+        publishedBytes_.store(compressedBytes_, std::memory_order_relaxed);
+    }
+
+    void popFront() {
+        heldFrames_ -= packets_.front().frames;
+        compressedBytes_ -= packets_.front().bytes;
+        packets_.pop_front();
+    }
+
+    // ---- Codec ----
+
+    class BitWriter {
+    public:
+        explicit BitWriter(uint8_t* out) : out_(out) {}
+        void put(uint32_t value, int bits) {
+            if (bits == 0) {
+                return;
+            }
+            accumulator_ = (accumulator_ << bits) | (value & ((1ull << bits) - 1));
+            count_ += bits;
+            while (count_ >= 8) {
+                count_ -= 8;
+                out_[bytes_++] = static_cast<uint8_t>(accumulator_ >> count_);
+            }
+        }
+        // quotient zeros then a one
+        void unary(uint32_t quotient) {
+            while (quotient >= 32) {
+                put(0, 32);
+                quotient -= 32;
+            }
+            put(1, static_cast<int>(quotient) + 1);
+        }
+        size_t finish() {
+            if (count_ > 0) {
+                out_[bytes_++] = static_cast<uint8_t>(accumulator_ << (8 - count_));
+                count_ = 0;
+            }
+            return bytes_;
+        }
+
+    private:
+        uint8_t* out_;
+        uint64_t accumulator_ = 0;
+        int count_ = 0;
+        size_t bytes_ = 0;
+    };
+
+    class BitReader {
+    public:
+        BitReader(const uint8_t* data, size_t bytes) : data_(data), bytes_(bytes) {}
+        uint32_t get(int bits) {
+            uint32_t value = 0;
+            for (int i = 0; i < bits; i++) {
+                value = (value << 1) | bit();
+            }
+            return value;
+        }
+        uint32_t unary() {
+            uint32_t quotient = 0;
+            while (!overrun_ && bit() == 0) {
+                quotient++;
+            }
+            return quotient;
+        }
+        bool overrun() const { return overrun_; }
+
+    private:
+        uint32_t bit() {
+            if (position_ >= bytes_ * 8) {
+                overrun_ = true;
+                return 1;
+            }
+            uint32_t value = (data_[position_ >> 3] >> (7 - (position_ & 7))) & 1;
+            position_++;
+            return value;
+        }
+
+        const uint8_t* data_;
+        size_t bytes_;
+        size_t position_ = 0;
+        bool overrun_ = false;
+    };
+
+    static uint32_t zigzag(int32_t value) {
+        return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    }
+
+    static int32_t unzigzag(uint32_t value) {
+        return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+    }
+
+    static int32_t predict(const int32_t* x, size_t i, uint32_t order) {
+        switch (order) {
+            case 1: return x[i - 1];
+            case 2: return 2 * x[i - 1] - x[i - 2];
+            default: return 0;
+        }
+    }
+
+    static int32_t quantize(float sample) {
+        float scaled = std::nearbyint(sample * 8388608.0f);
+        return static_cast<int32_t>(std::min(std::max(scaled, static_cast<float>(kSampleMin)),
+                                             static_cast<float>(kSampleMax)));
+    }
+
+    // Bits to Rice code x from order on with parameter k; stops counting past limit
+    static uint64_t riceBits(const int32_t* x, size_t frames, uint32_t order, int k, uint64_t limit) {
+        uint64_t bits = 0;
+        for (size_t i = order; i < frames && bits <= limit; i++) {
+            bits += (zigzag(x[i] - predict(x, i, order)) >> k) + 1 + k;
+        }
+        return bits;
+    }
+
+    size_t encodePacket(const float* interleaved, size_t frames, uint8_t* out) {
+        out[0] = static_cast<uint8_t>(frames);
+        out[1] = static_cast<uint8_t>(frames >> 8);
+        BitWriter writer(out + 2);
+        int32_t* x = quantized_.data();
+        for (size_t channel = 0; channel < kChannels; channel++) {
+            bool constant = true;
+            for (size_t i = 0; i < frames; i++) {
+                x[i] = quantize(interleaved[i * kChannels + channel]);
+                constant = constant && x[i] == x[0];
+            }
+            if (constant) {
+                writer.put(kConstant, kModeBits);
+                writer.put(static_cast<uint32_t>(x[0]), kSampleBits);
+                continue;
+            }
+
+            // Smallest residual magnitude picks the order, its mean the Rice parameter
+            uint32_t bestOrder = 0;
+            uint64_t bestSum = UINT64_MAX;
+            for (uint32_t order = 0; order <= 2 && order < frames; order++) {
+                uint64_t sum = 0;
+                for (size_t i = order; i < frames; i++) {
+                    sum += zigzag(x[i] - predict(x, i, order));
+                }
+                if (sum < bestSum) {
+                    bestSum = sum;
+                    bestOrder = order;
+                }
+            }
+            uint64_t count = frames - bestOrder;
+            int k = 0;
+            while (k < kSampleBits && (count << (k + 1)) <= bestSum) {
+                k++;
+            }
+            uint64_t verbatimBits = static_cast<uint64_t>(frames) * kSampleBits;
+            uint64_t codedBits = bestOrder * kSampleBits + kRiceBits
+                + riceBits(x, frames, bestOrder, k, verbatimBits);
+            if (codedBits >= verbatimBits) {
+                writer.put(kVerbatim, kModeBits);
+                for (size_t i = 0; i < frames; i++) {
+                    writer.put(static_cast<uint32_t>(x[i]), kSampleBits);
+                }
+                continue;
+            }
+
+            writer.put(bestOrder, kModeBits);
+            for (size_t i = 0; i < bestOrder; i++) {
+                writer.put(static_cast<uint32_t>(x[i]), kSampleBits);
+            }
+            writer.put(static_cast<uint32_t>(k), kRiceBits);
+            for (size_t i = bestOrder; i < frames; i++) {
+                uint32_t value = zigzag(x[i] - predict(x, i, bestOrder));
+                writer.unary(value >> k);
+                writer.put(value, k);
+            }
+        }
+        return 2 + writer.finish();
+    }
+
+    // Into interleaved 24-bit integers; fails unless the packet holds
+    // exactly `expected` frames, which out has room for
+    static bool decodePacket(const uint8_t* data, size_t bytes, size_t expected, int32_t* out) {
+        if (bytes < 2) {
+            return false;
+        }
+        size_t frames = static_cast<size_t>(data[0] | (data[1] << 8));
+        if (frames != expected) {
+            return false;
+        }
+        BitReader reader(data + 2, bytes - 2);
+        std::vector<int32_t> x(frames);
+        for (size_t channel = 0; channel < kChannels; channel++) {
+            uint32_t mode = reader.get(kModeBits);
+            if (mode == kConstant) {
+                int32_t value = signExtend(reader.get(kSampleBits));
+                std::fill(x.begin(), x.end(), value);
+            } else if (mode == kVerbatim) {
+                for (size_t i = 0; i < frames; i++) {
+                    x[i] = signExtend(reader.get(kSampleBits));
+                }
+            } else if (mode <= 2) {
+                for (size_t i = 0; i < mode && i < frames; i++) {
+                    x[i] = signExtend(reader.get(kSampleBits));
+                }
+                int k = static_cast<int>(reader.get(kRiceBits));
+                for (size_t i = mode; i < frames; i++) {
+                    uint32_t quotient = reader.unary();
+                    uint32_t value = (quotient << k) | reader.get(k);
+                    x[i] = unzigzag(value) + predict(x.data(), i, mode);
+                }
+            } else {
+                return false;
+            }
+            if (reader.overrun()) {
+                return false;
+            }
+            for (size_t i = 0; i < frames; i++) {
+                out[i * kChannels + channel] = x[i];
+            }
+        }
+        return true;
+    }
+
+    static int32_t signExtend(uint32_t value) {
+        return static_cast<int32_t>(value << 8) >> 8;
+    }
+
+    static void putLE(uint8_t* p, uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++) {
+            p[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+
+    static constexpr size_t kWavHeaderBytes = 44;
+
+    static void writeWavHeader(uint8_t* header, double sampleRate, uint64_t frames) {
+        uint64_t dataBytes = frames * kChannels * 3;
+        uint32_t rate = static_cast<uint32_t>(sampleRate);
+        memcpy(header, "RIFF", 4);
+        putLE(header + 4, 36 + dataBytes, 4);
+        memcpy(header + 8, "WAVE", 4);
+        memcpy(header + 12, "fmt ", 4);
+        putLE(header + 16, 16, 4);
+        putLE(header + 20, 1, 2);                                   // WAVE_FORMAT_PCM
+        putLE(header + 22, kChannels, 2);
+        putLE(header + 24, rate, 4);
+        putLE(header + 28, rate * kChannels * 3, 4);
+        putLE(header + 32, kChannels * 3, 2);
+        putLE(header + 34, 24, 2);
+        memcpy(header + 36, "data", 4);
+        putLE(header + 40, dataBytes, 4);
+    }
+
+    static bool writeAll(int fd, const uint8_t* data, size_t remaining, std::string& error) {
+        while (remaining > 0) {
+            ssize_t written = ::write(fd, data, remaining);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                error = std::string("write failed: ") + strerror(errno);
+                return false;
+            }
+            data += written;
+            remaining -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    // Render thread and control thread
+    std::atomic<bool> active_{false};
+    std::atomic<bool> pushing_{false};
+    std::unique_ptr<RingBuffer> ring_;
+    std::unique_ptr<RingStats> ringStats_;
+
+    // Encoder thread, set up by start()
+    double sampleRate_ = 0.0;
+    uint64_t windowFrames_ = 0;
+    std::vector<float> block_;
+    std::vector<int32_t> quantized_;
+    std::vector<uint8_t> packet_;
+
+    // Encoder writes, save() copies out
+    std::mutex arenaMutex_;
+    std::vector<uint8_t> arena_;
+    std::deque<Packet> packets_;
+    size_t segmentCount_ = 0;
+    size_t oldestSegment_ = 0;
+    size_t currentSegment_ = 0;
+    size_t segmentsUsed_ = 0;
+    size_t segmentOffset_ = 0;
+    uint64_t heldFrames_ = 0;
+    uint64_t compressedBytes_ = 0;
+
+    // Published by the encoder for stats()
+    std::atomic<double> windowSeconds_{0.0};
+    std::atomic<double> publishedRate_{0.0};
+    std::atomic<uint64_t> arenaBytes_{0};
+    std::atomic<uint64_t> publishedFrames_{0};
+    std::atomic<double> publishedSeconds_{0.0};
+    std::atomic<uint64_t> publishedBytes_{0};
+    std::atomic<uint64_t> evictedFrames_{0};
+    std::atomic<uint64_t> ringDropped_{0};
+    std::atomic<uint64_t> encodeNs_{0};
+    std::atomic<uint64_t> maxEncodeNs_{0};
+
+    std::thread encoder_;
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCondition_;
+    std::condition_variable flushedCondition_;
+    bool stopRequested_ = false;
+    uint64_t flushRequested_ = 0;
+    uint64_t flushDone_ = 0;
+
+    std::mutex controlMutex_;               // start/stop/save
+};
@@ -0,0 +1,114 @@
+// PC Panel Pro - byte ring buffer between an input and an output callback
+// Shared by the addon and the Linux tools; no platform dependencies.
+
+#pragma once
+
+#include "ring_stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Simple lock-free ring buffer for audio passthrough
+// No drift compensation - relies on matched sample rates
+// Short reads and writes are counted in stats, which may outlive the ring
+class RingBuffer {
+public:
+    RingBuffer(size_t sizeInFrames, uint32_t /* channelCount */, uint32_t bytesPerFrame,
+               RingStats* stats = nullptr)
+        : capacity_(sizeInFrames * bytesPerFrame)
+        , bytesPerFrame_(bytesPerFrame)
+        , buffer_(capacity_)
+        , writePos_(0)
+        , readPos_(0)
+        , stats_(stats)
+    {
+        if (stats_) {
+            stats_->setCapacity((capacity_ - 1) / bytesPerFrame_);
+        }
+    }
+
+    // Returns the bytes accepted; the rest is dropped
+    size_t write(const void* data, size_t bytes) {
+        const uint8_t* src = static_cast<const uint8_t*>(data);
+        size_t wp = writePos_.load(std::memory_order_relaxed);
+        size_t rp = readPos_.load(std::memory_order_acquire);
+
+        // Calculate available space (leave 1 byte to distinguish full from empty),
+        // in whole frames so a partial write never shifts the channels
+        size_t used = (wp >= rp) ? (wp - rp) : (capacity_ - rp + wp);
+        size_t space = capacity_ - used - 1;
+        space -= space % bytesPerFrame_;
+
+        size_t toWrite = std::min(bytes, space);
+        if (stats_) {
+            stats_->recordWrite(bytes / bytesPerFrame_, toWrite / bytesPerFrame_);
+        }
+        if (toWrite == 0) return 0;  // Buffer full, drop samples
+
+        size_t writeIdx = wp % capacity_;
+        size_t firstChunk = std::min(toWrite, capacity_ - writeIdx);
+
+        memcpy(buffer_.data() + writeIdx, src, firstChunk);
+        if (toWrite > firstChunk) {
+            memcpy(buffer_.data(), src + firstChunk, toWrite - firstChunk);
+        }
+
+        writePos_.store((wp + toWrite) % capacity_, std::memory_order_release);
+        return toWrite;
+    }
+
+    size_t read(void* data, size_t bytes) {
+        uint8_t* dst = static_cast<uint8_t*>(data);
+        size_t wp = writePos_.load(std::memory_order_acquire);
+        size_t rp = readPos_.load(std::memory_order_relaxed);
+
+        size_t available = (wp >= rp) ? (wp - rp) : (capacity_ - rp + wp);
+        size_t toRead = std::min(bytes, available);
+        if (stats_) {
+            stats_->recordRead(bytes / bytesPerFrame_, toRead / bytesPerFrame_, available / bytesPerFrame_);
+        }
+
+        if (toRead > 0) {
+            size_t readIdx = rp % capacity_;
+            size_t firstChunk = std::min(toRead, capacity_ - readIdx);
+
+            memcpy(dst, buffer_.data() + readIdx, firstChunk);
+            if (toRead > firstChunk) {
+                memcpy(dst + firstChunk, buffer_.data(), toRead - firstChunk);
+            }
+
+            readPos_.store((rp + toRead) % capacity_, std::memory_order_release);
+        }
+
+        // Fill remaining with silence
+        if (toRead < bytes) {
+            memset(dst + toRead, 0, bytes - toRead);
+        }
+
+        return toRead;
+    }
+
+    // Only while neither callback is running
+    void reset() {
+        writePos_.store(0, std::memory_order_relaxed);
+        readPos_.store(0, std::memory_order_relaxed);
+    }
+
+    size_t getAvailable() const {
+        size_t wp = writePos_.load(std::memory_order_relaxed);
+        size_t rp = readPos_.load(std::memory_order_relaxed);
+        return (wp >= rp) ? (wp - rp) : (capacity_ - rp + wp);
+    }
+
+private:
+    size_t capacity_;
+    size_t bytesPerFrame_;
+    std::vector<uint8_t> buffer_;
+    std::atomic<size_t> writePos_;
+    std::atomic<size_t> readPos_;
+    RingStats* stats_;
+};
@@ -0,0 +1,123 @@
+// PC Panel Pro - underrun/overflow accounting for one ring buffer
+// Shared by the addon, the driver and the Linux tools; no platform dependencies.
+//
+// The ring's writer thread owns the overflow counters and its reader thread
+// owns the underrun counters and the fill window, so every update is a
+// relaxed load and store - no read-modify-write on the audio threads. Any
+// thread may take a snapshot.
+
+#pragma once
+
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+class RingStats {
+public:
+    struct Snapshot {
+        uint64_t underruns;         // Reads that came back short
+        uint64_t silentFrames;      // Frames of silence those reads were padded with
+        uint64_t overflows;         // Writes that did not fit
+        uint64_t droppedFrames;     // Frames those writes lost
+        uint64_t fillMinFrames;     // Fill level seen by the reader since the last read()
+        uint64_t fillMaxFrames;
+        uint64_t capacityFrames;
+
+        Snapshot& operator+=(const Snapshot& other) {
+            underruns += other.underruns;
+            silentFrames += other.silentFrames;
+            overflows += other.overflows;
+            droppedFrames += other.droppedFrames;
+            fillMinFrames = capacityFrames == 0 ? other.fillMinFrames : std::min(fillMinFrames, other.fillMinFrames);
+            fillMaxFrames = std::max(fillMaxFrames, other.fillMaxFrames);
+            capacityFrames += other.capacityFrames;
+            return *this;
+        }
+    };
+
+    // Set by the ring when it is (re)allocated, before either side runs
+    void setCapacity(size_t frames) {
+        capacityFrames_.store(frames, std::memory_order_relaxed);
+    }
+
+    // Tags this ring's fill level and xruns in a trace; set before either side runs
+    void setTraceId(int32_t id) {
+        traceId_ = id;
+    }
+
+    // ---- Writer thread ----
+
+    void recordWrite(size_t requestedFrames, size_t writtenFrames) {
+        if (writtenFrames < requestedFrames) {
+            bump(overflows_, 1);
+            bump(droppedFrames_, requestedFrames - writtenFrames);
+            trace::instant("overflow", static_cast<double>(requestedFrames - writtenFrames), traceId_);
+        }
+    }
+
+    // ---- Reader thread ----
+
+    // fillFrames is what the ring held before this read
+    void recordRead(size_t requestedFrames, size_t readFrames, size_t fillFrames) {
+        if (windowResetRequested_.load(std::memory_order_relaxed)
+            && windowResetRequested_.exchange(false, std::memory_order_acquire)) {
+            fillMin_.store(fillFrames, std::memory_order_relaxed);
+            fillMax_.store(fillFrames, std::memory_order_relaxed);
+        } else {
+            if (fillFrames < fillMin_.load(std::memory_order_relaxed)) {
+                fillMin_.store(fillFrames, std::memory_order_relaxed);
+            }
+            if (fillFrames > fillMax_.load(std::memory_order_relaxed)) {
+                fillMax_.store(fillFrames, std::memory_order_relaxed);
+            }
+        }
+        lastFill_.store(fillFrames, std::memory_order_relaxed);
+        trace::counter("ring fill", static_cast<double>(fillFrames), traceId_);
+
+        if (readFrames < requestedFrames) {
+            bump(underruns_, 1);
+            bump(silentFrames_, requestedFrames - readFrames);
+            trace::instant("underrun", static_cast<double>(requestedFrames - readFrames), traceId_);
+        }
+    }
+
+    // ---- Any thread ----
+
+    // Counters are cumulative; the fill window restarts with the next read
+    Snapshot read() {
+        Snapshot snap = {};
+        snap.underruns = underruns_.load(std::memory_order_relaxed);
+        snap.silentFrames = silentFrames_.load(std::memory_order_relaxed);
+        snap.overflows = overflows_.load(std::memory_order_relaxed);
+        snap.droppedFrames = droppedFrames_.load(std::memory_order_relaxed);
+        snap.capacityFrames = capacityFrames_.load(std::memory_order_relaxed);
+
+        if (windowResetRequested_.exchange(true, std::memory_order_acq_rel)) {
+            // No read since the last snapshot; the level has not moved
+            snap.fillMinFrames = snap.fillMaxFrames = lastFill_.load(std::memory_order_relaxed);
+        } else {
+            snap.fillMinFrames = fillMin_.load(std::memory_order_relaxed);
+            snap.fillMaxFrames = fillMax_.load(std::memory_order_relaxed);
+        }
+        return snap;
+    }
+
+private:
+    static void bump(std::atomic<uint64_t>& counter, uint64_t amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> underruns_{0};
+    std::atomic<uint64_t> silentFrames_{0};
+    std::atomic<uint64_t> overflows_{0};
+    std::atomic<uint64_t> droppedFrames_{0};
+    std::atomic<uint64_t> fillMin_{0};
+    std::atomic<uint64_t> fillMax_{0};
+    std::atomic<uint64_t> lastFill_{0};
+    std::atomic<uint64_t> capacityFrames_{0};
+    std::atomic<bool> windowResetRequested_{false};
+    int32_t traceId_ = -1;
+};
@@ -0,0 +1,72 @@
+// PC Panel Pro - real-time scope markers
+// Shared by the addon, the driver and the Linux tools; no platform dependencies.
+//
+// rtsan::Scope marks code that runs on an audio thread. In normal builds it
+// is an empty object. Built with PCPANEL_RT_SANITIZER, it sets a thread-local
+// depth that the interceptors in tools/rt_sanitizer.cpp check: allocating,
+// locking a mutex, a blocking syscall or logging while it is set is reported
+// with a stack trace.
+
+#pragma once
+
+#include <cstddef>
+
+namespace rtsan {
+
+#if PCPANEL_RT_SANITIZER
+
+struct ThreadState {
+    int depth;              // Nested Scopes on this thread
+    int suspended;          // Nested Allows on this thread
+    const char* scope;      // Outermost scope name, for reports
+};
+
+inline thread_local ThreadState threadState{0, 0, nullptr};
+
+inline bool inRealtimeScope() {
+    return threadState.depth > 0 && threadState.suspended == 0;
+}
+
+class Scope {
+public:
+    explicit Scope(const char* name) {
+        if (threadState.depth++ == 0) {
+            threadState.scope = name;
+        }
+    }
+    ~Scope() {
+        if (--threadState.depth == 0) {
+            threadState.scope = nullptr;
+        }
+    }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+};
+
+// Lifts the checks for a reviewed exception inside a Scope
+class Allow {
+public:
+    Allow() { threadState.suspended++; }
+    ~Allow() { threadState.suspended--; }
+    Allow(const Allow&) = delete;
+    Allow& operator=(const Allow&) = delete;
+};
+
+// Provided by the interceptor runtime
+size_t violationCount();
+
+#else
+
+class Scope {
+public:
+    explicit Scope(const char* /* name */) {}
+};
+
+class Allow {
+public:
+    Allow() {}
+};
+
+#endif
+
+}  // namespace rtsan
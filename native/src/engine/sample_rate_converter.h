@@ -0,0 +1,108 @@
+// PC Panel Pro - linear interpolation sample rate converter
+// Shared by the addon and the Linux tools; no platform dependencies.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+// Simple linear interpolation; keeps its phase and the last input frame
+// across calls, so a stream converted in pieces is the same as one
+// converted in a single call. Feed it inputFramesFor(outputFrames) frames per
+// call: the converter uses every frame it is given and never drops input.
+class SampleRateConverter {
+public:
+    SampleRateConverter(double inputRate, double outputRate, int channels = 2)
+        : inputRate_(inputRate)
+        , outputRate_(outputRate)
+        , channels_(channels)
+        , ratio_(inputRate / outputRate)
+        , phase_(1.0)
+    {
+        history_.resize(channels, 0.0f);
+    }
+
+    // Input frames the next convert() needs to produce outputFrames
+    size_t inputFramesFor(size_t outputFrames) const {
+        if (inputRate_ == outputRate_) return outputFrames;
+        if (outputFrames == 0) return 0;
+        double last = phase_ + static_cast<double>(outputFrames - 1) * ratio_;
+        return static_cast<size_t>(std::floor(last)) + 1;
+    }
+
+    // Convert input samples to output sample rate
+    // Returns the number of output frames produced; fewer than
+    // maxOutputFrames only when the input runs out
+    size_t convert(const float* input, size_t inputFrames, float* output, size_t maxOutputFrames) {
+        if (inputRate_ == outputRate_) {
+            // No conversion needed
+            size_t framesToCopy = std::min(inputFrames, maxOutputFrames);
+            memcpy(output, input, framesToCopy * channels_ * sizeof(float));
+            return framesToCopy;
+        }
+
+        // Outputs between the history frame (position 0) and the first
+        // input frame (position 1)
+        size_t outputFrames = 0;
+        while (outputFrames < maxOutputFrames && phase_ < 1.0 && inputFrames > 0) {
+            float frac = static_cast<float>(phase_);
+            for (int ch = 0; ch < channels_; ch++) {
+                float s0 = history_[ch];
+                output[outputFrames * channels_ + ch] = s0 + (input[ch] - s0) * frac;
+            }
+            outputFrames++;
+            phase_ += ratio_;
+        }
+
+        // The rest lie within the input: position p is input frame p - 1
+        while (outputFrames < maxOutputFrames) {
+            double inputPos = phase_ - 1.0;
+            size_t idx0 = static_cast<size_t>(inputPos);
+            if (idx0 + 1 >= inputFrames) break;
+            float frac = static_cast<float>(inputPos - static_cast<double>(idx0));
+            const float* s0 = input + idx0 * channels_;
+            const float* s1 = s0 + channels_;
+            for (int ch = 0; ch < channels_; ch++) {
+                output[outputFrames * channels_ + ch] = s0[ch] + (s1[ch] - s0[ch]) * frac;
+            }
+            outputFrames++;
+            phase_ += ratio_;
+        }
+
+        // Keep the last frame and make the phase relative to it. More input
+        // than inputFramesFor() asked for can't be carried over, so the
+        // excess is skipped.
+        if (inputFrames > 0) {
+            memcpy(history_.data(), input + (inputFrames - 1) * channels_, channels_ * sizeof(float));
+        }
+        phase_ = std::max(0.0, phase_ - static_cast<double>(inputFrames));
+
+        return outputFrames;
+    }
+
+    // Reset state
+    void reset() {
+        phase_ = 1.0;
+        std::fill(history_.begin(), history_.end(), 0.0f);
+    }
+
+    // Calculate how many output frames we'd get for given input frames
+    size_t getOutputFrameCount(size_t inputFrames) const {
+        if (inputRate_ == outputRate_) return inputFrames;
+        return static_cast<size_t>(inputFrames * outputRate_ / inputRate_);
+    }
+
+    double getInputRate() const { return inputRate_; }
+    double getOutputRate() const { return outputRate_; }
+
+private:
+    double inputRate_;
+    double outputRate_;
+    int channels_;
+    double ratio_;
+    double phase_;                  // Next output's position; 0 is the history frame
+    std::vector<float> history_;
+};
@@ -0,0 +1,58 @@
+// PC Panel Pro - sidechain ducking
+// Gain computer that pulls target inputs down while a key input is loud.
+// Shared by the addon and the Linux tools; no platform dependencies.
+// Runs once per render cycle on the key's pre-fader peak, so the targets
+// are ducked within the same cycle the key crossed the threshold.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+struct DuckSettings {
+    float thresholdDb = -30.0f;     // Key level where ducking starts
+    float ratio = 4.0f;             // Above threshold: 1 dB of output per ratio dB of key
+    float attackMs = 10.0f;         // Time constant while reduction grows
+    float releaseMs = 300.0f;       // Time constant while it recovers
+};
+
+constexpr float kDuckMaxRatio = 100.0f;     // Effectively a gate-style duck
+constexpr float kDuckMaxTimeMs = 5000.0f;
+constexpr float kDuckFloorDb = -120.0f;     // Key level reported for silence
+
+inline DuckSettings clampDuckSettings(DuckSettings settings) {
+    settings.thresholdDb = std::max(-90.0f, std::min(0.0f, settings.thresholdDb));
+    settings.ratio = std::max(1.0f, std::min(kDuckMaxRatio, settings.ratio));
+    settings.attackMs = std::max(0.0f, std::min(kDuckMaxTimeMs, settings.attackMs));
+    settings.releaseMs = std::max(0.0f, std::min(kDuckMaxTimeMs, settings.releaseMs));
+    return settings;
+}
+
+class Ducker {
+public:
+    // One cycle of frames at sampleRate with the key peaking at keyPeak
+    // (linear); returns the gain targets should reach by the cycle's end
+    float process(const DuckSettings& settings, float keyPeak, size_t frames, double sampleRate) {
+        float levelDb = keyPeak > 0.0f ? 20.0f * std::log10(keyPeak) : kDuckFloorDb;
+        float over = levelDb - settings.thresholdDb;
+        float target = over > 0.0f ? over * (1.0f - 1.0f / settings.ratio) : 0.0f;
+
+        // One-pole smoothing evaluated per cycle: exact for a constant key
+        // level over the cycle, and the ramp in between is linear
+        float timeMs = target > reductionDb_ ? settings.attackMs : settings.releaseMs;
+        double timeFrames = timeMs * 0.001 * sampleRate;
+        float coeff = timeFrames > 0.0
+            ? static_cast<float>(std::exp(-static_cast<double>(frames) / timeFrames)) : 0.0f;
+        reductionDb_ = target + (reductionDb_ - target) * coeff;
+        return gain();
+    }
+
+    float reductionDb() const { return reductionDb_; }
+    float gain() const { return std::pow(10.0f, -reductionDb_ / 20.0f); }
+
+    void reset() { reductionDb_ = 0.0f; }
+
+private:
+    float reductionDb_ = 0.0f;      // Smoothed, >= 0
+};
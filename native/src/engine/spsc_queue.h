@@ -0,0 +1,55 @@
+// PC Panel Pro - lock-free SPSC queue
+// Shared by the addon and the Linux tools; no platform dependencies.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Fixed-capacity lock-free single-producer/single-consumer queue of small
+// POD messages. pushBatch publishes all items with one store, so the consumer
+// sees either the whole batch or none of it.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscQueue() : head_(0), tail_(0) {}
+
+    bool push(const T& item) {
+        return pushBatch(&item, 1);
+    }
+
+    bool pushBatch(const T* items, size_t count) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = head_.load(std::memory_order_acquire);
+        if (Capacity - (tail - head) < count) {
+            return false;  // Full - nothing is published
+        }
+        for (size_t i = 0; i < count; i++) {
+            buffer_[(tail + i) & (Capacity - 1)] = items[i];
+        }
+        tail_.store(tail + count, std::memory_order_release);
+        return true;
+    }
+
+    // Producer side: items that can be pushed now (only grows until the next push)
+    size_t writeSpace() const {
+        return Capacity - (tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_acquire));
+    }
+
+    bool pop(T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = buffer_[head & (Capacity - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    alignas(64) std::atomic<size_t> head_;  // Consumer position
+    alignas(64) std::atomic<size_t> tail_;  // Producer position
+    T buffer_[Capacity];
+};
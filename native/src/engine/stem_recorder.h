@@ -0,0 +1,678 @@
+// PC Panel Pro - multitrack stem recorder for a mixer's inputs
+// Shared by the addon and the Linux tools; POSIX file I/O, no other
+// platform dependencies.
+//
+// MixEngine taps every input it mixes: the chunk of input it just read
+// (after sample rate conversion) and the gain ramp it mixed the chunk with.
+// The tap is one memcpy into the input's ring plus a small block
+// descriptor stamped with the chunk's sample time on the bus clock. A
+// single writer thread applies the same ramp the mix applied, so each stem
+// is exactly that input's contribution to the bus before master gain. Time
+// an input contributed nothing (disabled, or its ring ran dry) is written as
+// silence, so the stems stay sample-aligned with each other and the bus.
+//
+// Layouts: one stereo file per input, written with pwritev() where silent
+// spans point at a shared zero page instead of being copied, or one file
+// with every input as an interleaved channel pair. Formats are Float32 WAV
+// and CAF, with the same 4 KiB-aligned headers as BusRecorder.
+
+#pragma once
+
+#include "bus_recorder.h"
+#include "callback_timing.h"
+#include "ring_buffer.h"
+#include "spsc_queue.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+class StemRecorder {
+public:
+    enum class Layout { PerFile, Interleaved };
+    using Format = BusRecorder::Format;
+
+    static constexpr size_t kMaxSlots = 32;                     // MixEngine input slots
+    static constexpr size_t kChannels = 2;                      // Interleaved stereo Float32 per input
+    static constexpr size_t kBytesPerFrame = kChannels * sizeof(float);
+    static constexpr double kRingSeconds = 2.0;                 // Per input; writer stalls this long lose nothing
+    static constexpr size_t kBlockQueueSize = 2048;             // Tapped chunks in flight per input
+    static constexpr size_t kPassFrames = 8192;                 // Frames per file per write pass
+    static constexpr size_t kAlignment = BusRecorder::kAlignment;
+    static constexpr off_t kPreallocateBytes = 16 << 20;        // File space reserved per step
+    static constexpr int kMaxIov = 64;                          // Per pwritev() call
+    static constexpr int kPollMs = 20;                          // Writer wake-up interval
+
+    // One input to record: its MixEngine slot and a name for its file
+    struct Stem {
+        int slot;
+        std::string name;
+    };
+
+    struct Stats {
+        bool recording;
+        uint64_t stems;
+        uint64_t framesWritten;         // Per stem; every stem has the same length
+        uint64_t droppedFrames;         // Tapped audio that didn't fit in a ring, all stems
+        uint64_t bytesWritten;          // Audio bytes, all files
+        double seconds;                 // Since start(), or the whole take once stopped
+        double writeSeconds;            // Spent inside pwrite()/pwritev() calls
+        uint64_t maxWriteNs;            // Slowest single call
+        uint64_t backlogMaxFrames;      // Most the writer was behind the render clock
+    };
+
+    StemRecorder() = default;
+    ~StemRecorder() { stop(); }
+    StemRecorder(const StemRecorder&) = delete;
+    StemRecorder& operator=(const StemRecorder&) = delete;
+
+    static bool parseLayout(const std::string& name, Layout& layout) {
+        if (name == "files") {
+            layout = Layout::PerFile;
+        } else if (name == "interleaved") {
+            layout = Layout::Interleaved;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // ---- Render thread (MixEngine::mix) ----
+
+    void beginCycle() {
+        inCycle_ = false;
+        if (!active_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        // Held for the whole cycle; stop() waits for it like BusRecorder::push
+        pushing_.store(true, std::memory_order_seq_cst);
+        if (!active_.load(std::memory_order_seq_cst)) {
+            pushing_.store(false, std::memory_order_release);
+            return;
+        }
+        // A new take restarts the clock at its first cycle
+        uint64_t generation = generation_.load(std::memory_order_relaxed);
+        if (generation != renderGeneration_) {
+            renderGeneration_ = generation;
+            clock_ = 0;
+        }
+        inCycle_ = true;
+    }
+
+    // One chunk an input added to the bus at offset frames into the cycle,
+    // before gain + gainStep * frame was applied
+    void tap(int slot, size_t offset, const float* samples, size_t frames, float gain, float gainStep) {
+        if (!inCycle_) {
+            return;
+        }
+        Track* track = slotTracks_[slot];
+        if (!track || frames == 0) {
+            return;
+        }
+        size_t written = 0;
+        if (track->blocks.writeSpace() > 0) {
+            written = track->ring->write(samples, frames * kBytesPerFrame) / kBytesPerFrame;
+        }
+        if (written < frames) {
+            track->dropped.store(track->dropped.load(std::memory_order_relaxed) + frames - written,
+                                 std::memory_order_relaxed);
+        }
+        if (written > 0) {
+            track->blocks.push({clock_ + offset, static_cast<uint32_t>(written), gain, gainStep});
+        }
+    }
+
+    void endCycle(size_t frames) {
+        if (!inCycle_) {
+            return;
+        }
+        clock_ += frames;
+        renderedFrames_.store(clock_, std::memory_order_release);
+        inCycle_ = false;
+        pushing_.store(false, std::memory_order_release);
+    }
+
+    // ---- Control thread ----
+
+    // Creates the files in directory and starts the writer
+    bool start(const std::string& directory, const std::vector<Stem>& stems, Layout layout, Format format,
+               double sampleRate, std::string& error) {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        if (writer_.joinable()) {
+            error = "already recording stems to " + directory_;
+            return false;
+        }
+        if (stems.empty()) {
+            error = "no inputs to record";
+            return false;
+        }
+
+        // Neither side is running, so everything can be replaced
+        tracks_.clear();
+        files_.clear();
+        paths_.clear();
+        size_t ringFrames = static_cast<size_t>(sampleRate * kRingSeconds);
+        for (const Stem& stem : stems) {
+            if (stem.slot < 0 || static_cast<size_t>(stem.slot) >= kMaxSlots) {
+                error = "bad input slot " + std::to_string(stem.slot);
+                return false;
+            }
+            auto track = std::make_unique<Track>();
+            track->slot = stem.slot;
+            track->ring = std::make_unique<RingBuffer>(ringFrames, kChannels, kBytesPerFrame);
+            track->staging.assign(kPassFrames * kChannels, 0.0f);
+            tracks_.push_back(std::move(track));
+        }
+
+        const char* extension = format == Format::Wav ? ".wav" : ".caf";
+        if (layout == Layout::PerFile) {
+            for (size_t i = 0; i < stems.size(); i++) {
+                char prefix[24];
+                snprintf(prefix, sizeof(prefix), "%02zu-", i + 1);
+                paths_.push_back(directory + "/" + prefix + fileName(stems[i].name) + extension);
+            }
+        } else {
+            paths_.push_back(directory + "/stems" + extension);
+            interleaved_.assign(kPassFrames * kChannels * stems.size(), 0.0f);
+        }
+        size_t fileChannels = layout == Layout::PerFile ? kChannels : kChannels * stems.size();
+        for (const std::string& path : paths_) {
+            int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0 || !writeHeader(fd, format, sampleRate, fileChannels, 0, false)) {
+                error = "can't create " + path + ": " + strerror(errno);
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+                closeFiles();
+                return false;
+            }
+            files_.push_back({fd, 0});
+        }
+        if (zeros_.empty()) {
+            zeros_.assign(kPassFrames * kBytesPerFrame, 0);
+        }
+
+        directory_ = directory;
+        layout_ = layout;
+        format_ = format;
+        sampleRate_ = sampleRate;
+        fileChannels_ = fileChannels;
+        written_ = 0;
+        lateFrames_ = 0;
+        failed_ = false;
+        {
+            std::lock_guard<std::mutex> status(statusMutex_);
+            writeError_.clear();
+        }
+        stemCount_.store(stems.size(), std::memory_order_relaxed);
+        framesWritten_.store(0, std::memory_order_relaxed);
+        droppedFrames_.store(0, std::memory_order_relaxed);
+        writeNs_.store(0, std::memory_order_relaxed);
+        maxWriteNs_.store(0, std::memory_order_relaxed);
+        backlogMaxFrames_.store(0, std::memory_order_relaxed);
+        startNs_.store(CallbackTiming::now(), std::memory_order_relaxed);
+        stopNs_.store(0, std::memory_order_relaxed);
+
+        slotTracks_.fill(nullptr);
+        for (const auto& track : tracks_) {
+            slotTracks_[track->slot] = track.get();
+        }
+        renderedFrames_.store(0, std::memory_order_relaxed);
+        generation_.store(generation_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        stopRequested_ = false;
+        flushRequested_ = 0;
+        flushDone_ = 0;
+        writer_ = std::thread([this] { run(); });
+        active_.store(true, std::memory_order_seq_cst);
+        return true;
+    }
+
+    // Writes out everything tapped, finalizes the headers and closes the
+    // files. Returns false with the reason if any write failed.
+    bool stop(std::string* error = nullptr) {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        if (!writer_.joinable()) {
+            return true;
+        }
+        active_.store(false, std::memory_order_seq_cst);
+        while (pushing_.load(std::memory_order_seq_cst)) {
+            std::this_thread::yield();
+        }
+        {
+            std::lock_guard<std::mutex> wake(wakeMutex_);
+            stopRequested_ = true;
+        }
+        wakeCondition_.notify_one();
+        writer_.join();
+        slotTracks_.fill(nullptr);
+        stopNs_.store(CallbackTiming::now(), std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> status(statusMutex_);
+        if (!writeError_.empty() && error) {
+            *error = writeError_;
+        }
+        return writeError_.empty();
+    }
+
+    // Waits until everything rendered so far is on disk. For callers that
+    // render faster than real time (offline rendering) and would otherwise
+    // overrun the rings.
+    void flush() {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        if (!writer_.joinable()) {
+            return;
+        }
+        std::unique_lock<std::mutex> wake(wakeMutex_);
+        uint64_t request = ++flushRequested_;
+        wakeCondition_.notify_one();
+        flushedCondition_.wait(wake, [this, request] { return flushDone_ >= request; });
+    }
+
+    bool isRecording() const { return active_.load(std::memory_order_relaxed); }
+
+    // Files of the current take, or the last one once stopped
+    std::vector<std::string> paths() const {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        return paths_;
+    }
+
+    // Any thread
+    Stats stats() const {
+        Stats stats = {};
+        stats.recording = active_.load(std::memory_order_relaxed);
+        uint64_t start = startNs_.load(std::memory_order_relaxed);
+        uint64_t stop = stopNs_.load(std::memory_order_relaxed);
+        if (start == 0) {
+            return stats;
+        }
+        stats.stems = stemCount_.load(std::memory_order_relaxed);
+        stats.framesWritten = framesWritten_.load(std::memory_order_relaxed);
+        stats.droppedFrames = droppedFrames_.load(std::memory_order_relaxed);
+        stats.bytesWritten = stats.framesWritten * kBytesPerFrame * stats.stems;
+        stats.seconds = ((stop != 0 ? stop : CallbackTiming::now()) - start) / 1e9;
+        stats.writeSeconds = writeNs_.load(std::memory_order_relaxed) / 1e9;
+        stats.maxWriteNs = maxWriteNs_.load(std::memory_order_relaxed);
+        stats.backlogMaxFrames = backlogMaxFrames_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    std::string error() const {
+        std::lock_guard<std::mutex> lock(statusMutex_);
+        return writeError_;
+    }
+
+private:
+    // A tapped chunk: frames in the input's ring starting at sampleTime
+    struct Block {
+        uint64_t sampleTime;
+        uint32_t frames;
+        float gain;
+        float gainStep;
+    };
+
+    struct Track {
+        int slot = 0;
+        std::unique_ptr<RingBuffer> ring;
+        SpscQueue<Block, kBlockQueueSize> blocks;
+        std::atomic<uint64_t> dropped{0};       // Render thread
+        // Writer thread
+        std::vector<float> staging;             // One pass, gain applied
+        Block pending = {};                     // Popped, not all written yet
+        uint32_t pendingDone = 0;
+        bool hasPending = false;
+    };
+
+    struct File {
+        int fd;
+        off_t preallocatedEnd;
+    };
+
+    // A run of tapped frames in a track's staging, in pass-relative frames
+    struct Span {
+        size_t start;
+        size_t frames;
+    };
+
+    // ---- Writer thread ----
+
+    void run() {
+        uint64_t flushed = 0;
+        for (;;) {
+            bool stopping;
+            uint64_t request;
+            {
+                std::unique_lock<std::mutex> wake(wakeMutex_);
+                wakeCondition_.wait_for(wake, std::chrono::milliseconds(kPollMs),
+                                        [this, flushed] { return stopRequested_ || flushRequested_ > flushed; });
+                stopping = stopRequested_;
+                request = flushRequested_;
+            }
+            // Only whole passes while running; the remainder once stopping or flushing
+            drain(stopping || request > flushed);
+            if (request > flushed) {
+                flushed = request;
+                {
+                    std::lock_guard<std::mutex> wake(wakeMutex_);
+                    flushDone_ = flushed;
+                }
+                flushedCondition_.notify_all();
+            }
+            if (stopping) {
+                break;
+            }
+        }
+        finish();
+    }
+
+    void drain(bool all) {
+        // Blocks are pushed before the cycle's end is published, so every
+        // block before end is in its queue
+        uint64_t end = renderedFrames_.load(std::memory_order_acquire);
+        uint64_t backlog = end - written_;
+        if (backlog > backlogMaxFrames_.load(std::memory_order_relaxed)) {
+            backlogMaxFrames_.store(backlog, std::memory_order_relaxed);
+        }
+        while (end - written_ >= kPassFrames || (all && end > written_)) {
+            uint64_t passEnd = std::min<uint64_t>(end, written_ + kPassFrames);
+            writePass(written_, passEnd);
+            written_ = passEnd;
+        }
+        uint64_t dropped = lateFrames_;
+        for (const auto& track : tracks_) {
+            dropped += track->dropped.load(std::memory_order_relaxed);
+        }
+        droppedFrames_.store(dropped, std::memory_order_relaxed);
+    }
+
+    // Frames [from, to) of every stem
+    void writePass(uint64_t from, uint64_t to) {
+        size_t frames = static_cast<size_t>(to - from);
+        uint64_t fileBytes = to * fileChannels_ * sizeof(float);
+        if (!failed_ && format_ == Format::Wav && fileBytes > BusRecorder::kMaxWavDataBytes) {
+            setError("WAV size limit reached; record stems to CAF for longer takes");
+            failed_ = true;
+        }
+
+        for (size_t t = 0; t < tracks_.size(); t++) {
+            Track& track = *tracks_[t];
+            gather(track, from, to);
+            if (failed_) {
+                continue;       // Still drained, so the rings keep moving
+            }
+            if (layout_ == Layout::PerFile) {
+                writeSpans(files_[t], track, from, frames);
+            } else {
+                // Interleave input t into channels 2t, 2t+1; silence where nothing was tapped
+                size_t stride = kChannels * tracks_.size();
+                fillGaps(track, frames);
+                for (size_t i = 0; i < frames; i++) {
+                    interleaved_[i * stride + t * kChannels] = track.staging[i * kChannels];
+                    interleaved_[i * stride + t * kChannels + 1] = track.staging[i * kChannels + 1];
+                }
+            }
+        }
+        if (!failed_ && layout_ == Layout::Interleaved) {
+            size_t bytesPerFrame = kBytesPerFrame * tracks_.size();
+            iovec vector = {interleaved_.data(), frames * bytesPerFrame};
+            writeVectors(files_[0], &vector, 1, static_cast<off_t>(kAlignment + from * bytesPerFrame));
+        }
+        if (!failed_) {
+            framesWritten_.store(to, std::memory_order_relaxed);
+        }
+    }
+
+    // Pops the track's blocks that start before `to` into staging with their
+    // gain ramp applied; spans_ lists where they landed
+    void gather(Track& track, uint64_t from, uint64_t to) {
+        spans_.clear();
+        for (;;) {
+            if (!track.hasPending) {
+                if (!track.blocks.pop(track.pending)) {
+                    break;
+                }
+                track.hasPending = true;
+                track.pendingDone = 0;
+            }
+            const Block& block = track.pending;
+            uint64_t start = block.sampleTime + track.pendingDone;
+            if (start >= to) {
+                break;          // A later pass
+            }
+            size_t frames = static_cast<size_t>(std::min<uint64_t>(block.frames - track.pendingDone, to - start));
+            float* out = track.staging.data();
+            if (start < from) {
+                // Behind the written position (never expected): consume and drop
+                frames = static_cast<size_t>(std::min<uint64_t>(frames, from - start));
+                track.ring->read(out, frames * kBytesPerFrame);
+                lateFrames_ += frames;
+            } else {
+                size_t at = static_cast<size_t>(start - from);
+                out += at * kChannels;
+                track.ring->read(out, frames * kBytesPerFrame);
+                // The same expression mixAccumulate scales the input by
+                for (size_t i = 0; i < frames; i++) {
+                    float frameGain = block.gain + block.gainStep * static_cast<float>(track.pendingDone + i);
+                    for (size_t ch = 0; ch < kChannels; ch++) {
+                        out[i * kChannels + ch] *= frameGain;
+                    }
+                }
+                if (!spans_.empty() && spans_.back().start + spans_.back().frames == at) {
+                    spans_.back().frames += frames;
+                } else {
+                    spans_.push_back({at, frames});
+                }
+            }
+            track.pendingDone += static_cast<uint32_t>(frames);
+            if (track.pendingDone == block.frames) {
+                track.hasPending = false;
+            }
+        }
+    }
+
+    // Zeroes the parts of staging that gather() didn't fill
+    void fillGaps(Track& track, size_t frames) {
+        size_t position = 0;
+        for (const Span& span : spans_) {
+            std::fill(track.staging.begin() + position * kChannels, track.staging.begin() + span.start * kChannels, 0.0f);
+            position = span.start + span.frames;
+        }
+        std::fill(track.staging.begin() + position * kChannels, track.staging.begin() + frames * kChannels, 0.0f);
+    }
+
+    // One stem file: tapped spans from staging, gaps from the zero page
+    void writeSpans(File& file, Track& track, uint64_t from, size_t frames) {
+        vectors_.clear();
+        size_t position = 0;
+        auto silence = [this](size_t count) {
+            if (count > 0) {
+                vectors_.push_back({zeros_.data(), count * kBytesPerFrame});
+            }
+        };
+        for (const Span& span : spans_) {
+            silence(span.start - position);
+            vectors_.push_back({track.staging.data() + span.start * kChannels, span.frames * kBytesPerFrame});
+            position = span.start + span.frames;
+        }
+        silence(frames - position);
+        writeVectors(file, vectors_.data(), vectors_.size(), static_cast<off_t>(kAlignment + from * kBytesPerFrame));
+    }
+
+    // pwritev() is macOS 11+ and weak-linked under the 10.15 deployment
+    // target; older systems get one pwrite() per vector, stopping at the
+    // first short write so the caller resumes from there
+    static ssize_t writeAt(int fd, const iovec* vectors, int count, off_t offset) {
+#if defined(__APPLE__)
+        if (__builtin_available(macOS 11.0, *)) {
+            return pwritev(fd, vectors, count, offset);
+        }
+        ssize_t total = 0;
+        for (int i = 0; i < count; i++) {
+            ssize_t written = pwrite(fd, vectors[i].iov_base, vectors[i].iov_len, offset + total);
+            if (written < 0) {
+                return total > 0 ? total : written;
+            }
+            total += written;
+            if (static_cast<size_t>(written) < vectors[i].iov_len) {
+                break;
+            }
+        }
+        return total;
+#else
+        return pwritev(fd, vectors, count, offset);
+#endif
+    }
+
+    // pwritev() in kMaxIov batches, resuming after short writes
+    void writeVectors(File& file, iovec* vectors, size_t count, off_t offset) {
+        size_t total = 0;
+        for (size_t i = 0; i < count; i++) {
+            total += vectors[i].iov_len;
+        }
+        if (offset + static_cast<off_t>(total) > file.preallocatedEnd) {
+            BusRecorder::preallocate(file.fd, offset, kPreallocateBytes);
+            file.preallocatedEnd = offset + kPreallocateBytes;
+        }
+
+        uint64_t start = CallbackTiming::now();
+        while (count > 0) {
+            ssize_t written = writeAt(file.fd, vectors, static_cast<int>(std::min<size_t>(count, kMaxIov)), offset);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                setError(std::string("write failed: ") + strerror(errno));
+                failed_ = true;
+                break;
+            }
+            offset += written;
+            size_t remaining = static_cast<size_t>(written);
+            while (count > 0 && remaining >= vectors->iov_len) {
+                remaining -= vectors->iov_len;
+                vectors++;
+                count--;
+            }
+            if (count > 0 && remaining > 0) {
+                vectors->iov_base = static_cast<uint8_t*>(vectors->iov_base) + remaining;
+                vectors->iov_len -= remaining;
+            }
+        }
+        uint64_t elapsed = CallbackTiming::now() - start;
+        writeNs_.store(writeNs_.load(std::memory_order_relaxed) + elapsed, std::memory_order_relaxed);
+        if (elapsed > maxWriteNs_.load(std::memory_order_relaxed)) {
+            maxWriteNs_.store(elapsed, std::memory_order_relaxed);
+        }
+    }
+
+    // Final sizes into the headers, give back the unused reservations, close
+    void finish() {
+        uint64_t frames = framesWritten_.load(std::memory_order_relaxed);
+        uint64_t dataBytes = frames * fileChannels_ * sizeof(float);
+        for (const File& file : files_) {
+            if (!writeHeader(file.fd, format_, sampleRate_, fileChannels_, dataBytes, true)
+                || ftruncate(file.fd, static_cast<off_t>(kAlignment + dataBytes)) != 0) {
+                setError(std::string("can't finalize file: ") + strerror(errno));
+            }
+        }
+        closeFiles();
+    }
+
+    void closeFiles() {
+        for (const File& file : files_) {
+            if (::close(file.fd) != 0) {
+                setError(std::string("close failed: ") + strerror(errno));
+            }
+        }
+        files_.clear();
+    }
+
+    static bool writeHeader(int fd, Format format, double sampleRate, size_t channels, uint64_t dataBytes,
+                            bool final) {
+        uint8_t header[kAlignment];
+        BusRecorder::buildHeader(header, format, sampleRate, channels, dataBytes, final);
+        return pwrite(fd, header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+    }
+
+    // Input names are user-editable; keep them to one path component
+    static std::string fileName(const std::string& name) {
+        std::string result = name.empty() ? "input" : name;
+        for (char& c : result) {
+            if (c == '/' || c == '\\' || c == ':') {
+                c = '_';
+            }
+        }
+        return result;
+    }
+
+    void setError(const std::string& message) {
+        std::lock_guard<std::mutex> lock(statusMutex_);
+        if (writeError_.empty()) {
+            writeError_ = message;
+        }
+    }
+
+    // Render thread and control thread
+    std::atomic<bool> active_{false};
+    std::atomic<bool> pushing_{false};
+    std::atomic<uint64_t> generation_{0};           // Bumped per take
+    std::atomic<uint64_t> renderedFrames_{0};       // Bus clock at the last finished cycle
+    std::array<Track*, kMaxSlots> slotTracks_{};    // Set before active_, cleared after stop
+
+    // Render thread
+    bool inCycle_ = false;
+    uint64_t renderGeneration_ = 0;
+    uint64_t clock_ = 0;
+
+    // Writer thread, set up by start()
+    std::vector<std::unique_ptr<Track>> tracks_;
+    std::vector<File> files_;
+    Layout layout_ = Layout::PerFile;
+    Format format_ = Format::Wav;
+    double sampleRate_ = 48000.0;
+    size_t fileChannels_ = kChannels;
+    uint64_t written_ = 0;
+    uint64_t lateFrames_ = 0;
+    bool failed_ = false;
+    std::vector<float> interleaved_;
+    std::vector<uint8_t> zeros_;
+    std::vector<Span> spans_;
+    std::vector<iovec> vectors_;
+
+    // Published by the writer for stats()
+    std::atomic<uint64_t> stemCount_{0};
+    std::atomic<uint64_t> framesWritten_{0};
+    std::atomic<uint64_t> droppedFrames_{0};
+    std::atomic<uint64_t> writeNs_{0};
+    std::atomic<uint64_t> maxWriteNs_{0};
+    std::atomic<uint64_t> backlogMaxFrames_{0};
+    std::atomic<uint64_t> startNs_{0};
+    std::atomic<uint64_t> stopNs_{0};
+
+    std::thread writer_;
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCondition_;
+    std::condition_variable flushedCondition_;
+    bool stopRequested_ = false;
+    uint64_t flushRequested_ = 0;
+    uint64_t flushDone_ = 0;
+
+    mutable std::mutex controlMutex_;       // start/stop and paths_
+    mutable std::mutex statusMutex_;        // writeError_
+    std::string directory_;
+    std::vector<std::string> paths_;
+    std::string writeError_;
+};
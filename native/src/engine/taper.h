@@ -0,0 +1,111 @@
+// PC Panel Pro - volume taper tables
+// Raw 8-bit control value -> linear gain. Shared by the addon and the Linux
+// tools; no platform dependencies.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+enum class TaperCurve : uint8_t { Linear, DbLinear, Audio, Custom };
+
+constexpr size_t kTaperSize = 256;
+constexpr double kTaperFloorDb = -60.0;   // DbLinear: value 1 sits here, value 0 is silence
+
+using TaperTable = std::array<float, kTaperSize>;
+
+// std::exp isn't constexpr; halve until small, Taylor series, square back up
+constexpr double constexprExp(double x) {
+    if (x > 0.5 || x < -0.5) {
+        double half = constexprExp(x / 2.0);
+        return half * half;
+    }
+    double term = 1.0;
+    double sum = 1.0;
+    for (int i = 1; i < 16; i++) {
+        term *= x / i;
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double dbToGain(double db) {
+    return constexprExp(db * 0.11512925464970229);  // ln(10) / 20
+}
+
+constexpr TaperTable makeLinearTaper() {
+    TaperTable table = {};
+    for (size_t i = 0; i < kTaperSize; i++) {
+        table[i] = static_cast<float>(static_cast<double>(i) / (kTaperSize - 1));
+    }
+    return table;
+}
+
+// Equal dB per step from kTaperFloorDb to 0 dB
+constexpr TaperTable makeDbLinearTaper() {
+    TaperTable table = {};
+    for (size_t i = 1; i < kTaperSize; i++) {
+        double position = static_cast<double>(i - 1) / (kTaperSize - 2);
+        table[i] = static_cast<float>(dbToGain(kTaperFloorDb * (1.0 - position)));
+    }
+    table[kTaperSize - 1] = 1.0f;
+    return table;
+}
+
+// Log-pot ("A") taper: 10% gain (-20 dB) at half travel, straight segments
+// either side like a two-slope potentiometer
+constexpr TaperTable makeAudioTaper() {
+    TaperTable table = {};
+    for (size_t i = 0; i < kTaperSize; i++) {
+        double position = static_cast<double>(i) / (kTaperSize - 1);
+        double gain = position < 0.5 ? position * 0.2 : 0.1 + (position - 0.5) * 1.8;
+        table[i] = static_cast<float>(gain);
+    }
+    return table;
+}
+
+constexpr TaperTable kLinearTaper = makeLinearTaper();
+constexpr TaperTable kDbLinearTaper = makeDbLinearTaper();
+constexpr TaperTable kAudioTaper = makeAudioTaper();
+
+static_assert(kDbLinearTaper[0] == 0.0f && kDbLinearTaper[255] == 1.0f, "dB taper endpoints");
+static_assert(kAudioTaper[0] == 0.0f && kAudioTaper[255] == 1.0f, "Audio taper endpoints");
+
+// Custom curves are sampled points (gain at evenly spaced positions, at
+// least two) linearly interpolated out to a full table
+inline TaperTable buildCustomTaper(const std::vector<float>& points) {
+    TaperTable table = kLinearTaper;
+    if (points.size() < 2) {
+        return table;
+    }
+    double segments = static_cast<double>(points.size() - 1);
+    for (size_t i = 0; i < kTaperSize; i++) {
+        double x = static_cast<double>(i) / (kTaperSize - 1) * segments;
+        size_t left = std::min(static_cast<size_t>(x), points.size() - 2);
+        double frac = x - static_cast<double>(left);
+        double gain = points[left] + (points[left + 1] - points[left]) * frac;
+        table[i] = static_cast<float>(std::max(0.0, std::min(1.0, gain)));
+    }
+    return table;
+}
+
+inline const TaperTable& taperTable(TaperCurve curve) {
+    switch (curve) {
+        case TaperCurve::DbLinear: return kDbLinearTaper;
+        case TaperCurve::Audio: return kAudioTaper;
+        default: return kLinearTaper;
+    }
+}
+
+// 'linear' | 'db' | 'audio' | 'custom'; unknown names fall back to linear
+inline TaperCurve taperCurveFromName(const std::string& name) {
+    if (name == "db") return TaperCurve::DbLinear;
+    if (name == "audio") return TaperCurve::Audio;
+    if (name == "custom") return TaperCurve::Custom;
+    return TaperCurve::Linear;
+}
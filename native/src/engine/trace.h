@@ -0,0 +1,308 @@
+// PC Panel Pro - real-time event trace with Chrome trace JSON export
+// Shared by the addon, the driver and the Linux tools; no platform
+// dependencies beyond the monotonic clock.
+//
+// trace::Scope, trace::counter and trace::instant record into a buffer owned
+// by the calling thread. While tracing is off (the default) each is a single
+// relaxed load. While it is on, each is a clock read, a few stores and an
+// uncontended increment of the buffer's writer count: the buffers come from
+// a pool that start() allocates, and a thread claims one with a single
+// fetch_add the first time it records, so audio threads never allocate or
+// lock. A thread that finds every slot taken records nothing; overflow()
+// counts those threads and their events, and the export notes them.
+// writeChromeJson() turns the buffers into Chrome trace JSON, which Perfetto
+// and chrome://tracing open directly.
+
+#pragma once
+
+#include "callback_timing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace trace {
+
+enum class Phase : uint8_t { Begin, End, Counter, Instant };
+
+struct Event {
+    uint64_t timeNs;
+    const char* name;       // String literal; never copied
+    double value;           // Counter value, or the instant's argument
+    int32_t id;             // Distinguishes rings, inputs etc.; -1 for none
+    Phase phase;
+};
+
+constexpr size_t kMaxThreads = 16;
+constexpr size_t kDefaultEventsPerThread = 1 << 15;
+
+namespace detail {
+
+// One thread's events; the oldest are overwritten once it is full
+struct ThreadBuffer {
+    std::unique_ptr<Event[]> events;
+    size_t capacity = 0;
+    std::atomic<size_t> written{0};         // Total recorded since start()
+    std::atomic<uint32_t> writers{0};       // record() calls inside this buffer right now
+};
+
+struct ThreadSlot {
+    uint32_t generation;
+    ThreadBuffer* buffer;
+};
+
+inline std::atomic<bool> enabled{false};
+inline std::atomic<uint32_t> generation{0};     // Bumped by start(); threads reclaim a slot
+inline std::atomic<size_t> threadsClaimed{0};    // Claims made, including those past kMaxThreads
+inline std::atomic<size_t> droppedEvents{0};     // Recorded by threads without a slot
+inline ThreadBuffer buffers[kMaxThreads];
+inline thread_local ThreadSlot threadSlot{0, nullptr};
+inline std::atomic<int32_t> lastId{0};
+
+// Control-thread state: labels for ids, and start/stop/export serialization
+inline std::mutex controlMutex;
+inline std::map<int32_t, std::string> labels;
+
+inline ThreadBuffer* threadBuffer(uint32_t current) {
+    if (threadSlot.generation != current) {
+        size_t index = threadsClaimed.fetch_add(1, std::memory_order_relaxed);
+        threadSlot.buffer = index < kMaxThreads ? &buffers[index] : nullptr;
+        threadSlot.generation = current;
+    }
+    return threadSlot.buffer;
+}
+
+// The writers count lets start() wait out a thread that checked enabled()
+// just before tracing was restarted. A write that finds tracing off, or a
+// newer session than the slot it claimed, is dropped.
+inline void record(Phase phase, const char* name, double value, int32_t id) {
+    uint32_t current = generation.load(std::memory_order_acquire);
+    ThreadBuffer* buffer = threadBuffer(current);
+    if (!buffer) {
+        droppedEvents.fetch_add(1, std::memory_order_relaxed);     // More threads than slots
+        return;
+    }
+    buffer->writers.fetch_add(1, std::memory_order_seq_cst);
+    if (enabled.load(std::memory_order_seq_cst) && generation.load(std::memory_order_acquire) == current
+        && buffer->capacity > 0) {
+        size_t index = buffer->written.load(std::memory_order_relaxed);
+        buffer->events[index % buffer->capacity] = {CallbackTiming::now(), name, value, id, phase};
+        buffer->written.store(index + 1, std::memory_order_release);
+    }
+    buffer->writers.fetch_sub(1, std::memory_order_release);
+}
+
+// Spins until no record() is inside any buffer. Once tracing is off, a
+// record() that starts afterwards sees it off and writes nothing.
+inline void waitForWriters() {
+    for (ThreadBuffer& buffer : buffers) {
+        while (buffer.writers.load(std::memory_order_seq_cst) != 0) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+}  // namespace detail
+
+// Hands out ids for label(); any thread
+inline int32_t nextId() {
+    return detail::lastId.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline bool enabled() {
+    return detail::enabled.load(std::memory_order_relaxed);
+}
+
+// ---- Any thread, including audio threads ----
+
+inline void counter(const char* name, double value, int32_t id = -1) {
+    if (enabled()) {
+        detail::record(Phase::Counter, name, value, id);
+    }
+}
+
+inline void instant(const char* name, double value = 0, int32_t id = -1) {
+    if (enabled()) {
+        detail::record(Phase::Instant, name, value, id);
+    }
+}
+
+// A slice on this thread's track, e.g. one IOProc call
+class Scope {
+public:
+    explicit Scope(const char* name, int32_t id = -1) : name_(nullptr), id_(id) {
+        if (enabled()) {
+            name_ = name;
+            detail::record(Phase::Begin, name_, 0, id_);
+        }
+    }
+    ~Scope() {
+        if (name_) {
+            detail::record(Phase::End, name_, 0, id_);
+        }
+    }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* name_;
+    int32_t id_;
+};
+
+// ---- Control threads ----
+
+// Shown instead of the bare id in the export
+inline void label(int32_t id, const std::string& text) {
+    std::lock_guard<std::mutex> lock(detail::controlMutex);
+    detail::labels[id] = text;
+}
+
+// Starts a new trace, discarding the previous one. Waits for any record()
+// still in flight, then (re)allocates the pool if eventsPerThread changed.
+inline void start(size_t eventsPerThread = kDefaultEventsPerThread) {
+    std::lock_guard<std::mutex> lock(detail::controlMutex);
+    detail::enabled.store(false, std::memory_order_seq_cst);
+    detail::waitForWriters();
+    for (detail::ThreadBuffer& buffer : detail::buffers) {
+        if (buffer.capacity != eventsPerThread) {
+            buffer.events.reset(new Event[eventsPerThread]);
+            buffer.capacity = eventsPerThread;
+        }
+        buffer.written.store(0, std::memory_order_relaxed);
+    }
+    detail::threadsClaimed.store(0, std::memory_order_relaxed);
+    detail::droppedEvents.store(0, std::memory_order_relaxed);
+    detail::generation.fetch_add(1, std::memory_order_release);
+    detail::enabled.store(true, std::memory_order_release);
+}
+
+inline void stop() {
+    detail::enabled.store(false, std::memory_order_seq_cst);
+}
+
+struct Overflow {
+    size_t threads;     // Threads that recorded after every slot was taken
+    size_t events;      // Events those threads lost
+};
+
+// Since start()
+inline Overflow overflow() {
+    size_t claimed = detail::threadsClaimed.load(std::memory_order_relaxed);
+    return {claimed > kMaxThreads ? claimed - kMaxThreads : 0,
+            detail::droppedEvents.load(std::memory_order_relaxed)};
+}
+
+// Writes everything recorded since start() (call stop() first for a clean
+// cut). Each thread is a track named after the first slice it recorded.
+// Threads that had no slot are reported in a trace_overflow metadata event.
+inline bool writeChromeJson(const std::string& path, size_t& eventCount, std::string& error) {
+    std::lock_guard<std::mutex> lock(detail::controlMutex);
+    eventCount = 0;
+
+    // Let a record() that was already past its enabled check finish its event
+    detail::waitForWriters();
+
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        error = "can't write " + path;
+        return false;
+    }
+
+    size_t threads = std::min(detail::threadsClaimed.load(std::memory_order_relaxed), kMaxThreads);
+
+    // Timestamps relative to the earliest surviving event
+    uint64_t origin = UINT64_MAX;
+    for (size_t t = 0; t < threads; t++) {
+        const detail::ThreadBuffer& buffer = detail::buffers[t];
+        size_t written = buffer.written.load(std::memory_order_acquire);
+        if (written > 0 && buffer.capacity > 0) {
+            size_t first = written > buffer.capacity ? written - buffer.capacity : 0;
+            origin = std::min(origin, buffer.events[first % buffer.capacity].timeNs);
+        }
+    }
+
+    auto eventName = [](const Event& event) {
+        std::string name = event.name;
+        if (event.id >= 0) {
+            auto found = detail::labels.find(event.id);
+            name += found != detail::labels.end() ? " " + found->second : " " + std::to_string(event.id);
+        }
+        std::string escaped;
+        for (char c : name) {
+            if (c == '"' || c == '\\') escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    };
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    const char* separator = "";
+
+    Overflow lost = overflow();
+    if (lost.threads > 0) {
+        fprintf(file, "{\"name\":\"trace_overflow\",\"ph\":\"M\",\"pid\":1,"
+                "\"args\":{\"threadsWithoutSlot\":%zu,\"droppedEvents\":%zu,\"maxThreads\":%zu}}",
+                lost.threads, lost.events, kMaxThreads);
+        separator = ",\n";
+    }
+    for (size_t t = 0; t < threads; t++) {
+        const detail::ThreadBuffer& buffer = detail::buffers[t];
+        size_t written = buffer.written.load(std::memory_order_acquire);
+        if (written == 0 || buffer.capacity == 0) {
+            continue;
+        }
+        size_t first = written > buffer.capacity ? written - buffer.capacity : 0;
+        int tid = static_cast<int>(t + 1);
+
+        std::string threadName = "thread " + std::to_string(tid);
+        for (size_t i = first; i < written; i++) {
+            const Event& event = buffer.events[i % buffer.capacity];
+            if (event.phase == Phase::Begin) {
+                threadName = event.name;
+                break;
+            }
+        }
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                separator, tid, threadName.c_str());
+        separator = ",\n";
+
+        for (size_t i = first; i < written; i++) {
+            const Event& event = buffer.events[i % buffer.capacity];
+            double us = (event.timeNs - origin) / 1000.0;
+            std::string name = eventName(event);
+            switch (event.phase) {
+                case Phase::Begin:
+                case Phase::End:
+                    fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}", separator,
+                            name.c_str(), event.phase == Phase::Begin ? 'B' : 'E', us, tid);
+                    break;
+                case Phase::Counter:
+                    fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%d,"
+                            "\"args\":{\"value\":%.9g}}", separator, name.c_str(), us, tid, event.value);
+                    break;
+                case Phase::Instant:
+                    fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%d,"
+                            "\"args\":{\"value\":%.9g}}", separator, name.c_str(), us, tid, event.value);
+                    break;
+            }
+            eventCount++;
+        }
+    }
+    fprintf(file, "\n]}\n");
+
+    bool ok = !ferror(file);
+    if (fclose(file) != 0 || !ok) {
+        error = "error writing " + path;
+        return false;
+    }
+    return true;
+}
+
+}  // namespace trace
@@ -0,0 +1,424 @@
+// PC Panel Pro - audio hot path microbenchmarks
+// Times every per-buffer operation of the render path in isolation: the
+// capture and loopback rings, sample rate conversion per rate pair, the mix
+// accumulate loop, meters, the per-input compressor at 48 and 96 kHz, master
+// gain + clipping and a whole MixEngine cycle with and without compressors.
+// Each runs over a grid of buffer sizes and channel counts and reports
+// ns/frame and bytes/sec, Google Benchmark style, with no dependencies
+// beyond the engine headers. --perf adds hardware counters per frame for
+// the measured batch (Linux): cycles, IPC, cache and branch misses.
+//
+// Usage: engine_bench [--filter=SUBSTR] [--frames=64,256,...]
+//                     [--channels=1,2,...] [--min-time=SECONDS] [--perf]
+
+#include "engine/compressor.h"
+#include "engine/mix_engine.h"
+#include "engine/mix_kernels.h"
+#include "engine/ring_buffer.h"
+#include "engine/sample_rate_converter.h"
+#include "LoopbackBuffer.hpp"
+#include "perf_counters.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// =============================================================================
+// Harness
+// =============================================================================
+
+// Keep the optimizer from discarding results it can prove unused
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct BenchArgs {
+    size_t frames;
+    size_t channels;
+};
+
+// What one iteration does, set up once per argument pair
+struct BenchCase {
+    std::function<void()> run;
+    size_t bytesPerIteration;       // Payload bytes the operation moves
+};
+
+struct Benchmark {
+    std::string name;
+    std::function<BenchCase(const BenchArgs&)> setUp;
+    std::vector<size_t> channelCounts;  // Empty = every requested count
+};
+
+struct BenchResult {
+    size_t iterations;
+    double seconds;
+    perf::Sample counters;          // Over the measured batch, if counters are open
+};
+
+static BenchResult timeCase(const BenchCase& benchCase, double minTime, const perf::CounterGroup& counters) {
+    using Clock = std::chrono::steady_clock;
+    benchCase.run();  // Warm caches and lazy allocations
+
+    // Grow the iteration count until a batch takes a measurable slice of
+    // minTime, then size one final batch to fill it
+    size_t iterations = 1;
+    for (;;) {
+        perf::Sample before;
+        counters.read(before);
+        auto start = Clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            benchCase.run();
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (seconds >= minTime) {
+            BenchResult result = {iterations, seconds, {}};
+            if (counters.read(result.counters)) {
+                for (int c = 0; c < perf::kCounterCount; c++) {
+                    result.counters.values[c] -= before.values[c];
+                }
+            }
+            return result;
+        }
+        double scale = seconds > 0 ? minTime * 1.2 / seconds : 10.0;
+        iterations = static_cast<size_t>(iterations * std::min(10.0, std::max(2.0, scale)));
+    }
+}
+
+static std::vector<float> noise(size_t count, float amplitude, uint32_t seed = 1) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-amplitude, amplitude);
+    std::vector<float> samples(count);
+    for (float& sample : samples) {
+        sample = dist(rng);
+    }
+    return samples;
+}
+
+// =============================================================================
+// Benchmarks
+// =============================================================================
+
+static constexpr double kRatePairs[][2] = {
+    {44100, 48000}, {48000, 44100}, {96000, 48000}, {48000, 96000}, {88200, 48000}, {32000, 48000},
+};
+
+static std::vector<Benchmark> registerBenchmarks() {
+    std::vector<Benchmark> benchmarks;
+
+    // Reference point for the copy-bound cases below
+    benchmarks.push_back({"Baseline/memcpy", [](const BenchArgs& args) {
+        size_t bytes = args.frames * args.channels * sizeof(float);
+        auto src = std::make_shared<std::vector<float>>(noise(args.frames * args.channels, 1.0f));
+        auto dst = std::make_shared<std::vector<float>>(src->size());
+        return BenchCase{[=] {
+            memcpy(dst->data(), src->data(), bytes);
+            doNotOptimize(dst->data());
+        }, bytes};
+    }, {}});
+
+    // One input callback's write plus the output callback's read of it
+    benchmarks.push_back({"RingBuffer/write+read", [](const BenchArgs& args) {
+        size_t bytes = args.frames * args.channels * sizeof(float);
+        auto ring = std::make_shared<RingBuffer>(48000 * 10, static_cast<uint32_t>(args.channels),
+                                                 static_cast<uint32_t>(args.channels * sizeof(float)));
+        auto src = std::make_shared<std::vector<float>>(noise(args.frames * args.channels, 1.0f));
+        auto dst = std::make_shared<std::vector<float>>(src->size());
+        return BenchCase{[=] {
+            ring->write(src->data(), bytes);
+            doNotOptimize(ring->read(dst->data(), bytes));
+        }, bytes};
+    }, {}});
+
+    // Same for the driver's loopback (fixed layout; channels only set the size)
+    benchmarks.push_back({"LoopbackBuffer/write+read", [](const BenchArgs& args) {
+        size_t bytes = args.frames * args.channels * sizeof(float);
+        auto loopback = std::make_shared<LoopbackBuffer>();
+        auto src = std::make_shared<std::vector<float>>(noise(args.frames * args.channels, 1.0f));
+        auto dst = std::make_shared<std::vector<float>>(src->size());
+        return BenchCase{[=] {
+            loopback->write(src->data(), bytes);
+            doNotOptimize(loopback->read(dst->data(), bytes));
+        }, bytes};
+    }, {}});
+
+    // Output-sized conversion fed the way MixEngine::mix feeds it
+    for (const auto& pair : kRatePairs) {
+        double inRate = pair[0];
+        double outRate = pair[1];
+        char name[64];
+        snprintf(name, sizeof(name), "SRC/%.0f->%.0f", inRate, outRate);
+        benchmarks.push_back({name, [=](const BenchArgs& args) {
+            size_t inFrames = static_cast<size_t>(args.frames * inRate / outRate) + 2;
+            auto converter = std::make_shared<SampleRateConverter>(inRate, outRate, static_cast<int>(args.channels));
+            auto src = std::make_shared<std::vector<float>>(noise(inFrames * args.channels, 1.0f));
+            auto dst = std::make_shared<std::vector<float>>(args.frames * args.channels);
+            return BenchCase{[=] {
+                size_t needed = converter->inputFramesFor(args.frames);
+                doNotOptimize(converter->convert(src->data(), needed, dst->data(), args.frames));
+            }, args.frames * args.channels * sizeof(float)};
+        }, {}});
+    }
+
+    // One input's contribution to the bus, with a gain ramp in progress
+    benchmarks.push_back({"Mix/accumulate", [](const BenchArgs& args) {
+        auto src = std::make_shared<std::vector<float>>(noise(args.frames * args.channels, 0.5f));
+        auto dst = std::make_shared<std::vector<float>>(src->size(), 0.0f);
+        float step = 0.5f / static_cast<float>(args.frames);
+        return BenchCase{[=] {
+            mixAccumulate(dst->data(), src->data(), args.frames, args.channels, 0.25f, step);
+            doNotOptimize(dst->data());
+        }, args.frames * args.channels * sizeof(float)};
+    }, {}});
+
+    // Input callback metering
+    benchmarks.push_back({"Meter/peak+rms", [](const BenchArgs& args) {
+        auto src = std::make_shared<std::vector<float>>(noise(args.frames * args.channels, 1.0f));
+        return BenchCase{[=] {
+            Levels levels = measureLevels(src->data(), src->size());
+            doNotOptimize(levels);
+        }, args.frames * args.channels * sizeof(float)};
+    }, {}});
+
+    // Compressor detection kernels alone, one block at a time
+    benchmarks.push_back({"Detect/peak", [](const BenchArgs& args) {
+        auto src = std::make_shared<std::vector<float>>(noise(args.frames * args.channels, 1.0f));
+        return BenchCase{[=] {
+            doNotOptimize(blockPeak(src->data(), src->size()));
+        }, args.frames * args.channels * sizeof(float)};
+    }, {}});
+
+    benchmarks.push_back({"Detect/mean square", [](const BenchArgs& args) {
+        auto src = std::make_shared<std::vector<float>>(noise(args.frames * args.channels, 1.0f));
+        return BenchCase{[=] {
+            doNotOptimize(blockMeanSquare(src->data(), src->size()));
+        }, args.frames * args.channels * sizeof(float)};
+    }, {}});
+
+    // One input's compressor over one buffer, held in gain reduction. The
+    // rate only changes the time constants, so per-frame cost should match
+    // at 48 and 96 kHz; a 96 kHz device just runs twice the frames.
+    // Refilled each iteration; subtract Baseline/memcpy for the compressor.
+    for (double rate : {48000.0, 96000.0}) {
+        for (CompressorDetector detector : {CompressorDetector::Peak, CompressorDetector::Rms}) {
+            char name[64];
+            snprintf(name, sizeof(name), "Compressor/%s %.0fk", detector == CompressorDetector::Rms ? "rms" : "peak",
+                     rate / 1000);
+            benchmarks.push_back({name, [=](const BenchArgs& args) {
+                CompressorSettings settings;
+                settings.enabled = true;
+                settings.detector = detector;
+                auto compressor = std::make_shared<Compressor>();
+                compressor->configure(settings, rate);
+                compressor->reset();
+                auto src = std::make_shared<std::vector<float>>(noise(args.frames * args.channels, 0.5f));
+                auto dst = std::make_shared<std::vector<float>>(src->size());
+                return BenchCase{[=] {
+                    memcpy(dst->data(), src->data(), src->size() * sizeof(float));
+                    compressor->process(dst->data(), args.frames, args.channels);
+                    doNotOptimize(dst->data());
+                }, args.frames * args.channels * sizeof(float)};
+            }, {}});
+        }
+    }
+
+    // Master gain + clip on a bus where a third of the samples are over;
+    // refilled each iteration, so subtract Baseline/memcpy for the kernel alone
+    benchmarks.push_back({"Master/gain+clip", [](const BenchArgs& args) {
+        auto src = std::make_shared<std::vector<float>>(noise(args.frames * args.channels, 1.5f));
+        auto dst = std::make_shared<std::vector<float>>(src->size());
+        float step = -0.1f / static_cast<float>(args.frames);
+        return BenchCase{[=] {
+            memcpy(dst->data(), src->data(), src->size() * sizeof(float));
+            applyGainAndClip(dst->data(), args.frames, args.channels, 1.0f, step);
+            doNotOptimize(dst->data());
+        }, args.frames * args.channels * sizeof(float)};
+    }, {}});
+
+    // A whole output cycle: eight stereo inputs, half of them resampled,
+    // each fed one buffer per cycle the way the input callbacks would; then
+    // the same with every input's compressor on
+    for (bool compressed : {false, true}) {
+        benchmarks.push_back({compressed ? "MixEngine/render 8 comp" : "MixEngine/render 8 inputs",
+                              [=](const BenchArgs& args) {
+            constexpr int kInputs = 8;
+            auto engine = std::make_shared<MixEngine>();
+            MixerParams& params = engine->params();
+            std::vector<MixerParams::Command> commands;
+            std::vector<double> rates;
+            for (int slot = 0; slot < kInputs; slot++) {
+                double rate = slot % 2 ? 44100.0 : 48000.0;
+                rates.push_back(rate);
+                engine->prepareInput(slot, rate);
+                params.bindInput(static_cast<uint32_t>(slot + 1), slot);
+                commands.push_back(MixerParams::makeAddInput(slot));
+                MixerParams::Command gain;
+                params.makeSetGain(static_cast<uint32_t>(slot + 1), 0.5f, gain);
+                commands.push_back(gain);
+                if (compressed) {
+                    CompressorSettings settings;
+                    settings.enabled = true;
+                    params.makeCompressor(static_cast<uint32_t>(slot + 1), settings, commands);
+                }
+            }
+            params.push(commands.data(), commands.size());
+            params.drain();
+            params.settle();
+
+            auto src = std::make_shared<std::vector<float>>(noise((args.frames + 2) * MixEngine::kChannels, 0.5f));
+            auto out = std::make_shared<std::vector<float>>(args.frames * MixEngine::kChannels);
+            auto inputFrames = std::make_shared<std::vector<size_t>>();
+            for (double rate : rates) {
+                // Exactly what mix() will take, so the rings stay level
+                double ratio = rate / engine->outputSampleRate();
+                inputFrames->push_back(ratio == 1.0 ? args.frames : static_cast<size_t>(args.frames * ratio) + 2);
+            }
+            return BenchCase{[=] {
+                for (int slot = 0; slot < kInputs; slot++) {
+                    engine->input(slot).write(src->data(), (*inputFrames)[slot] * MixEngine::kChannels);
+                }
+                engine->render(out->data(), args.frames);
+                doNotOptimize(out->data());
+            }, args.frames * MixEngine::kChannels * sizeof(float)};
+        }, {MixEngine::kChannels}});
+    }
+
+    return benchmarks;
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+struct Options {
+    std::string filter;
+    std::vector<size_t> frames = {64, 256, 1024, 4096};
+    std::vector<size_t> channels = {1, 2, 8};
+    double minTime = 0.1;
+    bool perf = false;
+};
+
+static std::vector<size_t> parseList(const char* text) {
+    std::vector<size_t> values;
+    while (*text) {
+        char* end;
+        size_t value = strtoul(text, &end, 10);
+        if (end == text) {
+            break;
+        }
+        if (value > 0) {
+            values.push_back(value);
+        }
+        text = *end == ',' ? end + 1 : end;
+    }
+    return values;
+}
+
+static bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--filter=", 9) == 0) {
+            options.filter = arg + 9;
+        } else if (strncmp(arg, "--frames=", 9) == 0) {
+            options.frames = parseList(arg + 9);
+        } else if (strncmp(arg, "--channels=", 11) == 0) {
+            options.channels = parseList(arg + 11);
+        } else if (strncmp(arg, "--min-time=", 11) == 0) {
+            options.minTime = atof(arg + 11);
+        } else if (strcmp(arg, "--perf") == 0) {
+            options.perf = true;
+        } else {
+            fprintf(stderr, "Usage: engine_bench [--filter=SUBSTR] [--frames=64,256,...]\n"
+                            "                    [--channels=1,2,...] [--min-time=SECONDS] [--perf]\n");
+            return false;
+        }
+    }
+    return !options.frames.empty() && !options.channels.empty() && options.minTime > 0;
+}
+
+// Per-frame counter columns; "-" where the counter isn't available
+static void printCounters(const perf::CounterGroup& counters, const BenchResult& result, size_t frames) {
+    double totalFrames = static_cast<double>(result.iterations) * frames;
+    auto column = [&](int counter, const char* format) {
+        if (counters.available(counter)) {
+            printf(format, result.counters.values[counter] / totalFrames);
+        } else {
+            printf(" %10s", "-");
+        }
+    };
+    column(perf::Cycles, " %10.2f");
+    const uint64_t* values = result.counters.values;
+    if (counters.available(perf::Cycles) && counters.available(perf::Instructions) && values[perf::Cycles] > 0) {
+        printf(" %6.2f", static_cast<double>(values[perf::Instructions]) / values[perf::Cycles]);
+    } else {
+        printf(" %6s", "-");
+    }
+    column(perf::CacheMisses, " %10.4f");
+    column(perf::BranchMisses, " %10.4f");
+}
+
+static void formatRate(double bytesPerSecond, char* out, size_t size) {
+    const char* units[] = {"B/s", "KB/s", "MB/s", "GB/s", "TB/s"};
+    size_t unit = 0;
+    while (bytesPerSecond >= 1000.0 && unit < 4) {
+        bytesPerSecond /= 1000.0;
+        unit++;
+    }
+    snprintf(out, size, "%.2f %s", bytesPerSecond, units[unit]);
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 2;
+    }
+
+    // Read once per batch, outside the timed loop
+    perf::CounterGroup counters;
+    if (options.perf) {
+        std::string error;
+        bool opened = counters.open(error);
+        if (!error.empty()) {
+            printf("perf: %s%s\n", error.c_str(), opened ? "" : "; no counters");
+        }
+    }
+
+    printf("%-28s %6s %3s %12s %10s %12s %12s", "Benchmark", "Frames", "Ch", "Time/iter", "ns/frame", "Bytes/s",
+           "Iterations");
+    if (counters.isOpen()) {
+        printf(" %10s %6s %10s %10s", "cyc/frame", "IPC", "miss/frame", "br/frame");
+    }
+    printf("\n%s\n", std::string(counters.isOpen() ? 128 : 88, '-').c_str());
+
+    for (const Benchmark& benchmark : registerBenchmarks()) {
+        if (!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos) {
+            continue;
+        }
+        const std::vector<size_t>& channelCounts =
+            benchmark.channelCounts.empty() ? options.channels : benchmark.channelCounts;
+        for (size_t frames : options.frames) {
+            for (size_t channels : channelCounts) {
+                BenchArgs args{frames, channels};
+                BenchCase benchCase = benchmark.setUp(args);
+                BenchResult result = timeCase(benchCase, options.minTime, counters);
+
+                double nsPerIteration = result.seconds * 1e9 / result.iterations;
+                char rate[32];
+                formatRate(benchCase.bytesPerIteration * result.iterations / result.seconds, rate, sizeof(rate));
+                printf("%-28s %6zu %3zu %9.0f ns %10.3f %12s %12zu", benchmark.name.c_str(), frames, channels,
+                       nsPerIteration, nsPerIteration / frames, rate, result.iterations);
+                if (counters.isOpen()) {
+                    printCounters(counters, result, frames);
+                }
+                printf("\n");
+            }
+        }
+    }
+    return 0;
+}
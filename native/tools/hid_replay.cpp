@@ -0,0 +1,372 @@
+// PC Panel Pro - headless HID trace replayer
+// Feeds a recorded trace (src/main/hid/trace.ts format) through the same
+// control path the native HID reader uses - parseHidReport, the gain map and
+// taper tables, every mixer's command queue - with a render thread standing
+// in for the output IOProc. Reports events/sec, report -> render apply
+// latency and heap allocations on each side.
+//
+// Usage: hid_replay <trace> [--speed=N | --max] [--mixers=N] [--buffer=FRAMES]
+//                   [--rate=HZ] [--loops=N] [--map=CONTROL:HANDLE[:CURVE]]...
+
+#include "engine/hid_gain_map.h"
+#include "engine/hid_report.h"
+#include "engine/mixer_params.h"
+#include "engine/taper.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// =============================================================================
+// Allocation counting
+// =============================================================================
+
+static std::atomic<uint64_t> g_allocations{0};
+static thread_local uint64_t t_allocations = 0;
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    t_allocations++;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+// =============================================================================
+// Trace loading
+// =============================================================================
+
+struct TraceEntry {
+    int64_t timeUs;
+    uint8_t report[kHidReportSize];
+    size_t length;
+};
+
+static bool parseHex(const std::string& hex, uint8_t* out, size_t maxBytes, size_t& length) {
+    if (hex.size() % 2 != 0 || hex.size() / 2 > maxBytes) {
+        return false;
+    }
+    length = hex.size() / 2;
+    for (size_t i = 0; i < length; i++) {
+        char byte[3] = { hex[i * 2], hex[i * 2 + 1], 0 };
+        char* end = nullptr;
+        out[i] = static_cast<uint8_t>(std::strtoul(byte, &end, 16));
+        if (end != byte + 2) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool loadTrace(const char* path, std::vector<TraceEntry>& entries) {
+    std::ifstream file(path);
+    if (!file) {
+        fprintf(stderr, "Can't open trace %s\n", path);
+        return false;
+    }
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        TraceEntry entry = {};
+        std::string hex;
+        size_t used = 0;
+        if (!(fields >> entry.timeUs >> hex) || !parseHex(hex, entry.report, kHidReportSize, used)) {
+            fprintf(stderr, "%s:%zu: malformed trace line\n", path, lineNumber);
+            return false;
+        }
+        entry.length = kHidReportSize;  // Trailing zeros were trimmed on write
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+// =============================================================================
+// Replay
+// =============================================================================
+
+struct Options {
+    const char* tracePath = nullptr;
+    double speed = 1.0;             // 0 = as fast as possible
+    size_t mixers = 2;              // Personal + voice chat mix
+    size_t bufferFrames = 256;
+    double sampleRate = 48000.0;
+    size_t loops = 1;
+    std::vector<HidGainMap::GainMapping> mappings;
+};
+
+static bool parseMapping(const char* spec, std::vector<HidGainMap::GainMapping>& mappings) {
+    unsigned control = 0;
+    unsigned handle = 0;
+    char curve[16] = "audio";
+    if (sscanf(spec, "%u:%u:%15s", &control, &handle, curve) < 2 || control >= kHidAnalogCount) {
+        return false;
+    }
+    mappings.resize(kHidAnalogCount);
+    mappings[control].deviceHandle = handle;
+    mappings[control].curve = taperCurveFromName(curve);
+    return true;
+}
+
+static bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--speed=", 8) == 0) {
+            options.speed = atof(arg + 8);
+        } else if (strcmp(arg, "--max") == 0) {
+            options.speed = 0.0;
+        } else if (strncmp(arg, "--mixers=", 9) == 0) {
+            options.mixers = std::max(1, atoi(arg + 9));
+        } else if (strncmp(arg, "--buffer=", 9) == 0) {
+            options.bufferFrames = std::max(1, atoi(arg + 9));
+        } else if (strncmp(arg, "--rate=", 7) == 0) {
+            options.sampleRate = atof(arg + 7);
+        } else if (strncmp(arg, "--loops=", 8) == 0) {
+            options.loops = std::max(1, atoi(arg + 8));
+        } else if (strncmp(arg, "--map=", 6) == 0) {
+            if (!parseMapping(arg + 6, options.mappings)) {
+                fprintf(stderr, "Bad mapping %s (want CONTROL:HANDLE[:linear|db|audio])\n", arg + 6);
+                return false;
+            }
+        } else if (arg[0] != '-' && !options.tracePath) {
+            options.tracePath = arg;
+        } else {
+            fprintf(stderr, "Unknown argument %s\n", arg);
+            return false;
+        }
+    }
+
+    if (!options.tracePath) {
+        fprintf(stderr, "Usage: hid_replay <trace> [--speed=N | --max] [--mixers=N] [--buffer=FRAMES]\n"
+                        "                  [--rate=HZ] [--loops=N] [--map=CONTROL:HANDLE[:CURVE]]...\n");
+        return false;
+    }
+
+    // Default: every control drives input handle control+1 through the audio taper
+    if (options.mappings.empty()) {
+        options.mappings.resize(kHidAnalogCount);
+        for (size_t i = 0; i < kHidAnalogCount; i++) {
+            options.mappings[i].deviceHandle = static_cast<uint32_t>(i + 1);
+            options.mappings[i].curve = TaperCurve::Audio;
+        }
+    }
+    return true;
+}
+
+using Clock = std::chrono::steady_clock;
+
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// One mixer's queue plus the bookkeeping that pairs each applied command
+// with the moment its report was handled
+struct ReplayMixer {
+    MixerParams params;
+    std::vector<int64_t> pushedAt;      // Indexed by command sequence
+    size_t pushed = 0;                  // Producer only
+    std::atomic<size_t> applied{0};     // Render only writes
+};
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 2;
+    }
+
+    std::vector<TraceEntry> trace;
+    if (!loadTrace(options.tracePath, trace)) {
+        return 1;
+    }
+    if (trace.empty()) {
+        fprintf(stderr, "Trace is empty\n");
+        return 1;
+    }
+
+    HidGainMap gainMap;
+    gainMap.set(options.mappings);
+
+    // Every report can produce at most one command per analog control
+    size_t maxCommands = trace.size() * options.loops * kHidAnalogCount;
+    std::vector<std::unique_ptr<ReplayMixer>> mixers;
+    for (size_t m = 0; m < options.mixers; m++) {
+        auto mixer = std::make_unique<ReplayMixer>();
+        int slot = 0;
+        for (const auto& mapping : options.mappings) {
+            if (mapping.deviceHandle == HidGainMap::kNoDevice ||
+                mixer->params.findInput(mapping.deviceHandle) >= 0) {
+                continue;
+            }
+            mixer->params.bindInput(mapping.deviceHandle, slot);
+            MixerParams::Command add = MixerParams::makeAddInput(slot++);
+            mixer->params.push(&add, 1);
+        }
+        mixer->params.drain();
+        mixer->params.settle();
+        mixer->pushedAt.resize(maxCommands);
+        mixers.push_back(std::move(mixer));
+    }
+
+    std::vector<int64_t> latencies;
+    latencies.reserve(maxCommands * options.mixers);
+
+    // Render side: one drain per buffer period, like the output IOProc
+    std::atomic<bool> producing{true};
+    uint64_t renderAllocations = 0;
+    size_t renderCycles = 0;
+    double periodS = options.bufferFrames / options.sampleRate;
+    auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.speed > 0 ? periodS / options.speed : 0.0));
+
+    std::thread render([&]() {
+        uint64_t allocationsBefore = t_allocations;
+        auto nextCycle = Clock::now();
+        for (;;) {
+            bool finished = !producing.load(std::memory_order_acquire);
+            for (auto& mixer : mixers) {
+                ReplayMixer* self = mixer.get();
+                self->params.drain([&](const MixerParams::Command& command) {
+                    if (command.type != MixerParams::CommandType::SetGain) {
+                        return;
+                    }
+                    size_t sequence = self->applied.load(std::memory_order_relaxed);
+                    latencies.push_back(nowNs() - self->pushedAt[sequence]);
+                    self->applied.store(sequence + 1, std::memory_order_relaxed);
+                });
+                self->params.finishCycle();
+            }
+            renderCycles++;
+            if (finished) {
+                break;  // Producer was done before this cycle's drain
+            }
+            if (period.count() > 0) {
+                nextCycle += period;
+                std::this_thread::sleep_until(nextCycle);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        renderAllocations = t_allocations - allocationsBefore;
+    });
+
+    // Producer side: the HID thread's handleReport/applyGain
+    size_t reports = 0;
+    size_t queueFullRetries = 0;
+    uint64_t producerAllocationsBefore = t_allocations;
+    auto start = Clock::now();
+    int64_t traceStartUs = trace.front().timeUs;
+    int64_t traceSpanUs = trace.back().timeUs - traceStartUs;
+
+    auto applyGain = [&](size_t control, uint8_t value) {
+        uint32_t deviceHandle;
+        float gain;
+        if (!gainMap.lookup(control, value, deviceHandle, gain)) {
+            return;
+        }
+        for (auto& mixer : mixers) {
+            MixerParams::Command command;
+            if (!mixer->params.makeSetGain(deviceHandle, gain, command)) {
+                continue;
+            }
+            mixer->pushedAt[mixer->pushed] = nowNs();
+            while (!mixer->params.push(&command, 1)) {
+                queueFullRetries++;
+                std::this_thread::yield();
+            }
+            mixer->pushed++;
+        }
+    };
+
+    for (size_t loop = 0; loop < options.loops; loop++) {
+        int64_t loopOffsetUs = static_cast<int64_t>(loop) * (traceSpanUs + 1000);
+        for (const TraceEntry& entry : trace) {
+            if (options.speed > 0) {
+                double dueS = (entry.timeUs - traceStartUs + loopOffsetUs) / 1e6 / options.speed;
+                std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(dueS)));
+            }
+
+            HidReport report;
+            if (!parseHidReport(entry.report, entry.length, report)) {
+                continue;
+            }
+            reports++;
+            if (report.type == HidReport::Type::KnobChange) {
+                applyGain(report.index, report.value);
+            } else if (report.type == HidReport::Type::StateResponse) {
+                for (size_t i = 0; i < kHidAnalogCount; i++) {
+                    applyGain(i, report.analogValues[i]);
+                }
+            }
+        }
+    }
+
+    double producerS = std::chrono::duration<double>(Clock::now() - start).count();
+    uint64_t producerAllocations = t_allocations - producerAllocationsBefore;
+
+    // Let the render side apply everything that was queued
+    for (auto& mixer : mixers) {
+        while (mixer->applied.load(std::memory_order_relaxed) < mixer->pushed) {
+            std::this_thread::yield();
+        }
+    }
+    producing.store(false, std::memory_order_release);
+    render.join();
+
+    size_t commands = 0;
+    for (auto& mixer : mixers) {
+        commands += mixer->pushed;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentileUs = [&](double p) {
+        if (latencies.empty()) {
+            return 0.0;
+        }
+        size_t index = std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()));
+        return latencies[index] / 1000.0;
+    };
+
+    printf("trace            %s (%zu reports, %.2f s recorded)\n",
+           options.tracePath, trace.size(), traceSpanUs / 1e6);
+    char speed[32] = "max speed";
+    if (options.speed > 0) {
+        snprintf(speed, sizeof(speed), "%gx speed", options.speed);
+    }
+    printf("replay           %s, %zu loop(s), %zu mixer(s), %zu-frame buffer @ %.0f Hz\n",
+           speed, options.loops, options.mixers, options.bufferFrames, options.sampleRate);
+    printf("reports          %zu in %.3f s = %.0f events/s\n", reports, producerS, reports / producerS);
+    printf("gain commands    %zu (%zu queue-full retries), %zu render cycles\n",
+           commands, queueFullRetries, renderCycles);
+    printf("apply latency    p50 %.1f us  p99 %.1f us  max %.1f us\n",
+           percentileUs(0.50), percentileUs(0.99), percentileUs(1.0));
+    printf("allocations      producer %llu  render %llu  (total %llu incl. setup)\n",
+           static_cast<unsigned long long>(producerAllocations),
+           static_cast<unsigned long long>(renderAllocations),
+           static_cast<unsigned long long>(g_allocations.load()));
+    return 0;
+}
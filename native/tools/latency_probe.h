@@ -0,0 +1,93 @@
+// PC Panel Pro - latency probe markers for the host tools
+// A maximum length sequence (MLS) is flat in spectrum and has a single sharp
+// autocorrelation peak, so it can be found again after gain, rate conversion
+// and mixing by cross-correlating against a reference copy.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace probe {
+
+constexpr int kMlsOrder = 10;                       // 1023 samples
+constexpr size_t kMlsLength = (1u << kMlsOrder) - 1;
+constexpr double kMinConfidence = 0.5;              // Normalized correlation needed to count a match
+
+// +/-1 MLS from a 10-bit Fibonacci LFSR (x^10 + x^7 + 1)
+inline std::vector<float> mlsSequence() {
+    std::vector<float> sequence(kMlsLength);
+    uint32_t reg = 1;
+    for (size_t i = 0; i < kMlsLength; i++) {
+        uint32_t bit = reg & 1;
+        sequence[i] = bit ? 1.0f : -1.0f;
+        uint32_t feedback = (reg ^ (reg >> 3)) & 1;
+        reg = (reg >> 1) | (feedback << (kMlsOrder - 1));
+    }
+    return sequence;
+}
+
+struct Match {
+    bool found;
+    double position;        // Sub-sample start of the marker in the signal
+    double confidence;      // Normalized correlation at the peak, 0-1
+};
+
+// Best alignment of reference within signal[begin, end). The peak is refined
+// with a parabola through its neighbours.
+inline Match findMarker(const float* signal, size_t signalLength, const std::vector<float>& reference,
+                        size_t begin, size_t end) {
+    size_t length = reference.size();
+    if (length == 0 || signalLength < length) {
+        return {false, 0, 0};
+    }
+    end = std::min(end, signalLength - length + 1);
+    if (begin >= end) {
+        return {false, 0, 0};
+    }
+
+    double referenceEnergy = 0;
+    for (float sample : reference) {
+        referenceEnergy += static_cast<double>(sample) * sample;
+    }
+
+    std::vector<double> correlation(end - begin);
+    size_t best = 0;
+    for (size_t lag = begin; lag < end; lag++) {
+        double sum = 0;
+        const float* window = signal + lag;
+        for (size_t i = 0; i < length; i++) {
+            sum += static_cast<double>(window[i]) * reference[i];
+        }
+        correlation[lag - begin] = sum;
+        if (sum > correlation[best]) {
+            best = lag - begin;
+        }
+    }
+
+    double windowEnergy = 0;
+    for (size_t i = 0; i < length; i++) {
+        double sample = signal[begin + best + i];
+        windowEnergy += sample * sample;
+    }
+    double peak = correlation[best];
+    double confidence = windowEnergy > 0 && referenceEnergy > 0
+        ? peak / std::sqrt(windowEnergy * referenceEnergy) : 0;
+
+    double offset = 0;
+    if (best > 0 && best + 1 < correlation.size()) {
+        double before = correlation[best - 1];
+        double after = correlation[best + 1];
+        double curvature = before - 2 * peak + after;
+        if (curvature < 0) {
+            offset = 0.5 * (before - after) / curvature;
+        }
+    }
+
+    return {confidence >= kMinConfidence, static_cast<double>(begin + best) + offset, confidence};
+}
+
+}  // namespace probe
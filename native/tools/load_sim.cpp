@@ -0,0 +1,366 @@
+// PC Panel Pro - CPU load simulation for many buses
+// Builds N virtual output buses, each a MixEngine with M stereo inputs, and
+// drives them from a simulated device clock: every cycle each input callback
+// writes one buffer and each bus renders one. Reports the work per cycle
+// against the buffer period, i.e. how much headroom is left before the
+// output callbacks start missing their deadlines.
+//
+// --parallel spreads the buses over worker threads, one bus group per
+// thread, the way separate output devices run on separate IOProc threads.
+// The cycle then takes as long as its slowest group. --sweep repeats the run
+// for 1..N buses and stops at the first bus count whose share of missed
+// deadlines is over --max-miss; a preempted cycle now and then is expected
+// on a machine that isn't running with real-time priority.
+//
+// Usage: load_sim [--buses=N] [--inputs=M] [--frames=N] [--rate=HZ]
+//                 [--src=FRACTION] [--src-rate=HZ] [--seconds=S]
+//                 [--parallel[=THREADS]] [--realtime] [--sweep]
+//                 [--max-miss=FRACTION]
+
+#include "engine/callback_timing.h"
+#include "engine/mix_engine.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Rings are allocated with this instead of kRingSeconds: the simulation keeps
+// them level, and 10 s each for a hundred inputs would be most of a gigabyte
+constexpr double kRingSeconds = 0.25;
+
+struct Options {
+    int buses = 6;
+    int inputs = 16;
+    size_t frames = 64;
+    double rate = 96000.0;
+    double srcFraction = 0.25;          // Share of inputs running at srcRate
+    double srcRate = 44100.0;
+    double seconds = 10.0;              // Simulated audio per run
+    int threads = 0;                    // 0 = serial
+    bool realtime = false;
+    bool sweep = false;
+    double maxMiss = 0.001;             // Share of cycles allowed to miss before a run fails
+};
+
+// One virtual device: its engine, its inputs' feeds and its output buffer
+struct Bus {
+    MixEngine engine;
+    std::vector<size_t> inputSamples;   // Written per cycle by each input, samples
+    std::vector<float> output;
+    CallbackTiming timing;              // This bus's share of each cycle
+};
+
+std::vector<float> noise(size_t count, float amplitude, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-amplitude, amplitude);
+    std::vector<float> samples(count);
+    for (float& sample : samples) {
+        sample = dist(rng);
+    }
+    return samples;
+}
+
+std::unique_ptr<Bus> makeBus(const Options& options) {
+    auto bus = std::make_unique<Bus>();
+    MixEngine& engine = bus->engine;
+    engine.setOutputSampleRate(options.rate);
+
+    MixerParams& params = engine.params();
+    std::vector<MixerParams::Command> commands;
+    int resampled = static_cast<int>(options.inputs * options.srcFraction + 0.5);
+    for (int slot = 0; slot < options.inputs; slot++) {
+        // Spread the resampled inputs out rather than bunching them first
+        bool convert = resampled > 0 && slot * resampled / options.inputs != (slot + 1) * resampled / options.inputs;
+        double inputRate = convert ? options.srcRate : options.rate;
+        engine.prepareInput(slot, inputRate, kRingSeconds);
+
+        // What mix() takes from the ring each cycle, so the rings stay level
+        double ratio = inputRate / options.rate;
+        size_t frames = ratio == 1.0 ? options.frames : static_cast<size_t>(options.frames * ratio) + 2;
+        bus->inputSamples.push_back(frames * MixEngine::kChannels);
+
+        params.bindInput(static_cast<uint32_t>(slot + 1), slot);
+        commands.push_back(MixerParams::makeAddInput(slot));
+        MixerParams::Command gain;
+        params.makeSetGain(static_cast<uint32_t>(slot + 1), 0.5f, gain);
+        commands.push_back(gain);
+    }
+    params.push(commands.data(), commands.size());
+    params.drain();
+    params.settle();
+
+    bus->output.resize(options.frames * MixEngine::kChannels);
+    return bus;
+}
+
+// The input callbacks' writes and then the output callback, for one bus
+void renderBus(Bus& bus, const std::vector<float>& source, size_t frames, uint64_t periodNs) {
+    uint64_t start = CallbackTiming::now();
+    for (size_t slot = 0; slot < bus.inputSamples.size(); slot++) {
+        bus.engine.input(static_cast<int>(slot)).write(source.data(), bus.inputSamples[slot]);
+    }
+    bus.engine.render(bus.output.data(), frames);
+    bus.timing.record(CallbackTiming::now() - start, periodNs);
+}
+
+struct RunResult {
+    CallbackTiming::Snapshot cycle;     // Wall time from the clock tick to the last bus finishing
+    uint64_t workNs;                    // Sum of every bus's time, all cycles
+    uint64_t worstBusP99Ns;
+    uint64_t lateCycles;                // --realtime: finished after the next tick was due
+
+    bool withinBudget(double maxMiss) const {
+        return cycle.count > 0 && (cycle.deadlineMisses + lateCycles) <= maxMiss * cycle.count;
+    }
+};
+
+// Workers spin on the clock's cycle number, run their buses and count
+// themselves done; the clock thread runs group 0 itself
+class WorkerPool {
+public:
+    WorkerPool(std::vector<std::vector<Bus*>> groups, const std::vector<float>& source, size_t frames,
+               uint64_t periodNs)
+        : groups_(std::move(groups)), source_(source), frames_(frames), periodNs_(periodNs) {
+        for (size_t g = 1; g < groups_.size(); g++) {
+            threads_.emplace_back([this, g] { work(g); });
+        }
+    }
+
+    ~WorkerPool() {
+        stopping_.store(true, std::memory_order_release);
+        cycle_.fetch_add(1, std::memory_order_release);
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    void runCycle() {
+        done_.store(0, std::memory_order_relaxed);
+        cycle_.fetch_add(1, std::memory_order_release);
+        runGroup(0);
+        while (done_.load(std::memory_order_acquire) < threads_.size()) {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    void work(size_t group) {
+        uint64_t seen = 0;
+        for (;;) {
+            uint64_t cycle;
+            while ((cycle = cycle_.load(std::memory_order_acquire)) == seen) {
+                std::this_thread::yield();
+            }
+            seen = cycle;
+            if (stopping_.load(std::memory_order_acquire)) {
+                return;
+            }
+            runGroup(group);
+            done_.fetch_add(1, std::memory_order_acq_rel);
+        }
+    }
+
+    void runGroup(size_t group) {
+        for (Bus* bus : groups_[group]) {
+            renderBus(*bus, source_, frames_, periodNs_);
+        }
+    }
+
+    std::vector<std::vector<Bus*>> groups_;
+    const std::vector<float>& source_;
+    size_t frames_;
+    uint64_t periodNs_;
+    std::vector<std::thread> threads_;
+    std::atomic<uint64_t> cycle_{0};
+    std::atomic<size_t> done_{0};
+    std::atomic<bool> stopping_{false};
+};
+
+RunResult run(const Options& options, int busCount) {
+    std::vector<std::unique_ptr<Bus>> buses;
+    for (int b = 0; b < busCount; b++) {
+        buses.push_back(makeBus(options));
+    }
+
+    size_t maxSamples = 0;
+    for (size_t samples : buses[0]->inputSamples) {
+        maxSamples = std::max(maxSamples, samples);
+    }
+    std::vector<float> source = noise(maxSamples, 0.5f, 1);
+
+    uint64_t periodNs = CallbackTiming::periodNs(options.frames, options.rate);
+    size_t cycles = static_cast<size_t>(options.seconds * options.rate / options.frames);
+
+    std::unique_ptr<WorkerPool> pool;
+    if (options.threads > 0) {
+        size_t groupCount = std::min<size_t>(options.threads, buses.size());
+        std::vector<std::vector<Bus*>> groups(groupCount);
+        for (size_t b = 0; b < buses.size(); b++) {
+            groups[b % groupCount].push_back(buses[b].get());
+        }
+        pool = std::make_unique<WorkerPool>(std::move(groups), source, options.frames, periodNs);
+    }
+
+    // Settle caches and the workers before measuring
+    size_t warmup = std::min<size_t>(cycles / 10 + 1, 1000);
+    CallbackTiming cycleTiming;
+    RunResult result = {};
+    uint64_t nextTick = CallbackTiming::now();
+    for (size_t cycle = 0; cycle < warmup + cycles; cycle++) {
+        if (cycle == warmup) {
+            cycleTiming.reset();
+            for (auto& bus : buses) {
+                bus->timing.reset();
+            }
+            nextTick = CallbackTiming::now();
+        }
+
+        if (options.realtime) {
+            // Wait for the simulated device clock, as an IOProc would
+            uint64_t now = CallbackTiming::now();
+            if (now < nextTick) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(nextTick - now));
+            }
+        }
+        uint64_t start = CallbackTiming::now();
+
+        if (pool) {
+            pool->runCycle();
+        } else {
+            for (auto& bus : buses) {
+                renderBus(*bus, source, options.frames, periodNs);
+            }
+        }
+
+        uint64_t end = CallbackTiming::now();
+        cycleTiming.record(end - start, periodNs);
+        nextTick += periodNs;
+        if (options.realtime && cycle >= warmup && end > nextTick) {
+            result.lateCycles++;
+        }
+    }
+    pool.reset();
+
+    result.cycle = cycleTiming.snapshot();
+    for (auto& bus : buses) {
+        CallbackTiming::Snapshot snap = bus->timing.snapshot();
+        result.workNs += snap.meanNs * snap.count;
+        result.worstBusP99Ns = std::max(result.worstBusP99Ns, snap.p99Ns);
+    }
+    return result;
+}
+
+void printHeader() {
+    printf("%5s %10s %10s %10s %7s %8s %10s %10s\n",
+           "Buses", "p50 us", "p99 us", "max us", "Load", "Misses", "Work us", "Bus p99 us");
+}
+
+// One line per run; load and headroom are the p99 cycle against the period
+void printResult(int busCount, const RunResult& result, const Options& options) {
+    const CallbackTiming::Snapshot& cycle = result.cycle;
+    double load = cycle.periodNs > 0 ? 100.0 * cycle.p99Ns / cycle.periodNs : 0;
+    double workPerCycle = cycle.count > 0 ? result.workNs / 1000.0 / cycle.count : 0;
+    printf("%5d %10.1f %10.1f %10.1f %6.1f%% %8llu %10.1f %10.1f", busCount, cycle.p50Ns / 1000.0,
+           cycle.p99Ns / 1000.0, cycle.maxNs / 1000.0, load, static_cast<unsigned long long>(cycle.deadlineMisses),
+           workPerCycle, result.worstBusP99Ns / 1000.0);
+    if (options.realtime) {
+        printf("  %llu late", static_cast<unsigned long long>(result.lateCycles));
+    }
+    printf("\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--buses=", 8) == 0) {
+            options.buses = atoi(arg + 8);
+        } else if (strncmp(arg, "--inputs=", 9) == 0) {
+            options.inputs = atoi(arg + 9);
+        } else if (strncmp(arg, "--frames=", 9) == 0) {
+            options.frames = strtoul(arg + 9, nullptr, 10);
+        } else if (strncmp(arg, "--rate=", 7) == 0) {
+            options.rate = atof(arg + 7);
+        } else if (strncmp(arg, "--src=", 6) == 0) {
+            options.srcFraction = atof(arg + 6);
+        } else if (strncmp(arg, "--src-rate=", 11) == 0) {
+            options.srcRate = atof(arg + 11);
+        } else if (strncmp(arg, "--seconds=", 10) == 0) {
+            options.seconds = atof(arg + 10);
+        } else if (strcmp(arg, "--parallel") == 0) {
+            options.threads = std::max(1u, std::thread::hardware_concurrency());
+        } else if (strncmp(arg, "--parallel=", 11) == 0) {
+            options.threads = atoi(arg + 11);
+        } else if (strcmp(arg, "--realtime") == 0) {
+            options.realtime = true;
+        } else if (strcmp(arg, "--sweep") == 0) {
+            options.sweep = true;
+        } else if (strncmp(arg, "--max-miss=", 11) == 0) {
+            options.maxMiss = atof(arg + 11);
+        } else {
+            fprintf(stderr, "Unknown argument %s\n", arg);
+            return false;
+        }
+    }
+    if (options.buses < 1 || options.inputs < 1 || options.inputs > static_cast<int>(MixEngine::kMaxInputs)) {
+        fprintf(stderr, "--buses must be at least 1 and --inputs 1-%zu\n", MixEngine::kMaxInputs);
+        return false;
+    }
+    if (options.frames < 1 || options.frames > MixEngine::kMaxCycleFrames || options.rate <= 0
+        || options.srcRate <= 0 || options.seconds <= 0 || options.threads < 0) {
+        fprintf(stderr, "--frames must be 1-%zu; rates, --seconds and --parallel must be positive\n",
+                MixEngine::kMaxCycleFrames);
+        return false;
+    }
+    options.srcFraction = std::min(1.0, std::max(0.0, options.srcFraction));
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "Usage: load_sim [--buses=N] [--inputs=M] [--frames=N] [--rate=HZ]\n"
+                        "                [--src=FRACTION] [--src-rate=HZ] [--seconds=S]\n"
+                        "                [--parallel[=THREADS]] [--realtime] [--sweep]\n"
+                        "                [--max-miss=FRACTION]\n");
+        return 2;
+    }
+
+    double periodUs = CallbackTiming::periodNs(options.frames, options.rate) / 1000.0;
+    printf("%d bus(es) x %d stereo inputs (%.0f%% from %.0f Hz), %zu frames @ %.0f Hz: %.1f us per cycle, %s\n",
+           options.buses, options.inputs, options.srcFraction * 100, options.srcRate, options.frames, options.rate,
+           periodUs, options.threads > 0 ? (std::to_string(options.threads) + " thread(s)").c_str() : "serial");
+    printHeader();
+
+    if (!options.sweep) {
+        RunResult result = run(options, options.buses);
+        printResult(options.buses, result, options);
+        double load = result.cycle.periodNs > 0 ? static_cast<double>(result.cycle.p99Ns) / result.cycle.periodNs : 0;
+        printf("Headroom at p99: %.1f%% of the period\n", (1.0 - load) * 100);
+        return result.withinBudget(options.maxMiss) ? 0 : 1;
+    }
+
+    // Grow the bus count until a run misses too often
+    int lastClean = 0;
+    for (int busCount = 1; busCount <= options.buses; busCount++) {
+        RunResult result = run(options, busCount);
+        printResult(busCount, result, options);
+        if (!result.withinBudget(options.maxMiss)) {
+            break;
+        }
+        lastClean = busCount;
+    }
+    printf("Largest bus count within %.2f%% missed deadlines: %d\n", options.maxMiss * 100, lastClean);
+    return 0;
+}
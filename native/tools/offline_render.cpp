@@ -0,0 +1,1099 @@
+// PC Panel Pro - offline render harness
+// Renders WAV inputs through the mixer graph (MixEngine: rings, sample rate
+// conversion, gain ramps, master, clipping) exactly as the IOProcs drive it,
+// but from a loop instead of live devices, so it runs faster than real time
+// on any machine. Outputs can be compared against golden files.
+//
+// Usage: offline_render <layout> [--out=DIR] [--golden=DIR] [--tolerance=X]
+//                       [--update-golden] [--trace=FILE] [--perf]
+//                       [--record=DIR] [--record-format=wav|caf]
+//                       [--replay=SECONDS] [--replay-mb=N]
+//                       [--stems=DIR] [--stems-layout=files|interleaved]
+//        offline_render <layout> --latency [--probes=N] [--input-phase=F]
+//                       [--max-latency-ms=X] [--max-drift=X]
+//
+// Layout file (paths relative to the layout file, '#' starts a comment):
+//
+//   rate 48000                          output sample rate
+//   buffer 256                          frames per render cycle
+//   input music music.wav               one line per source
+//   input voice voice_44k.wav
+//   bus personal music=0.8 voice master=0.9
+//   bus chat voice
+//   duck personal voice music threshold=-30 ratio=4 attack=10 release=300
+//   compress personal voice threshold=-24 ratio=4 knee=6 attack=5 release=120 makeup=6 detector=rms
+//
+// Each bus is its own MixEngine, like one AudioMixer per mix bus. A duck
+// line sets a bus's sidechain: the key input, then the inputs it ducks. A
+// compress line turns on one bus input's compressor; ratio=100 with the
+// default peak detector limits.
+// --trace writes the render's engine events as Chrome trace JSON. --perf
+// reads the hardware performance counters around every render cycle (Linux)
+// and prints cycles, instructions, cache and branch misses per frame.
+// --record streams every bus through BusRecorder, the addon's recording
+// path, while rendering, then checks each file against the render.
+// --replay keeps every bus in a ReplayBuffer and, after the render, saves
+// its window to <out>/<bus>_replay.wav and checks it against the render's
+// tail (to 24 bits). --replay-mb caps the arena instead of the default.
+// --stems records every bus's inputs through StemRecorder into DIR/<bus>
+// (format from --record-format), then checks that the stems, summed and
+// put through the bus's master gain and clip, give back the bus exactly.
+//
+// --latency measures each route (one input into one bus) instead of
+// rendering. The source is replaced with silence plus a train of MLS markers.
+// Input and output cycles are simulated on one clock: each input buffer is
+// delivered when it has been fully captured, offset from the output cycle by
+// --input-phase of a buffer. Markers are found in the bus output by
+// cross-correlation. Latency runs from a frame entering the virtual device
+// to the same frame being played, counting one output buffer; device and
+// safety offsets are not modelled. Drift is the slope of latency over the
+// run. The exit status is non-zero if any marker is lost or any route drifts
+// by more than --max-drift (ms of latency per minute).
+//
+// offline_render_rtsan is the same harness built with the RT-safety
+// sanitizer (tools/rt_sanitizer.cpp): anything the render path does that an
+// audio thread must not do aborts with a stack, or with PCPANEL_RTSAN=report
+// is counted and fails the run.
+
+#include "engine/bus_recorder.h"
+#include "engine/callback_timing.h"
+#include "engine/mix_engine.h"
+#include "engine/replay_buffer.h"
+#include "engine/ring_stats.h"
+#include "engine/rt_scope.h"
+#include "engine/stem_recorder.h"
+#include "engine/trace.h"
+#include "latency_probe.h"
+#include "perf_counters.h"
+#include "wav_file.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+// =============================================================================
+// Layout
+// =============================================================================
+
+struct InputSpec {
+    std::string name;
+    std::string path;
+    double sampleRate = 0;
+    std::vector<float> stereo;      // Interleaved stereo at the file's rate
+
+    size_t frames() const { return stereo.size() / MixEngine::kChannels; }
+};
+
+struct BusInput {
+    size_t input;                   // Index into Layout::inputs
+    float gain;
+    CompressorSettings compressor;
+};
+
+struct BusSpec {
+    std::string name;
+    std::vector<BusInput> inputs;
+    float master = 1.0f;
+    int duckKey = -1;                   // Index into inputs; -1 = no ducking
+    std::vector<size_t> duckTargets;    // Indices into inputs
+    DuckSettings duck;
+};
+
+struct Layout {
+    double sampleRate = 48000.0;
+    size_t bufferFrames = 256;
+    std::vector<InputSpec> inputs;
+    std::vector<BusSpec> buses;
+};
+
+static std::string directoryOf(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? "." : path.substr(0, slash);
+}
+
+static std::string resolvePath(const std::string& base, const std::string& path) {
+    return !path.empty() && path[0] == '/' ? path : base + "/" + path;
+}
+
+// Mono is duplicated to both channels; anything wider keeps the first two
+static std::vector<float> toStereo(const WavData& wavData) {
+    std::vector<float> stereo(wavData.frames() * MixEngine::kChannels);
+    for (size_t frame = 0; frame < wavData.frames(); frame++) {
+        const float* in = &wavData.samples[frame * wavData.channels];
+        stereo[frame * 2] = in[0];
+        stereo[frame * 2 + 1] = wavData.channels > 1 ? in[1] : in[0];
+    }
+    return stereo;
+}
+
+static bool loadLayout(const std::string& path, Layout& layout, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "can't open layout " + path;
+        return false;
+    }
+    std::string base = directoryOf(path);
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string keyword;
+        if (!(fields >> keyword)) {
+            continue;
+        }
+        std::string where = path + ":" + std::to_string(lineNumber) + ": ";
+
+        if (keyword == "rate") {
+            fields >> layout.sampleRate;
+        } else if (keyword == "buffer") {
+            fields >> layout.bufferFrames;
+        } else if (keyword == "input") {
+            InputSpec input;
+            std::string file;
+            if (!(fields >> input.name >> file)) {
+                error = where + "want 'input NAME PATH'";
+                return false;
+            }
+            input.path = resolvePath(base, file);
+            WavData wavData;
+            if (!readWav(input.path, wavData, error)) {
+                error = where + error;
+                return false;
+            }
+            input.sampleRate = wavData.sampleRate;
+            input.stereo = toStereo(wavData);
+            layout.inputs.push_back(std::move(input));
+        } else if (keyword == "bus") {
+            BusSpec bus;
+            if (!(fields >> bus.name)) {
+                error = where + "want 'bus NAME INPUT[=GAIN]... [master=GAIN]'";
+                return false;
+            }
+            std::string item;
+            while (fields >> item) {
+                size_t eq = item.find('=');
+                std::string name = item.substr(0, eq);
+                float gain = eq == std::string::npos ? 1.0f : std::strtof(item.c_str() + eq + 1, nullptr);
+                if (name == "master") {
+                    bus.master = gain;
+                    continue;
+                }
+                size_t index = 0;
+                while (index < layout.inputs.size() && layout.inputs[index].name != name) {
+                    index++;
+                }
+                if (index == layout.inputs.size()) {
+                    error = where + "unknown input '" + name + "'";
+                    return false;
+                }
+                bus.inputs.push_back({index, gain, {}});
+            }
+            layout.buses.push_back(std::move(bus));
+        } else if (keyword == "compress") {
+            std::string busName;
+            std::string inputName;
+            if (!(fields >> busName >> inputName)) {
+                error = where + "want 'compress BUS INPUT [threshold=DB] [ratio=R] [knee=DB] [attack=MS] "
+                                "[release=MS] [makeup=DB] [detector=peak|rms]'";
+                return false;
+            }
+            BusInput* target = nullptr;
+            for (BusSpec& bus : layout.buses) {
+                for (BusInput& input : bus.inputs) {
+                    if (bus.name == busName && layout.inputs[input.input].name == inputName) {
+                        target = &input;
+                    }
+                }
+            }
+            if (!target) {
+                error = where + "'" + inputName + "' is not an input of '" + busName +
+                        "' (compress lines go after their bus)";
+                return false;
+            }
+            CompressorSettings& settings = target->compressor;
+            settings.enabled = true;
+            std::string item;
+            while (fields >> item) {
+                size_t eq = item.find('=');
+                std::string name = item.substr(0, eq);
+                std::string text = eq == std::string::npos ? "" : item.substr(eq + 1);
+                float value = std::strtof(text.c_str(), nullptr);
+                if (name == "threshold") {
+                    settings.thresholdDb = value;
+                } else if (name == "ratio") {
+                    settings.ratio = value;
+                } else if (name == "knee") {
+                    settings.kneeDb = value;
+                } else if (name == "attack") {
+                    settings.attackMs = value;
+                } else if (name == "release") {
+                    settings.releaseMs = value;
+                } else if (name == "makeup") {
+                    settings.makeupDb = value;
+                } else if (name == "detector") {
+                    settings.detector = compressorDetectorFromName(text);
+                } else {
+                    error = where + "unknown compress setting '" + name + "'";
+                    return false;
+                }
+            }
+        } else if (keyword == "duck") {
+            std::string busName;
+            std::string keyName;
+            if (!(fields >> busName >> keyName)) {
+                error = where + "want 'duck BUS KEY TARGET... [threshold=DB] [ratio=R] [attack=MS] [release=MS]'";
+                return false;
+            }
+            BusSpec* bus = nullptr;
+            for (BusSpec& candidate : layout.buses) {
+                if (candidate.name == busName) {
+                    bus = &candidate;
+                }
+            }
+            if (!bus) {
+                error = where + "unknown bus '" + busName + "' (duck lines go after their bus)";
+                return false;
+            }
+            // Inputs are named by source; look them up among the bus's own
+            auto findBusInput = [&](const std::string& name) {
+                for (size_t i = 0; i < bus->inputs.size(); i++) {
+                    if (layout.inputs[bus->inputs[i].input].name == name) {
+                        return static_cast<int>(i);
+                    }
+                }
+                return -1;
+            };
+            bus->duckKey = findBusInput(keyName);
+            if (bus->duckKey < 0) {
+                error = where + "'" + keyName + "' is not an input of " + busName;
+                return false;
+            }
+            std::string item;
+            while (fields >> item) {
+                size_t eq = item.find('=');
+                if (eq != std::string::npos) {
+                    std::string name = item.substr(0, eq);
+                    float value = std::strtof(item.c_str() + eq + 1, nullptr);
+                    if (name == "threshold") {
+                        bus->duck.thresholdDb = value;
+                    } else if (name == "ratio") {
+                        bus->duck.ratio = value;
+                    } else if (name == "attack") {
+                        bus->duck.attackMs = value;
+                    } else if (name == "release") {
+                        bus->duck.releaseMs = value;
+                    } else {
+                        error = where + "unknown duck setting '" + name + "'";
+                        return false;
+                    }
+                    continue;
+                }
+                int target = findBusInput(item);
+                if (target < 0) {
+                    error = where + "'" + item + "' is not an input of " + busName;
+                    return false;
+                }
+                bus->duckTargets.push_back(static_cast<size_t>(target));
+            }
+        } else {
+            error = where + "unknown keyword '" + keyword + "'";
+            return false;
+        }
+    }
+
+    if (layout.buses.empty()) {
+        error = path + ": no buses";
+        return false;
+    }
+    if (layout.sampleRate <= 0 || layout.bufferFrames == 0) {
+        error = path + ": bad rate or buffer size";
+        return false;
+    }
+    return true;
+}
+
+// =============================================================================
+// Render
+// =============================================================================
+
+// One bus: its engine plus how far into each source the input side has got
+struct BusRender {
+    const BusSpec* spec;
+    std::unique_ptr<MixEngine> engine;
+    std::vector<size_t> fed;        // Input frames written per bus input
+    std::vector<float> output;      // Interleaved stereo at the layout rate
+    CallbackTiming timing;          // Per-cycle render time, as the output IOProc records it
+    perf::Stats counters;           // --perf: per-cycle hardware counters
+    BusRecorder recorder;           // --record
+    ReplayBuffer replay;            // --replay
+    StemRecorder stems;             // --stems
+    float maxDuckDb = 0.0f;         // Deepest sidechain gain reduction
+    std::vector<float> maxCompressDb;   // Deepest compressor reduction per bus input
+};
+
+static void setUpBus(const Layout& layout, const BusSpec& spec, BusRender& bus) {
+    bus.spec = &spec;
+    bus.engine = std::make_unique<MixEngine>();
+    bus.fed.assign(spec.inputs.size(), 0);
+    bus.maxCompressDb.assign(spec.inputs.size(), 0.0f);
+
+    MixEngine& engine = *bus.engine;
+    MixerParams& params = engine.params();
+    engine.setOutputSampleRate(layout.sampleRate);
+
+    // Same sequence as AudioMixer::addInput + start(): bind, add, set gains,
+    // drain and settle so the first cycle starts at the configured levels
+    std::vector<MixerParams::Command> commands;
+    for (size_t i = 0; i < spec.inputs.size(); i++) {
+        int slot = static_cast<int>(i);
+        uint32_t handle = static_cast<uint32_t>(i + 1);
+        const InputSpec& source = layout.inputs[spec.inputs[i].input];
+        engine.prepareInput(slot, source.sampleRate);
+        trace::label(engine.input(slot).traceId, source.name + " -> " + spec.name);
+        params.bindInput(handle, slot);
+        commands.push_back(MixerParams::makeAddInput(slot));
+
+        MixerParams::Command gain;
+        params.makeSetGain(handle, spec.inputs[i].gain, gain);
+        commands.push_back(gain);
+        if (spec.inputs[i].compressor.enabled) {
+            params.makeCompressor(handle, spec.inputs[i].compressor, commands);
+        }
+    }
+    commands.push_back(MixerParams::makeSetMasterGain(spec.master));
+    if (spec.duckKey >= 0) {
+        // Same batch AudioMixer::setDucking pushes
+        MixerParams::DuckingConfig ducking;
+        ducking.keyHandle = static_cast<uint32_t>(spec.duckKey + 1);
+        for (size_t target : spec.duckTargets) {
+            ducking.targetHandles.push_back(static_cast<uint32_t>(target + 1));
+        }
+        ducking.settings = spec.duck;
+        params.makeDucking(ducking, commands);
+    }
+    params.push(commands.data(), commands.size());
+    params.drain();
+    params.settle();
+}
+
+// Input side of one cycle: keep each source one buffer ahead of the render
+// side, at its own rate, the way a live input IOProc runs slightly ahead
+static void feedInputs(const Layout& layout, BusRender& bus, size_t cycle) {
+    for (size_t i = 0; i < bus.spec->inputs.size(); i++) {
+        const InputSpec& source = layout.inputs[bus.spec->inputs[i].input];
+        double ratio = source.sampleRate / layout.sampleRate;
+        size_t target = static_cast<size_t>(std::ceil((cycle + 2) * layout.bufferFrames * ratio));
+        target = std::min(target, source.frames());
+        if (target > bus.fed[i]) {
+            const float* samples = source.stereo.data() + bus.fed[i] * MixEngine::kChannels;
+            bus.engine->input(static_cast<int>(i)).write(samples, (target - bus.fed[i]) * MixEngine::kChannels);
+            bus.fed[i] = target;
+        }
+    }
+}
+
+static size_t outputLength(const Layout& layout) {
+    size_t longest = 0;
+    for (const InputSpec& input : layout.inputs) {
+        longest = std::max(longest, static_cast<size_t>(
+            std::ceil(input.frames() * layout.sampleRate / input.sampleRate)));
+    }
+    // One extra buffer lets the rings drain; whole cycles only
+    size_t cycles = (longest + layout.bufferFrames - 1) / layout.bufferFrames + 1;
+    return cycles * layout.bufferFrames;
+}
+
+// =============================================================================
+// Golden comparison
+// =============================================================================
+
+struct Comparison {
+    bool ok;
+    double maxDiff;
+    double rmsDiff;
+    std::string message;
+};
+
+static Comparison compareToGolden(const std::string& path, const WavData& rendered, double tolerance) {
+    WavData golden;
+    std::string error;
+    if (!readWav(path, golden, error)) {
+        return {false, 0, 0, error};
+    }
+    if (golden.sampleRate != rendered.sampleRate || golden.channels != rendered.channels
+        || golden.samples.size() != rendered.samples.size()) {
+        char message[160];
+        snprintf(message, sizeof(message), "shape differs: golden %u Hz x%u %zu frames, rendered %u Hz x%u %zu frames",
+                 golden.sampleRate, golden.channels, golden.frames(),
+                 rendered.sampleRate, rendered.channels, rendered.frames());
+        return {false, 0, 0, message};
+    }
+
+    double maxDiff = 0;
+    double sumSquares = 0;
+    for (size_t i = 0; i < golden.samples.size(); i++) {
+        double diff = std::fabs(static_cast<double>(golden.samples[i]) - rendered.samples[i]);
+        maxDiff = std::max(maxDiff, diff);
+        sumSquares += diff * diff;
+    }
+    double rmsDiff = golden.samples.empty() ? 0 : std::sqrt(sumSquares / golden.samples.size());
+    return {maxDiff <= tolerance, maxDiff, rmsDiff, ""};
+}
+
+// =============================================================================
+// Latency probe
+// =============================================================================
+
+struct RouteLatency {
+    size_t sent = 0;
+    std::vector<double> frames;     // One per marker found, at the output rate
+    std::vector<double> sentAt;     // When each found marker was sent, in output frames
+};
+
+// One route through its own engine: marker train in, bus output back out
+static RouteLatency measureRoute(const Layout& layout, const BusSpec& spec, size_t routeIndex,
+                                 size_t probes, double inputPhase, double maxLatencyMs) {
+    BusSpec routeSpec;              // No ducking: the key may not be on this route
+    routeSpec.name = spec.name;
+    routeSpec.inputs = {spec.inputs[routeIndex]};
+    routeSpec.master = spec.master;
+    BusRender bus;
+    setUpBus(layout, routeSpec, bus);
+    MixEngine::Input& input = bus.engine->input(0);
+
+    const size_t buffer = layout.bufferFrames;
+    const double ratio = input.sampleRate / layout.sampleRate;
+    const size_t maxLatency = static_cast<size_t>(maxLatencyMs * layout.sampleRate / 1000.0);
+    const std::vector<float> marker = probe::mlsSequence();
+    const size_t markerOut = static_cast<size_t>(std::ceil(marker.size() / ratio));
+
+    // Markers far enough apart that each search window holds only one, each
+    // landing at a different point in the cycle
+    size_t spacing = maxLatency + markerOut + 2 * buffer;
+    std::vector<double> sentAt(probes);
+    size_t totalFrames = 0;
+    for (size_t k = 0; k < probes; k++) {
+        double t = static_cast<double>(4 * buffer + k * spacing + (k * 97) % buffer);
+        sentAt[k] = std::round(t * ratio) / ratio;
+        totalFrames = static_cast<size_t>(sentAt[k]) + spacing;
+    }
+    size_t cycles = (totalFrames + buffer - 1) / buffer;
+    totalFrames = cycles * buffer;
+
+    // Source at its own rate: silence with the markers on both channels
+    size_t inputBuffer = std::max<size_t>(1, static_cast<size_t>(std::lround(buffer * ratio)));
+    size_t sourceFrames = static_cast<size_t>(std::ceil(totalFrames * ratio)) + inputBuffer;
+    std::vector<float> source(sourceFrames * MixEngine::kChannels, 0.0f);
+    const float amplitude = 0.25f;
+    for (double t : sentAt) {
+        size_t start = static_cast<size_t>(std::lround(t * ratio));
+        for (size_t i = 0; i < marker.size() && start + i < sourceFrames; i++) {
+            source[(start + i) * 2] = source[(start + i) * 2 + 1] = marker[i] * amplitude;
+        }
+    }
+
+    // What the marker looks like after the engine's converter
+    std::vector<float> reference(marker.size());
+    if (ratio != 1.0) {
+        std::vector<float> stereoIn(marker.size() * 2);
+        for (size_t i = 0; i < marker.size(); i++) {
+            stereoIn[i * 2] = stereoIn[i * 2 + 1] = marker[i];
+        }
+        std::vector<float> stereoOut(markerOut * 2 + 2);
+        SampleRateConverter converter(input.sampleRate, layout.sampleRate, MixEngine::kChannels);
+        size_t produced = converter.convert(stereoIn.data(), marker.size(), stereoOut.data(), markerOut + 1);
+        reference.resize(produced);
+        for (size_t i = 0; i < produced; i++) {
+            reference[i] = stereoOut[i * 2];
+        }
+    } else {
+        reference = marker;
+    }
+
+    // Input buffer n is delivered once captured: at ((n + 1) * inputBuffer) /
+    // ratio + phase in output frames. Deliveries due by a cycle's start run first.
+    std::vector<float> output(totalFrames * MixEngine::kChannels, 0.0f);
+    double phase = inputPhase * buffer;
+    size_t delivered = 0;
+    for (size_t cycle = 0; cycle < cycles; cycle++) {
+        double now = static_cast<double>(cycle * buffer);
+        while ((delivered + inputBuffer) / ratio + phase <= now && delivered + inputBuffer <= sourceFrames) {
+            input.write(source.data() + delivered * MixEngine::kChannels, inputBuffer * MixEngine::kChannels);
+            delivered += inputBuffer;
+        }
+        bus.engine->render(output.data() + cycle * buffer * MixEngine::kChannels, buffer);
+    }
+
+    std::vector<float> left(totalFrames);
+    for (size_t i = 0; i < totalFrames; i++) {
+        left[i] = output[i * 2];
+    }
+
+    RouteLatency result;
+    result.sent = probes;
+    for (double t : sentAt) {
+        size_t begin = static_cast<size_t>(t);
+        probe::Match match = probe::findMarker(left.data(), left.size(), reference, begin, begin + maxLatency);
+        if (match.found) {
+            // Rendered during cycle c, played during cycle c + 1
+            result.frames.push_back(match.position + buffer - t);
+            result.sentAt.push_back(t);
+        }
+    }
+    return result;
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+struct Options {
+    std::string layoutPath;
+    std::string outDir = ".";
+    std::string goldenDir;
+    double tolerance = 1e-5;
+    bool updateGolden = false;
+    std::string tracePath;
+    bool perf = false;
+    std::string recordDir;
+    BusRecorder::Format recordFormat = BusRecorder::Format::Wav;
+    double replaySeconds = 0.0;
+    double replayMegabytes = 0.0;   // 0: ReplayBuffer's default budget
+    std::string stemsDir;
+    StemRecorder::Layout stemsLayout = StemRecorder::Layout::PerFile;
+    bool latency = false;
+    size_t probes = 16;
+    double inputPhase = 0.5;        // Input cycle offset, in output buffers
+    double maxLatencyMs = 200.0;    // Correlation search window after each marker
+    double maxDriftMsPerMin = 0.5;  // Latency a route may gain or lose per minute
+};
+
+static bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--out=", 6) == 0) {
+            options.outDir = arg + 6;
+        } else if (strncmp(arg, "--golden=", 9) == 0) {
+            options.goldenDir = arg + 9;
+        } else if (strncmp(arg, "--tolerance=", 12) == 0) {
+            options.tolerance = atof(arg + 12);
+        } else if (strcmp(arg, "--update-golden") == 0) {
+            options.updateGolden = true;
+        } else if (strncmp(arg, "--trace=", 8) == 0) {
+            options.tracePath = arg + 8;
+        } else if (strcmp(arg, "--perf") == 0) {
+            options.perf = true;
+        } else if (strncmp(arg, "--record=", 9) == 0) {
+            options.recordDir = arg + 9;
+        } else if (strncmp(arg, "--record-format=", 16) == 0) {
+            if (!BusRecorder::parseFormat(arg + 16, options.recordFormat)) {
+                fprintf(stderr, "--record-format must be wav or caf\n");
+                return false;
+            }
+        } else if (strncmp(arg, "--replay=", 9) == 0) {
+            options.replaySeconds = atof(arg + 9);
+        } else if (strncmp(arg, "--replay-mb=", 12) == 0) {
+            options.replayMegabytes = std::max(0.0, atof(arg + 12));
+        } else if (strncmp(arg, "--stems=", 8) == 0) {
+            options.stemsDir = arg + 8;
+        } else if (strncmp(arg, "--stems-layout=", 15) == 0) {
+            if (!StemRecorder::parseLayout(arg + 15, options.stemsLayout)) {
+                fprintf(stderr, "--stems-layout must be files or interleaved\n");
+                return false;
+            }
+        } else if (strcmp(arg, "--latency") == 0) {
+            options.latency = true;
+        } else if (strncmp(arg, "--probes=", 9) == 0) {
+            options.probes = static_cast<size_t>(std::max(1, atoi(arg + 9)));
+        } else if (strncmp(arg, "--input-phase=", 14) == 0) {
+            options.inputPhase = std::max(0.0, atof(arg + 14));
+        } else if (strncmp(arg, "--max-latency-ms=", 17) == 0) {
+            options.maxLatencyMs = std::max(1.0, atof(arg + 17));
+        } else if (strncmp(arg, "--max-drift=", 12) == 0) {
+            options.maxDriftMsPerMin = std::max(0.0, atof(arg + 12));
+        } else if (arg[0] != '-' && options.layoutPath.empty()) {
+            options.layoutPath = arg;
+        } else {
+            fprintf(stderr, "Unknown argument %s\n", arg);
+            return false;
+        }
+    }
+    if (options.layoutPath.empty() || (options.updateGolden && options.goldenDir.empty())) {
+        fprintf(stderr, "Usage: offline_render <layout> [--out=DIR] [--golden=DIR] [--tolerance=X]\n"
+                        "                      [--update-golden] [--trace=FILE] [--perf]\n"
+                        "                      [--record=DIR] [--record-format=wav|caf]\n"
+                        "                      [--replay=SECONDS] [--replay-mb=N]\n"
+                        "                      [--stems=DIR] [--stems-layout=files|interleaved]\n"
+                        "       offline_render <layout> --latency [--probes=N] [--input-phase=F]\n"
+                        "                      [--max-latency-ms=X] [--max-drift=X]\n");
+        return false;
+    }
+    return true;
+}
+
+// Stops a bus's recorder and compares the file's audio with what was
+// rendered; frames the recorder reports dropped are the only ones allowed
+// to be missing
+static bool checkRecording(BusRender& bus, size_t renderedFrames) {
+    std::string error;
+    bool ok = bus.recorder.stop(&error);
+    BusRecorder::Stats stats = bus.recorder.stats();
+    std::string path = bus.recorder.path();
+    const char* name = bus.spec->name.c_str();
+
+    double megabytes = stats.bytesWritten / 1e6;
+    printf("  %-12s record %llu frames, %llu dropped, %.1f MB in %.3f s of writes (%.0f MB/s), "
+           "slowest write %.2f ms, backlog max %llu/%llu frames -> %s\n",
+           name, static_cast<unsigned long long>(stats.framesWritten),
+           static_cast<unsigned long long>(stats.droppedFrames), megabytes, stats.writeSeconds,
+           stats.writeSeconds > 0 ? megabytes / stats.writeSeconds : 0.0, stats.maxWriteNs / 1e6,
+           static_cast<unsigned long long>(stats.backlogMaxFrames),
+           static_cast<unsigned long long>(stats.ringCapacityFrames), path.c_str());
+    if (!ok) {
+        printf("  %-12s record FAIL  %s\n", name, error.c_str());
+        return false;
+    }
+    if (stats.framesWritten + stats.droppedFrames != renderedFrames) {
+        printf("  %-12s record FAIL  %zu frames rendered\n", name, renderedFrames);
+        return false;
+    }
+
+    // WAV and CAF both start the audio kAlignment bytes in
+    std::vector<uint8_t> bytes;
+    if (!wav::readFile(path, bytes) || bytes.size() != BusRecorder::kAlignment + stats.bytesWritten) {
+        printf("  %-12s record FAIL  file is not header + %llu audio bytes\n", name,
+               static_cast<unsigned long long>(stats.bytesWritten));
+        return false;
+    }
+    if (stats.droppedFrames == 0
+        && memcmp(bytes.data() + BusRecorder::kAlignment, bus.output.data(), stats.bytesWritten) != 0) {
+        printf("  %-12s record FAIL  audio differs from the render\n", name);
+        return false;
+    }
+    return true;
+}
+
+// Saves a bus's replay window next to its render and compares it with the
+// end of the render. Quantizing to 24 bits is the only difference allowed,
+// and only checked if the ring dropped nothing.
+static bool checkReplay(BusRender& bus, size_t renderedFrames, const std::string& outDir) {
+    const char* name = bus.spec->name.c_str();
+    std::string path = outDir + "/" + bus.spec->name + "_replay.wav";
+    std::string error;
+    uint64_t saved = 0;
+    bool ok = bus.replay.save(path, 0, saved, error);
+    ReplayBuffer::Stats stats = bus.replay.stats();
+    bus.replay.stop();
+
+    printf("  %-12s replay %.1f/%.1f s held in %.2f MB (%.2f MB/min, %.1fx smaller than Float32), "
+           "arena %.1f MB, %llu dropped, %llu evicted, encode %.3f s (slowest block %.2f ms) -> %s\n",
+           name, stats.heldSeconds, stats.windowSeconds, stats.compressedBytes / 1e6, stats.bytesPerMinute / 1e6,
+           stats.compressionRatio, stats.arenaBytes / 1e6, static_cast<unsigned long long>(stats.droppedFrames),
+           static_cast<unsigned long long>(stats.evictedFrames), stats.encodeSeconds, stats.maxEncodeNs / 1e6,
+           path.c_str());
+    if (!ok) {
+        printf("  %-12s replay FAIL  %s\n", name, error.c_str());
+        return false;
+    }
+    if (stats.droppedFrames > 0) {
+        return true;
+    }
+
+    WavData replay;
+    if (!readWav(path, replay, error) || replay.channels != MixEngine::kChannels || replay.frames() != saved
+        || saved > renderedFrames) {
+        printf("  %-12s replay FAIL  can't read back %llu frames: %s\n", name,
+               static_cast<unsigned long long>(saved), error.c_str());
+        return false;
+    }
+    const float* tail = bus.output.data() + (renderedFrames - saved) * MixEngine::kChannels;
+    double maxDiff = 0;
+    for (size_t i = 0; i < replay.samples.size(); i++) {
+        maxDiff = std::max(maxDiff, static_cast<double>(std::fabs(replay.samples[i] - tail[i])));
+    }
+    if (maxDiff > 1.0 / 8388608.0) {
+        printf("  %-12s replay FAIL  differs from the render by %.3g\n", name, maxDiff);
+        return false;
+    }
+    return true;
+}
+
+// Stops a bus's stem recorder and rebuilds the bus from the stems: summed
+// in render order (a duck key first), master gain, clip. With nothing
+// dropped that is the render exactly.
+static bool checkStems(BusRender& bus, size_t renderedFrames) {
+    const char* name = bus.spec->name.c_str();
+    std::string error;
+    bool ok = bus.stems.stop(&error);
+    StemRecorder::Stats stats = bus.stems.stats();
+    std::vector<std::string> paths = bus.stems.paths();
+
+    double megabytes = stats.bytesWritten / 1e6;
+    printf("  %-12s stems  %llu x %llu frames, %llu dropped, %zu file(s), %.1f MB in %.3f s of writes "
+           "(%.0f MB/s), slowest write %.2f ms, backlog max %llu frames\n",
+           name, static_cast<unsigned long long>(stats.stems), static_cast<unsigned long long>(stats.framesWritten),
+           static_cast<unsigned long long>(stats.droppedFrames), paths.size(), megabytes, stats.writeSeconds,
+           stats.writeSeconds > 0 ? megabytes / stats.writeSeconds : 0.0, stats.maxWriteNs / 1e6,
+           static_cast<unsigned long long>(stats.backlogMaxFrames));
+    if (!ok) {
+        printf("  %-12s stems FAIL  %s\n", name, error.c_str());
+        return false;
+    }
+    if (stats.framesWritten != renderedFrames) {
+        printf("  %-12s stems FAIL  %zu frames rendered\n", name, renderedFrames);
+        return false;
+    }
+    if (stats.droppedFrames > 0) {
+        return true;
+    }
+
+    // CAF isn't readable here; its audio is at the same offset as WAV's
+    size_t fileStems = paths.size() == 1 ? static_cast<size_t>(stats.stems) : 1;
+    size_t channels = fileStems * MixEngine::kChannels;
+    std::vector<std::vector<uint8_t>> files(paths.size());
+    for (size_t f = 0; f < paths.size(); f++) {
+        if (!wav::readFile(paths[f], files[f]) || files[f].size() < StemRecorder::kAlignment) {
+            printf("  %-12s stems FAIL  can't read %s\n", name, paths[f].c_str());
+            return false;
+        }
+        if (files[f].size() != StemRecorder::kAlignment + renderedFrames * channels * sizeof(float)) {
+            printf("  %-12s stems FAIL  %s is not header + %zu frames\n", name, paths[f].c_str(), renderedFrames);
+            return false;
+        }
+    }
+
+    std::vector<size_t> order;
+    if (bus.spec->duckKey >= 0) {
+        order.push_back(static_cast<size_t>(bus.spec->duckKey));
+    }
+    for (size_t stem = 0; stem < stats.stems; stem++) {
+        if (static_cast<int>(stem) != bus.spec->duckKey) {
+            order.push_back(stem);
+        }
+    }
+
+    std::vector<float> sum(renderedFrames * MixEngine::kChannels, 0.0f);
+    for (size_t stem : order) {
+        size_t file = paths.size() == 1 ? 0 : stem;
+        size_t s = paths.size() == 1 ? stem : 0;
+        const uint8_t* audio = files[file].data() + StemRecorder::kAlignment;
+        for (size_t frame = 0; frame < renderedFrames; frame++) {
+            for (size_t ch = 0; ch < MixEngine::kChannels; ch++) {
+                float sample;
+                memcpy(&sample, audio + ((frame * channels) + s * MixEngine::kChannels + ch) * sizeof(float),
+                       sizeof(sample));
+                sum[frame * MixEngine::kChannels + ch] += sample;
+            }
+        }
+    }
+    applyGainAndClip(sum.data(), renderedFrames, MixEngine::kChannels, bus.spec->master, 0.0f);
+
+    double maxDiff = 0;
+    for (size_t i = 0; i < sum.size(); i++) {
+        maxDiff = std::max(maxDiff, static_cast<double>(std::fabs(sum[i] - bus.output[i])));
+    }
+    if (maxDiff > 0) {
+        printf("  %-12s stems FAIL  stems sum to the bus within %.3g, not exactly\n", name, maxDiff);
+        return false;
+    }
+    return true;
+}
+
+// Every route of every bus; non-zero if any marker went missing or a route's
+// latency drifted. Either means the input slipped against the output, e.g. a
+// converter that came up short in some cycles.
+static int runLatencyProbe(const Layout& layout, const Options& options) {
+    printf("latency probe: %zu MLS markers per route, %zu-frame cycles @ %.0f Hz, input phase %.2f buffer\n",
+           options.probes, layout.bufferFrames, layout.sampleRate, options.inputPhase);
+
+    bool allFound = true;
+    for (const BusSpec& bus : layout.buses) {
+        for (size_t i = 0; i < bus.inputs.size(); i++) {
+            const InputSpec& source = layout.inputs[bus.inputs[i].input];
+            RouteLatency route = measureRoute(layout, bus, i, options.probes, options.inputPhase,
+                                              options.maxLatencyMs);
+            if (route.frames.empty()) {
+                printf("  %-12s %-12s %2zu/%zu  no markers found (silent route or over %.0f ms)\n",
+                       bus.name.c_str(), source.name.c_str(), route.frames.size(), route.sent,
+                       options.maxLatencyMs);
+                allFound = false;
+                continue;
+            }
+
+            double sum = 0;
+            double lowest = route.frames[0];
+            double highest = route.frames[0];
+            for (double frames : route.frames) {
+                sum += frames;
+                lowest = std::min(lowest, frames);
+                highest = std::max(highest, frames);
+            }
+            double mean = sum / route.frames.size();
+            double variance = 0;
+            for (double frames : route.frames) {
+                variance += (frames - mean) * (frames - mean);
+            }
+            double jitter = std::sqrt(variance / route.frames.size());
+
+            // Least-squares slope of latency against send time
+            double meanSent = 0;
+            for (double t : route.sentAt) {
+                meanSent += t;
+            }
+            meanSent /= route.sentAt.size();
+            double covariance = 0;
+            double spread = 0;
+            for (size_t k = 0; k < route.frames.size(); k++) {
+                covariance += (route.sentAt[k] - meanSent) * (route.frames[k] - mean);
+                spread += (route.sentAt[k] - meanSent) * (route.sentAt[k] - meanSent);
+            }
+            double drift = spread > 0 ? covariance / spread : 0;    // Frames of latency per frame
+
+            double msPerFrame = 1000.0 / layout.sampleRate;
+            printf("  %-12s %-12s %2zu/%zu  mean %6.2f ms  min %6.2f  max %6.2f  jitter %.3f ms sd  "
+                   "drift %+.1f ms/min  (%.1f frames)\n",
+                   bus.name.c_str(), source.name.c_str(), route.frames.size(), route.sent,
+                   mean * msPerFrame, lowest * msPerFrame, highest * msPerFrame, jitter * msPerFrame,
+                   drift * 60000.0, mean);
+            allFound = allFound && route.frames.size() == route.sent;
+            if (std::fabs(drift * 60000.0) > options.maxDriftMsPerMin) {
+                printf("  %-12s %-12s FAIL  drift over %.2f ms/min\n", bus.name.c_str(), source.name.c_str(),
+                       options.maxDriftMsPerMin);
+                allFound = false;
+            }
+        }
+    }
+    return allFound ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 2;
+    }
+
+    Layout layout;
+    std::string error;
+    if (!loadLayout(options.layoutPath, layout, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+
+    if (options.latency) {
+        return runLatencyProbe(layout, options);
+    }
+
+    size_t totalFrames = outputLength(layout);
+    size_t cycles = totalFrames / layout.bufferFrames;
+
+    if (!options.tracePath.empty()) {
+        trace::start();     // Before setup, so the rate and SRC events are in it
+    }
+
+    std::vector<BusRender> buses(layout.buses.size());
+    for (size_t b = 0; b < layout.buses.size(); b++) {
+        setUpBus(layout, layout.buses[b], buses[b]);
+        buses[b].output.assign(totalFrames * MixEngine::kChannels, 0.0f);
+    }
+
+    // Opened on this thread, which does all the rendering; the counter reads
+    // wrap the timing so they don't show up in it
+    perf::CounterGroup counters;
+    if (options.perf) {
+        std::string perfError;
+        bool opened = counters.open(perfError);
+        if (!perfError.empty()) {
+            printf("perf: %s%s\n", perfError.c_str(), opened ? "" : "; no counters");
+        }
+    }
+
+    if (!options.recordDir.empty()) {
+        const char* extension = options.recordFormat == BusRecorder::Format::Wav ? ".wav" : ".caf";
+        for (BusRender& bus : buses) {
+            std::string path = options.recordDir + "/" + bus.spec->name + extension;
+            if (!bus.recorder.start(path, options.recordFormat, layout.sampleRate, error)) {
+                fprintf(stderr, "%s\n", error.c_str());
+                return 1;
+            }
+        }
+    }
+
+    if (options.replaySeconds > 0) {
+        size_t maxBytes = static_cast<size_t>(options.replayMegabytes * 1e6);
+        for (BusRender& bus : buses) {
+            if (!bus.replay.start(layout.sampleRate, options.replaySeconds, maxBytes, error)) {
+                fprintf(stderr, "%s\n", error.c_str());
+                return 1;
+            }
+        }
+    }
+
+    if (!options.stemsDir.empty()) {
+        mkdir(options.stemsDir.c_str(), 0755);
+        for (BusRender& bus : buses) {
+            std::vector<StemRecorder::Stem> stems;
+            for (size_t i = 0; i < bus.spec->inputs.size(); i++) {
+                stems.push_back({static_cast<int>(i), layout.inputs[bus.spec->inputs[i].input].name});
+            }
+            std::string directory = options.stemsDir + "/" + bus.spec->name;
+            mkdir(directory.c_str(), 0755);
+            bus.engine->setStemRecorder(&bus.stems);
+            if (!bus.stems.start(directory, stems, options.stemsLayout, options.recordFormat, layout.sampleRate,
+                                 error)) {
+                fprintf(stderr, "%s\n", error.c_str());
+                return 1;
+            }
+        }
+    }
+
+    // Once per second of audio: well inside the replay and stem rings
+    size_t flushCycles = std::max<size_t>(1, static_cast<size_t>(layout.sampleRate / layout.bufferFrames));
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t cycle = 0; cycle < cycles; cycle++) {
+        for (BusRender& bus : buses) {
+            feedInputs(layout, bus, cycle);
+            float* out = bus.output.data() + cycle * layout.bufferFrames * MixEngine::kChannels;
+            perf::Scope counting(counters, bus.counters, layout.bufferFrames);
+            CallbackTiming::Scope timing(bus.timing);
+            timing.setPeriod(layout.bufferFrames, layout.sampleRate);
+            bus.engine->render(out, layout.bufferFrames);
+            bus.maxDuckDb = std::max(bus.maxDuckDb, bus.engine->duckReductionDb());
+            for (size_t i = 0; i < bus.maxCompressDb.size(); i++) {
+                const MixEngine::Input& input = bus.engine->input(static_cast<int>(i));
+                float reduction = input.gainReductionDb.load(std::memory_order_relaxed);
+                bus.maxCompressDb[i] = std::max(bus.maxCompressDb[i], reduction);
+            }
+            bus.recorder.push(out, layout.bufferFrames);
+            bus.replay.push(out, layout.bufferFrames);
+            if ((cycle + 1) % flushCycles == 0) {
+                // Keeps the rings from overflowing faster than real time
+                if (options.replaySeconds > 0) {
+                    bus.replay.flush();
+                }
+                if (!options.stemsDir.empty()) {
+                    bus.stems.flush();
+                }
+            }
+        }
+    }
+    double renderS = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!options.tracePath.empty()) {
+        trace::stop();
+        size_t events = 0;
+        if (!trace::writeChromeJson(options.tracePath, events, error)) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        printf("trace: %zu events -> %s\n", events, options.tracePath.c_str());
+        trace::Overflow lost = trace::overflow();
+        if (lost.threads > 0) {
+            printf("trace: %zu thread(s) found every slot taken; %zu event(s) dropped\n", lost.threads,
+                   lost.events);
+        }
+    }
+    double audioS = totalFrames / layout.sampleRate;
+
+    printf("rendered %zu bus(es) x %.2f s in %.3f s (%.0fx real time, %zu-frame cycles @ %.0f Hz)\n",
+           buses.size(), audioS, renderS, renderS > 0 ? audioS * buses.size() / renderS : 0.0,
+           layout.bufferFrames, layout.sampleRate);
+
+    bool allMatch = true;
+    if (!options.recordDir.empty()) {
+        for (BusRender& bus : buses) {
+            allMatch = checkRecording(bus, cycles * layout.bufferFrames) && allMatch;
+        }
+    }
+    if (options.replaySeconds > 0) {
+        for (BusRender& bus : buses) {
+            allMatch = checkReplay(bus, cycles * layout.bufferFrames, options.outDir) && allMatch;
+        }
+    }
+    if (!options.stemsDir.empty()) {
+        for (BusRender& bus : buses) {
+            allMatch = checkStems(bus, cycles * layout.bufferFrames) && allMatch;
+        }
+    }
+
+    for (BusRender& bus : buses) {
+        WavData rendered;
+        rendered.sampleRate = static_cast<uint32_t>(layout.sampleRate);
+        rendered.channels = MixEngine::kChannels;
+        rendered.samples = bus.output;
+
+        const std::string& name = bus.spec->name;
+        std::string outPath = (options.updateGolden ? options.goldenDir : options.outDir) + "/" + name + ".wav";
+        if (!writeWav(outPath, rendered)) {
+            fprintf(stderr, "Can't write %s\n", outPath.c_str());
+            return 1;
+        }
+
+        CallbackTiming::Snapshot timing = bus.timing.snapshot();
+        printf("  %-12s cycle p50 %.1f us  p99 %.1f us  max %.1f us  (period %.0f us, %llu over)\n", name.c_str(),
+               timing.p50Ns / 1000.0, timing.p99Ns / 1000.0, timing.maxNs / 1000.0, timing.periodNs / 1000.0,
+               static_cast<unsigned long long>(timing.deadlineMisses));
+        if (bus.spec->duckKey >= 0) {
+            printf("  %-12s duck  key %s, %zu target(s), deepest reduction %.1f dB\n", name.c_str(),
+                   layout.inputs[bus.spec->inputs[bus.spec->duckKey].input].name.c_str(),
+                   bus.spec->duckTargets.size(), bus.maxDuckDb);
+        }
+        for (size_t i = 0; i < bus.spec->inputs.size(); i++) {
+            const CompressorSettings& settings = bus.spec->inputs[i].compressor;
+            if (settings.enabled) {
+                printf("  %-12s comp  %s %.0f dB %.1f:1, deepest reduction %.1f dB\n", name.c_str(),
+                       layout.inputs[bus.spec->inputs[i].input].name.c_str(), settings.thresholdDb,
+                       settings.ratio, bus.maxCompressDb[i]);
+            }
+        }
+        if (counters.isOpen()) {
+            printf("  %-12s perf  %s\n", name.c_str(), bus.counters.summary(counters).c_str());
+        }
+
+        // Inputs run dry once their files end, so underruns at the tail are expected
+        RingStats::Snapshot xruns = {};
+        for (size_t i = 0; i < bus.spec->inputs.size(); i++) {
+            xruns += bus.engine->input(static_cast<int>(i)).ringStats.read();
+        }
+        printf("  %-12s rings %llu underrun(s) / %llu silent frames, %llu overflow(s) / %llu dropped, fill %llu..%llu frames\n",
+               name.c_str(), static_cast<unsigned long long>(xruns.underruns),
+               static_cast<unsigned long long>(xruns.silentFrames), static_cast<unsigned long long>(xruns.overflows),
+               static_cast<unsigned long long>(xruns.droppedFrames), static_cast<unsigned long long>(xruns.fillMinFrames),
+               static_cast<unsigned long long>(xruns.fillMaxFrames));
+
+        if (options.updateGolden || options.goldenDir.empty()) {
+            printf("  %-12s -> %s\n", name.c_str(), outPath.c_str());
+            continue;
+        }
+
+        Comparison result = compareToGolden(options.goldenDir + "/" + name + ".wav", rendered, options.tolerance);
+        if (!result.message.empty()) {
+            printf("  %-12s FAIL  %s\n", name.c_str(), result.message.c_str());
+        } else {
+            printf("  %-12s %s  max diff %.3g  rms diff %.3g  (tolerance %.3g)\n", name.c_str(),
+                   result.ok ? "ok  " : "FAIL", result.maxDiff, result.rmsDiff, options.tolerance);
+        }
+        allMatch = allMatch && result.ok;
+    }
+
+#if PCPANEL_RT_SANITIZER
+    if (rtsan::violationCount() > 0) {
+        printf("FAIL: %zu real-time safety violation(s) in the render path\n", rtsan::violationCount());
+        return 1;
+    }
+    printf("rtsan: no real-time safety violations\n");
+#endif
+
+    return allMatch ? 0 : 1;
+}
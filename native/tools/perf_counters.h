@@ -0,0 +1,229 @@
+// PC Panel Pro - hardware performance counters for the host tools
+// Counts cycles, instructions, cache and branch misses for the calling
+// thread with Linux perf_event, so a benchmark can tell a compute-bound loop
+// from a memory-bound one. The counters run as one group and are read with
+// a single read() at each end of a measured region, which is cheap next to a
+// render cycle but not free: keep it out of timings it would skew.
+//
+// Counters the kernel or the machine doesn't offer (VMs often expose no PMU,
+// and perf_event_paranoid may forbid them) are reported as unavailable; off
+// Linux all of them are.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace perf {
+
+enum Counter { Cycles, Instructions, CacheMisses, BranchMisses, kCounterCount };
+
+inline const char* counterName(int counter) {
+    static const char* const names[kCounterCount] = {"cycles", "instructions", "cache-misses", "branch-misses"};
+    return names[counter];
+}
+
+// Counter deltas over one region; meaningful only where available[i]
+struct Sample {
+    uint64_t values[kCounterCount];
+};
+
+// The calling thread's counters. Open on the thread that will be measured.
+class CounterGroup {
+public:
+    CounterGroup() {
+        for (int i = 0; i < kCounterCount; i++) {
+            fds_[i] = -1;
+            available_[i] = false;
+        }
+    }
+    ~CounterGroup() { close(); }
+    CounterGroup(const CounterGroup&) = delete;
+    CounterGroup& operator=(const CounterGroup&) = delete;
+
+    // True if at least one counter opened; error says why any did not
+    bool open(std::string& error) {
+#ifdef __linux__
+        static const uint64_t configs[kCounterCount] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES,
+        };
+        int leader = -1;
+        for (int i = 0; i < kCounterCount; i++) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.disabled = leader < 0;         // The group starts with its leader
+            attr.exclude_kernel = 1;            // Allowed at perf_event_paranoid 2
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID;
+            int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+            if (fd < 0) {
+                if (error.empty()) {
+                    error = std::string(counterName(i)) + ": " + strerror(errno);
+                }
+                continue;
+            }
+            uint64_t id = 0;
+            ioctl(fd, PERF_EVENT_IOC_ID, &id);
+            fds_[i] = fd;
+            ids_[i] = id;
+            available_[i] = true;
+            if (leader < 0) {
+                leader = fd;
+            }
+        }
+        if (leader < 0) {
+            return false;
+        }
+        leader_ = leader;
+        ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        return true;
+#else
+        error = "perf_event is Linux only";
+        return false;
+#endif
+    }
+
+    bool isOpen() const { return leader_ >= 0; }
+    bool available(int counter) const { return available_[counter]; }
+
+    // Running totals since open(); unavailable counters read as 0
+    bool read(Sample& sample) const {
+        for (uint64_t& value : sample.values) {
+            value = 0;
+        }
+#ifdef __linux__
+        if (leader_ < 0) {
+            return false;
+        }
+        // PERF_FORMAT_GROUP | PERF_FORMAT_ID: nr, then {value, id} per member
+        uint64_t buffer[1 + 2 * kCounterCount];
+        ssize_t bytes = ::read(leader_, buffer, sizeof(buffer));
+        if (bytes < static_cast<ssize_t>(sizeof(uint64_t))) {
+            return false;
+        }
+        uint64_t count = buffer[0];
+        for (uint64_t n = 0; n < count && n < kCounterCount; n++) {
+            for (int i = 0; i < kCounterCount; i++) {
+                if (available_[i] && ids_[i] == buffer[2 + 2 * n]) {
+                    sample.values[i] = buffer[1 + 2 * n];
+                }
+            }
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void close() {
+#ifdef __linux__
+        for (int i = 0; i < kCounterCount; i++) {
+            if (fds_[i] >= 0) {
+                ::close(fds_[i]);
+                fds_[i] = -1;
+            }
+            available_[i] = false;
+        }
+#endif
+        leader_ = -1;
+    }
+
+private:
+    int fds_[kCounterCount];
+    uint64_t ids_[kCounterCount] = {};
+    bool available_[kCounterCount];
+    int leader_ = -1;
+};
+
+// Per-region statistics: totals for per-frame averages, worst region per counter
+class Stats {
+public:
+    void record(const Sample& before, const Sample& after, size_t frames) {
+        for (int i = 0; i < kCounterCount; i++) {
+            uint64_t delta = after.values[i] - before.values[i];
+            totals_[i] += delta;
+            if (delta > max_[i]) {
+                max_[i] = delta;
+            }
+        }
+        regions_++;
+        frames_ += frames;
+    }
+
+    uint64_t regions() const { return regions_; }
+    double perFrame(int counter) const { return frames_ > 0 ? static_cast<double>(totals_[counter]) / frames_ : 0; }
+    double perRegion(int counter) const { return regions_ > 0 ? static_cast<double>(totals_[counter]) / regions_ : 0; }
+    uint64_t max(int counter) const { return max_[counter]; }
+
+    // "cycles 12.3/frame  instructions 30.1/frame  IPC 2.45  ..." for the available counters
+    std::string summary(const CounterGroup& group) const {
+        std::string text;
+        char part[96];
+        for (int i = 0; i < kCounterCount; i++) {
+            if (group.available(i)) {
+                snprintf(part, sizeof(part), "%s%s %.2f/frame", text.empty() ? "" : "  ", counterName(i), perFrame(i));
+                text += part;
+            }
+        }
+        if (group.available(Cycles) && group.available(Instructions) && totals_[Cycles] > 0) {
+            snprintf(part, sizeof(part), "  IPC %.2f",
+                     static_cast<double>(totals_[Instructions]) / totals_[Cycles]);
+            text += part;
+        }
+        if (group.available(CacheMisses) && group.available(Instructions) && totals_[Instructions] > 0) {
+            // Misses per thousand instructions: high MPKI with low IPC means memory-bound
+            snprintf(part, sizeof(part), "  %.2f cache MPKI",
+                     1000.0 * totals_[CacheMisses] / totals_[Instructions]);
+            text += part;
+        }
+        return text.empty() ? "no counters available" : text;
+    }
+
+private:
+    uint64_t totals_[kCounterCount] = {};
+    uint64_t max_[kCounterCount] = {};
+    uint64_t regions_ = 0;
+    uint64_t frames_ = 0;
+};
+
+// Counts one region into stats, like CallbackTiming::Scope
+class Scope {
+public:
+    Scope(const CounterGroup& group, Stats& stats, size_t frames)
+        : group_(group), stats_(stats), frames_(frames) {
+        active_ = group_.read(before_);
+    }
+    ~Scope() {
+        Sample after;
+        if (active_ && group_.read(after)) {
+            stats_.record(before_, after, frames_);
+        }
+    }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const CounterGroup& group_;
+    Stats& stats_;
+    size_t frames_;
+    Sample before_;
+    bool active_;
+};
+
+}  // namespace perf
@@ -0,0 +1,219 @@
+// PC Panel Pro - property check for the SPSC ring buffers
+// Decodes the input bytes into a sequence of writes, reads and clears, runs
+// them against RingBuffer and LoopbackBuffer on one thread and compares each
+// result with a plain std::deque model:
+//
+//   - a read returns exactly the oldest frames the model holds, padded with
+//     silence, and never a partial frame
+//   - a write keeps exactly as many whole frames as fit
+//   - LoopbackBuffer::clear() drops what was written before it, from the
+//     next read on
+//   - RingStats agrees with the model's overflow and underrun counts
+//
+// With clang this is a libFuzzer target (-fsanitize=fuzzer,address). Other
+// compilers get a small driver instead:
+//
+//   ring_fuzz [--runs=N] [--seed=N]      random inputs
+//   ring_fuzz FILE...                    replay inputs, e.g. a saved crash
+
+#include "LoopbackBuffer.hpp"
+#include "engine/ring_buffer.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr size_t kBytesPerFrame = sizeof(uint64_t);     // One sequence number per frame
+
+static_assert(LoopbackBuffer::kBytesPerFrame == kBytesPerFrame, "frames must match the loopback ring");
+
+// Reads the input a byte at a time; zeros once it runs out
+class Input {
+public:
+    Input(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    bool done() const { return position_ >= size_; }
+    uint8_t byte() { return position_ < size_ ? data_[position_++] : 0; }
+    uint16_t word() { return static_cast<uint16_t>(byte() | (byte() << 8)); }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t position_ = 0;
+};
+
+[[noreturn]] void fail(const char* ring, const char* what, uint64_t got, uint64_t expected) {
+    fprintf(stderr, "%s: %s: got %" PRIu64 ", expected %" PRIu64 "\n", ring, what, got, expected);
+    abort();
+}
+
+// Ring is RingBuffer or LoopbackBuffer; capacityFrames is how many frames it holds
+template <typename Ring>
+void check(const char* name, Ring& ring, RingStats& stats, size_t capacityFrames, size_t chunkScale,
+           bool canClear, Input& input) {
+    std::deque<uint64_t> model;
+    uint64_t next = 1;                  // 0 is what short reads are padded with
+    uint64_t clearMark = 0;             // Frames below this were cleared
+    bool clearPending = false;
+    uint64_t dropped = 0;
+    uint64_t silent = 0;
+    std::vector<uint64_t> frames;
+
+    while (!input.done()) {
+        uint8_t op = input.byte();
+        size_t count = static_cast<size_t>(input.word() % 1024) * chunkScale / 16;
+
+        switch (op % 3) {
+            case 0: {
+                frames.resize(count);
+                for (uint64_t& frame : frames) {
+                    frame = next++;
+                }
+                ring.write(frames.data(), count * kBytesPerFrame);
+                size_t fits = std::min(count, capacityFrames - model.size());
+                model.insert(model.end(), frames.begin(), frames.begin() + fits);
+                dropped += count - fits;
+                break;
+            }
+            case 1: {
+                if (clearPending) {
+                    while (!model.empty() && model.front() < clearMark) {
+                        model.pop_front();
+                    }
+                    clearPending = false;
+                }
+                frames.assign(count, UINT64_MAX);
+                size_t bytes = ring.read(frames.data(), count * kBytesPerFrame);
+                if (bytes % kBytesPerFrame != 0) {
+                    fail(name, "read returned a partial frame (bytes)", bytes, bytes - bytes % kBytesPerFrame);
+                }
+                size_t expected = std::min(count, model.size());
+                if (bytes / kBytesPerFrame != expected) {
+                    fail(name, "frames read", bytes / kBytesPerFrame, expected);
+                }
+                for (size_t i = 0; i < count; i++) {
+                    uint64_t want = i < expected ? model[i] : 0;
+                    if (frames[i] != want) {
+                        fail(name, "frame value", frames[i], want);
+                    }
+                }
+                model.erase(model.begin(), model.begin() + expected);
+                silent += count - expected;
+                break;
+            }
+            case 2:
+                if (canClear) {
+                    ring.clear();
+                    clearMark = next;
+                    clearPending = true;
+                }
+                break;
+        }
+    }
+
+    RingStats::Snapshot snap = stats.read();
+    if (snap.droppedFrames != dropped) {
+        fail(name, "dropped frames", snap.droppedFrames, dropped);
+    }
+    if (snap.silentFrames != silent) {
+        fail(name, "silent frames", snap.silentFrames, silent);
+    }
+}
+
+// RingBuffer has no clear()
+struct CaptureRing {
+    RingStats stats;
+    RingBuffer ring;
+
+    explicit CaptureRing(size_t frames) : ring(frames, 2, kBytesPerFrame, &stats) {}
+    void write(const void* data, size_t bytes) { ring.write(data, bytes); }
+    size_t read(void* data, size_t bytes) { return ring.read(data, bytes); }
+    void clear() {}
+};
+
+void runOne(const uint8_t* data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+
+    // First byte picks the ring and, for RingBuffer, its size
+    uint8_t selector = data[0];
+    Input input(data + 1, size - 1);
+    if (selector & 1) {
+        // Kept tiny so the model sees wrap-around and full/empty edges often
+        size_t frames = 2 + (selector >> 1);
+        CaptureRing capture(frames);
+        // RingBuffer keeps one byte free, i.e. one frame once rounded down
+        check("RingBuffer", capture, capture.stats, frames - 1, 1 + frames / 64, false, input);
+    } else {
+        auto loopback = std::make_unique<LoopbackBuffer>();
+        check("LoopbackBuffer", *loopback, loopback->stats(), LoopbackBuffer::kBufferFrames,
+              LoopbackBuffer::kBufferFrames / 2048, true, input);
+    }
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    runOne(data, size);
+    return 0;
+}
+
+#ifndef PCPANEL_LIBFUZZER
+int main(int argc, char** argv) {
+    long runs = 20000;
+    uint32_t seed = 1;
+    std::vector<const char*> files;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--runs=", 7) == 0) {
+            runs = atol(argv[i] + 7);
+        } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+            seed = static_cast<uint32_t>(strtoul(argv[i] + 7, nullptr, 10));
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Usage: ring_fuzz [--runs=N] [--seed=N] | ring_fuzz FILE...\n");
+            return 2;
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+
+    if (!files.empty()) {
+        for (const char* path : files) {
+            FILE* file = fopen(path, "rb");
+            if (!file) {
+                fprintf(stderr, "Can't open %s\n", path);
+                return 1;
+            }
+            std::vector<uint8_t> data;
+            uint8_t chunk[4096];
+            size_t got;
+            while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+                data.insert(data.end(), chunk, chunk + got);
+            }
+            fclose(file);
+            runOne(data.data(), data.size());
+        }
+        printf("%zu inputs ok\n", files.size());
+        return 0;
+    }
+
+    std::mt19937 random(seed);
+    std::vector<uint8_t> data;
+    for (long run = 0; run < runs; run++) {
+        data.resize(std::uniform_int_distribution<size_t>(1, 512)(random));
+        for (uint8_t& byte : data) {
+            byte = static_cast<uint8_t>(random());
+        }
+        runOne(data.data(), data.size());
+    }
+    printf("%ld random inputs ok\n", runs);
+    return 0;
+}
+#endif
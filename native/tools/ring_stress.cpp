@@ -0,0 +1,276 @@
+// PC Panel Pro - SPSC ring buffer stress test
+// Hammers RingBuffer (addon capture/passthrough ring) and LoopbackBuffer
+// (driver loopback) with a real producer and consumer thread, each moving
+// randomly sized chunks in random bursts so the ring runs both full and
+// empty. Every frame carries a 64-bit sequence number; the consumer checks:
+//
+//   - sequence numbers only ever increase (no duplication or reordering)
+//   - every frame is one the producer wrote (no torn or stale frames)
+//   - padding after a short read is silence
+//   - frames missing from the sequence add up to the ring's reported drops
+//
+// --clear adds a third thread calling LoopbackBuffer::clear() the way the
+// driver's StartIO/StopIO do while I/O may still be running. Cleared frames
+// are not counted as drops, so only the ordering checks apply.
+//
+// Usage: ring_stress [--ring=ring|loopback|all] [--seconds=N] [--seed=N]
+//                    [--max-chunk=FRAMES] [--clear]
+//
+// ring_stress_tsan is the same program built with ThreadSanitizer.
+
+#include "LoopbackBuffer.hpp"
+#include "engine/ring_buffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t kBytesPerFrame = sizeof(uint64_t);     // One sequence number; stereo Float32 size
+
+static_assert(LoopbackBuffer::kBytesPerFrame == kBytesPerFrame, "frames must match the loopback ring");
+
+struct Options {
+    std::string ring = "all";
+    double seconds = 2.0;
+    uint32_t seed = 1;
+    size_t maxChunk = 1024;
+    bool clear = false;
+};
+
+// RingBuffer and LoopbackBuffer behind one interface
+struct RingUnderTest {
+    virtual ~RingUnderTest() = default;
+    virtual void write(const void* data, size_t bytes) = 0;
+    virtual size_t read(void* data, size_t bytes) = 0;
+    virtual void clear() = 0;
+    virtual RingStats& stats() = 0;
+};
+
+struct CaptureRing : RingUnderTest {
+    RingStats ringStats;
+    RingBuffer ring;
+
+    explicit CaptureRing(size_t frames) : ring(frames, 2, kBytesPerFrame, &ringStats) {}
+    void write(const void* data, size_t bytes) override { ring.write(data, bytes); }
+    size_t read(void* data, size_t bytes) override { return ring.read(data, bytes); }
+    void clear() override {}
+    RingStats& stats() override { return ringStats; }
+};
+
+struct Loopback : RingUnderTest {
+    LoopbackBuffer ring;
+
+    void write(const void* data, size_t bytes) override { ring.write(data, bytes); }
+    size_t read(void* data, size_t bytes) override { return ring.read(data, bytes); }
+    void clear() override { ring.clear(); }
+    RingStats& stats() override { return ring.stats(); }
+};
+
+struct Result {
+    uint64_t produced = 0;
+    uint64_t received = 0;
+    uint64_t gapFrames = 0;
+    uint64_t shortReads = 0;
+    uint64_t clears = 0;
+    std::string failure;
+};
+
+// Alternates bursts of work with pauses so each side sometimes outruns the other
+class Pacer {
+public:
+    explicit Pacer(uint32_t seed) : random_(seed) {}
+
+    size_t chunk(size_t maxChunk) {
+        return std::uniform_int_distribution<size_t>(1, maxChunk)(random_);
+    }
+
+    void pace() {
+        if (remaining_ == 0) {
+            remaining_ = std::uniform_int_distribution<int>(1, 400)(random_);
+            int pause = std::uniform_int_distribution<int>(0, 3)(random_);
+            if (pause == 1) {
+                std::this_thread::yield();
+            } else if (pause == 2) {
+                std::this_thread::sleep_for(std::chrono::microseconds(
+                    std::uniform_int_distribution<int>(50, 2000)(random_)));
+            }
+        }
+        remaining_--;
+    }
+
+private:
+    std::mt19937 random_;
+    int remaining_ = 0;
+};
+
+Result run(RingUnderTest& ring, const Options& options, uint32_t seed) {
+    Result result;
+    std::atomic<uint64_t> published{0};     // Sequence numbers below this have been written
+    std::atomic<bool> producing{true};
+    std::atomic<bool> running{true};
+
+    std::thread producer([&] {
+        Pacer pacer(seed * 3 + 1);
+        std::vector<uint64_t> frames(options.maxChunk);
+        uint64_t next = 0;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(options.seconds);
+        while (std::chrono::steady_clock::now() < deadline) {
+            size_t count = pacer.chunk(options.maxChunk);
+            for (size_t i = 0; i < count; i++) {
+                frames[i] = next + i;
+            }
+            published.store(next + count, std::memory_order_release);
+            ring.write(frames.data(), count * kBytesPerFrame);
+            next += count;
+            pacer.pace();
+        }
+        result.produced = next;
+        producing.store(false, std::memory_order_release);
+    });
+
+    std::thread clearer;
+    if (options.clear) {
+        clearer = std::thread([&] {
+            Pacer pacer(seed * 5 + 2);
+            while (running.load(std::memory_order_acquire)) {
+                std::this_thread::sleep_for(std::chrono::microseconds(pacer.chunk(5000)));
+                ring.clear();
+                result.clears++;
+            }
+        });
+    }
+
+    // Consumer on this thread
+    Pacer pacer(seed * 7 + 3);
+    std::vector<uint64_t> frames(options.maxChunk);
+    uint64_t expected = 0;
+    bool drained = false;
+    while (!drained && result.failure.empty()) {
+        bool finished = !producing.load(std::memory_order_acquire);
+        size_t count = pacer.chunk(options.maxChunk);
+        memset(frames.data(), 0xAB, count * kBytesPerFrame);
+        size_t bytes = ring.read(frames.data(), count * kBytesPerFrame);
+        uint64_t limit = published.load(std::memory_order_acquire);
+
+        char message[200];
+        if (bytes % kBytesPerFrame != 0) {
+            snprintf(message, sizeof(message), "read returned %zu bytes, not whole frames", bytes);
+            result.failure = message;
+            break;
+        }
+        size_t got = bytes / kBytesPerFrame;
+        for (size_t i = 0; i < got; i++) {
+            uint64_t value = frames[i];
+            if (value < expected || value >= limit) {
+                snprintf(message, sizeof(message), "frame %" PRIu64 " after %" PRIu64 " (written so far: %" PRIu64 ")",
+                         value, expected, limit);
+                result.failure = message;
+                break;
+            }
+            result.gapFrames += value - expected;
+            expected = value + 1;
+        }
+        for (size_t i = got; i < count && result.failure.empty(); i++) {
+            if (frames[i] != 0) {
+                result.failure = "short read not padded with silence";
+            }
+        }
+        result.received += got;
+        if (got < count) {
+            result.shortReads++;
+        }
+        // Empty after the producer finished: everything has been seen
+        drained = finished && got == 0;
+        pacer.pace();
+    }
+
+    running.store(false, std::memory_order_release);
+    producer.join();
+    if (clearer.joinable()) {
+        clearer.join();
+    }
+
+    if (result.failure.empty() && !options.clear) {
+        // The missing frames are exactly the ones write() reported dropping
+        RingStats::Snapshot stats = ring.stats().read();
+        if (result.gapFrames + (result.produced - expected) != stats.droppedFrames) {
+            char message[200];
+            snprintf(message, sizeof(message), "%" PRIu64 " frames missing but %" PRIu64 " reported dropped",
+                     result.gapFrames + (result.produced - expected), static_cast<uint64_t>(stats.droppedFrames));
+            result.failure = message;
+        }
+    }
+    return result;
+}
+
+bool report(const char* name, const Result& result) {
+    printf("%-16s %10" PRIu64 " written  %10" PRIu64 " read  %9" PRIu64 " dropped  %7" PRIu64 " short reads",
+           name, result.produced, result.received, result.gapFrames, result.shortReads);
+    if (result.clears > 0) {
+        printf("  %" PRIu64 " clears", result.clears);
+    }
+    printf("  %s\n", result.failure.empty() ? "ok" : "FAIL");
+    if (!result.failure.empty()) {
+        printf("  %s\n", result.failure.c_str());
+    }
+    return result.failure.empty();
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--ring=", 7) == 0) {
+            options.ring = arg + 7;
+        } else if (strncmp(arg, "--seconds=", 10) == 0) {
+            options.seconds = atof(arg + 10);
+        } else if (strncmp(arg, "--seed=", 7) == 0) {
+            options.seed = static_cast<uint32_t>(strtoul(arg + 7, nullptr, 10));
+        } else if (strncmp(arg, "--max-chunk=", 12) == 0) {
+            options.maxChunk = std::max<size_t>(1, strtoul(arg + 12, nullptr, 10));
+        } else if (strcmp(arg, "--clear") == 0) {
+            options.clear = true;
+        } else {
+            fprintf(stderr, "Unknown argument %s\n", arg);
+            return false;
+        }
+    }
+    if (options.ring != "ring" && options.ring != "loopback" && options.ring != "all") {
+        fprintf(stderr, "--ring must be ring, loopback or all\n");
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "Usage: ring_stress [--ring=ring|loopback|all] [--seconds=N] [--seed=N]\n"
+                        "                   [--max-chunk=FRAMES] [--clear]\n");
+        return 2;
+    }
+
+    bool ok = true;
+    if ((options.ring == "ring" || options.ring == "all") && !options.clear) {
+        // Small enough that the producer's bursts overflow it
+        CaptureRing ring(4096);
+        ok = report("RingBuffer", run(ring, options, options.seed)) && ok;
+    }
+    if (options.ring == "loopback" || options.ring == "all") {
+        auto ring = std::make_unique<Loopback>();
+        ok = report(options.clear ? "LoopbackBuffer+clear" : "LoopbackBuffer",
+                    run(*ring, options, options.seed + 1)) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,470 @@
+// PC Panel Pro - real-time safety sanitizer runtime (Linux, glibc)
+// Link into a tool built with PCPANEL_RT_SANITIZER=1. Interposes the libc
+// entry points an audio callback must never reach - allocation, mutexes and
+// condition variables, blocking I/O and sleeps, stdio and syslog - and reports
+// any call made inside an rtsan::Scope with a stack trace.
+//
+// PCPANEL_RTSAN=abort   report the first violation and abort (default)
+// PCPANEL_RTSAN=report  report and keep going; the tool checks violationCount()
+// PCPANEL_RTSAN=off     count only
+
+#ifndef __linux__
+#error "rt_sanitizer.cpp interposes glibc symbols and only builds on Linux"
+#endif
+
+#include "engine/rt_scope.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <syslog.h>
+#include <time.h>
+#include <unistd.h>
+
+#if !PCPANEL_RT_SANITIZER
+#error "Build the tool with PCPANEL_RT_SANITIZER=1 so the scope markers are live"
+#endif
+
+// glibc's own entry points, so the allocator interposers never recurse
+extern "C" {
+void* __libc_malloc(size_t size);
+void __libc_free(void* ptr);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+}
+
+namespace {
+
+enum class Mode { Abort, Report, Off };
+
+constexpr size_t kMaxStackReports = 10;     // Full reports in report mode
+constexpr int kMaxFrames = 32;
+
+std::atomic<size_t> violations{0};
+Mode mode = Mode::Abort;
+
+// Next definition of an interposed symbol, resolved before main so the
+// lookup (which can allocate) never happens on an audio thread
+template <typename F>
+F next(const char* name) {
+    return reinterpret_cast<F>(dlsym(RTLD_NEXT, name));
+}
+
+struct Real {
+    ssize_t (*write)(int, const void*, size_t);
+    ssize_t (*read)(int, void*, size_t);
+    int (*open)(const char*, int, ...);
+    int (*openat)(int, const char*, int, ...);
+    int (*close)(int);
+    int (*nanosleep)(const struct timespec*, struct timespec*);
+    int (*clock_nanosleep)(clockid_t, int, const struct timespec*, struct timespec*);
+    int (*usleep)(useconds_t);
+    unsigned (*sleep)(unsigned);
+    void* (*mmap)(void*, size_t, int, int, int, off_t);
+    int (*munmap)(void*, size_t);
+    int (*pthread_mutex_lock)(pthread_mutex_t*);
+    int (*pthread_rwlock_rdlock)(pthread_rwlock_t*);
+    int (*pthread_rwlock_wrlock)(pthread_rwlock_t*);
+    int (*pthread_cond_wait)(pthread_cond_t*, pthread_mutex_t*);
+    int (*pthread_cond_timedwait)(pthread_cond_t*, pthread_mutex_t*, const struct timespec*);
+    int (*sem_wait)(sem_t*);
+    FILE* (*fopen)(const char*, const char*);
+    int (*fclose)(FILE*);
+    size_t (*fwrite)(const void*, size_t, size_t, FILE*);
+    int (*fputs)(const char*, FILE*);
+    int (*puts)(const char*);
+    int (*fputc)(int, FILE*);
+    int (*putc)(int, FILE*);
+    int (*putchar)(int);
+    int (*fflush)(FILE*);
+    int (*vfprintf)(FILE*, const char*, va_list);
+    int (*vprintf)(const char*, va_list);
+    int (*vfprintf_chk)(FILE*, int, const char*, va_list);
+    int (*vprintf_chk)(int, const char*, va_list);
+    void (*vsyslog)(int, const char*, va_list);
+};
+
+Real real;
+
+void writeAll(const char* text, size_t length) {
+    while (length > 0) {
+        ssize_t n = real.write ? real.write(STDERR_FILENO, text, length) : -1;
+        if (n <= 0) {
+            return;
+        }
+        text += n;
+        length -= static_cast<size_t>(n);
+    }
+}
+
+void reportViolation(const char* call) {
+    // Reporting itself writes and may allocate
+    rtsan::Allow allow;
+
+    size_t count = violations.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (mode == Mode::Off || (mode == Mode::Report && count > kMaxStackReports)) {
+        return;
+    }
+
+    char header[256];
+    int length = snprintf(header, sizeof(header), "==rtsan== %s called in real-time scope \"%s\"\n",
+                          call, rtsan::threadState.scope ? rtsan::threadState.scope : "?");
+    writeAll(header, static_cast<size_t>(std::max(0, std::min(length, static_cast<int>(sizeof(header)) - 1))));
+
+    void* frames[kMaxFrames];
+    int depth = backtrace(frames, kMaxFrames);
+    backtrace_symbols_fd(frames + 1, depth - 1, STDERR_FILENO);  // Skip this function
+
+    if (mode == Mode::Abort) {
+        writeAll("==rtsan== aborting (PCPANEL_RTSAN=report to continue)\n", 55);
+        abort();
+    }
+    if (count == kMaxStackReports) {
+        writeAll("==rtsan== further violations are counted only\n", 46);
+    }
+}
+
+inline void check(const char* call) {
+    if (rtsan::inRealtimeScope()) {
+        reportViolation(call);
+    }
+}
+
+void printSummary() {
+    size_t count = violations.load();
+    if (count > 0) {
+        char line[96];
+        int length = snprintf(line, sizeof(line), "==rtsan== %zu real-time violation(s)\n", count);
+        writeAll(line, static_cast<size_t>(length));
+    }
+}
+
+// Runs ahead of the tool's own static constructors
+__attribute__((constructor(101))) void initialize() {
+    real.write = next<decltype(real.write)>("write");
+    real.read = next<decltype(real.read)>("read");
+    real.open = next<decltype(real.open)>("open");
+    real.openat = next<decltype(real.openat)>("openat");
+    real.close = next<decltype(real.close)>("close");
+    real.nanosleep = next<decltype(real.nanosleep)>("nanosleep");
+    real.clock_nanosleep = next<decltype(real.clock_nanosleep)>("clock_nanosleep");
+    real.usleep = next<decltype(real.usleep)>("usleep");
+    real.sleep = next<decltype(real.sleep)>("sleep");
+    real.mmap = next<decltype(real.mmap)>("mmap");
+    real.munmap = next<decltype(real.munmap)>("munmap");
+    real.pthread_mutex_lock = next<decltype(real.pthread_mutex_lock)>("pthread_mutex_lock");
+    real.pthread_rwlock_rdlock = next<decltype(real.pthread_rwlock_rdlock)>("pthread_rwlock_rdlock");
+    real.pthread_rwlock_wrlock = next<decltype(real.pthread_rwlock_wrlock)>("pthread_rwlock_wrlock");
+    real.pthread_cond_wait = next<decltype(real.pthread_cond_wait)>("pthread_cond_wait");
+    real.pthread_cond_timedwait = next<decltype(real.pthread_cond_timedwait)>("pthread_cond_timedwait");
+    real.sem_wait = next<decltype(real.sem_wait)>("sem_wait");
+    real.fopen = next<decltype(real.fopen)>("fopen");
+    real.fclose = next<decltype(real.fclose)>("fclose");
+    real.fwrite = next<decltype(real.fwrite)>("fwrite");
+    real.fputs = next<decltype(real.fputs)>("fputs");
+    real.puts = next<decltype(real.puts)>("puts");
+    real.fputc = next<decltype(real.fputc)>("fputc");
+    real.putc = next<decltype(real.putc)>("putc");
+    real.putchar = next<decltype(real.putchar)>("putchar");
+    real.fflush = next<decltype(real.fflush)>("fflush");
+    real.vfprintf = next<decltype(real.vfprintf)>("vfprintf");
+    real.vprintf = next<decltype(real.vprintf)>("vprintf");
+    real.vfprintf_chk = next<decltype(real.vfprintf_chk)>("__vfprintf_chk");
+    real.vprintf_chk = next<decltype(real.vprintf_chk)>("__vprintf_chk");
+    real.vsyslog = next<decltype(real.vsyslog)>("vsyslog");
+
+    const char* setting = getenv("PCPANEL_RTSAN");
+    if (setting && strcmp(setting, "report") == 0) {
+        mode = Mode::Report;
+    } else if (setting && strcmp(setting, "off") == 0) {
+        mode = Mode::Off;
+    }
+
+    // backtrace() loads libgcc_s on first use; do that now, not mid-report
+    void* frame;
+    backtrace(&frame, 1);
+    atexit(printSummary);
+}
+
+}  // namespace
+
+size_t rtsan::violationCount() {
+    return violations.load(std::memory_order_relaxed);
+}
+
+// =============================================================================
+// Interposers
+// =============================================================================
+
+extern "C" {
+
+// ---- Allocation ----
+
+void* malloc(size_t size) noexcept {
+    check("malloc");
+    return __libc_malloc(size);
+}
+
+void free(void* ptr) noexcept {
+    if (ptr) {
+        check("free");
+    }
+    __libc_free(ptr);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    check("calloc");
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept {
+    check("realloc");
+    return __libc_realloc(ptr, size);
+}
+
+int posix_memalign(void** result, size_t alignment, size_t size) noexcept {
+    check("posix_memalign");
+    void* ptr = __libc_memalign(alignment, size);
+    if (!ptr) {
+        return ENOMEM;
+    }
+    *result = ptr;
+    return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    check("aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept {
+    check("memalign");
+    return __libc_memalign(alignment, size);
+}
+
+void* mmap(void* address, size_t length, int protection, int flags, int fd, off_t offset) noexcept {
+    check("mmap");
+    return real.mmap(address, length, protection, flags, fd, offset);
+}
+
+int munmap(void* address, size_t length) noexcept {
+    check("munmap");
+    return real.munmap(address, length);
+}
+
+// ---- Locks ----
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept {
+    check("pthread_mutex_lock");
+    return real.pthread_mutex_lock(mutex);
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t* lock) noexcept {
+    check("pthread_rwlock_rdlock");
+    return real.pthread_rwlock_rdlock(lock);
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t* lock) noexcept {
+    check("pthread_rwlock_wrlock");
+    return real.pthread_rwlock_wrlock(lock);
+}
+
+int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex) {
+    check("pthread_cond_wait");
+    return real.pthread_cond_wait(cond, mutex);
+}
+
+int pthread_cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* deadline) {
+    check("pthread_cond_timedwait");
+    return real.pthread_cond_timedwait(cond, mutex, deadline);
+}
+
+int sem_wait(sem_t* semaphore) {
+    check("sem_wait");
+    return real.sem_wait(semaphore);
+}
+
+// ---- Blocking syscalls ----
+
+ssize_t write(int fd, const void* data, size_t size) {
+    check("write");
+    return real.write(fd, data, size);
+}
+
+ssize_t read(int fd, void* data, size_t size) {
+    check("read");
+    return real.read(fd, data, size);
+}
+
+// The mode argument is only there when a file may be created
+int open(const char* path, int flags, ...) {
+    check("open");
+    mode_t permissions = 0;
+    if (flags & (O_CREAT | O_TMPFILE)) {
+        va_list args;
+        va_start(args, flags);
+        permissions = static_cast<mode_t>(va_arg(args, int));
+        va_end(args);
+    }
+    return real.open(path, flags, permissions);
+}
+
+int openat(int directory, const char* path, int flags, ...) {
+    check("openat");
+    mode_t permissions = 0;
+    if (flags & (O_CREAT | O_TMPFILE)) {
+        va_list args;
+        va_start(args, flags);
+        permissions = static_cast<mode_t>(va_arg(args, int));
+        va_end(args);
+    }
+    return real.openat(directory, path, flags, permissions);
+}
+
+int close(int fd) {
+    check("close");
+    return real.close(fd);
+}
+
+int nanosleep(const struct timespec* duration, struct timespec* remaining) {
+    check("nanosleep");
+    return real.nanosleep(duration, remaining);
+}
+
+int clock_nanosleep(clockid_t clock, int flags, const struct timespec* duration, struct timespec* remaining) {
+    check("clock_nanosleep");
+    return real.clock_nanosleep(clock, flags, duration, remaining);
+}
+
+int usleep(useconds_t microseconds) {
+    check("usleep");
+    return real.usleep(microseconds);
+}
+
+unsigned sleep(unsigned seconds) {
+    check("sleep");
+    return real.sleep(seconds);
+}
+
+// ---- Logging ----
+// glibc's stdio reaches the kernel through internal aliases, not the write()
+// above, so the public entry points are interposed themselves
+
+FILE* fopen(const char* path, const char* openMode) {
+    check("fopen");
+    return real.fopen(path, openMode);
+}
+
+int fclose(FILE* file) {
+    check("fclose");
+    return real.fclose(file);
+}
+
+size_t fwrite(const void* data, size_t size, size_t count, FILE* file) {
+    check("fwrite");
+    return real.fwrite(data, size, count, file);
+}
+
+int fputs(const char* text, FILE* file) {
+    check("fputs");
+    return real.fputs(text, file);
+}
+
+int puts(const char* text) {
+    check("puts");
+    return real.puts(text);
+}
+
+// The compiler turns single-character prints into these
+int fputc(int c, FILE* file) {
+    check("fputc");
+    return real.fputc(c, file);
+}
+
+int putc(int c, FILE* file) {
+    check("putc");
+    return real.putc(c, file);
+}
+
+int putchar(int c) {
+    check("putchar");
+    return real.putchar(c);
+}
+
+int fflush(FILE* file) {
+    check("fflush");
+    return real.fflush(file);
+}
+
+int vfprintf(FILE* file, const char* format, va_list args) {
+    check("vfprintf");
+    return real.vfprintf(file, format, args);
+}
+
+int fprintf(FILE* file, const char* format, ...) {
+    check("fprintf");
+    va_list args;
+    va_start(args, format);
+    int result = real.vfprintf(file, format, args);
+    va_end(args);
+    return result;
+}
+
+int vprintf(const char* format, va_list args) {
+    check("vprintf");
+    return real.vprintf(format, args);
+}
+
+int printf(const char* format, ...) {
+    check("printf");
+    va_list args;
+    va_start(args, format);
+    int result = real.vprintf(format, args);
+    va_end(args);
+    return result;
+}
+
+// What fprintf/printf compile to under _FORTIFY_SOURCE
+int __fprintf_chk(FILE* file, int flag, const char* format, ...) {
+    check("fprintf");
+    va_list args;
+    va_start(args, format);
+    int result = real.vfprintf_chk(file, flag, format, args);
+    va_end(args);
+    return result;
+}
+
+int __printf_chk(int flag, const char* format, ...) {
+    check("printf");
+    va_list args;
+    va_start(args, format);
+    int result = real.vprintf_chk(flag, format, args);
+    va_end(args);
+    return result;
+}
+
+int __vfprintf_chk(FILE* file, int flag, const char* format, va_list args) {
+    check("vfprintf");
+    return real.vfprintf_chk(file, flag, format, args);
+}
+
+void syslog(int priority, const char* format, ...) {
+    check("syslog");
+    va_list args;
+    va_start(args, format);
+    real.vsyslog(priority, format, args);
+    va_end(args);
+}
+
+}  // extern "C"
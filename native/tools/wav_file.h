@@ -0,0 +1,167 @@
+// PC Panel Pro - minimal WAV reader/writer for the host tools
+// Reads PCM 16/24/32-bit and IEEE float 32-bit (plain or extensible) into
+// interleaved Float32; writes interleaved Float32.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct WavData {
+    uint32_t sampleRate = 0;
+    uint16_t channels = 0;
+    std::vector<float> samples;     // Interleaved
+
+    size_t frames() const {
+        return channels ? samples.size() / channels : 0;
+    }
+};
+
+namespace wav {
+
+constexpr uint16_t kFormatPcm = 1;
+constexpr uint16_t kFormatFloat = 3;
+constexpr uint16_t kFormatExtensible = 0xFFFE;
+
+inline uint16_t readU16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+inline uint32_t readU32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8)
+        | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline void writeU16(std::vector<uint8_t>& out, uint16_t v) {
+    out.push_back(static_cast<uint8_t>(v));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+}
+
+inline void writeU32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+inline bool readFile(const std::string& path, std::vector<uint8_t>& bytes) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    uint8_t chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        bytes.insert(bytes.end(), chunk, chunk + n);
+    }
+    fclose(file);
+    return true;
+}
+
+}  // namespace wav
+
+// Returns false with a message in error on anything it can't decode
+inline bool readWav(const std::string& path, WavData& wavData, std::string& error) {
+    std::vector<uint8_t> bytes;
+    if (!wav::readFile(path, bytes)) {
+        error = "can't open " + path;
+        return false;
+    }
+    if (bytes.size() < 12 || memcmp(bytes.data(), "RIFF", 4) != 0 || memcmp(bytes.data() + 8, "WAVE", 4) != 0) {
+        error = path + " is not a RIFF/WAVE file";
+        return false;
+    }
+
+    uint16_t format = 0;
+    uint16_t bitsPerSample = 0;
+    const uint8_t* data = nullptr;
+    size_t dataSize = 0;
+
+    size_t pos = 12;
+    while (pos + 8 <= bytes.size()) {
+        const uint8_t* chunk = bytes.data() + pos;
+        uint32_t chunkSize = wav::readU32(chunk + 4);
+        size_t bodySize = std::min<size_t>(chunkSize, bytes.size() - pos - 8);
+        if (memcmp(chunk, "fmt ", 4) == 0 && bodySize >= 16) {
+            format = wav::readU16(chunk + 8);
+            wavData.channels = wav::readU16(chunk + 10);
+            wavData.sampleRate = wav::readU32(chunk + 12);
+            bitsPerSample = wav::readU16(chunk + 22);
+            if (format == wav::kFormatExtensible && bodySize >= 26) {
+                format = wav::readU16(chunk + 32);   // First two bytes of the subformat GUID
+            }
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            data = chunk + 8;
+            dataSize = bodySize;
+        }
+        pos += 8 + chunkSize + (chunkSize & 1);
+    }
+
+    if (!data || wavData.channels == 0 || wavData.sampleRate == 0) {
+        error = path + ": missing fmt or data chunk";
+        return false;
+    }
+
+    size_t bytesPerSample = bitsPerSample / 8;
+    bool supported = (format == wav::kFormatPcm && (bitsPerSample == 16 || bitsPerSample == 24 || bitsPerSample == 32))
+        || (format == wav::kFormatFloat && bitsPerSample == 32);
+    if (!supported) {
+        error = path + ": unsupported format " + std::to_string(format) + "/" + std::to_string(bitsPerSample) + "-bit";
+        return false;
+    }
+
+    size_t sampleCount = dataSize / bytesPerSample;
+    sampleCount -= sampleCount % wavData.channels;
+    wavData.samples.resize(sampleCount);
+    for (size_t i = 0; i < sampleCount; i++) {
+        const uint8_t* p = data + i * bytesPerSample;
+        float value;
+        if (format == wav::kFormatFloat) {
+            uint32_t bits = wav::readU32(p);
+            memcpy(&value, &bits, sizeof(value));
+        } else if (bitsPerSample == 16) {
+            value = static_cast<int16_t>(wav::readU16(p)) / 32768.0f;
+        } else if (bitsPerSample == 24) {
+            int32_t v = static_cast<int32_t>((p[0] << 8) | (p[1] << 16) | (static_cast<uint32_t>(p[2]) << 24)) >> 8;
+            value = v / 8388608.0f;
+        } else {
+            value = static_cast<float>(static_cast<int32_t>(wav::readU32(p)) / 2147483648.0);
+        }
+        wavData.samples[i] = value;
+    }
+    return true;
+}
+
+inline bool writeWav(const std::string& path, const WavData& wavData) {
+    std::vector<uint8_t> out;
+    uint32_t dataSize = static_cast<uint32_t>(wavData.samples.size() * sizeof(float));
+    out.reserve(44 + dataSize);
+
+    out.insert(out.end(), {'R', 'I', 'F', 'F'});
+    wav::writeU32(out, 36 + dataSize);
+    out.insert(out.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+    wav::writeU32(out, 16);
+    wav::writeU16(out, wav::kFormatFloat);
+    wav::writeU16(out, wavData.channels);
+    wav::writeU32(out, wavData.sampleRate);
+    wav::writeU32(out, wavData.sampleRate * wavData.channels * sizeof(float));
+    wav::writeU16(out, static_cast<uint16_t>(wavData.channels * sizeof(float)));
+    wav::writeU16(out, 32);
+    out.insert(out.end(), {'d', 'a', 't', 'a'});
+    wav::writeU32(out, dataSize);
+    for (float sample : wavData.samples) {
+        uint32_t bits;
+        memcpy(&bits, &sample, sizeof(bits));
+        wav::writeU32(out, bits);
+    }
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = fwrite(out.data(), 1, out.size(), file) == out.size();
+    return fclose(file) == 0 && ok;
+}
@@ -0,0 +1,172 @@
+#!/usr/bin/env node
+// Replay HID traces through the knob event coalescer and report event rate
+// and CPU per sweep for a range of windows.
+//
+// Usage: npm run bench:hid -- [trace files...] [--windows=0,8,16,33] [--runs=N]
+//
+// Without trace files a synthetic set of sweeps is replayed. Replay runs on
+// a virtual clock, so a long capture finishes as fast as the CPU allows.
+
+const fs = require('fs');
+const path = require('path');
+
+const DIST_HID = path.join(__dirname, '../dist/main/hid');
+const { parseInputPacket, INPUT_CODE_KNOB_CHANGE, INPUT_CODE_BUTTON_CHANGE } = require(path.join(DIST_HID, 'protocol.js'));
+const { EventCoalescer } = require(path.join(DIST_HID, 'coalescer.js'));
+const { parseTrace, formatTraceEntry, TRACE_HEADER } = require(path.join(DIST_HID, 'trace.js'));
+
+function parseArgs(argv) {
+  const options = { files: [], windows: [0, 8, 16, 33], runs: 20 };
+  for (const arg of argv) {
+    if (arg.startsWith('--windows=')) {
+      options.windows = arg.slice('--windows='.length).split(',').map(Number);
+    } else if (arg.startsWith('--runs=')) {
+      options.runs = Number(arg.slice('--runs='.length));
+    } else {
+      options.files.push(arg);
+    }
+  }
+  return options;
+}
+
+/**
+ * Slider sweeps at the panel's ~1 kHz report rate: one slider full travel
+ * up and down, then two knobs turned together, then a button press.
+ */
+function syntheticTrace() {
+  const lines = [TRACE_HEADER];
+  const report = (code, index, value) => Buffer.from([code, index, value]);
+  let t = 0;
+
+  for (let v = 0; v <= 255; v++, t += 1000) {
+    lines.push(formatTraceEntry(t, report(INPUT_CODE_KNOB_CHANGE, 5, v)));
+  }
+  for (let v = 255; v >= 0; v--, t += 1000) {
+    lines.push(formatTraceEntry(t, report(INPUT_CODE_KNOB_CHANGE, 5, v)));
+  }
+  t += 250000;
+  for (let v = 64; v <= 192; v++, t += 1000) {
+    lines.push(formatTraceEntry(t, report(INPUT_CODE_KNOB_CHANGE, 0, v)));
+    lines.push(formatTraceEntry(t + 500, report(INPUT_CODE_KNOB_CHANGE, 1, 255 - v)));
+  }
+  t += 100000;
+  lines.push(formatTraceEntry(t, report(INPUT_CODE_BUTTON_CHANGE, 2, 1)));
+  lines.push(formatTraceEntry(t + 80000, report(INPUT_CODE_BUTTON_CHANGE, 2, 0)));
+
+  return parseTrace(lines.join('\n'));
+}
+
+/**
+ * Stand-in for what one delivery costs downstream: the 'state' copy and
+ * the structured-clone-ish serialization of the IPC message.
+ */
+function makeSink(stats) {
+  const state = { connected: true, analogValues: new Array(9).fill(0), buttonStates: new Array(5).fill(false) };
+  return (events) => {
+    for (const event of events) {
+      if (event.type === 'knob-change') {
+        state.analogValues[event.index] = event.value;
+        stats.lastDeliveredValue[event.index] = event.value;
+        stats.lastDeliveredAt[event.index] = stats.clock;
+      }
+      stats.serializedBytes += JSON.stringify(event).length;
+    }
+    const snapshot = { ...state, analogValues: [...state.analogValues], buttonStates: [...state.buttonStates] };
+    stats.serializedBytes += JSON.stringify(snapshot).length;
+    stats.deliveries++;
+  };
+}
+
+function replay(entries, windowMs) {
+  const stats = {
+    clock: 0,
+    deliveries: 0,
+    serializedBytes: 0,
+    lastDeliveredValue: [],
+    lastDeliveredAt: [],
+  };
+  const lastReported = [];
+  const lastReportedAt = [];
+  const coalescer = new EventCoalescer(windowMs, makeSink(stats), () => stats.clock);
+
+  for (const entry of entries) {
+    const time = entry.timeUs / 1000;
+    // Fire the flush timers that would have run before this report
+    while (coalescer.nextFlushTime() <= time) {
+      stats.clock = coalescer.nextFlushTime();
+      coalescer.flush();
+    }
+    stats.clock = time;
+
+    const event = parseInputPacket(entry.report);
+    if (!event) continue;
+    if (event.type === 'knob-change') {
+      lastReported[event.index] = event.value;
+      lastReportedAt[event.index] = stats.clock;
+    }
+    coalescer.push(event);
+  }
+
+  // Let every open window close, as the timers would
+  while (coalescer.nextFlushTime() !== Infinity) {
+    stats.clock = coalescer.nextFlushTime();
+    coalescer.flush();
+  }
+  coalescer.reset();
+
+  let maxFinalLagMs = 0;
+  lastReported.forEach((value, index) => {
+    if (value === undefined) return;
+    if (stats.lastDeliveredValue[index] !== value) {
+      throw new Error(`Control ${index}: final value ${value} never delivered`);
+    }
+    maxFinalLagMs = Math.max(maxFinalLagMs, stats.lastDeliveredAt[index] - lastReportedAt[index]);
+  });
+
+  const { received, delivered } = coalescer.getStats();
+  return { received, delivered, deliveries: stats.deliveries, serializedBytes: stats.serializedBytes, maxFinalLagMs };
+}
+
+function bench(name, entries, options) {
+  const durationS = entries.length > 0 ? (entries[entries.length - 1].timeUs - entries[0].timeUs) / 1e6 : 0;
+  console.log(`\n${name}: ${entries.length} reports over ${durationS.toFixed(2)} s`);
+  console.log('window  events/s  delivered  reduction  final lag  CPU/replay  IPC bytes');
+
+  for (const windowMs of options.windows) {
+    replay(entries, windowMs); // warm-up
+
+    let result;
+    const cpuStart = process.cpuUsage();
+    for (let run = 0; run < options.runs; run++) {
+      result = replay(entries, windowMs);
+    }
+    const cpu = process.cpuUsage(cpuStart);
+    const cpuUsPerRun = (cpu.user + cpu.system) / options.runs;
+
+    const rate = durationS > 0 ? result.delivered / durationS : 0;
+    const reduction = result.received > 0 ? 1 - result.delivered / result.received : 0;
+    console.log(
+      `${String(windowMs).padStart(4)}ms` +
+      `${rate.toFixed(0).padStart(10)}` +
+      `${String(result.delivered).padStart(11)}` +
+      `${(reduction * 100).toFixed(1).padStart(10)}%` +
+      `${result.maxFinalLagMs.toFixed(1).padStart(9)}ms` +
+      `${cpuUsPerRun.toFixed(0).padStart(10)}us` +
+      `${String(result.serializedBytes).padStart(11)}`
+    );
+  }
+}
+
+function main() {
+  const options = parseArgs(process.argv.slice(2));
+
+  if (options.files.length === 0) {
+    bench('synthetic sweeps', syntheticTrace(), options);
+    return;
+  }
+  for (const file of options.files) {
+    bench(path.basename(file), parseTrace(fs.readFileSync(file, 'utf8')), options);
+  }
+}
+
+main();
@@ -3,7 +3,7 @@
 import * as fs from 'fs';
 import * as path from 'path';
 import { app } from 'electron';
-import { AudioRoutingConfig, createDefaultConfig } from './types';
+import { AudioRoutingConfig, ChannelCompressor, MixDucking, VolumeTaper, createDefaultConfig } from './types';
 
 const CONFIG_FILENAME = 'audio-routing.json';
 
@@ -74,6 +74,10 @@ function mergeWithDefaults(loaded: Partial<AudioRoutingConfig>): AudioRoutingCon
         channelName: loadedChannel.channelName ?? defaultChannel.channelName,
         volume: loadedChannel.volume ?? defaultChannel.volume,
         muted: loadedChannel.muted ?? defaultChannel.muted,
+        // Saved before tapers existed: keep the linear response those knobs had
+        taper: loadedChannel.taper ?? 'linear',
+        customTaper: loadedChannel.customTaper ?? defaultChannel.customTaper,
+        compressor: loadedChannel.compressor ?? defaultChannel.compressor,
       };
     }
     return defaultChannel;
@@ -87,7 +91,12 @@ function mergeWithDefaults(loaded: Partial<AudioRoutingConfig>): AudioRoutingCon
         ...defaultBus,
         name: loadedBus.name ?? defaultBus.name,
         outputDeviceId: loadedBus.outputDeviceId ?? defaultBus.outputDeviceId,
+        // Configs saved before UIDs were persisted only have the (unstable) ID
+        outputDeviceUid: loadedBus.outputDeviceUid !== undefined
+          ? loadedBus.outputDeviceUid
+          : defaultBus.outputDeviceUid,
         channels: loadedBus.channels ?? defaultBus.channels,
+        ducking: loadedBus.ducking ?? defaultBus.ducking,
       };
     }
     return defaultBus;
@@ -123,6 +132,43 @@ export function updateChannelLabel(
   };
 }
 
+/**
+ * Update a channel's volume taper
+ */
+export function updateChannelTaper(
+  config: AudioRoutingConfig,
+  channelId: string,
+  taper: VolumeTaper,
+  customTaper: number[] | null
+): AudioRoutingConfig {
+  return {
+    ...config,
+    inputChannels: config.inputChannels.map(channel =>
+      channel.id === channelId
+        ? { ...channel, taper, customTaper: taper === 'custom' ? customTaper : null }
+        : channel
+    ),
+  };
+}
+
+/**
+ * Set or clear (null) a channel's compressor
+ */
+export function updateChannelCompressor(
+  config: AudioRoutingConfig,
+  channelId: string,
+  compressor: ChannelCompressor | null
+): AudioRoutingConfig {
+  return {
+    ...config,
+    inputChannels: config.inputChannels.map(channel =>
+      channel.id === channelId
+        ? { ...channel, compressor }
+        : channel
+    ),
+  };
+}
+
 /**
  * Update a channel's volume
  */
@@ -209,13 +255,32 @@ export function updateMixBusChannel(
 export function updateMixBusOutput(
   config: AudioRoutingConfig,
   mixId: string,
-  outputDeviceId: number | null
+  outputDeviceId: number | null,
+  outputDeviceUid: string | null
+): AudioRoutingConfig {
+  return {
+    ...config,
+    mixBuses: config.mixBuses.map(bus =>
+      bus.id === mixId
+        ? { ...bus, outputDeviceId, outputDeviceUid }
+        : bus
+    ),
+  };
+}
+
+/**
+ * Set or clear (null) a mix bus's sidechain ducking
+ */
+export function updateMixBusDucking(
+  config: AudioRoutingConfig,
+  mixId: string,
+  ducking: MixDucking | null
 ): AudioRoutingConfig {
   return {
     ...config,
     mixBuses: config.mixBuses.map(bus =>
       bus.id === mixId
-        ? { ...bus, outputDeviceId }
+        ? { ...bus, ducking }
         : bus
     ),
   };
@@ -25,6 +25,7 @@ const audioAddon = require(getNativeModulePath());
 interface AudioDevice {
   id: number;
   name: string;
+  uid: string;
   hasOutput: boolean;
   hasInput: boolean;
 }
@@ -40,12 +41,14 @@ class AudioPassthroughManager {
   private channels: Map<number, PassthroughChannel> = new Map();
   private deviceNames = ['PCPanel K1', 'PCPanel K2', 'PCPanel K3', 'PCPanel K4', 'PCPanel K5',
                          'PCPanel S1', 'PCPanel S2', 'PCPanel S3', 'PCPanel S4'];
+  // Persistent UIDs set by the driver (index + 1), used to address devices natively
+  private deviceUids = this.deviceNames.map((_, i) => `com.pcpanel.audio.device.${i + 1}`);
 
   /**
    * List all audio devices on the system
    */
   listDevices(): AudioDevice[] {
-    return audioAddon.listAudioDevices() || [];
+    return audioAddon.getCachedAudioDevices() || [];
   }
 
   /**
@@ -60,13 +63,13 @@ class AudioPassthroughManager {
    */
   findPCPanelDevices(): AudioDevice[] {
     const devices = this.listDevices();
-    return devices.filter((d: AudioDevice) => d.name.startsWith('PCPanel'));
+    return devices.filter((d: AudioDevice) => d.uid.startsWith('com.pcpanel.audio.'));
   }
 
   /**
-   * Start passthrough for a specific channel
+   * Start passthrough for a specific channel (IOProcs start on a native worker)
    */
-  startChannel(channelIndex: number): boolean {
+  async startChannel(channelIndex: number): Promise<boolean> {
     if (channelIndex < 0 || channelIndex >= this.deviceNames.length) {
       console.error(`Invalid channel index: ${channelIndex}`);
       return false;
@@ -82,7 +85,7 @@ class AudioPassthroughManager {
     }
 
     try {
-      const passthroughId = audioAddon.startPassthrough(deviceName);
+      const passthroughId = await audioAddon.startPassthrough(this.deviceUids[channelIndex]);
 
       this.channels.set(channelIndex, {
         index: channelIndex,
@@ -94,6 +97,10 @@ class AudioPassthroughManager {
       console.log(`Started passthrough for ${deviceName} (channel ${channelIndex})`);
       return true;
     } catch (err) {
+      // stopAll() while this start was in flight; the native side stopped it
+      if ((err as { code?: string }).code === 'ECANCELED') {
+        return false;
+      }
       console.error(`Failed to start passthrough for ${deviceName}:`, err);
       return false;
     }
@@ -122,15 +129,16 @@ class AudioPassthroughManager {
   /**
    * Start passthrough for all available PCPanel devices
    */
-  startAll(): void {
-    const pcpanelDevices = this.findPCPanelDevices();
-
-    for (const device of pcpanelDevices) {
-      const channelIndex = this.deviceNames.indexOf(device.name);
-      if (channelIndex >= 0) {
-        this.startChannel(channelIndex);
-      }
-    }
+  async startAll(): Promise<void> {
+    // Async listing: the first one builds the native registry off the main thread
+    const devices: AudioDevice[] = (await audioAddon.listAudioDevices()) || [];
+    const pcpanelDevices = devices.filter((d: AudioDevice) => d.uid.startsWith('com.pcpanel.audio.'));
+
+    // Channels start in parallel; each resolves independently
+    await Promise.all(pcpanelDevices
+      .map((device: AudioDevice) => this.deviceUids.indexOf(device.uid))
+      .filter((channelIndex: number) => channelIndex >= 0)
+      .map((channelIndex: number) => this.startChannel(channelIndex)));
   }
 
   /**
@@ -7,9 +7,22 @@ import {
   AudioRoutingConfig,
   AudioRoutingState,
   AudioOutputDevice,
+  ChannelCompressor,
   ChannelState,
   MixBusState,
+  MixDucking,
+  InputChannel,
+  MixTiming,
+  MixXruns,
+  RecordingFormat,
+  RecordingStats,
+  ReplayStats,
+  StemLayout,
+  StemStats,
+  VolumeTaper,
   CHANNEL_DEFINITIONS,
+  PCPANEL_UID_PREFIX,
+  VOICE_CHAT_DEVICE_UID,
 } from './types';
 import {
   loadConfig,
@@ -17,7 +30,10 @@ import {
   updateChannelLabel,
   updateChannelVolume,
   updateChannelMuted,
+  updateChannelTaper,
+  updateChannelCompressor,
   updateMixBusChannel,
+  updateMixBusDucking,
   updateMixBusOutput,
 } from './config';
 
@@ -40,8 +56,22 @@ const audioAddon = require(getNativeModulePath());
 interface NativeAudioDevice {
   id: number;
   name: string;
+  uid: string;
   hasOutput: boolean;
   hasInput: boolean;
+  inputChannels: number;
+  outputChannels: number;
+  sampleRate: number;
+}
+
+/**
+ * Device change pushed from the native device registry
+ */
+export interface NativeDeviceChangeEvent {
+  type: 'added' | 'removed' | 'changed' | 'default-output';
+  id: number;
+  name: string;
+  uid: string;
 }
 
 /**
@@ -53,8 +83,11 @@ interface NativeAudioDevice {
 class AudioRoutingManager {
   private config: AudioRoutingConfig;
   private mixerHandles: Map<string, number> = new Map();
+  /** Native device handles resolved once from channel UIDs (channelId -> handle) */
+  private deviceHandles: Map<string, number> = new Map();
   private isInitialized = false;
   private saveTimeout: ReturnType<typeof setTimeout> | null = null;
+  private deviceChangeListeners: ((event: NativeDeviceChangeEvent) => void)[] = [];
 
   constructor() {
     this.config = loadConfig();
@@ -62,9 +95,10 @@ class AudioRoutingManager {
 
   /**
    * Initialize the audio routing system
-   * Creates mixers for all configured mix buses
+   * Creates mixers for all configured mix buses; device enumeration and
+   * IOProc startup run on native worker threads
    */
-  initialize(): void {
+  async initialize(): Promise<void> {
     if (this.isInitialized) {
       console.log('AudioRoutingManager already initialized');
       return;
@@ -72,19 +106,46 @@ class AudioRoutingManager {
 
     console.log('Initializing AudioRoutingManager...');
 
+    // The first listing builds the native device registry on a worker thread;
+    // it must finish before any synchronous lookup below, which would
+    // otherwise enumerate the HAL on this thread
+    const devices: NativeAudioDevice[] = (await audioAddon.listAudioDevices()) || [];
+
+    // Device list, default output and stream format changes are pushed from
+    // the native registry instead of being polled
+    audioAddon.onDeviceChange((event: NativeDeviceChangeEvent) => {
+      this.handleDeviceChange(event);
+    });
+
+    // Resolve every channel's UID into a compact native handle once; all
+    // hot-path setters use the handle instead of the display name
+    for (const channel of this.config.inputChannels) {
+      const handle = audioAddon.resolveDevice(channel.deviceUid);
+      if (handle !== null) {
+        this.deviceHandles.set(channel.id, handle);
+        try {
+          this.syncCustomTaper(channel);
+        } catch (err) {
+          console.error(`Ignoring invalid custom taper for ${channel.id}:`, err);
+        }
+      }
+    }
+    this.syncHidGainMapping();
+
     // Find PCPanel devices
-    const devices = this.listDevices();
-    const pcpanelDevices = devices.filter((d: NativeAudioDevice) => d.name.startsWith('PCPanel'));
+    const pcpanelDevices = devices.filter((d: NativeAudioDevice) => d.uid.startsWith(PCPANEL_UID_PREFIX));
 
     if (pcpanelDevices.length === 0) {
       console.warn('No PCPanel devices found. Waiting for devices...');
     }
 
-    // Create the Personal Mix (always create even if no devices yet)
-    this.createPersonalMix(pcpanelDevices);
-
-    // Create the Voice Chat Mix (outputs to PCPanel Voice Chat virtual mic)
-    this.createVoiceChatMix(pcpanelDevices);
+    // Create both mixes concurrently:
+    // - Personal Mix (always created even if no devices yet)
+    // - Voice Chat Mix (outputs to PCPanel Voice Chat virtual mic)
+    await Promise.all([
+      this.createPersonalMix(pcpanelDevices),
+      this.createVoiceChatMix(pcpanelDevices),
+    ]);
 
     this.isInitialized = true;
     console.log('AudioRoutingManager initialized');
@@ -93,7 +154,7 @@ class AudioRoutingManager {
   /**
    * Create the Personal Mix - aggregates all channels to user's output
    */
-  private createPersonalMix(pcpanelDevices: NativeAudioDevice[]): void {
+  private async createPersonalMix(pcpanelDevices: NativeAudioDevice[]): Promise<void> {
     const personalMix = this.config.mixBuses.find(b => b.id === 'personal');
     if (!personalMix) {
       console.error('No personal mix bus configured');
@@ -104,42 +165,55 @@ class AudioRoutingManager {
       // Create the mixer
       const mixerHandle = audioAddon.createMixer('Personal Mix');
       this.mixerHandles.set('personal', mixerHandle);
+      const initialParams: { channel: number; gain: number; enabled: boolean }[] = [];
 
       // Add all available PCPanel devices as inputs
       for (const device of pcpanelDevices) {
-        const channelDef = CHANNEL_DEFINITIONS.find(c => c.deviceName === device.name);
+        const channelDef = CHANNEL_DEFINITIONS.find(c => c.deviceUid === device.uid);
         if (!channelDef) continue;
 
         const channel = this.config.inputChannels.find(c => c.id === channelDef.id);
-        if (!channel) continue;
+        const deviceHandle = this.deviceHandles.get(channelDef.id);
+        if (!channel || deviceHandle === undefined) continue;
 
         // Check if this channel is enabled in the personal mix
         const mixChannel = personalMix.channels.find(c => c.channelId === channel.id);
         const enabled = mixChannel?.enabled ?? true;
 
         try {
-          audioAddon.mixerAddInput(mixerHandle, device.name);
+          audioAddon.mixerAddInput(mixerHandle, deviceHandle);
 
-          // Set initial gain based on channel volume
-          const effectiveVolume = channel.muted ? 0 : channel.volume;
-          audioAddon.mixerSetInputGain(mixerHandle, device.name, effectiveVolume);
-          audioAddon.mixerSetInputEnabled(mixerHandle, device.name, enabled);
+          // Initial gain based on channel volume (applied below as one batch)
+          const gain = this.channelGain(channel);
+          initialParams.push({ channel: deviceHandle, gain, enabled });
 
-          console.log(`Added ${device.name} to Personal Mix (vol: ${effectiveVolume}, enabled: ${enabled})`);
+          console.log(`Added ${device.name} to Personal Mix (gain: ${gain}, enabled: ${enabled})`);
         } catch (err) {
           console.error(`Failed to add ${device.name} to mixer:`, err);
         }
       }
 
-      // Set output device
-      if (personalMix.outputDeviceId !== null) {
-        audioAddon.mixerSetOutput(mixerHandle, personalMix.outputDeviceId);
+      audioAddon.mixerApplyUpdates(mixerHandle, initialParams);
+      this.applyCompressors(mixerHandle, initialParams.map(p => p.channel));
+      this.applyDucking('personal', mixerHandle);
+
+      // Set output device - resolved by UID since device IDs change across
+      // reboots and reconnects
+      const outputDeviceId = this.resolveOutputDeviceId(personalMix.outputDeviceUid, personalMix.outputDeviceId);
+      if (outputDeviceId !== null) {
+        audioAddon.mixerSetOutput(mixerHandle, outputDeviceId);
+      }
+      if (outputDeviceId !== personalMix.outputDeviceId && personalMix.outputDeviceUid !== null) {
+        // Same device, new ID - keep the UI selection in sync
+        this.config = updateMixBusOutput(this.config, 'personal', outputDeviceId, personalMix.outputDeviceUid);
+        this.scheduleSave();
       }
       // If null, mixer uses default output
 
       // Start the mixer
-      audioAddon.mixerStart(mixerHandle);
-      console.log('Personal Mix started');
+      if (await this.startMixer(mixerHandle)) {
+        console.log('Personal Mix started');
+      }
     } catch (err) {
       console.error('Failed to create Personal Mix:', err);
     }
@@ -149,7 +223,7 @@ class AudioRoutingManager {
    * Create the Voice Chat Mix - routes selected channels to virtual mic
    * Apps like Discord can select "PCPanel Voice Chat" as their microphone
    */
-  private createVoiceChatMix(pcpanelDevices: NativeAudioDevice[]): void {
+  private async createVoiceChatMix(pcpanelDevices: NativeAudioDevice[]): Promise<void> {
     const voiceChatMix = this.config.mixBuses.find(b => b.id === 'voicechat');
     if (!voiceChatMix) {
       console.log('No voice chat mix bus configured');
@@ -157,12 +231,11 @@ class AudioRoutingManager {
     }
 
     // Find the Voice Chat virtual mic device
-    const allDevices = this.listDevices();
-    const voiceChatDevice = allDevices.find((d: NativeAudioDevice) => d.name === 'PCPanel Voice Chat');
+    const voiceChatDevice: NativeAudioDevice | null = audioAddon.getDeviceByUID(VOICE_CHAT_DEVICE_UID);
 
     if (!voiceChatDevice) {
       console.warn('PCPanel Voice Chat device not found. Voice Chat Mix disabled.');
-      console.log('Available devices:', allDevices.map((d: NativeAudioDevice) => d.name).join(', '));
+      console.log('Available devices:', this.listDevices().map((d: NativeAudioDevice) => d.name).join(', '));
       return;
     }
 
@@ -176,25 +249,26 @@ class AudioRoutingManager {
       // Create the mixer
       const mixerHandle = audioAddon.createMixer('Voice Chat Mix');
       this.mixerHandles.set('voicechat', mixerHandle);
+      const initialParams: { channel: number; gain: number; enabled: boolean }[] = [];
 
       // Add only the channels that are enabled in the voice chat mix
       for (const mixChannel of voiceChatMix.channels) {
         if (!mixChannel.enabled) continue;
 
         const channel = this.config.inputChannels.find(c => c.id === mixChannel.channelId);
-        if (!channel) continue;
+        const deviceHandle = this.deviceHandles.get(mixChannel.channelId);
+        if (!channel || deviceHandle === undefined) continue;
 
         // Find the corresponding PCPanel device
-        const device = pcpanelDevices.find((d: NativeAudioDevice) => d.name === channel.deviceName);
+        const device = pcpanelDevices.find((d: NativeAudioDevice) => d.uid === channel.deviceUid);
         if (!device) continue;
 
         try {
-          audioAddon.mixerAddInput(mixerHandle, device.name);
+          audioAddon.mixerAddInput(mixerHandle, deviceHandle);
 
           // Use gain override if set, otherwise use channel volume
-          const gain = mixChannel.gainOverride ?? (channel.muted ? 0 : channel.volume);
-          audioAddon.mixerSetInputGain(mixerHandle, device.name, gain);
-          audioAddon.mixerSetInputEnabled(mixerHandle, device.name, true);
+          const gain = mixChannel.gainOverride ?? this.channelGain(channel);
+          initialParams.push({ channel: deviceHandle, gain, enabled: true });
 
           console.log(`Added ${device.name} to Voice Chat Mix (gain: ${gain})`);
         } catch (err) {
@@ -202,12 +276,16 @@ class AudioRoutingManager {
         }
       }
 
+      audioAddon.mixerApplyUpdates(mixerHandle, initialParams);
+      this.applyCompressors(mixerHandle, initialParams.map(p => p.channel));
+      this.applyDucking('voicechat', mixerHandle);
+
       // Set output to the Voice Chat virtual mic device
       // The mixer writes to the output stream, which loops back to the input stream
       audioAddon.mixerSetOutput(mixerHandle, voiceChatDevice.id);
 
       // Start the mixer
-      audioAddon.mixerStart(mixerHandle);
+      if (!(await this.startMixer(mixerHandle))) return;
       console.log(`Voice Chat Mix started, outputting to ${voiceChatDevice.name} (ID: ${voiceChatDevice.id})`);
     } catch (err) {
       console.error('Failed to create Voice Chat Mix:', err);
@@ -215,29 +293,66 @@ class AudioRoutingManager {
   }
 
   /**
-   * Shutdown the audio routing system
+   * Start a mixer on the native worker pool. Resolves false if the start
+   * failed or was superseded by a later stop/start of the same mixer.
    */
-  shutdown(): void {
+  private async startMixer(mixerHandle: number): Promise<boolean> {
+    try {
+      return await audioAddon.mixerStart(mixerHandle);
+    } catch (err) {
+      if ((err as { code?: string }).code === 'ECANCELED') {
+        return false;
+      }
+      throw err;
+    }
+  }
+
+  /**
+   * Shutdown the audio routing system. Resolves once every mixer has stopped
+   * and any recording in progress has been finalized.
+   */
+  async shutdown(): Promise<void> {
     if (!this.isInitialized) return;
+    this.isInitialized = false;
 
     console.log('Shutting down AudioRoutingManager...');
 
+    audioAddon.onDeviceChange(null);
+    this.deviceHandles.clear();
+    this.syncHidGainMapping();
+
     // Stop all mixers
-    audioAddon.stopAllMixers();
     this.mixerHandles.clear();
+    await audioAddon.stopAllMixers();
 
     // Save config
     this.saveConfigNow();
 
-    this.isInitialized = false;
     console.log('AudioRoutingManager shutdown complete');
   }
 
   /**
-   * List all audio devices on the system
+   * Subscribe to audio device changes (devices added/removed, default output
+   * changed, stream format changed)
+   */
+  onDevicesChanged(listener: (event: NativeDeviceChangeEvent) => void): void {
+    this.deviceChangeListeners.push(listener);
+  }
+
+  private handleDeviceChange(event: NativeDeviceChangeEvent): void {
+    if (event.type !== 'changed') {
+      console.log(`Audio device ${event.type}: ${event.name || event.id}`);
+    }
+    for (const listener of this.deviceChangeListeners) {
+      listener(event);
+    }
+  }
+
+  /**
+   * List all audio devices on the system (served from the native device cache)
    */
   listDevices(): NativeAudioDevice[] {
-    return audioAddon.listAudioDevices() || [];
+    return audioAddon.getCachedAudioDevices() || [];
   }
 
   /**
@@ -248,14 +363,36 @@ class AudioRoutingManager {
     const defaultOutput = audioAddon.getDefaultOutputDevice();
 
     return devices
-      .filter((d: NativeAudioDevice) => d.hasOutput && !d.name.startsWith('PCPanel'))
+      .filter((d: NativeAudioDevice) => d.hasOutput && !d.uid.startsWith(PCPANEL_UID_PREFIX))
       .map((d: NativeAudioDevice) => ({
         id: d.id,
         name: d.name,
+        uid: d.uid,
         isDefault: defaultOutput && d.id === defaultOutput.id,
       }));
   }
 
+  /**
+   * Resolve a persisted output device UID to its current device ID.
+   * Falls back to the stored ID for configs saved before UIDs were persisted.
+   */
+  private resolveOutputDeviceId(uid: string | null, fallbackId: number | null): number | null {
+    if (uid !== null) {
+      const device: NativeAudioDevice | null = audioAddon.getDeviceByUID(uid);
+      if (device) return device.id;
+      console.warn(`Output device ${uid} not present, using default output`);
+      return null;
+    }
+    return fallbackId;
+  }
+
+  /**
+   * Native handle for a channel's device, if resolved
+   */
+  private getDeviceHandle(channel: InputChannel): number | undefined {
+    return this.deviceHandles.get(channel.id);
+  }
+
   /**
    * Set channel volume (0.0 - 1.0)
    */
@@ -271,25 +408,147 @@ class AudioRoutingManager {
     this.scheduleSave();
 
     // Update all mixers that include this channel
-    const effectiveVolume = this.config.inputChannels.find(c => c.id === channelId)!.muted
-      ? 0
-      : volume;
+    this.pushChannelGains([channelId]);
+  }
+
+  /**
+   * Mixer gain for a channel: its volume position through the channel's
+   * taper, or 0 when muted. Uses the same native tables as the HID reader.
+   */
+  private channelGain(channel: InputChannel): number {
+    if (channel.muted) return 0;
+    const rawValue = Math.round(channel.volume * 255);
+    return audioAddon.taperGain(channel.taper, rawValue, this.getDeviceHandle(channel));
+  }
 
+  /**
+   * Build a channel's custom taper table natively, once per curve change;
+   * channelGain() then only looks values up
+   */
+  private syncCustomTaper(channel: InputChannel): void {
+    const deviceHandle = this.getDeviceHandle(channel);
+    if (deviceHandle === undefined) return;
+    audioAddon.setCustomTaper(deviceHandle, channel.taper === 'custom' ? channel.customTaper : null);
+  }
+
+  /**
+   * Set a channel's volume taper
+   */
+  setChannelTaper(channelId: string, taper: VolumeTaper, customTaper: number[] | null = null): void {
+    const channel = this.config.inputChannels.find(c => c.id === channelId);
+    if (!channel) {
+      console.error(`Channel not found: ${channelId}`);
+      return;
+    }
+
+    // Built natively first, so a curve the addon rejects (TypeError) is never saved
+    this.syncCustomTaper({ ...channel, taper, customTaper });
+    this.config = updateChannelTaper(this.config, channelId, taper, customTaper);
+    this.scheduleSave();
+
+    this.pushChannelGains([channelId]);
+    this.syncHidGainMapping();
+  }
+
+  /**
+   * Set or clear (null) a channel's compressor in every mix it's part of
+   */
+  setChannelCompressor(channelId: string, compressor: ChannelCompressor | null): void {
+    const channel = this.config.inputChannels.find(c => c.id === channelId);
+    if (!channel) {
+      console.error(`Channel not found: ${channelId}`);
+      return;
+    }
+
+    this.config = updateChannelCompressor(this.config, channelId, compressor);
+    this.scheduleSave();
+
+    const deviceHandle = this.getDeviceHandle(channel);
+    if (deviceHandle === undefined) return;
+    for (const mixerHandle of this.mixerHandles.values()) {
+      // Channels that aren't in this mixer are skipped natively
+      this.applyCompressors(mixerHandle, [deviceHandle]);
+    }
+  }
+
+  /**
+   * Push the configured compressor of each given input (by device handle) to a mixer
+   */
+  private applyCompressors(mixerHandle: number, deviceHandles: number[]): void {
+    for (const deviceHandle of deviceHandles) {
+      const channel = this.config.inputChannels.find(c => this.getDeviceHandle(c) === deviceHandle);
+      if (!channel) continue;
+      try {
+        audioAddon.mixerSetInputCompressor(mixerHandle, deviceHandle, channel.compressor);
+      } catch (err) {
+        console.error(`Failed to set compressor for ${channel.id}:`, err);
+      }
+    }
+  }
+
+  /**
+   * Push the current effective gain (tapered volume, or 0 when muted) of the given
+   * channels to every mixer as a single batch per mixer. The native side
+   * applies each batch atomically at one render-cycle boundary.
+   */
+  private pushChannelGains(channelIds: string[]): void {
     if (this.mixerHandles.size === 0) {
-      // Mixer not created yet, just update config
+      // Mixer not created yet, config already holds the values
       return;
     }
 
+    const updates: { channel: number; gain: number }[] = [];
+    for (const channelId of channelIds) {
+      const channel = this.config.inputChannels.find(c => c.id === channelId);
+      if (!channel) continue;
+      const deviceHandle = this.getDeviceHandle(channel);
+      if (deviceHandle === undefined) continue;
+      updates.push({ channel: deviceHandle, gain: this.channelGain(channel) });
+    }
+
+    if (updates.length === 0) return;
+
     for (const [mixId, mixerHandle] of this.mixerHandles) {
       try {
-        audioAddon.mixerSetInputGain(mixerHandle, channel.deviceName, effectiveVolume);
-        console.log(`Updated ${channel.deviceName} gain to ${effectiveVolume} in mixer ${mixId}`);
-      } catch {
-        // Channel may not be in this mixer
+        // Channels that aren't in this mixer are skipped natively
+        audioAddon.mixerApplyUpdates(mixerHandle, updates);
+      } catch (err) {
+        console.error(`Failed to apply gain updates to mixer ${mixId}:`, err);
       }
     }
   }
 
+  /**
+   * Tell the native HID reader which mixer input each analog control drives.
+   * Muted channels and non-volume mappings stay on the JS path. Custom
+   * tapers use the tables syncCustomTaper() built.
+   */
+  private syncHidGainMapping(): void {
+    if (typeof audioAddon.hidSetGainMapping !== 'function') return;
+
+    const mapping: ({ channel: number; taper: VolumeTaper } | null)[] = [];
+    for (let i = 0; i < CHANNEL_DEFINITIONS.length; i++) {
+      const hardwareMapping = this.config.hardwareMapping[i];
+      const channel = hardwareMapping?.type === 'channel-volume'
+        ? this.config.inputChannels.find(c => c.id === hardwareMapping.targetId)
+        : undefined;
+      const deviceHandle = channel && !channel.muted ? this.getDeviceHandle(channel) : undefined;
+      mapping.push(channel && deviceHandle !== undefined
+        ? { channel: deviceHandle, taper: channel.taper }
+        : null);
+    }
+    audioAddon.hidSetGainMapping(mapping);
+  }
+
+  /**
+   * Record a volume the native HID reader has already applied to the mixers
+   */
+  private recordHardwareVolume(channelId: string, hardwareValue: number): void {
+    if (!this.config.inputChannels.some(c => c.id === channelId)) return;
+    this.config = updateChannelVolume(this.config, channelId, hardwareValue / 255);
+    this.scheduleSave();
+  }
+
   /**
    * Set channel volume from hardware value (0-255)
    */
@@ -299,9 +558,42 @@ class AudioRoutingManager {
   }
 
   /**
-   * Handle hardware control change (knob/slider)
+   * Apply a full hardware state snapshot (e.g. the device's state response).
+   * All volume changes go to each mixer as one batch instead of one native
+   * call per control. `applied` marks controls the native reader already
+   * pushed to the mixers.
+   */
+  handleHardwareState(analogValues: number[], applied?: boolean[]): void {
+    const changedChannels: string[] = [];
+    let volumesChanged = false;
+
+    for (let i = 0; i < analogValues.length; i++) {
+      const mapping = this.config.hardwareMapping[i];
+      if (mapping?.type === 'channel-volume') {
+        if (!this.config.inputChannels.some(c => c.id === mapping.targetId)) continue;
+        this.config = updateChannelVolume(this.config, mapping.targetId, analogValues[i] / 255);
+        volumesChanged = true;
+        if (!applied?.[i]) {
+          changedChannels.push(mapping.targetId);
+        }
+      } else {
+        this.handleHardwareChange(i, analogValues[i]);
+      }
+    }
+
+    if (volumesChanged) {
+      this.scheduleSave();
+    }
+    if (changedChannels.length > 0) {
+      this.pushChannelGains(changedChannels);
+    }
+  }
+
+  /**
+   * Handle hardware control change (knob/slider). `applied` is set when the
+   * native HID reader has already pushed the gain to the mixers.
    */
-  handleHardwareChange(hardwareIndex: number, value: number): void {
+  handleHardwareChange(hardwareIndex: number, value: number, applied = false): void {
     const mapping = this.config.hardwareMapping[hardwareIndex];
     if (!mapping) {
       console.warn(`No mapping for hardware index ${hardwareIndex}`);
@@ -310,7 +602,11 @@ class AudioRoutingManager {
 
     switch (mapping.type) {
       case 'channel-volume':
-        this.setChannelVolumeFromHardware(mapping.targetId, value);
+        if (applied) {
+          this.recordHardwareVolume(mapping.targetId, value);
+        } else {
+          this.setChannelVolumeFromHardware(mapping.targetId, value);
+        }
         break;
       case 'channel-mute':
         // Toggle mute on button press (value > 0)
@@ -340,16 +636,11 @@ class AudioRoutingManager {
     this.config = updateChannelMuted(this.config, channelId, muted);
     this.scheduleSave();
 
-    // Update all mixers - set gain to 0 if muted, otherwise use volume
-    const effectiveVolume = muted ? 0 : channel.volume;
+    // Update all mixers - gain is 0 while muted, otherwise the volume
+    this.pushChannelGains([channelId]);
 
-    for (const [mixId, mixerHandle] of this.mixerHandles) {
-      try {
-        audioAddon.mixerSetInputGain(mixerHandle, channel.deviceName, effectiveVolume);
-      } catch {
-        // Channel may not be in this mixer
-      }
-    }
+    // Knob moves on a muted channel must not reach the mixers natively
+    this.syncHidGainMapping();
   }
 
   /**
@@ -376,28 +667,100 @@ class AudioRoutingManager {
 
     // Update mixer
     const mixerHandle = this.mixerHandles.get(mixId);
-    if (mixerHandle !== undefined) {
+    const deviceHandle = this.getDeviceHandle(channel);
+    if (mixerHandle !== undefined && deviceHandle !== undefined) {
       try {
-        audioAddon.mixerSetInputEnabled(mixerHandle, channel.deviceName, enabled);
+        audioAddon.mixerSetInputEnabled(mixerHandle, deviceHandle, enabled);
       } catch (err) {
         console.error(`Failed to update channel enabled state in mixer:`, err);
       }
     }
   }
 
+  /**
+   * Set or clear (null) a mix's sidechain ducking. The key and targets must
+   * be channels of that mix; the native side swaps the whole setup in one
+   * render cycle.
+   */
+  setMixDucking(mixId: string, ducking: MixDucking | null): void {
+    if (!this.config.mixBuses.some(b => b.id === mixId)) {
+      console.error(`Mix bus not found: ${mixId}`);
+      return;
+    }
+
+    this.config = updateMixBusDucking(this.config, mixId, ducking);
+    this.scheduleSave();
+
+    const mixerHandle = this.mixerHandles.get(mixId);
+    if (mixerHandle !== undefined) {
+      this.applyDucking(mixId, mixerHandle);
+    }
+  }
+
+  /**
+   * Push a mix's configured ducking to its mixer (off if the key has no device)
+   */
+  private applyDucking(mixId: string, mixerHandle: number): void {
+    const ducking = this.config.mixBuses.find(b => b.id === mixId)?.ducking ?? null;
+    const keyHandle = ducking ? this.deviceHandles.get(ducking.keyChannelId) : undefined;
+    try {
+      if (!ducking || keyHandle === undefined) {
+        audioAddon.mixerSetDucking(mixerHandle, null);
+        return;
+      }
+      const targets = ducking.targetChannelIds
+        .map(channelId => this.deviceHandles.get(channelId))
+        .filter((handle): handle is number => handle !== undefined);
+      const applied = audioAddon.mixerSetDucking(mixerHandle, {
+        key: keyHandle,
+        targets,
+        thresholdDb: ducking.thresholdDb,
+        ratio: ducking.ratio,
+        attackMs: ducking.attackMs,
+        releaseMs: ducking.releaseMs,
+      });
+      if (!applied) {
+        console.warn(`Ducking key ${ducking.keyChannelId} is not an input of mix ${mixId}`);
+      }
+    } catch (err) {
+      console.error(`Failed to set ducking for mix ${mixId}:`, err);
+    }
+  }
+
+  /**
+   * Current sidechain gain reduction in dB of every mix with ducking on
+   * Returns { mixId: reductionDb }
+   */
+  getDuckingReduction(): Record<string, number> {
+    const result: Record<string, number> = {};
+    for (const [mixId, handle] of this.mixerHandles) {
+      const ducking = audioAddon.mixerGetDucking(handle) as { enabled: boolean; reductionDb: number } | null;
+      if (ducking && ducking.enabled) {
+        result[mixId] = ducking.reductionDb;
+      }
+    }
+    return result;
+  }
+
   /**
    * Set the output device for a mix bus
    */
-  setMixOutput(mixId: string, deviceId: number | null): void {
+  async setMixOutput(mixId: string, deviceId: number | null): Promise<void> {
+    // Persist the UID alongside the ID - the ID is only valid until the next reconnect
+    const outputDevice = deviceId !== null
+      ? this.listDevices().find((d: NativeAudioDevice) => d.id === deviceId)
+      : undefined;
+    const deviceUid = outputDevice?.uid ?? null;
+
     // Update config
-    this.config = updateMixBusOutput(this.config, mixId, deviceId);
+    this.config = updateMixBusOutput(this.config, mixId, deviceId, deviceUid);
     this.scheduleSave();
 
     // Live switch: stop mixer, change output, restart
     const mixerHandle = this.mixerHandles.get(mixId);
     if (mixerHandle !== undefined) {
       try {
-        audioAddon.mixerStop(mixerHandle);
+        await audioAddon.mixerStop(mixerHandle);
 
         // Determine the actual device ID to use
         let actualDeviceId = deviceId;
@@ -413,7 +776,8 @@ class AudioRoutingManager {
           audioAddon.mixerSetOutput(mixerHandle, actualDeviceId);
         }
 
-        audioAddon.mixerStart(mixerHandle);
+        // A newer switch for the same mix supersedes this one
+        if (!(await this.startMixer(mixerHandle))) return;
         console.log(`Mix ${mixId} output switched to device ${actualDeviceId}`);
       } catch (err) {
         console.error(`Failed to switch output for mix ${mixId}:`, err);
@@ -533,19 +897,21 @@ class AudioRoutingManager {
    * Get audio levels for all channels
    * Returns { channelId: { peak, rms } }
    */
-  getAudioLevels(): Record<string, { peak: number; rms: number }> {
-    const result: Record<string, { peak: number; rms: number }> = {};
+  getAudioLevels(): Record<string, { peak: number; rms: number; gainReductionDb: number }> {
+    const result: Record<string, { peak: number; rms: number; gainReductionDb: number }> = {};
 
     // Get levels from the personal mix (main mixer)
     const personalHandle = this.mixerHandles.get('personal');
     if (personalHandle !== undefined) {
       try {
-        const levels = audioAddon.mixerGetLevels(personalHandle) as Record<string, { peak: number; rms: number }>;
+        const levels = audioAddon.mixerGetLevels(personalHandle) as
+          Record<string, { peak: number; rms: number; gainReductionDb: number }>;
 
-        // Map device names back to channel IDs
+        // Map device UIDs back to channel IDs
         for (const channel of this.config.inputChannels) {
-          if (levels[channel.deviceName]) {
-            result[channel.id] = levels[channel.deviceName];
+          const level = levels[channel.deviceUid];
+          if (level) {
+            result[channel.id] = { peak: level.peak, rms: level.rms, gainReductionDb: level.gainReductionDb };
           }
         }
       } catch (err) {
@@ -555,6 +921,189 @@ class AudioRoutingManager {
 
     return result;
   }
+
+  /**
+   * Get IOProc execution-time histograms for every running mix
+   * Returns { mixId: MixTiming }
+   */
+  getCallbackTiming(): Record<string, MixTiming> {
+    const result: Record<string, MixTiming> = {};
+    for (const [mixId, handle] of this.mixerHandles) {
+      const timing = audioAddon.mixerGetTiming(handle) as MixTiming | null;
+      if (timing) {
+        result[mixId] = timing;
+      }
+    }
+    return result;
+  }
+
+  /**
+   * Start every mix's timing histograms over
+   */
+  resetCallbackTiming(): void {
+    for (const handle of this.mixerHandles.values()) {
+      audioAddon.mixerResetTiming(handle);
+    }
+  }
+
+  /**
+   * Start recording real-time engine events, discarding any previous trace
+   */
+  startTrace(): void {
+    audioAddon.traceStart();
+  }
+
+  /**
+   * Stop recording and write Chrome trace JSON (opens in Perfetto)
+   * Resolves with the number of events written
+   */
+  async stopTrace(filePath: string): Promise<number> {
+    audioAddon.traceStop();
+    const result = (await audioAddon.traceWrite(filePath)) as
+      { events: number; droppedThreads: number; droppedEvents: number };
+    if (result.droppedThreads > 0) {
+      console.warn(`Audio trace: ${result.droppedThreads} thread(s) had no trace slot; `
+        + `${result.droppedEvents} event(s) dropped`);
+    }
+    return result.events;
+  }
+
+  /**
+   * Get underrun/overflow counters for every running mix
+   * Returns { mixId: MixXruns }; each call starts a new fill-level window
+   */
+  getXrunStats(): Record<string, MixXruns> {
+    const result: Record<string, MixXruns> = {};
+    for (const [mixId, handle] of this.mixerHandles) {
+      const xruns = audioAddon.mixerGetRingStats(handle) as MixXruns | null;
+      if (xruns) {
+        result[mixId] = xruns;
+      }
+    }
+    return result;
+  }
+
+  /**
+   * Start recording a running mix's output to filePath
+   * Rejects if the mix isn't running or the file can't be created
+   */
+  async startRecording(mixId: string, filePath: string, format: RecordingFormat): Promise<void> {
+    const handle = this.mixerHandles.get(mixId);
+    if (handle === undefined) {
+      throw new Error(`Mix ${mixId} is not running`);
+    }
+    await audioAddon.mixerStartRecording(handle, filePath, format);
+  }
+
+  /**
+   * Finish a mix's recording; resolves with its final stats (null if the mix is gone)
+   */
+  async stopRecording(mixId: string): Promise<RecordingStats | null> {
+    const handle = this.mixerHandles.get(mixId);
+    if (handle === undefined) {
+      return null;
+    }
+    return (await audioAddon.mixerStopRecording(handle)) as RecordingStats | null;
+  }
+
+  /**
+   * Recording progress for every mix that has recorded since it was created
+   * Returns { mixId: RecordingStats }
+   */
+  getRecordingStats(): Record<string, RecordingStats> {
+    const result: Record<string, RecordingStats> = {};
+    for (const [mixId, handle] of this.mixerHandles) {
+      const stats = audioAddon.mixerGetRecordingStats(handle) as RecordingStats | null;
+      if (stats && stats.path) {
+        result[mixId] = stats;
+      }
+    }
+    return result;
+  }
+
+  /**
+   * Record every input of a running mix, after its gain, as aligned stems in directory
+   * Rejects if the mix isn't running or the files can't be created
+   */
+  async startStems(mixId: string, directory: string, layout: StemLayout, format: RecordingFormat): Promise<void> {
+    const handle = this.mixerHandles.get(mixId);
+    if (handle === undefined) {
+      throw new Error(`Mix ${mixId} is not running`);
+    }
+    await audioAddon.mixerStartStems(handle, directory, layout, format);
+  }
+
+  /**
+   * Finish a mix's stem take; resolves with its final stats (null if the mix is gone)
+   */
+  async stopStems(mixId: string): Promise<StemStats | null> {
+    const handle = this.mixerHandles.get(mixId);
+    if (handle === undefined) {
+      return null;
+    }
+    return (await audioAddon.mixerStopStems(handle)) as StemStats | null;
+  }
+
+  /**
+   * Stem take progress for every mix that has recorded stems since it was created
+   * Returns { mixId: StemStats }
+   */
+  getStemStats(): Record<string, StemStats> {
+    const result: Record<string, StemStats> = {};
+    for (const [mixId, handle] of this.mixerHandles) {
+      const stats = audioAddon.mixerGetStemStats(handle) as StemStats | null;
+      if (stats && stats.paths.length > 0) {
+        result[mixId] = stats;
+      }
+    }
+    return result;
+  }
+
+  /**
+   * Keep the last `seconds` of a running mix in memory for saveReplay()
+   * Throws if the mix isn't running
+   */
+  startReplay(mixId: string, seconds: number): void {
+    const handle = this.mixerHandles.get(mixId);
+    if (handle === undefined) {
+      throw new Error(`Mix ${mixId} is not running`);
+    }
+    audioAddon.mixerStartReplay(handle, seconds);
+  }
+
+  /**
+   * Write the newest `seconds` of a mix's replay buffer (0: all of it) to filePath
+   * Resolves with the seconds saved; decoding and the write run on a native worker
+   */
+  async saveReplay(mixId: string, filePath: string, seconds = 0): Promise<number> {
+    const handle = this.mixerHandles.get(mixId);
+    if (handle === undefined) {
+      throw new Error(`Mix ${mixId} is not running`);
+    }
+    return (await audioAddon.mixerSaveReplay(handle, filePath, seconds)) as number;
+  }
+
+  stopReplay(mixId: string): void {
+    const handle = this.mixerHandles.get(mixId);
+    if (handle !== undefined) {
+      audioAddon.mixerStopReplay(handle);
+    }
+  }
+
+  /**
+   * Replay buffer state for every mix that has one running
+   * Returns { mixId: ReplayStats }
+   */
+  getReplayStats(): Record<string, ReplayStats> {
+    const result: Record<string, ReplayStats> = {};
+    for (const [mixId, handle] of this.mixerHandles) {
+      const stats = audioAddon.mixerGetReplayStats(handle) as ReplayStats | null;
+      if (stats && stats.running) {
+        result[mixId] = stats;
+      }
+    }
+    return result;
+  }
 }
 
 export const audioRouting = new AudioRoutingManager();
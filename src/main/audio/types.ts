@@ -8,6 +8,8 @@ export interface InputChannel {
   id: string;
   /** Virtual device name: 'PCPanel K1', 'PCPanel S2', etc. */
   deviceName: string;
+  /** Persistent virtual device UID: 'com.pcpanel.audio.device.1', etc. */
+  deviceUid: string;
   /** User-editable channel name: 'Discord', 'Music', 'Game', etc. */
   channelName: string;
   /** Hardware control index (0-8) mapping to physical knob/slider */
@@ -16,8 +18,38 @@ export interface InputChannel {
   volume: number;
   /** Whether channel is muted */
   muted: boolean;
+  /** How the volume position (and raw hardware value) maps to gain */
+  taper: VolumeTaper;
+  /** Gains at evenly spaced positions for the 'custom' taper (null otherwise) */
+  customTaper: number[] | null;
+  /** Dynamics applied in every mix the channel is part of (null = off) */
+  compressor: ChannelCompressor | null;
 }
 
+/**
+ * Feed-forward compressor on one input channel, before its fader. A ratio
+ * of 100 with peak detection and no knee works as a limiter.
+ */
+export interface ChannelCompressor {
+  enabled: boolean;
+  /** 'peak' reacts to transients; 'rms' follows loudness */
+  detector: 'peak' | 'rms';
+  thresholdDb: number;
+  /** 1-100 */
+  ratio: number;
+  /** Soft-knee width centred on the threshold (0 = hard knee) */
+  kneeDb: number;
+  attackMs: number;
+  releaseMs: number;
+  makeupDb: number;
+}
+
+/**
+ * Volume curve: 'linear' gain, 'db' (equal dB steps down to -60 dB),
+ * 'audio' (log-pot, -20 dB at half travel) or a user 'custom' curve
+ */
+export type VolumeTaper = 'linear' | 'db' | 'audio' | 'custom';
+
 /**
  * Channel configuration within a mix bus
  */
@@ -30,6 +62,22 @@ export interface MixBusChannel {
   gainOverride: number | null;
 }
 
+/**
+ * Sidechain ducking of a mix: while the key channel is above the threshold,
+ * the target channels are turned down
+ */
+export interface MixDucking {
+  /** InputChannel.id whose level drives the ducking */
+  keyChannelId: string;
+  /** InputChannel.ids turned down while the key is loud */
+  targetChannelIds: string[];
+  thresholdDb: number;
+  /** Reduction is (key dB over threshold) * (1 - 1 / ratio) */
+  ratio: number;
+  attackMs: number;
+  releaseMs: number;
+}
+
 /**
  * A mix bus that aggregates multiple input channels and routes to an output
  */
@@ -40,8 +88,15 @@ export interface MixBus {
   name: string;
   /** Output device ID (null = default output, or virtual mic device ID) */
   outputDeviceId: number | null;
+  /**
+   * Persistent UID of the output device (null = default output).
+   * Device IDs are not stable across reboots/reconnects; this is what gets resolved on startup.
+   */
+  outputDeviceUid: string | null;
   /** Channels included in this mix with their settings */
   channels: MixBusChannel[];
+  /** Sidechain ducking (null = off) */
+  ducking: MixDucking | null;
 }
 
 /**
@@ -103,6 +158,129 @@ export interface AudioRoutingState {
   availableOutputs: AudioOutputDevice[];
 }
 
+/**
+ * Execution time of one audio callback since the last reset (times in µs)
+ */
+export interface CallbackTimingStats {
+  /** Callbacks recorded */
+  count: number;
+  /** Callbacks that ran longer than their buffer period */
+  deadlineMisses: number;
+  minUs: number;
+  maxUs: number;
+  meanUs: number;
+  /** Percentiles are histogram bucket upper bounds (quarter-octave resolution) */
+  p50Us: number;
+  p99Us: number;
+  /** Buffer period of the latest callback */
+  periodUs: number;
+  /** Non-empty buckets as [upper bound µs, count] */
+  histogram: [number, number][];
+}
+
+/**
+ * Callback timing of one mixer: its output IOProc and each input IOProc
+ */
+export interface MixTiming {
+  output: CallbackTimingStats;
+  /** Keyed by device UID */
+  inputs: Record<string, CallbackTimingStats & { name: string; handle: number }>;
+}
+
+/**
+ * Underrun/overflow counters of one ring buffer (counters are cumulative)
+ */
+export interface RingXrunStats {
+  /** Reads that came back short, and the frames of silence they were padded with */
+  underruns: number;
+  silentFrames: number;
+  /** Writes that did not fit, and the frames they lost */
+  overflows: number;
+  droppedFrames: number;
+  /** Fill level seen by the reader since the previous call */
+  fillMinFrames: number;
+  fillMaxFrames: number;
+  capacityFrames: number;
+}
+
+/**
+ * Xruns of one mixer: its capture ring per input, and those summed for the bus
+ */
+export interface MixXruns {
+  total: RingXrunStats;
+  /** Keyed by device UID */
+  inputs: Record<string, RingXrunStats & { name: string; handle: number }>;
+}
+
+/**
+ * File format for bus recordings (both Float32 stereo; CAF has no 4 GB limit)
+ */
+export type RecordingFormat = 'wav' | 'caf';
+
+/**
+ * Progress of a mix bus recording, or the final figures once it has stopped
+ */
+export interface RecordingStats {
+  recording: boolean;
+  path: string;
+  framesWritten: number;
+  /** Frames lost because the disk fell behind for longer than the ring lasts */
+  droppedFrames: number;
+  bytesWritten: number;
+  seconds: number;
+  /** Time spent inside file writes; bytesWritten / writeSeconds is disk throughput */
+  writeSeconds: number;
+  maxWriteMs: number;
+  /** Most the recorder's ring held before the writer drained it */
+  backlogMaxFrames: number;
+  ringCapacityFrames: number;
+}
+
+/**
+ * How a stem take is laid out on disk: one stereo file per input, or one
+ * file with every input as a channel pair
+ */
+export type StemLayout = 'files' | 'interleaved';
+
+/**
+ * Progress of a multitrack stem take, or the final figures once it has stopped
+ */
+export interface StemStats {
+  recording: boolean;
+  paths: string[];
+  stems: number;
+  /** Per stem; all stems are the same length and start on the same sample */
+  framesWritten: number;
+  droppedFrames: number;
+  bytesWritten: number;
+  seconds: number;
+  writeSeconds: number;
+  maxWriteMs: number;
+  backlogMaxFrames: number;
+}
+
+/**
+ * Instant-replay buffer of a mix: memory use and how much can be saved
+ */
+export interface ReplayStats {
+  running: boolean;
+  sampleRate: number;
+  windowSeconds: number;
+  /** Encoded and saveable now */
+  heldSeconds: number;
+  compressedBytes: number;
+  /** Memory reserved for the window; never grows past this */
+  arenaBytes: number;
+  bytesPerMinute: number;
+  /** Float32 size over compressed size */
+  compressionRatio: number;
+  droppedFrames: number;
+  /** Frames pushed out early because the arena filled before the window */
+  evictedFrames: number;
+  encodeSeconds: number;
+  maxEncodeMs: number;
+}
+
 /**
  * Audio output device info
  */
@@ -111,25 +289,33 @@ export interface AudioOutputDevice {
   id: number;
   /** Device name */
   name: string;
+  /** Persistent device UID */
+  uid: string;
   /** Whether this is the system default */
   isDefault: boolean;
 }
 
 /**
- * Default channel IDs and device names
+ * Default channel IDs, device names and UIDs (UIDs match the driver's DeviceUID)
  */
-export const CHANNEL_DEFINITIONS: readonly { id: string; deviceName: string; hardwareIndex: number }[] = [
-  { id: 'k1', deviceName: 'PCPanel K1', hardwareIndex: 0 },
-  { id: 'k2', deviceName: 'PCPanel K2', hardwareIndex: 1 },
-  { id: 'k3', deviceName: 'PCPanel K3', hardwareIndex: 2 },
-  { id: 'k4', deviceName: 'PCPanel K4', hardwareIndex: 3 },
-  { id: 'k5', deviceName: 'PCPanel K5', hardwareIndex: 4 },
-  { id: 's1', deviceName: 'PCPanel S1', hardwareIndex: 5 },
-  { id: 's2', deviceName: 'PCPanel S2', hardwareIndex: 6 },
-  { id: 's3', deviceName: 'PCPanel S3', hardwareIndex: 7 },
-  { id: 's4', deviceName: 'PCPanel S4', hardwareIndex: 8 },
+export const CHANNEL_DEFINITIONS: readonly { id: string; deviceName: string; deviceUid: string; hardwareIndex: number }[] = [
+  { id: 'k1', deviceName: 'PCPanel K1', deviceUid: 'com.pcpanel.audio.device.1', hardwareIndex: 0 },
+  { id: 'k2', deviceName: 'PCPanel K2', deviceUid: 'com.pcpanel.audio.device.2', hardwareIndex: 1 },
+  { id: 'k3', deviceName: 'PCPanel K3', deviceUid: 'com.pcpanel.audio.device.3', hardwareIndex: 2 },
+  { id: 'k4', deviceName: 'PCPanel K4', deviceUid: 'com.pcpanel.audio.device.4', hardwareIndex: 3 },
+  { id: 'k5', deviceName: 'PCPanel K5', deviceUid: 'com.pcpanel.audio.device.5', hardwareIndex: 4 },
+  { id: 's1', deviceName: 'PCPanel S1', deviceUid: 'com.pcpanel.audio.device.6', hardwareIndex: 5 },
+  { id: 's2', deviceName: 'PCPanel S2', deviceUid: 'com.pcpanel.audio.device.7', hardwareIndex: 6 },
+  { id: 's3', deviceName: 'PCPanel S3', deviceUid: 'com.pcpanel.audio.device.8', hardwareIndex: 7 },
+  { id: 's4', deviceName: 'PCPanel S4', deviceUid: 'com.pcpanel.audio.device.9', hardwareIndex: 8 },
 ] as const;
 
+/** UID prefix shared by all PCPanel virtual devices */
+export const PCPANEL_UID_PREFIX = 'com.pcpanel.audio.';
+
+/** UID of the Voice Chat virtual mic device */
+export const VOICE_CHAT_DEVICE_UID = 'com.pcpanel.audio.voicechat';
+
 /**
  * Create default configuration
  */
@@ -137,10 +323,14 @@ export function createDefaultConfig(): AudioRoutingConfig {
   const inputChannels: InputChannel[] = CHANNEL_DEFINITIONS.map(def => ({
     id: def.id,
     deviceName: def.deviceName,
+    deviceUid: def.deviceUid,
     channelName: def.id.toUpperCase(),
     hardwareIndex: def.hardwareIndex,
     volume: 1.0,
     muted: false,
+    taper: 'audio' as VolumeTaper,
+    customTaper: null,
+    compressor: null,
   }));
 
   const mixBuses: MixBus[] = [
@@ -148,17 +338,21 @@ export function createDefaultConfig(): AudioRoutingConfig {
       id: 'personal',
       name: 'Personal Mix',
       outputDeviceId: null, // Default output
+      outputDeviceUid: null,
       channels: CHANNEL_DEFINITIONS.map(def => ({
         channelId: def.id,
         enabled: true,
         gainOverride: null,
       })),
+      ducking: null,
     },
     {
       id: 'voicechat',
       name: 'Voice Chat Mix',
       outputDeviceId: null, // Will be virtual mic device
+      outputDeviceUid: VOICE_CHAT_DEVICE_UID,
       channels: [], // Empty by default, user adds channels
+      ducking: null,
     },
   ];
 
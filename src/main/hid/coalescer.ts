@@ -0,0 +1,173 @@
+// Per-control knob event coalescer
+// A fast slider sweep produces one HID report per step; downstream every
+// delivered event costs a state copy, an IPC message and N-API gain calls.
+// The coalescer forwards at most one knob-change per control per window.
+
+import { DeviceEvent, KnobChangeEvent } from './protocol';
+
+// One 60 Hz UI frame; fine enough that a sweep still looks continuous
+export const DEFAULT_COALESCE_WINDOW_MS = 16;
+
+// Knob values at the ends of travel can't be overtaken in that direction,
+// so they are delivered without waiting for the window
+const VALUE_MIN = 0;
+const VALUE_MAX = 255;
+
+export interface CoalescerStats {
+  received: number;
+  delivered: number;
+}
+
+/**
+ * Collapses bursts of knob-change events per control to the latest value.
+ *
+ * - The first change of a control after a quiet window is delivered at once.
+ * - Further changes inside the window replace a single pending event, which
+ *   is delivered when the window closes (no extra debounce delay), so the
+ *   final value of a sweep always lands at most one window late.
+ * - End-of-travel values, button changes and state responses are delivered
+ *   immediately; a state response drops pending knob events it supersedes.
+ *
+ * A window of 0 disables coalescing.
+ */
+export class EventCoalescer {
+  private readonly lastDelivered: number[] = [];
+  private readonly pending: (KnobChangeEvent | null)[] = [];
+  private timer: ReturnType<typeof setTimeout> | null = null;
+  private timerDue = Infinity;
+  private batch: DeviceEvent[] | null = null;
+  private received = 0;
+  private delivered = 0;
+
+  constructor(
+    private readonly windowMs: number,
+    private readonly deliver: (events: DeviceEvent[]) => void,
+    private readonly now: () => number = () => performance.now(),
+  ) {}
+
+  push(event: DeviceEvent): void {
+    this.received++;
+
+    if (event.type === 'state-response') {
+      this.pending.fill(null);
+      this.emit([event]);
+      return;
+    }
+
+    if (event.type !== 'knob-change' || this.windowMs <= 0) {
+      this.emit([event]);
+      return;
+    }
+
+    const index = event.index;
+    const now = this.now();
+    const last = this.lastDelivered[index];
+    const atEnd = event.value === VALUE_MIN || event.value === VALUE_MAX;
+
+    if (atEnd || last === undefined || now - last >= this.windowMs) {
+      this.pending[index] = null;
+      this.lastDelivered[index] = now;
+      this.emit([event]);
+      return;
+    }
+
+    this.pending[index] = event;
+    this.schedule(last + this.windowMs, now);
+  }
+
+  /**
+   * Push several events and deliver whatever passes through as one batch
+   */
+  pushAll(events: DeviceEvent[]): void {
+    this.batch = [];
+    try {
+      for (const event of events) {
+        this.push(event);
+      }
+    } finally {
+      const ready = this.batch;
+      this.batch = null;
+      if (ready.length > 0) {
+        this.deliver(ready);
+      }
+    }
+  }
+
+  /**
+   * Deliver pending events whose window has closed (all of them when forced)
+   */
+  flush(force = false): void {
+    if (this.timer) {
+      clearTimeout(this.timer);
+      this.timer = null;
+    }
+    this.timerDue = Infinity;
+
+    const now = this.now();
+    const ready: DeviceEvent[] = [];
+    let nextDue = Infinity;
+
+    for (let index = 0; index < this.pending.length; index++) {
+      const event = this.pending[index];
+      if (!event) continue;
+
+      const due = (this.lastDelivered[index] ?? 0) + this.windowMs;
+      if (force || now >= due) {
+        this.pending[index] = null;
+        this.lastDelivered[index] = now;
+        ready.push(event);
+      } else {
+        nextDue = Math.min(nextDue, due);
+      }
+    }
+
+    if (nextDue !== Infinity) {
+      this.schedule(nextDue, now);
+    }
+    if (ready.length > 0) {
+      this.emit(ready);
+    }
+  }
+
+  /**
+   * Drop pending events and timers (on disconnect)
+   */
+  reset(): void {
+    if (this.timer) {
+      clearTimeout(this.timer);
+      this.timer = null;
+    }
+    this.timerDue = Infinity;
+    this.pending.fill(null);
+    this.lastDelivered.length = 0;
+  }
+
+  /**
+   * Time the pending flush is due (Infinity when nothing is pending)
+   */
+  nextFlushTime(): number {
+    return this.timerDue;
+  }
+
+  getStats(): CoalescerStats {
+    return { received: this.received, delivered: this.delivered };
+  }
+
+  private schedule(due: number, now: number): void {
+    if (this.timer) {
+      if (due >= this.timerDue) return;
+      clearTimeout(this.timer);
+    }
+    this.timerDue = due;
+    this.timer = setTimeout(() => this.flush(), Math.max(0, due - now));
+  }
+
+  private emit(events: DeviceEvent[]): void {
+    this.delivered += events.length;
+    if (this.batch) {
+      this.batch.push(...events);
+    } else {
+      this.deliver(events);
+    }
+  }
+}
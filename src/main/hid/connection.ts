@@ -1,6 +1,9 @@
 import HID from 'node-hid';
+import * as fs from 'fs';
 import { EventEmitter } from 'events';
 import { parseInputPacket, createStateRequestPacket, DeviceEvent, ANALOG_COUNT, BUTTON_COUNT, VENDOR_ID, PRODUCT_ID } from './protocol';
+import { EventCoalescer, DEFAULT_COALESCE_WINDOW_MS } from './coalescer';
+import { TRACE_HEADER, formatTraceEntry } from './trace';
 
 export interface DeviceState {
   connected: boolean;
@@ -8,17 +11,33 @@ export interface DeviceState {
   buttonStates: boolean[]; // 5 buttons
 }
 
+export interface ConnectionOptions {
+  // Per-control knob event window in ms; 0 delivers every report
+  coalesceWindowMs?: number;
+  // Append every raw input report to this HID trace file (see trace.ts)
+  recordPath?: string;
+}
+
 export class PCPanelConnection extends EventEmitter {
   private device: HID.HID | null = null;
   private state: DeviceState;
+  private coalescer: EventCoalescer;
+  private recordPath: string | undefined;
+  private recorder: fs.WriteStream | null = null;
+  private recordStart = 0;
 
-  constructor() {
+  constructor(options: ConnectionOptions = {}) {
     super();
     this.state = {
       connected: false,
       analogValues: new Array(ANALOG_COUNT).fill(0),
       buttonStates: new Array(BUTTON_COUNT).fill(false),
     };
+    this.coalescer = new EventCoalescer(
+      options.coalesceWindowMs ?? DEFAULT_COALESCE_WINDOW_MS,
+      (events) => this.deliverEvents(events),
+    );
+    this.recordPath = options.recordPath;
   }
 
   connect(_path: string): boolean {
@@ -26,6 +45,7 @@ export class PCPanelConnection extends EventEmitter {
       // Open by VID/PID (more reliable on macOS)
       this.device = new HID.HID(VENDOR_ID, PRODUCT_ID);
       this.state.connected = true;
+      this.startRecording();
 
       this.device.on('data', (data: Buffer) => {
         this.handleData(data);
@@ -53,16 +73,24 @@ export class PCPanelConnection extends EventEmitter {
       }
       this.device = null;
     }
+    this.coalescer.reset();
+    this.stopRecording();
     this.state.connected = false;
     this.emit('disconnected');
   }
 
   private handleData(data: Buffer): void {
+    if (this.recorder) {
+      const timeUs = (performance.now() - this.recordStart) * 1000;
+      this.recorder.write(formatTraceEntry(timeUs, data) + '\n');
+    }
+
     const event = parseInputPacket(data);
     if (!event) {
       return;
     }
 
+    // State tracks every report; only the emitted events are coalesced
     if (event.type === 'knob-change') {
       this.state.analogValues[event.index] = event.value;
     } else if (event.type === 'button-change') {
@@ -72,10 +100,37 @@ export class PCPanelConnection extends EventEmitter {
       this.state.buttonStates = [...event.buttonStates];
     }
 
-    this.emit('event', event);
+    this.coalescer.push(event);
+  }
+
+  private deliverEvents(events: DeviceEvent[]): void {
+    for (const event of events) {
+      this.emit('event', event);
+    }
     this.emit('state', this.getState());
   }
 
+  private startRecording(): void {
+    if (!this.recordPath || this.recorder) {
+      return;
+    }
+    this.recorder = fs.createWriteStream(this.recordPath, { flags: 'a' });
+    this.recorder.on('error', (error: Error) => {
+      console.error('HID trace recording failed:', error);
+      this.recorder = null;
+    });
+    this.recorder.write(TRACE_HEADER + '\n');
+    this.recordStart = performance.now();
+    console.log(`Recording HID reports to ${this.recordPath}`);
+  }
+
+  private stopRecording(): void {
+    if (this.recorder) {
+      this.recorder.end();
+      this.recorder = null;
+    }
+  }
+
   getState(): DeviceState {
     return { ...this.state };
   }
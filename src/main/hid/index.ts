@@ -1,3 +1,5 @@
 export * from './protocol';
 export * from './scanner';
 export * from './connection';
+export * from './coalescer';
+export * from './native';
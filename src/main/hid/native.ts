@@ -0,0 +1,136 @@
+// Native PC Panel reader
+// The addon opens the device on its own thread, applies mapped knob/slider
+// gains straight into the mixers and delivers coalesced events here
+
+import * as path from 'path';
+import { app } from 'electron';
+import { EventEmitter } from 'events';
+import { DeviceEvent, ANALOG_COUNT, BUTTON_COUNT, VENDOR_ID, PRODUCT_ID } from './protocol';
+import { DeviceState, ConnectionOptions } from './connection';
+import { EventCoalescer, DEFAULT_COALESCE_WINDOW_MS } from './coalescer';
+
+/**
+ * Get the path to the native audio addon.
+ * Works in both development and packaged modes.
+ */
+function getNativeModulePath(): string {
+  if (app.isPackaged) {
+    return path.join(process.resourcesPath, 'native', 'pcpanel_audio.node');
+  } else {
+    return path.join(__dirname, '../../../native/build/Release/pcpanel_audio.node');
+  }
+}
+
+// Load the native addon
+// eslint-disable-next-line @typescript-eslint/no-var-requires
+const audioAddon = require(getNativeModulePath());
+
+type NativeHidEvent = DeviceEvent | { type: 'connected' } | { type: 'disconnected' };
+
+/**
+ * Drop-in alternative to PCPanelConnection backed by the native reader.
+ * Emits the same 'connected' / 'disconnected' / 'event' / 'state' events;
+ * knob and state events carry `applied` when the gain was already set natively.
+ */
+export class NativePCPanelConnection extends EventEmitter {
+  private started = false;
+  private state: DeviceState;
+  private coalescer: EventCoalescer;
+
+  constructor(options: ConnectionOptions = {}) {
+    super();
+    this.state = {
+      connected: false,
+      analogValues: new Array(ANALOG_COUNT).fill(0),
+      buttonStates: new Array(BUTTON_COUNT).fill(false),
+    };
+    // Gains are already applied natively per report; this only limits how
+    // often the app and renderer hear about it
+    this.coalescer = new EventCoalescer(
+      options.coalesceWindowMs ?? DEFAULT_COALESCE_WINDOW_MS,
+      (events) => this.deliverEvents(events),
+    );
+  }
+
+  /**
+   * Whether this build of the addon has the native reader
+   */
+  static isAvailable(): boolean {
+    return typeof audioAddon.hidStart === 'function';
+  }
+
+  /**
+   * Start watching for the device; connection changes arrive as events
+   */
+  connect(): boolean {
+    if (this.started) {
+      return true;
+    }
+
+    this.started = audioAddon.hidStart(VENDOR_ID, PRODUCT_ID, (events: NativeHidEvent[]) => {
+      this.handleEvents(events);
+    });
+    return this.started;
+  }
+
+  disconnect(): void {
+    if (this.started) {
+      audioAddon.hidStop();
+      this.started = false;
+    }
+    this.coalescer.reset();
+    if (this.state.connected) {
+      this.state.connected = false;
+      this.emit('disconnected');
+    }
+  }
+
+  private handleEvents(events: NativeHidEvent[]): void {
+    const deviceEvents: DeviceEvent[] = [];
+
+    for (const event of events) {
+      if (event.type === 'connected') {
+        this.state.connected = true;
+        this.emit('connected');
+        continue;
+      }
+      if (event.type === 'disconnected') {
+        this.coalescer.reset();
+        this.state.connected = false;
+        this.emit('disconnected');
+        continue;
+      }
+
+      if (event.type === 'knob-change') {
+        this.state.analogValues[event.index] = event.value;
+      } else if (event.type === 'button-change') {
+        this.state.buttonStates[event.index] = event.pressed;
+      } else if (event.type === 'state-response') {
+        this.state.analogValues = [...event.analogValues];
+        this.state.buttonStates = [...event.buttonStates];
+      }
+      deviceEvents.push(event);
+    }
+
+    this.coalescer.pushAll(deviceEvents);
+  }
+
+  private deliverEvents(events: DeviceEvent[]): void {
+    for (const event of events) {
+      this.emit('event', event);
+    }
+    this.emit('state', this.getState());
+  }
+
+  getState(): DeviceState {
+    return { ...this.state };
+  }
+
+  isConnected(): boolean {
+    return this.state.connected;
+  }
+
+  requestState(): boolean {
+    return audioAddon.hidRequestState();
+  }
+}
@@ -88,6 +88,7 @@ export interface KnobChangeEvent {
   type: 'knob-change';
   index: number; // 0-N
   value: number; // 0-255
+  applied?: boolean; // Gain already applied by the native reader
 }
 
 export interface ButtonChangeEvent {
@@ -100,6 +101,7 @@ export interface StateResponseEvent {
   type: 'state-response';
   analogValues: number[]; // N values, 0-255
   buttonStates: boolean[]; // M buttons
+  applied?: boolean[]; // Per analog control, gain already applied by the native reader
 }
 
 export type DeviceEvent = KnobChangeEvent | ButtonChangeEvent | StateResponseEvent;
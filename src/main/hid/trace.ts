@@ -0,0 +1,46 @@
+// HID trace format
+// Plain-text capture of raw input reports so knob sessions can be replayed
+// without the hardware. One report per line:
+//
+//   # pcpanel-hid-trace v1
+//   <microseconds since capture start> <report bytes as hex>
+//
+// Trailing zero bytes are trimmed on write and restored on read.
+
+import { PACKET_SIZE } from './protocol';
+
+export const TRACE_HEADER = '# pcpanel-hid-trace v1';
+
+export interface TraceEntry {
+  timeUs: number;
+  report: Buffer;
+}
+
+export function formatTraceEntry(timeUs: number, report: Buffer): string {
+  let end = report.length;
+  while (end > 1 && report[end - 1] === 0) {
+    end--;
+  }
+  return `${Math.round(timeUs)} ${report.subarray(0, end).toString('hex')}`;
+}
+
+export function parseTrace(text: string): TraceEntry[] {
+  const entries: TraceEntry[] = [];
+
+  for (const rawLine of text.split('\n')) {
+    const line = rawLine.trim();
+    if (!line || line.startsWith('#')) continue;
+
+    const [time, hex] = line.split(/\s+/);
+    const timeUs = Number(time);
+    if (!Number.isFinite(timeUs) || !hex || hex.length % 2 !== 0) {
+      throw new Error(`Malformed trace line: ${line}`);
+    }
+
+    const report = Buffer.alloc(Math.max(PACKET_SIZE, hex.length / 2));
+    report.write(hex, 'hex');
+    entries.push({ timeUs, report });
+  }
+
+  return entries;
+}
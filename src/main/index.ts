@@ -1,12 +1,13 @@
 import { app, BrowserWindow, ipcMain, Tray, Menu, nativeImage, dialog } from 'electron';
+import * as fs from 'fs';
 import * as path from 'path';
-import { scanForDevices, PCPanelConnection, DeviceState, DeviceEvent } from './hid';
+import { scanForDevices, PCPanelConnection, NativePCPanelConnection, DeviceState, DeviceEvent } from './hid';
 import { audioRouting } from './audio/routing';
-import { CHANNEL_DEFINITIONS } from './audio/types';
+import { CHANNEL_DEFINITIONS, ChannelCompressor, MixDucking, VolumeTaper } from './audio/types';
 import { isDriverInstalled, promptAndInstallDriver, showDriverNotInstalledWarning, isFirstLaunch, markFirstLaunchComplete } from './driver/installer';
 
 let mainWindow: BrowserWindow | null = null;
-let connection: PCPanelConnection | null = null;
+let connection: PCPanelConnection | NativePCPanelConnection | null = null;
 let scanInterval: NodeJS.Timeout | null = null;
 let activityInterval: NodeJS.Timeout | null = null;
 let levelsInterval: NodeJS.Timeout | null = null;
@@ -195,13 +196,12 @@ async function connectToDevice(): Promise<void> {
     await new Promise(resolve => setTimeout(resolve, 100));
   }
 
-  connection = new PCPanelConnection();
+  // PCPANEL_HID_TRACE=<file> records raw reports for native/tools/hid_replay
+  connection = new PCPanelConnection({ recordPath: process.env.PCPANEL_HID_TRACE });
+  attachConnectionHandlers(connection, device.profile.name);
 
+  // Request current device state to initialize volumes
   connection.on('connected', () => {
-    log(`Connected to ${device.profile.name}`);
-    sendToRenderer('device-status', { connected: true, message: `Connected to ${device.profile.name}` });
-
-    // Request current device state to initialize volumes
     setTimeout(() => {
       if (connection) {
         log('Requesting device state...');
@@ -210,39 +210,69 @@ async function connectToDevice(): Promise<void> {
     }, 100);
   });
 
-  connection.on('disconnected', () => {
-    log(`Disconnected from ${device.profile.name}`);
+  const success = connection.connect(device.path);
+  if (!success) {
+    sendToRenderer('device-status', { connected: false, message: 'Failed to connect' });
+  }
+}
+
+function attachConnectionHandlers(conn: PCPanelConnection | NativePCPanelConnection, deviceName: string): void {
+  conn.on('connected', () => {
+    log(`Connected to ${deviceName}`);
+    sendToRenderer('device-status', { connected: true, message: `Connected to ${deviceName}` });
+  });
+
+  conn.on('disconnected', () => {
+    log(`Disconnected from ${deviceName}`);
     sendToRenderer('device-status', { connected: false, message: 'Disconnected' });
   });
 
-  connection.on('event', (event: DeviceEvent) => {
+  conn.on('event', (event: DeviceEvent) => {
     sendToRenderer('device-event', event);
 
-    // Update volume when knob or slider changes
+    // Update volume when knob or slider changes (already applied to the
+    // mixers when the native reader delivered it)
     if (event.type === 'knob-change') {
-      audioRouting.handleHardwareChange(event.index, event.value);
+      audioRouting.handleHardwareChange(event.index, event.value, event.applied ?? false);
     } else if (event.type === 'state-response') {
-      // Apply all initial volume values from device state
+      // Apply all initial volume values from device state in one batch
       log('Received device state, applying initial volumes');
-      for (let i = 0; i < event.analogValues.length; i++) {
-        audioRouting.handleHardwareChange(i, event.analogValues[i]);
-      }
+      audioRouting.handleHardwareState(event.analogValues, event.applied);
     }
   });
 
-  connection.on('state', (state: DeviceState) => {
+  conn.on('state', (state: DeviceState) => {
     sendToRenderer('device-state', state);
   });
 
-  connection.on('error', (error: Error) => {
+  conn.on('error', (error: Error) => {
     logError('Device error:', error);
     sendToRenderer('device-status', { connected: false, message: `Error: ${error.message}` });
   });
+}
 
-  const success = connection.connect(device.path);
-  if (!success) {
-    sendToRenderer('device-status', { connected: false, message: 'Failed to connect' });
+/**
+ * Read the panel in the native addon: reports are parsed on a dedicated
+ * thread and mapped gains go straight to the mixers, independent of how
+ * busy this thread is. The native reader handles hotplug itself and
+ * requests the device state on connect.
+ */
+function startNativeHid(): boolean {
+  if (!NativePCPanelConnection.isAvailable()) {
+    return false;
   }
+
+  const nativeConnection = new NativePCPanelConnection();
+  attachConnectionHandlers(nativeConnection, 'PC Panel');
+  if (!nativeConnection.connect()) {
+    logError('Native HID reader failed to start, falling back to node-hid');
+    nativeConnection.removeAllListeners();
+    return false;
+  }
+
+  connection = nativeConnection;
+  sendToRenderer('device-status', { connected: false, message: 'No PC Panel found' });
+  return true;
 }
 
 function startDeviceScanning(): void {
@@ -318,14 +348,23 @@ app.whenReady().then(async () => {
     }
   }, 500);
 
-  startDeviceScanning();
+  // Prefer the native reader; node-hid polling is the fallback. Recording a
+  // HID trace needs the raw reports, which only the node-hid path sees.
+  if (process.env.PCPANEL_HID_TRACE || !startNativeHid()) {
+    startDeviceScanning();
+  }
 
   // Start audio routing (BEACN-style mixer)
-  setTimeout(() => {
+  setTimeout(async () => {
     log('Starting audio routing...');
-    audioRouting.initialize();
+    await audioRouting.initialize();
     log('Audio routing started');
 
+    // Refresh the renderer's device lists when CoreAudio devices change
+    audioRouting.onDevicesChanged(() => {
+      sendToRenderer('audio-routing', audioRouting.getState());
+    });
+
     // Start polling for channel activity
     activityInterval = setInterval(() => {
       const activityInfo = audioRouting.getChannelActivityInfo();
@@ -361,12 +400,11 @@ app.on('window-all-closed', () => {
   // On macOS with tray, don't quit when windows are closed
   // The app continues running in the background
   if (process.platform !== 'darwin') {
-    cleanup();
     app.quit();
   }
 });
 
-function cleanup(): void {
+async function cleanup(): Promise<void> {
   if (scanInterval) {
     clearInterval(scanInterval);
     scanInterval = null;
@@ -383,17 +421,27 @@ function cleanup(): void {
     connection.disconnect();
     connection = null;
   }
-  // Stop all audio routing
-  audioRouting.shutdown();
-
   if (tray) {
     tray.destroy();
     tray = null;
   }
+
+  // Stop all audio routing; recordings are finalized on a native worker thread
+  await audioRouting.shutdown();
 }
 
-app.on('will-quit', () => {
-  cleanup();
+let cleanedUp = false;
+
+app.on('will-quit', (event) => {
+  if (cleanedUp) return;
+  // Hold the quit until the mixers have stopped and their files are closed
+  event.preventDefault();
+  cleanup()
+    .catch((err) => console.error('Cleanup failed:', err))
+    .finally(() => {
+      cleanedUp = true;
+      app.quit();
+    });
 });
 
 // IPC handlers
@@ -406,14 +454,19 @@ ipcMain.handle('get-device-state', () => {
 });
 
 ipcMain.handle('reconnect-device', async () => {
+  if (connection instanceof NativePCPanelConnection) {
+    // The native reader reconnects on its own; just refresh the state
+    connection.requestState();
+    return;
+  }
   await connectToDevice();
 });
 
 ipcMain.handle('get-output-device', () => {
   const state = audioRouting.getState();
   const personalMix = state.mixBuses.find(m => m.id === 'personal');
-  if (personalMix && personalMix.outputDeviceId !== null) {
-    const output = state.availableOutputs.find(o => o.id === personalMix.outputDeviceId);
+  if (personalMix && personalMix.outputDeviceUid !== null) {
+    const output = state.availableOutputs.find(o => o.uid === personalMix.outputDeviceUid);
     if (output) return output;
   }
   // Return default output
@@ -424,6 +477,77 @@ ipcMain.handle('get-channel-activity', () => {
   return audioRouting.getChannelActivityInfo();
 });
 
+ipcMain.handle('get-callback-timing', () => {
+  return audioRouting.getCallbackTiming();
+});
+
+ipcMain.handle('reset-callback-timing', () => {
+  audioRouting.resetCallbackTiming();
+  return true;
+});
+
+ipcMain.handle('get-xrun-stats', () => {
+  return audioRouting.getXrunStats();
+});
+
+ipcMain.handle('start-audio-trace', () => {
+  audioRouting.startTrace();
+  return true;
+});
+
+ipcMain.handle('stop-audio-trace', async () => {
+  const filePath = path.join(app.getPath('logs'), `audio-trace-${Date.now()}.json`);
+  const events = await audioRouting.stopTrace(filePath);
+  return { path: filePath, events };
+});
+
+ipcMain.handle('start-recording', async (_event, mixId: string, format: 'wav' | 'caf' = 'wav') => {
+  const filePath = path.join(app.getPath('music'), `pcpanel-${mixId}-${Date.now()}.${format}`);
+  await audioRouting.startRecording(mixId, filePath, format);
+  return filePath;
+});
+
+ipcMain.handle('stop-recording', (_event, mixId: string) => {
+  return audioRouting.stopRecording(mixId);
+});
+
+ipcMain.handle('get-recording-stats', () => {
+  return audioRouting.getRecordingStats();
+});
+
+ipcMain.handle('start-stems', async (_event, mixId: string, layout: 'files' | 'interleaved' = 'files',
+  format: 'wav' | 'caf' = 'wav') => {
+  const directory = path.join(app.getPath('music'), `pcpanel-${mixId}-stems-${Date.now()}`);
+  await fs.promises.mkdir(directory, { recursive: true });
+  await audioRouting.startStems(mixId, directory, layout, format);
+  return directory;
+});
+
+ipcMain.handle('stop-stems', (_event, mixId: string) => {
+  return audioRouting.stopStems(mixId);
+});
+
+ipcMain.handle('get-stem-stats', () => {
+  return audioRouting.getStemStats();
+});
+
+ipcMain.handle('start-replay', (_event, mixId: string, seconds = 120) => {
+  audioRouting.startReplay(mixId, seconds);
+});
+
+ipcMain.handle('save-replay', async (_event, mixId: string, seconds = 0) => {
+  const filePath = path.join(app.getPath('music'), `pcpanel-${mixId}-replay-${Date.now()}.wav`);
+  return { path: filePath, seconds: await audioRouting.saveReplay(mixId, filePath, seconds) };
+});
+
+ipcMain.handle('stop-replay', (_event, mixId: string) => {
+  audioRouting.stopReplay(mixId);
+});
+
+ipcMain.handle('get-replay-stats', () => {
+  return audioRouting.getReplayStats();
+});
+
 // Audio routing IPC handlers
 ipcMain.handle('get-audio-routing', () => {
   const state = audioRouting.getState();
@@ -446,16 +570,35 @@ ipcMain.handle('set-channel-muted', (_event, channelId: string, muted: boolean)
   return true;
 });
 
+ipcMain.handle('set-channel-taper', (_event, channelId: string, taper: VolumeTaper, customTaper: number[] | null) => {
+  audioRouting.setChannelTaper(channelId, taper, customTaper);
+  return true;
+});
+
+ipcMain.handle('set-channel-compressor', (_event, channelId: string, compressor: ChannelCompressor | null) => {
+  audioRouting.setChannelCompressor(channelId, compressor);
+  return true;
+});
+
 ipcMain.handle('set-channel-enabled-in-mix', (_event, mixId: string, channelId: string, enabled: boolean) => {
   audioRouting.setChannelEnabledInMix(mixId, channelId, enabled);
   return true;
 });
 
-ipcMain.handle('set-mix-output', (_event, mixId: string, deviceId: number | null) => {
-  audioRouting.setMixOutput(mixId, deviceId);
+ipcMain.handle('set-mix-output', async (_event, mixId: string, deviceId: number | null) => {
+  await audioRouting.setMixOutput(mixId, deviceId);
+  return true;
+});
+
+ipcMain.handle('set-mix-ducking', (_event, mixId: string, ducking: MixDucking | null) => {
+  audioRouting.setMixDucking(mixId, ducking);
   return true;
 });
 
+ipcMain.handle('get-ducking-reduction', () => {
+  return audioRouting.getDuckingReduction();
+});
+
 ipcMain.handle('get-available-outputs', () => {
   return audioRouting.getAvailableOutputDevices();
 });
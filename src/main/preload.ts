@@ -4,16 +4,30 @@ import { contextBridge, ipcRenderer } from 'electron';
 interface AudioOutputDevice {
   id: number;
   name: string;
+  uid: string;
   isDefault: boolean;
 }
 
+interface ChannelCompressor {
+  enabled: boolean;
+  detector: 'peak' | 'rms';
+  thresholdDb: number;
+  ratio: number;
+  kneeDb: number;
+  attackMs: number;
+  releaseMs: number;
+  makeupDb: number;
+}
+
 interface ChannelState {
   id: string;
   deviceName: string;
+  deviceUid: string;
   channelName: string;
   hardwareIndex: number;
   volume: number;
   muted: boolean;
+  compressor: ChannelCompressor | null;
   isActive: boolean;
   apps: string[];
 }
@@ -24,15 +38,99 @@ interface MixBusChannel {
   gainOverride: number | null;
 }
 
+interface MixDucking {
+  keyChannelId: string;
+  targetChannelIds: string[];
+  thresholdDb: number;
+  ratio: number;
+  attackMs: number;
+  releaseMs: number;
+}
+
 interface MixBusState {
   id: string;
   name: string;
   outputDeviceId: number | null;
+  outputDeviceUid: string | null;
   channels: MixBusChannel[];
+  ducking: MixDucking | null;
   isRunning: boolean;
   mixerHandle: number | null;
 }
 
+interface CallbackTimingStats {
+  count: number;
+  deadlineMisses: number;
+  minUs: number;
+  maxUs: number;
+  meanUs: number;
+  p50Us: number;
+  p99Us: number;
+  periodUs: number;
+  histogram: [number, number][];
+}
+
+interface MixTiming {
+  output: CallbackTimingStats;
+  inputs: Record<string, CallbackTimingStats & { name: string; handle: number }>;
+}
+
+interface RingXrunStats {
+  underruns: number;
+  silentFrames: number;
+  overflows: number;
+  droppedFrames: number;
+  fillMinFrames: number;
+  fillMaxFrames: number;
+  capacityFrames: number;
+}
+
+interface MixXruns {
+  total: RingXrunStats;
+  inputs: Record<string, RingXrunStats & { name: string; handle: number }>;
+}
+
+interface RecordingStats {
+  recording: boolean;
+  path: string;
+  framesWritten: number;
+  droppedFrames: number;
+  bytesWritten: number;
+  seconds: number;
+  writeSeconds: number;
+  maxWriteMs: number;
+  backlogMaxFrames: number;
+  ringCapacityFrames: number;
+}
+
+interface StemStats {
+  recording: boolean;
+  paths: string[];
+  stems: number;
+  framesWritten: number;
+  droppedFrames: number;
+  bytesWritten: number;
+  seconds: number;
+  writeSeconds: number;
+  maxWriteMs: number;
+  backlogMaxFrames: number;
+}
+
+interface ReplayStats {
+  running: boolean;
+  sampleRate: number;
+  windowSeconds: number;
+  heldSeconds: number;
+  compressedBytes: number;
+  arenaBytes: number;
+  bytesPerMinute: number;
+  compressionRatio: number;
+  droppedFrames: number;
+  evictedFrames: number;
+  encodeSeconds: number;
+  maxEncodeMs: number;
+}
+
 interface AudioRoutingState {
   channels: ChannelState[];
   mixBuses: MixBusState[];
@@ -56,9 +154,12 @@ contextBridge.exposeInMainWorld('pcpanel', {
   onChannelActivity: (callback: (activityInfo: Record<number, { isActive: boolean; apps: string[] }>) => void) => {
     ipcRenderer.on('channel-activity', (_event, info) => callback(info));
   },
-  onAudioLevels: (callback: (levels: Record<string, { peak: number; rms: number }>) => void) => {
+  onAudioLevels: (callback: (levels: Record<string, { peak: number; rms: number; gainReductionDb: number }>) => void) => {
     ipcRenderer.on('audio-levels', (_event, levels) => callback(levels));
   },
+  onAudioRouting: (callback: (state: AudioRoutingState) => void) => {
+    ipcRenderer.on('audio-routing', (_event, state) => callback(state));
+  },
   onToast: (callback: (toast: { type: 'success' | 'warning' | 'error' | 'info'; message: string; duration?: number }) => void) => {
     ipcRenderer.on('toast', (_event, toast) => callback(toast));
   },
@@ -69,6 +170,26 @@ contextBridge.exposeInMainWorld('pcpanel', {
   getChannelActivity: () => ipcRenderer.invoke('get-channel-activity') as Promise<Record<number, { isActive: boolean; apps: string[] }>>,
   reconnect: () => ipcRenderer.invoke('reconnect-device'),
 
+  // Diagnostics
+  getCallbackTiming: () => ipcRenderer.invoke('get-callback-timing') as Promise<Record<string, MixTiming>>,
+  resetCallbackTiming: () => ipcRenderer.invoke('reset-callback-timing') as Promise<boolean>,
+  getXrunStats: () => ipcRenderer.invoke('get-xrun-stats') as Promise<Record<string, MixXruns>>,
+  startAudioTrace: () => ipcRenderer.invoke('start-audio-trace') as Promise<boolean>,
+  stopAudioTrace: () => ipcRenderer.invoke('stop-audio-trace') as Promise<{ path: string; events: number }>,
+  startRecording: (mixId: string, format: 'wav' | 'caf' = 'wav') =>
+    ipcRenderer.invoke('start-recording', mixId, format) as Promise<string>,
+  stopRecording: (mixId: string) => ipcRenderer.invoke('stop-recording', mixId) as Promise<RecordingStats | null>,
+  getRecordingStats: () => ipcRenderer.invoke('get-recording-stats') as Promise<Record<string, RecordingStats>>,
+  startStems: (mixId: string, layout: 'files' | 'interleaved' = 'files', format: 'wav' | 'caf' = 'wav') =>
+    ipcRenderer.invoke('start-stems', mixId, layout, format) as Promise<string>,
+  stopStems: (mixId: string) => ipcRenderer.invoke('stop-stems', mixId) as Promise<StemStats | null>,
+  getStemStats: () => ipcRenderer.invoke('get-stem-stats') as Promise<Record<string, StemStats>>,
+  startReplay: (mixId: string, seconds = 120) => ipcRenderer.invoke('start-replay', mixId, seconds) as Promise<void>,
+  saveReplay: (mixId: string, seconds = 0) =>
+    ipcRenderer.invoke('save-replay', mixId, seconds) as Promise<{ path: string; seconds: number }>,
+  stopReplay: (mixId: string) => ipcRenderer.invoke('stop-replay', mixId) as Promise<void>,
+  getReplayStats: () => ipcRenderer.invoke('get-replay-stats') as Promise<Record<string, ReplayStats>>,
+
   // New audio routing API
   getAudioRouting: () => ipcRenderer.invoke('get-audio-routing') as Promise<AudioRoutingState>,
   setChannelLabel: (channelId: string, label: string) =>
@@ -77,10 +198,17 @@ contextBridge.exposeInMainWorld('pcpanel', {
     ipcRenderer.invoke('set-channel-volume', channelId, volume) as Promise<boolean>,
   setChannelMuted: (channelId: string, muted: boolean) =>
     ipcRenderer.invoke('set-channel-muted', channelId, muted) as Promise<boolean>,
+  setChannelTaper: (channelId: string, taper: 'linear' | 'db' | 'audio' | 'custom', customTaper: number[] | null = null) =>
+    ipcRenderer.invoke('set-channel-taper', channelId, taper, customTaper) as Promise<boolean>,
+  setChannelCompressor: (channelId: string, compressor: ChannelCompressor | null) =>
+    ipcRenderer.invoke('set-channel-compressor', channelId, compressor) as Promise<boolean>,
   setChannelEnabled: (mixId: string, channelId: string, enabled: boolean) =>
     ipcRenderer.invoke('set-channel-enabled-in-mix', mixId, channelId, enabled) as Promise<boolean>,
   setMixOutput: (mixId: string, deviceId: number | null) =>
     ipcRenderer.invoke('set-mix-output', mixId, deviceId) as Promise<boolean>,
+  setMixDucking: (mixId: string, ducking: MixDucking | null) =>
+    ipcRenderer.invoke('set-mix-ducking', mixId, ducking) as Promise<boolean>,
+  getDuckingReduction: () => ipcRenderer.invoke('get-ducking-reduction') as Promise<Record<string, number>>,
   getAvailableOutputs: () =>
     ipcRenderer.invoke('get-available-outputs') as Promise<AudioOutputDevice[]>,
 });
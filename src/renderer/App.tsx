@@ -88,6 +88,20 @@ export function App() {
       setAudioLevels(levels);
     });
 
+    pcpanel.onAudioRouting((state) => {
+      // Pushed when audio devices change - keep live activity flags
+      setRoutingState(prev => {
+        if (!prev) return state;
+        return {
+          ...state,
+          channels: state.channels.map(ch => {
+            const existing = prev.channels.find(p => p.id === ch.id);
+            return existing ? { ...ch, isActive: existing.isActive, apps: existing.apps } : ch;
+          }),
+        };
+      });
+    });
+
     pcpanel.onToast((toast) => {
       setCurrentToast(toast);
     });
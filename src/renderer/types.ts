@@ -6,6 +6,81 @@ export interface ChannelActivityInfo {
 export interface AudioLevelInfo {
   peak: number;
   rms: number;
+  /** Compressor gain reduction in dB (0 while it's off) */
+  gainReductionDb: number;
+}
+
+export interface CallbackTimingStats {
+  count: number;
+  deadlineMisses: number;
+  minUs: number;
+  maxUs: number;
+  meanUs: number;
+  p50Us: number;
+  p99Us: number;
+  periodUs: number;
+  histogram: [number, number][];
+}
+
+export interface MixTiming {
+  output: CallbackTimingStats;
+  inputs: Record<string, CallbackTimingStats & { name: string; handle: number }>;
+}
+
+export interface RingXrunStats {
+  underruns: number;
+  silentFrames: number;
+  overflows: number;
+  droppedFrames: number;
+  fillMinFrames: number;
+  fillMaxFrames: number;
+  capacityFrames: number;
+}
+
+export interface MixXruns {
+  total: RingXrunStats;
+  inputs: Record<string, RingXrunStats & { name: string; handle: number }>;
+}
+
+export interface RecordingStats {
+  recording: boolean;
+  path: string;
+  framesWritten: number;
+  droppedFrames: number;
+  bytesWritten: number;
+  seconds: number;
+  writeSeconds: number;
+  maxWriteMs: number;
+  backlogMaxFrames: number;
+  ringCapacityFrames: number;
+}
+
+export interface StemStats {
+  recording: boolean;
+  paths: string[];
+  stems: number;
+  framesWritten: number;
+  droppedFrames: number;
+  bytesWritten: number;
+  seconds: number;
+  writeSeconds: number;
+  maxWriteMs: number;
+  backlogMaxFrames: number;
+}
+
+export interface ReplayStats {
+  running: boolean;
+  sampleRate: number;
+  windowSeconds: number;
+  heldSeconds: number;
+  compressedBytes: number;
+  arenaBytes: number;
+  bytesPerMinute: number;
+  compressionRatio: number;
+  droppedFrames: number;
+  evictedFrames: number;
+  encodeSeconds: number;
+  maxEncodeMs: number;
 }
 
 export interface DeviceState {
@@ -15,19 +90,36 @@ export interface DeviceState {
 }
 
 // Audio routing types (mirrored from main/audio/types.ts)
+export type VolumeTaper = 'linear' | 'db' | 'audio' | 'custom';
+
 export interface AudioOutputDevice {
   id: number;
   name: string;
+  uid: string;
   isDefault: boolean;
 }
 
+export interface ChannelCompressor {
+  enabled: boolean;
+  detector: 'peak' | 'rms';
+  thresholdDb: number;
+  ratio: number;
+  kneeDb: number;
+  attackMs: number;
+  releaseMs: number;
+  makeupDb: number;
+}
+
 export interface ChannelState {
   id: string;
   deviceName: string;
+  deviceUid: string;
   channelName: string;
   hardwareIndex: number;
   volume: number;
   muted: boolean;
+  taper: VolumeTaper;
+  compressor: ChannelCompressor | null;
   isActive: boolean;
   apps: string[];
 }
@@ -38,11 +130,22 @@ export interface MixBusChannel {
   gainOverride: number | null;
 }
 
+export interface MixDucking {
+  keyChannelId: string;
+  targetChannelIds: string[];
+  thresholdDb: number;
+  ratio: number;
+  attackMs: number;
+  releaseMs: number;
+}
+
 export interface MixBusState {
   id: string;
   name: string;
   outputDeviceId: number | null;
+  outputDeviceUid: string | null;
   channels: MixBusChannel[];
+  ducking: MixDucking | null;
   isRunning: boolean;
   mixerHandle: number | null;
 }
@@ -87,6 +190,7 @@ export interface PCPanelAPI {
   onOutputDevice: (callback: (device: { name: string }) => void) => void;
   onChannelActivity: (callback: (activityInfo: Record<number, ChannelActivityInfo>) => void) => void;
   onAudioLevels: (callback: (levels: Record<string, AudioLevelInfo>) => void) => void;
+  onAudioRouting: (callback: (state: AudioRoutingState) => void) => void;
   onToast: (callback: (toast: ToastData) => void) => void;
 
   // Legacy API
@@ -95,12 +199,34 @@ export interface PCPanelAPI {
   getChannelActivity: () => Promise<Record<number, ChannelActivityInfo>>;
   reconnect: () => Promise<void>;
 
+  // Diagnostics
+  getCallbackTiming: () => Promise<Record<string, MixTiming>>;
+  resetCallbackTiming: () => Promise<boolean>;
+  getXrunStats: () => Promise<Record<string, MixXruns>>;
+  startAudioTrace: () => Promise<boolean>;
+  stopAudioTrace: () => Promise<{ path: string; events: number }>;
+  startRecording: (mixId: string, format?: 'wav' | 'caf') => Promise<string>;
+  stopRecording: (mixId: string) => Promise<RecordingStats | null>;
+  getRecordingStats: () => Promise<Record<string, RecordingStats>>;
+  startStems: (mixId: string, layout?: 'files' | 'interleaved', format?: 'wav' | 'caf') => Promise<string>;
+  stopStems: (mixId: string) => Promise<StemStats | null>;
+  getStemStats: () => Promise<Record<string, StemStats>>;
+  startReplay: (mixId: string, seconds?: number) => Promise<void>;
+  saveReplay: (mixId: string, seconds?: number) => Promise<{ path: string; seconds: number }>;
+  stopReplay: (mixId: string) => Promise<void>;
+  getReplayStats: () => Promise<Record<string, ReplayStats>>;
+
   // Audio routing API
   getAudioRouting: () => Promise<AudioRoutingState>;
   setChannelLabel: (channelId: string, label: string) => Promise<AudioRoutingState>;
   setChannelVolume: (channelId: string, volume: number) => Promise<boolean>;
   setChannelMuted: (channelId: string, muted: boolean) => Promise<boolean>;
+  setChannelTaper: (channelId: string, taper: VolumeTaper, customTaper?: number[] | null) => Promise<boolean>;
+  setChannelCompressor: (channelId: string, compressor: ChannelCompressor | null) => Promise<boolean>;
   setChannelEnabled: (mixId: string, channelId: string, enabled: boolean) => Promise<boolean>;
   setMixOutput: (mixId: string, deviceId: number | null) => Promise<boolean>;
+  setMixDucking: (mixId: string, ducking: MixDucking | null) => Promise<boolean>;
+  /** Current gain reduction in dB of every mix with ducking on */
+  getDuckingReduction: () => Promise<Record<string, number>>;
   getAvailableOutputs: () => Promise<AudioOutputDevice[]>;
 }